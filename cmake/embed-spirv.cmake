@@ -0,0 +1,33 @@
+# Writes the header embedding the shaders compiled to SPIR-V at build time
+#
+# Run in script mode : cmake -DMANIFEST=<manifest> -DOUTPUT=<header> -P embed-spirv.cmake
+# Each line of the manifest describes a variant : identifier|source filename|definitions (NAME=VALUE, comma separated)|SPIR-V words (glslc -mfmt=num)
+
+CMAKE_MINIMUM_REQUIRED(VERSION 3.23) # Empty fields (variants without definitions) are kept by LIST
+
+FILE(STRINGS ${MANIFEST} variants)
+
+SET(arrays "")
+SET(table "")
+
+FOREACH(variant ${variants})
+    STRING(REPLACE "|" ";" fields "${variant}")
+
+    LIST(GET fields 0 identifier)
+    LIST(GET fields 1 source)
+    LIST(GET fields 2 definitions)
+    LIST(GET fields 3 words)
+
+    FILE(READ ${words} code)
+    STRING(STRIP "${code}" code)
+
+    STRING(APPEND arrays "    inline constexpr uint32_t ${identifier}_SPIRV[] = {\n${code}\n    };\n\n")
+    STRING(APPEND table "        EmbeddedShader{ \"${source}\", \"${definitions}\", ${identifier}_SPIRV },\n")
+ENDFOREACH()
+
+SET(header "// Generated at build time from shaders/*.glsl by cmake/embed-spirv.cmake : do not edit\n")
+STRING(APPEND header "#pragma once\n\n#include <cstdint>\n\n#include \"embedded-shaders.hpp\"\n\n")
+STRING(APPEND header "namespace fhope::embedded {\n${arrays}")
+STRING(APPEND header "    inline constexpr EmbeddedShader SHADERS[] = {\n${table}    };\n}\n")
+
+FILE(WRITE ${OUTPUT} "${header}")
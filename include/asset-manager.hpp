@@ -0,0 +1,362 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/vulkan.h>
+
+#include "task.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+    struct TextureAsset;
+    struct ModelAsset;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t     INVALID_ASSET        = UINT32_MAX; ///< Entry of no asset
+    inline constexpr VkDeviceSize DEFAULT_ASSET_BUDGET = 512 << 20;  ///< Device memory managed assets may keep resident by default (512 MiB)
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Handle of an asset of a given type, kept by it's user until released
+     *
+     * @tparam Asset Type of the asset
+     */
+    template <typename Asset>
+    struct AssetHandle {
+        uint32_t entry      = INVALID_ASSET; ///< Entry of the asset in it's registry
+        uint32_t generation = 0;             ///< Generation of the entry when the handle has been given (stale handles are rejected)
+    };
+
+    using TextureHandle = AssetHandle<TextureAsset>; ///< Handle of a managed texture
+    using ModelHandle   = AssetHandle<ModelAsset>;   ///< Handle of a managed model
+
+
+    /**
+     * @brief Loading state of an asset
+     */
+    enum class AssetState {
+        Loading,  ///< Being read, decoded or uploaded
+        Resident, ///< Usable
+        Failed    ///< Could not be loaded (the error has been rethrown by the async scheduler's pump)
+    };
+
+
+    /**
+     * @brief Registry of reference-counted textures and models, loaded asynchronously and shared between their users
+     *
+     * Acquiring a file already acquired (same canonical path) returns the same asset, which is referenced once per
+     * acquisition and must be released as many times. Files whose contents turn out to
+     * be identical once read (same hash and size) share the first one's asset. Assets nobody references anymore stay
+     * resident as a cache, until the device memory of resident assets exceeds the budget : the least recently released
+     * ones are then evicted, their destruction deferred until no in-flight frame uses them. Render thread only.
+     */
+    class AssetManager {
+        private:
+            /**
+             * @brief Asset of a registry, or alias of another entry holding the same contents
+             */
+            template <typename Asset>
+            struct Entry {
+                Asset                    asset;       ///< The asset, once resident
+                AssetState               state;       ///< Loading state of the asset
+                uint32_t                 generation;  ///< Incremented when the entry is freed
+                uint32_t                 references;  ///< Handles of the entry not released yet (aliases' included)
+                uint32_t                 target;      ///< Entry holding the asset, for aliases (INVALID_ASSET otherwise)
+                uint64_t                 lastUsed;    ///< Use clock when the entry has last been acquired or released
+                VkDeviceSize             sizeInBytes; ///< Device memory of the asset, once resident
+                uint64_t                 contentHash; ///< Hash of the file's contents, once read
+                size_t                   contentSize; ///< Size of the file's contents, once read
+                std::vector<std::string> paths;       ///< Canonical paths of every file the asset has been acquired with
+                bool                     live;        ///< Wether or not the entry is in use
+            };
+
+
+            /**
+             * @brief Entries of a type of asset, and their lookups
+             */
+            template <typename Asset>
+            struct Registry {
+                std::vector<Entry<Asset>>                 entries;     ///< Every entry, indexed by handle
+                std::vector<uint32_t>                     freeEntries; ///< Freed entries, reused by next acquisitions
+                std::unordered_map<std::string, uint32_t> byPath;      ///< Entry of each canonical path
+                std::unordered_map<uint64_t, uint32_t>    byContent;   ///< Entry of each content hash
+            };
+
+            Registry<TextureAsset> textures; ///< Managed textures
+            Registry<ModelAsset>   models;   ///< Managed models
+
+            VkDeviceSize budget;        ///< Device memory resident assets may use before unreferenced ones are evicted
+            VkDeviceSize residentBytes; ///< Device memory of resident assets
+            uint64_t     useClock;      ///< Incremented on every acquisition and release, ordering them
+
+            /**
+             * @brief References the entry of a file, creating a loading one if the file is not registered
+             *
+             * @param registry The registry of the file's type of asset
+             * @param filename Name of the file
+             * @param created Set to wether or not the entry has been created, and must be loaded
+             * @return AssetHandle<Asset> Handle of the entry
+             */
+            template <typename Asset>
+            AssetHandle<Asset> acquire(Registry<Asset> *registry, const std::string &filename, bool *created);
+
+            /**
+             * @brief Registers an asset created by the caller as a file's resident asset, referenced once
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param registry The registry of the asset's type
+             * @param filename Name of the file
+             * @param asset The asset
+             * @param sizeInBytes Device memory of the asset
+             * @return AssetHandle<Asset> Handle of the asset
+             * @throws std::runtime_error If the file is already registered
+             */
+            template <typename Asset>
+            AssetHandle<Asset> add(const InstanceSetup &setup, Registry<Asset> *registry, const std::string &filename, const Asset &asset, VkDeviceSize sizeInBytes);
+
+            /**
+             * @brief Dereferences an entry (and it's alias target), freeing it once unreferenced if it holds nothing
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param registry The entry's registry
+             * @param handle Handle of the entry
+             * @throws std::runtime_error If the handle has been released already, or more times than it's entry has been acquired
+             */
+            template <typename Asset>
+            void release(const InstanceSetup &setup, Registry<Asset> *registry, AssetHandle<Asset> handle);
+
+            /**
+             * @brief Gets the entry holding a handle's asset, following aliases
+             *
+             * @param registry The handle's registry
+             * @param handle The handle
+             * @return const Entry<Asset>& The entry holding the asset
+             * @throws std::runtime_error If the handle has been released
+             */
+            template <typename Asset>
+            const Entry<Asset> &resolve(const Registry<Asset> &registry, AssetHandle<Asset> handle) const;
+
+            /**
+             * @brief Makes a loading entry an alias of an entry holding the same contents, or records it's contents
+             *
+             * @param registry The entry's registry
+             * @param entry The loading entry, whose file has just been read
+             * @param contentHash Hash of the file's contents
+             * @param contentSize Size of the file's contents
+             * @return true If the entry is now an alias : nothing is left to load
+             * @return false If the contents are new : the asset must be created
+             */
+            template <typename Asset>
+            bool share_contents(Registry<Asset> *registry, uint32_t entry, uint64_t contentHash, size_t contentSize);
+
+            /**
+             * @brief Stores a loaded asset in it's entry, then enforces the budget
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param registry The entry's registry
+             * @param entry The loading entry
+             * @param asset The loaded asset
+             * @param sizeInBytes Device memory of the asset
+             */
+            template <typename Asset>
+            void make_resident(const InstanceSetup &setup, Registry<Asset> *registry, uint32_t entry, const Asset &asset, VkDeviceSize sizeInBytes);
+
+            /**
+             * @brief Marks a loading entry as failed, unregistering it's paths so that next acquisitions retry
+             *
+             * @param registry The entry's registry
+             * @param entry The loading entry
+             */
+            template <typename Asset>
+            void mark_failed(Registry<Asset> *registry, uint32_t entry);
+
+            /**
+             * @brief Unregisters an entry and makes it reusable, invalidating it's handles
+             *
+             * @param registry The entry's registry
+             * @param entry The entry
+             */
+            template <typename Asset>
+            void free_entry(Registry<Asset> *registry, uint32_t entry);
+
+            /**
+             * @brief Frees a resident entry, deferring the destruction of it's asset until no in-flight frame uses it
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param registry The entry's registry
+             * @param entry The entry
+             */
+            template <typename Asset>
+            void evict(const InstanceSetup &setup, Registry<Asset> *registry, uint32_t entry);
+
+            /**
+             * @brief Finds the least recently released resident asset nobody references
+             *
+             * @param registry The registry to search
+             * @param lastUsed Use clock of the best candidate so far, updated if one is found
+             * @return uint32_t The candidate's entry, or INVALID_ASSET if none is older than lastUsed
+             */
+            template <typename Asset>
+            uint32_t find_eviction_candidate(const Registry<Asset> &registry, uint64_t *lastUsed) const;
+
+            /**
+             * @brief Evicts unreferenced assets, least recently released first, until the resident ones fit the budget
+             *
+             * @param setup A setup containing at least a deletion queue
+             */
+            void enforce_budget(const InstanceSetup &setup);
+
+            /**
+             * @brief Reads a texture entry's file, then aliases an entry with the same contents or creates the texture
+             *
+             * @param setup The setup the texture is loaded with
+             * @param entry The loading entry
+             * @param path Canonical path of the file
+             * @return Task<void> The load, spawned on the async scheduler
+             */
+            Task<void> load_texture(InstanceSetup *setup, uint32_t entry, std::string path);
+
+            /**
+             * @brief Reads a model entry's file, then aliases an entry with the same contents or creates the model
+             *
+             * @param setup The setup the model is loaded with
+             * @param entry The loading entry
+             * @param path Canonical path of the file
+             * @return Task<void> The load, spawned on the async scheduler
+             */
+            Task<void> load_model(InstanceSetup *setup, uint32_t entry, std::string path);
+
+            static std::function<void()> make_destruction(const InstanceSetup &setup, const TextureAsset &asset); ///< Destroys a texture and frees it's bindless slot, capturing the device and the bindless array by value
+            static std::function<void()> make_destruction(const InstanceSetup &setup, const ModelAsset &asset);   ///< Removes a model's mesh from the geometry pool, capturing the pool by value
+
+        public:
+            /**
+             * @brief Creates an empty registry
+             *
+             * @param budget Device memory resident assets may use before unreferenced ones are evicted
+             */
+            explicit AssetManager(VkDeviceSize budget = DEFAULT_ASSET_BUDGET);
+
+            ~AssetManager();
+
+            AssetManager(const AssetManager &) = delete;
+            AssetManager &operator=(const AssetManager &) = delete;
+
+            /**
+             * @brief Explicitely destroys every resident asset at once (the device must be idle, and no load pending)
+             *
+             * @param setup The setup assets have been loaded with
+             */
+            void destroy(const InstanceSetup &setup);
+
+            /**
+             * @brief Acquires a texture, loading it asynchronously unless it is already acquired or cached
+             *
+             * @param setup A setup containing at least an async scheduler, and everything create_texture_from_image requires
+             * @param filename Name of the image file
+             * @return TextureHandle Handle of the texture, to release once unused
+             */
+            TextureHandle acquire_texture(InstanceSetup *setup, const std::string &filename);
+
+            /**
+             * @brief Acquires a model, loading it asynchronously in the geometry pool unless it is already acquired or cached
+             *
+             * @param setup A setup containing at least an async scheduler and a geometry pool
+             * @param filename Name of the model file (wavefront OBJ)
+             * @return ModelHandle Handle of the model, to release once unused
+             */
+            ModelHandle acquire_model(InstanceSetup *setup, const std::string &filename);
+
+            /**
+             * @brief Registers a texture created by the caller as the resident asset of a file, as if it had been loaded from it
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param filename Name of the image file the texture stands for
+             * @param asset The texture, destroyed by the manager from now on
+             * @param sizeInBytes Device memory of the texture
+             * @return TextureHandle Handle of the texture, to release once unused
+             * @throws std::runtime_error If the file is already registered
+             */
+            TextureHandle add_texture(const InstanceSetup &setup, const std::string &filename, const TextureAsset &asset, VkDeviceSize sizeInBytes);
+
+            /**
+             * @brief Registers a model created by the caller as the resident asset of a file, as if it had been loaded from it
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param filename Name of the model file the model stands for
+             * @param asset The model, removed from the geometry pool by the manager from now on
+             * @param sizeInBytes Device memory of the model
+             * @return ModelHandle Handle of the model, to release once unused
+             * @throws std::runtime_error If the file is already registered
+             */
+            ModelHandle add_model(const InstanceSetup &setup, const std::string &filename, const ModelAsset &asset, VkDeviceSize sizeInBytes);
+
+            /**
+             * @brief Releases a texture handle : once nobody references the texture, it may be evicted
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param handle The handle, invalid afterwards
+             * @throws std::runtime_error If the texture has already been released as many times as it has been acquired
+             */
+            void release(const InstanceSetup &setup, TextureHandle handle);
+
+            /**
+             * @brief Releases a model handle : once nobody references the model, it may be evicted
+             *
+             * @param setup A setup containing at least a deletion queue
+             * @param handle The handle, invalid afterwards
+             * @throws std::runtime_error If the model has already been released as many times as it has been acquired
+             */
+            void release(const InstanceSetup &setup, ModelHandle handle);
+
+            /**
+             * @brief Gets a texture
+             *
+             * @param handle Handle of the texture
+             * @return const TextureAsset* The texture, or nullptr while it is loading (or if it failed to)
+             */
+            const TextureAsset *get(TextureHandle handle) const;
+
+            /**
+             * @brief Gets a model
+             *
+             * @param handle Handle of the model
+             * @return const ModelAsset* The model, or nullptr while it is loading (or if it failed to)
+             */
+            const ModelAsset *get(ModelHandle handle) const;
+
+            /**
+             * @brief Gets the loading state of a texture
+             *
+             * @param handle Handle of the texture
+             * @return AssetState The texture's state
+             */
+            AssetState get_state(TextureHandle handle) const;
+
+            /**
+             * @brief Gets the loading state of a model
+             *
+             * @param handle Handle of the model
+             * @return AssetState The model's state
+             */
+            AssetState get_state(ModelHandle handle) const;
+
+            /**
+             * @brief Gets the device memory of resident assets (evicted ones waiting for their destruction excluded)
+             *
+             * @return VkDeviceSize The device memory of resident assets, in bytes
+             */
+            VkDeviceSize get_resident_bytes() const;
+    };
+}
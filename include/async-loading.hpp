@@ -0,0 +1,97 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <glad/vulkan.h>
+
+#include "task.hpp"
+#include "setup.hpp"
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Texture loaded asynchronously, ready to be sampled
+     */
+    struct TextureAsset {
+        WrappedTexture              texture;       ///< Uploaded texture, mipmaps included, in shader read-only layout
+        VkImageView                 view;          ///< View over every mip level of the texture
+        VkSampler                   sampler;       ///< Sampler of the texture (owned by the setup's sampler cache)
+        std::optional<TextureIndex> bindlessIndex; ///< Index of the texture in the bindless array (only when bindless textures are enabled)
+    };
+
+
+    /**
+     * @brief Model loaded asynchronously, it's CPU-side data freed once uploaded
+     */
+    struct ModelAsset {
+        MeshHandle mesh; ///< Mesh of the model in the setup's geometry pool
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Loads a texture without blocking any thread : the file is read and decoded on workers, the upload is
+     * submitted at a frame boundary and awaited through it's fence
+     *
+     * @param setup A setup containing at least an async scheduler, and everything create_texture_from_image requires
+     * @param filename Name of the image file to load
+     * @return Task<TextureAsset> The loaded texture, to destroy with destroy_texture_asset
+     */
+    Task<TextureAsset> load_texture_async(InstanceSetup *setup, std::string filename);
+
+    /**
+     * @brief Creates a texture from the contents of it's file, decoding on the calling thread (a worker) then uploading
+     * like load_texture_async : it completes on the render thread
+     *
+     * @param setup A setup containing at least an async scheduler, and everything create_texture_from_image requires
+     * @param contents Contents of the image file
+     * @param name Name of the image, for error messages
+     * @return Task<TextureAsset> The created texture, to destroy with destroy_texture_asset
+     */
+    Task<TextureAsset> create_texture_async(InstanceSetup *setup, std::vector<char> contents, std::string name);
+
+    /**
+     * @brief Loads a model in the setup's geometry pool without blocking any thread : the file is read, parsed and staged
+     * on workers, then it's ranges are allocated and it's copy submitted at a frame boundary and awaited through it's fence
+     *
+     * @param setup A setup containing at least an async scheduler and a geometry pool
+     * @param filename Name of the model file to load (wavefront OBJ)
+     * @return Task<MeshHandle> Handle of the model's mesh in the geometry pool
+     */
+    Task<MeshHandle> load_model_async(InstanceSetup *setup, std::string filename);
+
+    /**
+     * @brief Creates a model in the setup's geometry pool from the contents of it's file, parsing and staging on the calling
+     * thread (a worker) then uploading like load_model_async : it completes on the render thread, once the mesh is drawable
+     *
+     * @param setup A setup containing at least an async scheduler and a geometry pool
+     * @param contents Contents of the model file (wavefront OBJ)
+     * @param name Name of the model, for error messages
+     * @return Task<MeshHandle> Handle of the model's mesh in the geometry pool
+     */
+    Task<MeshHandle> create_model_async(InstanceSetup *setup, std::vector<char> contents, std::string name);
+
+    /**
+     * @brief Destroys a texture loaded asynchronously, once the GPU no longer samples it (render thread)
+     *
+     * @param setup The setup the texture has been loaded with
+     * @param asset The texture
+     */
+    void destroy_texture_asset(const InstanceSetup &setup, const TextureAsset &asset);
+
+    /**
+     * @brief Destroys a texture loaded asynchronously, without a setup (for destructions deferred past the setup's location)
+     *
+     * @param device The logical device the texture has been loaded with
+     * @param textures The bindless array holding the texture, if it has an index in it
+     * @param asset The texture
+     */
+    void destroy_texture_asset(VkDevice device, BindlessTextures *textures, const TextureAsset &asset);
+}
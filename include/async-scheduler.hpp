@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glad/vulkan.h>
+
+#include "task.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+    struct DetachedTask;
+    class JobSystem;
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Resumes coroutines on job workers, once files are read, once GPU work completes, or at frame boundaries
+     *
+     * Coroutines awaiting GPU completion or a frame boundary are parked until the render thread pumps the scheduler,
+     * which it does once per frame without ever blocking. Code resumed at a frame boundary runs on the render thread :
+     * it may touch what only the render thread owns (graphics queue, caches, geometry pool, bindless array), and must
+     * stay short. Every other resumption happens on a job worker.
+     */
+    class AsyncScheduler {
+        private:
+            /**
+             * @brief Coroutine parked until a fence is signaled or a timeline semaphore reaches a value
+             */
+            struct GpuWait {
+                VkFence                 fence;      ///< Awaited fence (VK_NULL_HANDLE when awaiting a semaphore)
+                VkSemaphore             semaphore;  ///< Awaited timeline semaphore (VK_NULL_HANDLE when awaiting a fence)
+                uint64_t                value;      ///< Value the timeline semaphore must reach
+                std::coroutine_handle<> coroutine;  ///< Coroutine resumed on a worker once the wait completes
+            };
+
+            VkDevice      device;     ///< Logical device fences and semaphores are polled on
+            VkQueue       queue;      ///< Graphics queue uploads are submitted to
+            VkCommandPool uploadPool; ///< Pool of upload command buffers (render thread only)
+            JobSystem    *jobs;       ///< Workers coroutines are resumed on
+
+            std::mutex                           mutex;        ///< Protects every member below
+            std::vector<GpuWait>                 gpuWaits;     ///< Coroutines waiting for the GPU
+            std::vector<std::coroutine_handle<>> frameWaiters; ///< Coroutines waiting for the next frame boundary
+            std::exception_ptr                   error;        ///< First exception a spawned task threw since the last pump
+
+            std::atomic<uint32_t> pending; ///< Spawned tasks not completed yet
+
+            /**
+             * @brief Runs a spawned task to completion, reporting it's failure to the scheduler
+             *
+             * @param scheduler The scheduler the task has been spawned on
+             * @param task The task
+             * @return DetachedTask Nothing to keep : the coroutine frees itself once done
+             */
+            static DetachedTask run_detached(AsyncScheduler *scheduler, Task<void> task);
+
+            /**
+             * @brief Resumes the coroutines whose GPU wait completed (on workers) and those waiting for a frame boundary (inline)
+             */
+            void resume_ready();
+
+        public:
+            /**
+             * @brief Hops to a job worker
+             */
+            struct ScheduleAwaiter {
+                JobSystem *jobs; ///< Workers to hop to
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> coroutine) const;
+                void await_resume() const noexcept {}
+            };
+
+
+            /**
+             * @brief Reads a whole file on a job worker, resuming there with it's contents
+             */
+            struct FileReadAwaiter {
+                JobSystem         *jobs;     ///< Workers the file is read on
+                std::string        filename; ///< Name of the file
+                std::vector<char>  contents; ///< Contents of the file, once read
+                std::exception_ptr error;    ///< Failure to read the file
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> coroutine);
+                std::vector<char> await_resume();
+            };
+
+
+            /**
+             * @brief Parks the coroutine until GPU work completes, resuming it on a job worker
+             */
+            struct GpuAwaiter {
+                AsyncScheduler *scheduler; ///< Scheduler polling the wait
+                GpuWait         wait;      ///< What is waited for
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> coroutine);
+                void await_resume() const noexcept {}
+            };
+
+
+            /**
+             * @brief Parks the coroutine until the next frame boundary, resuming it on the render thread
+             */
+            struct FrameAwaiter {
+                AsyncScheduler *scheduler; ///< Scheduler pumped by the render thread
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> coroutine) const;
+                void await_resume() const noexcept {}
+            };
+
+            /**
+             * @brief Creates the scheduler and it's upload command pool
+             *
+             * @param setup A setup containing at least a logical device, queue families and a graphics queue
+             * @param jobs Workers coroutines are resumed on, outliving the scheduler
+             */
+            AsyncScheduler(const InstanceSetup &setup, JobSystem *jobs);
+
+            AsyncScheduler(const AsyncScheduler &) = delete;
+            AsyncScheduler &operator=(const AsyncScheduler &) = delete;
+
+            /**
+             * @brief Explicitely waits for every spawned task, then destroys the upload command pool
+             */
+            void destroy();
+
+            /**
+             * @brief Runs a task without waiting for it : it runs on the calling thread until it's first suspension
+             *
+             * @param task The task, whose exception (if any) is rethrown by the next pump
+             */
+            void spawn(Task<void> task);
+
+            /**
+             * @brief Resumes the coroutines whose wait completed, without blocking (render thread, once per frame)
+             *
+             * @throws The first exception a spawned task threw since the last pump
+             */
+            void pump();
+
+            /**
+             * @brief Pumps until every spawned task has completed (render thread)
+             */
+            void drain();
+
+            /**
+             * @brief Gets the amount of spawned tasks not completed yet
+             *
+             * @return uint32_t The amount of pending tasks
+             */
+            uint32_t get_pending() const;
+
+            /**
+             * @brief Awaitable hopping to a job worker
+             *
+             * @return ScheduleAwaiter The awaitable
+             */
+            ScheduleAwaiter schedule() const;
+
+            /**
+             * @brief Awaitable reading a whole file on a job worker
+             *
+             * @param filename Name of the file
+             * @return FileReadAwaiter The awaitable, producing the file's contents
+             */
+            FileReadAwaiter read_file(std::string filename) const;
+
+            /**
+             * @brief Awaitable completing once a fence is signaled
+             *
+             * @param fence The fence
+             * @return GpuAwaiter The awaitable
+             */
+            GpuAwaiter gpu_complete(VkFence fence);
+
+            /**
+             * @brief Awaitable completing once a timeline semaphore reaches a value
+             *
+             * @param timeline The timeline semaphore (the timeline semaphore feature must be enabled)
+             * @param value The value to reach
+             * @return GpuAwaiter The awaitable
+             */
+            GpuAwaiter gpu_complete(VkSemaphore timeline, uint64_t value);
+
+            /**
+             * @brief Awaitable completing at the next frame boundary, on the render thread
+             *
+             * @return FrameAwaiter The awaitable
+             */
+            FrameAwaiter next_frame();
+
+            /**
+             * @brief Allocates and begins a one-time upload command buffer (render thread only)
+             *
+             * @return VkCommandBuffer The begun command buffer
+             */
+            VkCommandBuffer begin_upload();
+
+            /**
+             * @brief Ends and submits an upload command buffer to the graphics queue, without waiting (render thread only)
+             *
+             * @param commandBuffer The upload command buffer
+             * @return VkFence Fence signaled once the upload completes, to await with gpu_complete
+             */
+            VkFence submit_upload(VkCommandBuffer commandBuffer);
+
+            /**
+             * @brief Frees a completed upload's command buffer and fence (render thread only)
+             *
+             * @param commandBuffer The upload command buffer
+             * @param fence The upload's fence, signaled
+             */
+            void release_upload(VkCommandBuffer commandBuffer, VkFence fence);
+    };
+}
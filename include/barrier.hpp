@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/vulkan.h>
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Pipeline stages and memory accesses an image layout (or a buffer usage) implies
+     */
+    struct StageAccess {
+        VkPipelineStageFlags2KHR stages; ///< Tightest pipeline stages touching the resource
+        VkAccessFlags2KHR        access; ///< Tightest memory accesses performed on the resource
+    };
+
+
+    /**
+     * @brief Collects image and buffer memory barriers and records them in a single pipeline barrier call
+     *
+     * Barriers are stored with synchronization2 masks. When VK_KHR_synchronization2 is enabled on the device, they are
+     * flushed through vkCmdPipelineBarrier2KHR with per-barrier masks, otherwise they are downgraded to a single legacy
+     * vkCmdPipelineBarrier whose stage masks are the union of every collected barrier's.
+     */
+    class BarrierBatch {
+        private:
+            bool useSynchronization2; ///< Wether or not vkCmdPipelineBarrier2KHR is available and enabled
+
+            std::vector<VkImageMemoryBarrier2KHR>  imageBarriers;  ///< Pending image barriers
+            std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers; ///< Pending buffer barriers
+
+        public:
+            /**
+             * @brief Creates an empty barrier batch
+             *
+             * @param useSynchronization2 Wether or not the device has VK_KHR_synchronization2 enabled
+             */
+            explicit BarrierBatch(bool useSynchronization2);
+
+            /**
+             * @brief Queues a layout transition of a subresource range, deriving stages and accesses from both layouts
+             *
+             * @param image The image to transition
+             * @param range The subresource range to transition
+             * @param oldLayout The range's current layout
+             * @param newLayout The range's desired layout
+             * @return BarrierBatch& The batch, for chaining
+             */
+            BarrierBatch &transition_image(VkImage image, const VkImageSubresourceRange &range, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+            /**
+             * @brief Queues a layout transition of a subresource range with explicit source and destination scopes
+             *
+             * @param image The image to transition
+             * @param range The subresource range to transition
+             * @param oldLayout The range's current layout
+             * @param newLayout The range's desired layout
+             * @param source Stages and accesses that must complete before the transition
+             * @param destination Stages and accesses that must wait for the transition
+             * @return BarrierBatch& The batch, for chaining
+             */
+            BarrierBatch &transition_image(VkImage image, const VkImageSubresourceRange &range, VkImageLayout oldLayout, VkImageLayout newLayout, const StageAccess &source, const StageAccess &destination);
+
+            /**
+             * @brief Queues a buffer memory barrier
+             *
+             * @param buffer The buffer to synchronize
+             * @param offset Offset of the synchronized range, in bytes
+             * @param size Size of the synchronized range, in bytes (or VK_WHOLE_SIZE)
+             * @param source Stages and accesses that must complete before the barrier
+             * @param destination Stages and accesses that must wait for the barrier
+             * @return BarrierBatch& The batch, for chaining
+             */
+            BarrierBatch &buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const StageAccess &source, const StageAccess &destination);
+
+            /**
+             * @brief Checks wether or not any barrier is pending
+             *
+             * @return true If no barrier has been queued since the last flush
+             * @return false If at least one barrier is pending
+             */
+            bool empty() const;
+
+            /**
+             * @brief Records every pending barrier in a single call, then empties the batch
+             *
+             * @param commandBuffer The command buffer to record the barriers in
+             */
+            void flush(VkCommandBuffer commandBuffer);
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Gets the tightest stages and accesses implied by an image layout
+     *
+     * @param layout The layout to inspect
+     * @param asSource Wether the layout is left (true) or entered (false), which changes what UNDEFINED and PRESENT_SRC imply
+     * @return StageAccess The stages and accesses matching the layout
+     */
+    StageAccess get_layout_stage_access(VkImageLayout layout, bool asSource);
+
+    /**
+     * @brief Gets the aspect flags of an image from it's format
+     *
+     * @param format The image's format
+     * @return VkImageAspectFlags Depth (and stencil) aspects for depth formats, color aspect otherwise
+     */
+    VkImageAspectFlags get_format_aspect(VkFormat format);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/vulkan.h>
+
+namespace fhope {
+    struct InstanceSetup;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t DEFAULT_BINDLESS_TEXTURE_CAPACITY = 4096; ///< Textures the bindless array holds (clamped to the device's update-after-bind limits)
+    inline constexpr uint32_t BINDLESS_TEXTURE_SET = 1;                 ///< Set of the bindless texture array in the drawing pipeline layout
+    inline constexpr uint32_t BINDLESS_TEXTURE_BINDING = 0;             ///< Binding of the bindless texture array in it's set
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    using TextureIndex = uint32_t; ///< Index of a texture in the bindless array, as read by shaders
+
+    /**
+     * @brief Single large array of combined image samplers, indexed by shaders (descriptor indexing)
+     *
+     * The array is partially bound and update-after-bind : it is bound once, and textures are added to free slots while
+     * frames using other slots are still pending. Draws only differ by the texture index they read (per instance), so
+     * material changes do not break draw batches.
+     */
+    class BindlessTextures {
+        private:
+            VkDevice              device;        ///< Logical device the descriptors have been created with
+            VkDescriptorSetLayout layout;        ///< Layout of the array's set
+            VkDescriptorPool      pool;          ///< Update-after-bind pool of the array's set
+            VkDescriptorSet       descriptorSet; ///< Set holding the array
+
+            uint32_t                  capacity;  ///< Amount of slots of the array
+            uint32_t                  nextSlot;  ///< First slot never used
+            std::vector<TextureIndex> freeSlots; ///< Slots of removed textures, reused by next additions
+
+        public:
+            /**
+             * @brief Creates the array's layout, pool and set, without any texture
+             *
+             * @param setup A setup containing at least a physical device and a logical device created with descriptor indexing
+             * @param requestedCapacity Amount of slots wished for the array
+             */
+            BindlessTextures(const InstanceSetup &setup, uint32_t requestedCapacity = DEFAULT_BINDLESS_TEXTURE_CAPACITY);
+
+            BindlessTextures(const BindlessTextures &) = delete;
+            BindlessTextures &operator=(const BindlessTextures &) = delete;
+
+            /**
+             * @brief Explicitely destroys the array's layout and pool
+             */
+            void destroy();
+
+            /**
+             * @brief Writes a texture in a free slot of the array
+             *
+             * @param view View to the texture, in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+             * @param sampler Sampler the texture is read with
+             * @return TextureIndex Index shaders read the texture at
+             */
+            TextureIndex add(VkImageView view, VkSampler sampler);
+
+            /**
+             * @brief Frees a texture's slot, for the next additions to reuse it
+             *
+             * @param index Index of the texture, which no pending frame may read anymore
+             */
+            void remove(TextureIndex index);
+
+            /**
+             * @brief Gets the amount of slots of the array
+             *
+             * @return uint32_t The amount of slots
+             */
+            uint32_t get_capacity() const;
+
+            /**
+             * @brief Gets the layout of the array's set
+             *
+             * @return VkDescriptorSetLayout The layout, to put at BINDLESS_TEXTURE_SET in pipeline layouts
+             */
+            VkDescriptorSetLayout get_layout() const;
+
+            /**
+             * @brief Gets the set holding the array
+             *
+             * @return VkDescriptorSet The set, to bind at BINDLESS_TEXTURE_SET
+             */
+            VkDescriptorSet get_descriptor_set() const;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Destructions deferred until no frame submitted before them may still use what they destroy
+     *
+     * A destruction pushed while a frame is prepared waits for that frame's submission to complete, which the queue
+     * learns when the frame slot's fence is waited on again. Submissions complete in order on the graphics queue : a
+     * slot's fence covers every earlier submission. Render thread only.
+     */
+    class DeletionQueue {
+        private:
+            /**
+             * @brief Destruction waiting for a submission to complete
+             */
+            struct Deletion {
+                uint64_t              submission; ///< Last submission which may use what is destroyed
+                std::function<void()> destroy;    ///< The destruction
+            };
+
+            uint64_t submitted; ///< Amount of frames submitted so far
+            uint64_t completed; ///< Last submission known to be complete
+
+            std::vector<uint64_t> slotSubmissions; ///< Last submission of each frame slot
+            std::deque<Deletion>  deletions;       ///< Pending destructions, in push (and submission) order
+
+        public:
+            /**
+             * @brief Creates an empty queue
+             *
+             * @param framesInFlight Amount of frame slots
+             */
+            explicit DeletionQueue(uint32_t framesInFlight);
+
+            DeletionQueue(const DeletionQueue &) = delete;
+            DeletionQueue &operator=(const DeletionQueue &) = delete;
+
+            /**
+             * @brief Defers a destruction until the frame being prepared (and every earlier one) has completed
+             *
+             * @param destroy The destruction
+             */
+            void push(std::function<void()> destroy);
+
+            /**
+             * @brief Records the submission of a frame slot
+             *
+             * @param frameIndex The submitted frame slot
+             */
+            void mark_submitted(uint32_t frameIndex);
+
+            /**
+             * @brief Runs the destructions whose submissions have completed
+             *
+             * @param frameIndex The frame slot whose fence has just been waited on
+             */
+            void collect(uint32_t frameIndex);
+
+            /**
+             * @brief Runs every pending destruction (the device must be idle)
+             */
+            void flush();
+
+            /**
+             * @brief Gets the amount of pending destructions
+             *
+             * @return size_t The amount of pending destructions
+             */
+            size_t size() const;
+    };
+}
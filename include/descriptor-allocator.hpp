@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/vulkan.h>
+
+namespace fhope {
+    struct InstanceSetup;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t DEFAULT_DESCRIPTOR_POOL_SETS = 64;   ///< Sets the first pool of a descriptor allocator can allocate
+    inline constexpr uint32_t MAX_DESCRIPTOR_POOL_SETS     = 4096; ///< Sets a pool of a descriptor allocator can allocate at most (pools double up to it)
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Amount of descriptors of a type a pool holds per set it can allocate
+     */
+    struct PoolSizeRatio {
+        VkDescriptorType type;  ///< Type of the descriptors
+        float            ratio; ///< Descriptors of the type per set
+    };
+
+
+    /**
+     * @brief Contents of a sampler create info a sampler cache compares (every field but the extension chain)
+     */
+    struct SamplerKey {
+        VkSamplerCreateInfo info; ///< Create info, without extension chain
+
+        bool operator==(const SamplerKey &o) const;
+    };
+
+
+    /**
+     * @brief Hashes every compared field of a sampler key
+     */
+    struct SamplerKeyHash {
+        size_t operator() (const SamplerKey &toHash) const;
+    };
+
+
+    /**
+     * @brief Contents of a descriptor set layout create info a layout cache compares
+     */
+    struct DescriptorLayoutKey {
+        VkDescriptorSetLayoutCreateFlags          flags;             ///< Flags of the layout
+        std::vector<VkDescriptorSetLayoutBinding> bindings;          ///< Bindings sorted by binding number, without immutable samplers
+        std::vector<VkDescriptorBindingFlags>     bindingFlags;      ///< Flags of each sorted binding (empty without binding flags)
+        std::vector<std::vector<VkSampler>>       immutableSamplers; ///< Immutable samplers of each sorted binding (empty for a binding without any)
+
+        bool operator==(const DescriptorLayoutKey &o) const;
+    };
+
+
+    /**
+     * @brief Hashes every compared field of a descriptor layout key
+     */
+    struct DescriptorLayoutKeyHash {
+        size_t operator() (const DescriptorLayoutKey &toHash) const;
+    };
+
+
+    /**
+     * @brief Allocates descriptor sets from a growable chain of pools
+     *
+     * When the current pool runs out of memory, it is retired and allocation retries from a new (or previously reset)
+     * pool, each new pool able to hold twice as many sets as the previous one. Resetting the allocator resets every
+     * pool at once : an allocator owned by a frame slot and reset after the slot's fence has been waited on gives
+     * transient, per-frame sets.
+     */
+    class DescriptorAllocator {
+        private:
+            VkDevice device; ///< Logical device the pools have been created with
+
+            std::vector<PoolSizeRatio> ratios;      ///< Descriptors per set of every pool
+            uint32_t                   setsPerPool; ///< Sets the next created pool can allocate
+
+            VkDescriptorPool              currentPool; ///< Pool sets are allocated from (VK_NULL_HANDLE before the first allocation)
+            std::vector<VkDescriptorPool> fullPools;   ///< Pools that ran out of memory since the last reset
+            std::vector<VkDescriptorPool> freePools;   ///< Reset pools, reused before creating new ones
+
+            /**
+             * @brief Gets an empty pool, reusing a reset one if any
+             *
+             * @return VkDescriptorPool The empty pool
+             */
+            VkDescriptorPool grab_pool();
+
+        public:
+            /**
+             * @brief Creates an allocator without any pool, pools being created by allocations
+             *
+             * @param setup A setup containing at least a logical device
+             * @param poolRatios Descriptors per set of every pool (the engine's usual sets if empty)
+             * @param initialSets Sets the first pool can allocate
+             */
+            DescriptorAllocator(const InstanceSetup &setup, const std::vector<PoolSizeRatio> &poolRatios = {}, uint32_t initialSets = DEFAULT_DESCRIPTOR_POOL_SETS);
+
+            DescriptorAllocator(const DescriptorAllocator &) = delete;
+            DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+            /**
+             * @brief Explicitely destroys every pool, freeing every set allocated from them
+             */
+            void destroy();
+
+            /**
+             * @brief Allocates a descriptor set, chaining a new pool if the current one is exhausted
+             *
+             * @param layout Layout of the set
+             * @return VkDescriptorSet The allocated set, valid until the next reset
+             */
+            VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+            /**
+             * @brief Frees every set at once, keeping the pools for next allocations
+             */
+            void reset();
+    };
+
+
+    /**
+     * @brief Deduplicates samplers by the contents of their create info
+     */
+    class SamplerCache {
+        private:
+            VkDevice device; ///< Logical device the samplers have been created with
+
+            std::unordered_map<SamplerKey, VkSampler, SamplerKeyHash> samplers; ///< Every created sampler
+
+        public:
+            /**
+             * @brief Creates an empty cache
+             *
+             * @param setup A setup containing at least a logical device
+             */
+            explicit SamplerCache(const InstanceSetup &setup);
+
+            SamplerCache(const SamplerCache &) = delete;
+            SamplerCache &operator=(const SamplerCache &) = delete;
+
+            /**
+             * @brief Explicitely destroys every cached sampler
+             */
+            void destroy();
+
+            /**
+             * @brief Gets a sampler matching a create info, creating it on first request
+             *
+             * @param createInfo Create info of the sampler, without extension chain
+             * @return VkSampler The cached sampler, owned by the cache
+             */
+            VkSampler get(const VkSamplerCreateInfo &createInfo);
+
+            /**
+             * @brief Gets the amount of distinct samplers
+             *
+             * @return size_t The amount of cached samplers
+             */
+            size_t size() const;
+    };
+
+
+    /**
+     * @brief Deduplicates descriptor set layouts by the contents of their create info
+     */
+    class DescriptorLayoutCache {
+        private:
+            VkDevice device; ///< Logical device the layouts have been created with
+
+            std::unordered_map<DescriptorLayoutKey, VkDescriptorSetLayout, DescriptorLayoutKeyHash> layouts; ///< Every created layout
+
+        public:
+            /**
+             * @brief Creates an empty cache
+             *
+             * @param setup A setup containing at least a logical device
+             */
+            explicit DescriptorLayoutCache(const InstanceSetup &setup);
+
+            DescriptorLayoutCache(const DescriptorLayoutCache &) = delete;
+            DescriptorLayoutCache &operator=(const DescriptorLayoutCache &) = delete;
+
+            /**
+             * @brief Explicitely destroys every cached layout
+             */
+            void destroy();
+
+            /**
+             * @brief Gets a layout matching a create info, creating it on first request (bindings may be in any order)
+             *
+             * @param createInfo Create info of the layout, optionally chaining binding flags
+             * @return VkDescriptorSetLayout The cached layout, owned by the cache
+             */
+            VkDescriptorSetLayout get(const VkDescriptorSetLayoutCreateInfo &createInfo);
+
+            /**
+             * @brief Gets the amount of distinct layouts
+             *
+             * @return size_t The amount of cached layouts
+             */
+            size_t size() const;
+    };
+}
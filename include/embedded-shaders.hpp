@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Variant of a shader compiled to SPIR-V at build time, embedded in the binary
+     */
+    struct EmbeddedShader {
+        const char                *filename;    ///< Filename of the shader's source, without directory
+        const char                *definitions; ///< Preprocessor definitions of the variant, as NAME=VALUE sorted by name and separated by commas
+        std::span<const uint32_t>  code;        ///< SPIR-V words of the variant
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Gets the SPIR-V of a shader variant embedded at build time (only without FHOPE_RUNTIME_SHADERS)
+     *
+     * @param filename Filename of the shader's source (it's directory is ignored)
+     * @param definitions Preprocessor macros the variant has been compiled with (name, value)
+     * @return std::span<const uint32_t> SPIR-V words of the variant, living as long as the program
+     * @throws std::runtime_error If the variant has not been embedded (see FHOPE_EMBED_SHADER in CMakeLists.txt)
+     */
+    std::span<const uint32_t> get_embedded_shader(const std::string &filename, const std::map<std::string, std::string> &definitions = {});
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fhope::bench {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t DEFAULT_SAMPLES = 15;               ///< Default amount of timed samples per benchmark
+    inline constexpr double   DEFAULT_SAMPLE_MILLISECONDS = 20.0; ///< Minimum duration of a sample, the body is repeated until it is reached
+    inline constexpr double   DEFAULT_THRESHOLD_PERCENT = 10.0;   ///< Default median slowdown above which a benchmark is reported as regressed
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Named micro-benchmark
+     */
+    struct Benchmark {
+        std::string name; ///< Unique name of the benchmark ("group/case")
+
+        std::function<uint64_t()> body; ///< Runs the measured code once, returns the amount of operations it performed (timings are per operation)
+    };
+
+
+    /**
+     * @brief Timings of a benchmark, per operation
+     */
+    struct BenchmarkResult {
+        std::string name;       ///< Name of the benchmark
+        uint64_t    operations; ///< Amount of operations timed over every sample
+
+        double medianNanoseconds; ///< Median of the samples
+        double meanNanoseconds;   ///< Mean of the samples
+        double minNanoseconds;    ///< Fastest sample
+        double maxNanoseconds;    ///< Slowest sample
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Runs a benchmark : one warmup run, then samples of repeated runs lasting at least sampleMilliseconds each
+     *
+     * @param benchmark The benchmark to run
+     * @param samples Amount of timed samples
+     * @param sampleMilliseconds Minimum duration of a sample
+     * @return BenchmarkResult The timings of the benchmark
+     */
+    BenchmarkResult run_benchmark(const Benchmark &benchmark, uint32_t samples = DEFAULT_SAMPLES, double sampleMilliseconds = DEFAULT_SAMPLE_MILLISECONDS);
+
+    /**
+     * @brief Serializes results as a JSON document (one benchmark per line)
+     *
+     * @param results The results to serialize
+     * @return std::string The JSON document
+     */
+    std::string results_to_json(const std::vector<BenchmarkResult> &results);
+
+    /**
+     * @brief Reads the median timings of a JSON document written by results_to_json
+     *
+     * @param filename Name of the JSON file to read
+     * @return std::map<std::string, double> Median nanoseconds per operation, by benchmark name
+     */
+    std::map<std::string, double> load_baseline(const std::string &filename);
+
+    /**
+     * @brief Prints how results moved relatively to a baseline
+     *
+     * @param results The current results
+     * @param baseline Median timings of the baseline, by benchmark name
+     * @param thresholdPercent Median slowdown above which a benchmark is reported as regressed
+     * @return true If no benchmark regressed
+     * @return false If at least one benchmark regressed
+     */
+    bool compare_to_baseline(const std::vector<BenchmarkResult> &results, const std::map<std::string, double> &baseline, double thresholdPercent);
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <chrono>
+
+#include <glad/vulkan.h>
+
+#include "render-graph.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+    struct RenderConfig;
+    class GpuProfiler;
+    class GpuCulling;
+    class JobSystem;
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Raw handles the drawing hot path needs, validated once when the context is created
+     *
+     * Unlike InstanceSetup, nothing here is optional : if a context exists, every handle in it is valid.
+     * Swap chain dependant handles are refreshed by recreating the context along the swap chain.
+     */
+    struct DeviceContext {
+        VkDevice       device;        ///< Logical device
+        VkQueue        graphicsQueue; ///< Queue frames are submitted (and presented) to
+        VkSwapchainKHR swapChain;     ///< Swap chain frames are presented to (VK_NULL_HANDLE in headless mode)
+        VkExtent2D     extent;        ///< Extent of the swap chain's images
+
+        VkPipeline       pipeline;       ///< Drawing graphics pipeline
+        VkPipelineLayout pipelineLayout; ///< Layout of the drawing graphics pipeline
+        VkDescriptorSet  textureSet;     ///< Bindless texture array, bound once for every frame (VK_NULL_HANDLE without bindless textures)
+
+        RenderGraph  *graph;       ///< Frame graph the frame is drawn with (owns the render pass and the framebuffers)
+        GraphResource target;      ///< Graph resource the swap chain images are imported as
+        GraphPassId   forwardPass; ///< Graph pass the draws are recorded in
+        VkRenderPass  renderPass;  ///< Render pass of the forward pass, inherited by secondary command buffers
+    };
+
+
+    /**
+     * @brief Command recording resources owned by a single recording thread for a single in-flight frame
+     */
+    struct ThreadContext {
+        VkCommandPool   pool;      ///< Command pool only this thread records from, reset as a whole every frame
+        VkCommandBuffer secondary; ///< Secondary command buffer the thread records it's share of draws in
+    };
+
+
+    /**
+     * @brief Raw per in-flight frame resources, validated once when the context is created
+     */
+    struct FrameContext {
+        uint32_t        index;          ///< Index of the frame slot
+        VkCommandBuffer primary;        ///< Primary command buffer submitted for the frame
+        VkSemaphore     imageAvailable; ///< Signaled when the acquired swap chain image is ready
+        VkSemaphore     renderFinished; ///< Signaled when the frame has been rendered
+        VkFence         inFlight;       ///< Signaled when the frame's submission has completed
+        VkDescriptorSet descriptorSet;  ///< Descriptor set bound for the frame's draws
+
+        void        *uniformMapping;              ///< Persistent mapping of the frame's uniform buffer
+        VkDeviceSize uniformSize;                 ///< Size of the frame's uniform buffer, in bytes
+        uint64_t     uniformVersion = UINT64_MAX; ///< Version of the MVP last written to the frame's uniform buffer
+
+        std::vector<ThreadContext> threads; ///< Per-thread recording resources (empty when recording inline)
+
+        std::optional<std::chrono::steady_clock::time_point> inputSampleTime; ///< When the input of the frame's pending submission has been sampled
+
+        std::vector<VkCommandBuffer> cachedPrimaries; ///< Reusable primary command buffers, 1 per swap chain image (cached recording only)
+        std::vector<uint64_t>        cachedVersions;  ///< Scene version each cached primary command buffer has been recorded at
+    };
+
+
+    /**
+     * @brief Rolling statistics of the latency between input sampling and the completion of the frame it drove
+     *
+     * Completion is observed when the frame's fence is waited on, which makes every sample an upper bound.
+     * Scanout time after presentation is not observable without presentation timing extensions.
+     */
+    struct LatencyStats {
+        double   lastMilliseconds    = 0.0; ///< Latency of the last completed frame
+        double   averageMilliseconds = 0.0; ///< Exponential moving average of the latency
+        double   maxMilliseconds     = 0.0; ///< Highest latency measured
+        uint64_t sampleCount         = 0;   ///< Amount of measured frames
+    };
+
+
+    /**
+     * @brief Single indexed draw of a draw list
+     */
+    struct DrawItem {
+        VkBuffer vertexBuffer;      ///< Vertex buffer to draw from
+        VkBuffer indexBuffer;       ///< Index buffer to draw from
+        uint32_t indexCount;        ///< Number of indices to draw
+        uint32_t firstIndex    = 0; ///< First index to draw in the index buffer
+        int32_t  vertexOffset  = 0; ///< Value added to every index
+        uint32_t instanceCount = 1; ///< Number of instances to draw
+        uint32_t firstInstance = 0; ///< First instance to draw (gl_InstanceIndex starts from it)
+    };
+
+
+    /**
+     * @brief Records a draw list in parallel on a job system, each slice in it's own secondary command buffer
+     */
+    class ParallelRecorder {
+        private:
+            JobSystem *jobs;       ///< Job system the slices are recorded on
+            uint32_t   sliceCount; ///< Amount of slices the draw list is partitioned in (1 per recording thread context)
+
+        public:
+            /**
+             * @brief Creates a recorder partitioning draw lists in a given amount of slices
+             *
+             * @param jobs Job system to record on, outliving the recorder
+             * @param sliceCount Amount of slices (at least 1), which must match the thread contexts of the frames
+             */
+            ParallelRecorder(JobSystem *jobs, uint32_t sliceCount);
+
+            ParallelRecorder(const ParallelRecorder &) = delete;
+            ParallelRecorder &operator=(const ParallelRecorder &) = delete;
+
+            /**
+             * @brief Gets the amount of slices draw lists are partitioned in
+             *
+             * @return uint32_t The amount of slices
+             */
+            uint32_t get_thread_count() const;
+
+            /**
+             * @brief Partitions a draw list in slices, recorded as jobs in their own secondary command buffer (the calling thread helps)
+             *
+             * @param device The device context to record with
+             * @param frame The frame context owning the slices' command pools (one per slice)
+             * @param drawItems The draw list to record
+             * @return std::vector<VkCommandBuffer> The recorded secondary command buffers, in draw list order
+             */
+            std::vector<VkCommandBuffer> record(const DeviceContext &device, FrameContext *frame, const std::vector<DrawItem> &drawItems);
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Gets the amount of recording threads a render config asks for
+     *
+     * @param config The render config
+     * @return uint32_t The configured amount of threads, or the amount of hardware threads if it is 0
+     */
+    uint32_t get_recording_thread_count(const RenderConfig &config);
+
+    /**
+     * @brief Validates and gathers the raw handles the drawing hot path needs
+     *
+     * @param setup A setup containing at least a logical device, a graphics queue, a swap chain (and it's config), a frame graph and a graphics pipeline
+     * @return DeviceContext The created device context
+     */
+    DeviceContext create_device_context(const InstanceSetup &setup);
+
+    /**
+     * @brief Validates and gathers per in-flight frame resources, and creates per-thread command pools for parallel recording
+     *
+     * @param setup A setup containing at least a logical device, queues, command buffers, sync objects, descriptor sets and mapped uniform buffers
+     * @return std::vector<FrameContext> The created frame contexts (1 per in-flight frame)
+     */
+    std::vector<FrameContext> create_frame_contexts(const InstanceSetup &setup);
+
+    /**
+     * @brief (Re)allocates the cached primary command buffers of frame contexts, 1 per swap chain image, all marked as outdated
+     *
+     * @param setup A setup containing at least a logical device, command pools and swap chain images
+     * @param frames The frame contexts to allocate cached command buffers for
+     */
+    void allocate_cached_command_buffers(const InstanceSetup &setup, std::vector<FrameContext> *frames);
+
+    /**
+     * @brief Destroys the per-thread command pools of frame contexts
+     *
+     * @param device The logical device the pools have been created with
+     * @param frames The frame contexts to clean
+     */
+    void destroy_frame_contexts(const VkDevice &device, const std::vector<FrameContext> &frames);
+
+    /**
+     * @brief Adds the latency of a frame context's completed submission to rolling statistics, if it has not been measured yet
+     *
+     * @param stats The statistics to update
+     * @param frame A frame context whose fence has just been waited on
+     */
+    void measure_frame_latency(LatencyStats *stats, FrameContext *frame);
+
+    /**
+     * @brief Records a frame's graph in a primary command buffer, it's forward pass' draws either inline, from secondary command buffers recorded in parallel, or indirectly after a GPU cull pass
+     *
+     * @param device The device context to record with
+     * @param frame The frame context to record
+     * @param commandBuffer The primary command buffer to record in
+     * @param imageIndex Index of the swap chain image to draw to
+     * @param drawItems The draw list to record
+     * @param recorder The parallel recorder to use, or nullptr to record inline
+     * @param profiler The GPU profiler to record zones with, or nullptr
+     * @param culling The GPU culling drawing in place of the draw list (the recorder is then ignored), or nullptr
+     */
+    void record_frame(const DeviceContext &device, FrameContext *frame, VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<DrawItem> &drawItems, ParallelRecorder *recorder, GpuProfiler *profiler, GpuCulling *culling);
+
+    /**
+     * @brief Records a slice of a draw list : binds the pipeline, dynamic states and descriptors, then draws every item
+     *
+     * @param device The device context to record with
+     * @param frame The frame context whose descriptor set is bound
+     * @param commandBuffer The (primary or secondary) command buffer to record in, inside a render pass
+     * @param first First item to draw
+     * @param last Item after the last item to draw
+     */
+    void record_draw_items(const DeviceContext &device, const FrameContext &frame, VkCommandBuffer commandBuffer, const DrawItem *first, const DrawItem *last);
+}
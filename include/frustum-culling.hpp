@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace fhope {
+    struct MVP;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    /// Objects tested per iteration by cull_spheres and cull_aabbs (8 with AVX2, 4 with SSE, 1 otherwise)
+#if defined(__AVX2__)
+    inline constexpr uint32_t CULLING_LANES = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    inline constexpr uint32_t CULLING_LANES = 4;
+#else
+    inline constexpr uint32_t CULLING_LANES = 1;
+#endif
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Six planes bounding the visible volume, in world space
+     *
+     * Each plane is (normal, distance) with a normalized normal pointing inside : a point p is inside when dot(normal, p) + distance >= 0.
+     */
+    struct Frustum {
+        std::array<glm::vec4, 6> planes; ///< Left, right, bottom, top, near and far planes
+    };
+
+
+    /**
+     * @brief Bounding spheres stored as structure of arrays, so that several spheres are tested at once
+     */
+    struct SphereSoA {
+        std::vector<float> centerX; ///< X coordinate of every center
+        std::vector<float> centerY; ///< Y coordinate of every center
+        std::vector<float> centerZ; ///< Z coordinate of every center
+        std::vector<float> radius;  ///< Radius of every sphere
+
+        /**
+         * @brief Appends a sphere
+         *
+         * @param sphere Center (xyz) and radius (w) of the sphere
+         */
+        void push_back(const glm::vec4 &sphere);
+
+        /**
+         * @brief Gets the amount of spheres
+         *
+         * @return size_t The amount of spheres
+         */
+        size_t size() const;
+    };
+
+
+    /**
+     * @brief Axis-aligned bounding boxes stored as structure of arrays (center and half extent), so that several boxes are tested at once
+     */
+    struct AabbSoA {
+        std::vector<float> centerX; ///< X coordinate of every center
+        std::vector<float> centerY; ///< Y coordinate of every center
+        std::vector<float> centerZ; ///< Z coordinate of every center
+        std::vector<float> extentX; ///< Half extent of every box along X
+        std::vector<float> extentY; ///< Half extent of every box along Y
+        std::vector<float> extentZ; ///< Half extent of every box along Z
+
+        /**
+         * @brief Appends a box from it's corners
+         *
+         * @param minimum Lowest corner of the box
+         * @param maximum Highest corner of the box
+         */
+        void push_back(const glm::vec3 &minimum, const glm::vec3 &maximum);
+
+        /**
+         * @brief Gets the amount of boxes
+         *
+         * @return size_t The amount of boxes
+         */
+        size_t size() const;
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Extracts the planes of the volume a view-projection matrix maps to clip space (Gribb-Hartmann)
+     *
+     * The near plane is taken at z = -w, which is exact for [-1, 1] depth and conservative for [0, 1] depth.
+     *
+     * @param viewProjection Projection matrix multiplied by the view matrix
+     * @return Frustum The normalized world-space planes
+     */
+    Frustum extract_frustum(const glm::mat4 &viewProjection);
+
+    /**
+     * @brief Extracts the world-space frustum of an MVP's view and projection (the model matrix is ignored)
+     *
+     * @param mvp The MVP whose camera is used
+     * @return Frustum The normalized world-space planes
+     */
+    Frustum extract_frustum(const MVP &mvp);
+
+    /**
+     * @brief Tests every sphere against a frustum, CULLING_LANES spheres per iteration
+     *
+     * @param frustum The frustum to test against
+     * @param spheres The spheres to test
+     * @param visible Receives the indices of spheres intersecting the frustum, in increasing order (resized, capacity is kept)
+     * @return size_t The amount of visible spheres
+     */
+    size_t cull_spheres(const Frustum &frustum, const SphereSoA &spheres, std::vector<uint32_t> *visible);
+
+    /**
+     * @brief Tests every box against a frustum, CULLING_LANES boxes per iteration
+     *
+     * @param frustum The frustum to test against
+     * @param boxes The boxes to test
+     * @param visible Receives the indices of boxes intersecting the frustum, in increasing order (resized, capacity is kept)
+     * @return size_t The amount of visible boxes
+     */
+    size_t cull_aabbs(const Frustum &frustum, const AabbSoA &boxes, std::vector<uint32_t> *visible);
+
+    /**
+     * @brief Tests every sphere against a frustum one at a time (reference for cull_spheres)
+     *
+     * @param frustum The frustum to test against
+     * @param spheres The spheres to test
+     * @param visible Receives the indices of spheres intersecting the frustum, in increasing order (resized, capacity is kept)
+     * @return size_t The amount of visible spheres
+     */
+    size_t cull_spheres_scalar(const Frustum &frustum, const SphereSoA &spheres, std::vector<uint32_t> *visible);
+
+    /**
+     * @brief Tests every box against a frustum one at a time (reference for cull_aabbs)
+     *
+     * @param frustum The frustum to test against
+     * @param boxes The boxes to test
+     * @param visible Receives the indices of boxes intersecting the frustum, in increasing order (resized, capacity is kept)
+     * @return size_t The amount of visible boxes
+     */
+    size_t cull_aabbs_scalar(const Frustum &frustum, const AabbSoA &boxes, std::vector<uint32_t> *visible);
+}
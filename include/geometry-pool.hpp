@@ -0,0 +1,265 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "frame-context.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+    struct Vertex3D;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t DEFAULT_POOL_VERTEX_CAPACITY = 1 << 20; ///< Vertices a block of the geometry pool can hold
+    inline constexpr uint32_t DEFAULT_POOL_INDEX_CAPACITY  = 1 << 22; ///< Indices a block of the geometry pool can hold
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    using MeshHandle = uint32_t; ///< Identifier of a mesh in a geometry pool
+
+    /**
+     * @brief Location of a mesh in a geometry pool
+     */
+    struct MeshRange {
+        uint32_t  block;          ///< Block whose buffers hold the mesh
+        uint32_t  firstIndex;     ///< First index of the mesh in the block's index buffer
+        uint32_t  indexCount;     ///< Number of indices of the mesh
+        int32_t   vertexOffset;   ///< First vertex of the mesh in the block's vertex buffer, added to every index
+        uint32_t  vertexCount;    ///< Number of vertices of the mesh
+        glm::vec4 boundingSphere; ///< Model-space center (xyz) and radius (w) of the mesh
+    };
+
+
+    /**
+     * @brief Mesh staged for an upload to a geometry pool, whose copy is recorded by the caller
+     */
+    struct MeshUpload {
+        VkBuffer       staging        = VK_NULL_HANDLE; ///< Host-visible buffer holding the vertices, then the indices
+        VkDeviceMemory stagingMemory  = VK_NULL_HANDLE; ///< Memory of the staging buffer
+        uint32_t       vertexCount    = 0;              ///< Number of vertices of the mesh
+        uint32_t       indexCount     = 0;              ///< Number of indices of the mesh
+        glm::vec4      boundingSphere;                  ///< Model-space center (xyz) and radius (w) of the mesh
+        MeshHandle     mesh           = 0;              ///< Handle of the mesh, once allocated (not drawable before the copy completes)
+        VkBuffer       vertexBuffer   = VK_NULL_HANDLE; ///< Vertex buffer of the mesh's block, once allocated
+        VkBuffer       indexBuffer    = VK_NULL_HANDLE; ///< Index buffer of the mesh's block, once allocated
+        VkBufferCopy   vertexCopy{};                    ///< Copy of the vertices from the staging buffer, once allocated
+        VkBufferCopy   indexCopy{};                     ///< Copy of the indices from the staging buffer, once allocated
+    };
+
+
+    /**
+     * @brief Meshes sub-allocated in a few large device-local vertex and index buffers
+     *
+     * Meshes are placed in the first block with room for both their vertices and indices, and are described by their
+     * firstIndex and vertexOffset only : draws of meshes sharing a block bind the buffers once. A new block is created
+     * when no block has room left (sized for the mesh if it is larger than a default block). Ranges of removed meshes
+     * are coalesced and reused first-fit by next additions, blocks themselves are only released with the whole pool.
+     */
+    class GeometryPool {
+        private:
+            /**
+             * @brief Range of free elements (vertices or indices) below the end of a block's allocated elements
+             */
+            struct FreeRange {
+                uint32_t offset; ///< First free element
+                uint32_t count;  ///< Amount of free elements
+            };
+
+
+            /**
+             * @brief Vertex and index buffers of a block
+             */
+            struct Block {
+                VkBuffer               vertexBuffer   = VK_NULL_HANDLE; ///< Device-local vertex buffer
+                VkDeviceMemory         vertexMemory   = VK_NULL_HANDLE; ///< Memory of the vertex buffer
+                VkBuffer               indexBuffer    = VK_NULL_HANDLE; ///< Device-local index buffer
+                VkDeviceMemory         indexMemory    = VK_NULL_HANDLE; ///< Memory of the index buffer
+                uint32_t               vertexCapacity = 0;              ///< Amount of vertices the block can hold
+                uint32_t               indexCapacity  = 0;              ///< Amount of indices the block can hold
+                uint32_t               vertexCount    = 0;              ///< End of the allocated vertices
+                uint32_t               indexCount     = 0;              ///< End of the allocated indices
+                std::vector<FreeRange> freeVertices;                    ///< Free vertex ranges below vertexCount, sorted by offset
+                std::vector<FreeRange> freeIndices;                     ///< Free index ranges below indexCount, sorted by offset
+            };
+
+            VkDevice device; ///< Logical device the buffers have been created with
+
+            uint32_t vertexCapacity; ///< Vertices a default block can hold
+            uint32_t indexCapacity;  ///< Indices a default block can hold
+
+            std::vector<Block>      blocks;      ///< Every block, in creation order
+            std::vector<MeshRange>  meshes;      ///< Every mesh, indexed by handle (removed ones have no index)
+            std::vector<MeshHandle> freeHandles; ///< Handles of removed meshes, reused by next additions
+
+            /**
+             * @brief Checks wether or not a block's vertices or indices can hold a range
+             *
+             * @param freeRanges Free ranges of the elements
+             * @param end End of the allocated elements
+             * @param capacity Amount of elements the block can hold
+             * @param count Size of the range
+             * @return true If a free range or the end of the block has room for the range
+             * @return false If it does not fit
+             */
+            static bool fits(const std::vector<FreeRange> &freeRanges, uint32_t end, uint32_t capacity, uint32_t count);
+
+            /**
+             * @brief Allocates a range in a block's vertices or indices, in the first free range large enough or at the end
+             *
+             * @param freeRanges Free ranges of the elements
+             * @param end End of the allocated elements, moved if the range is allocated there
+             * @param count Size of the range, which fits
+             * @return uint32_t Offset of the range
+             */
+            static uint32_t allocate_range(std::vector<FreeRange> *freeRanges, uint32_t *end, uint32_t count);
+
+            /**
+             * @brief Frees a range of a block's vertices or indices, merging it with it's free neighbours
+             *
+             * @param freeRanges Free ranges of the elements
+             * @param end End of the allocated elements, moved back if the range was the last one
+             * @param offset Offset of the range
+             * @param count Size of the range
+             */
+            static void release_range(std::vector<FreeRange> *freeRanges, uint32_t *end, uint32_t offset, uint32_t count);
+
+            /**
+             * @brief Creates an empty block
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param vertices Amount of vertices the block must hold
+             * @param indices Amount of indices the block must hold
+             * @return Block The created block
+             */
+            Block create_block(const InstanceSetup &setup, uint32_t vertices, uint32_t indices) const;
+
+        public:
+            /**
+             * @brief Creates an empty pool, with a first block
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param vertexCapacity Vertices a default block can hold
+             * @param indexCapacity Indices a default block can hold
+             */
+            GeometryPool(const InstanceSetup &setup, uint32_t vertexCapacity = DEFAULT_POOL_VERTEX_CAPACITY, uint32_t indexCapacity = DEFAULT_POOL_INDEX_CAPACITY);
+
+            GeometryPool(const GeometryPool &) = delete;
+            GeometryPool &operator=(const GeometryPool &) = delete;
+
+            /**
+             * @brief Explicitely destroys every block
+             */
+            void destroy();
+
+            /**
+             * @brief Uploads a mesh in the pool, using a staging buffer
+             *
+             * @param setup A setup containing at least a logical device, a transfer command pool, and a transfer queue (and their requirements)
+             * @param vertices The vertices of the mesh
+             * @param indices The indices of the mesh, relative to it's first vertex
+             * @return MeshHandle Handle of the new mesh
+             */
+            MeshHandle add_mesh(const InstanceSetup &setup, const std::vector<Vertex3D> &vertices, const std::vector<uint32_t> &indices);
+
+            /**
+             * @brief Copies a mesh to a new staging buffer, without touching the pool (any thread)
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param vertices The vertices of the mesh
+             * @param indices The indices of the mesh, relative to it's first vertex
+             * @return MeshUpload The staged mesh, to allocate then record
+             */
+            static MeshUpload stage_mesh(const InstanceSetup &setup, const std::vector<Vertex3D> &vertices, const std::vector<uint32_t> &indices);
+
+            /**
+             * @brief Allocates a staged mesh's ranges and handle in the pool, and computes it's copies
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (in case a block is created)
+             * @param upload The staged mesh, receiving it's handle, destination buffers and copies
+             */
+            void allocate_mesh(const InstanceSetup &setup, MeshUpload *upload);
+
+            /**
+             * @brief Records the copies of an allocated mesh to it's block, making them visible to every later read
+             *
+             * @param setup A setup containing at least a logical device (and it's requirements)
+             * @param commandBuffer The command buffer to record in
+             * @param upload The allocated mesh
+             */
+            static void record_mesh_upload(const InstanceSetup &setup, VkCommandBuffer commandBuffer, const MeshUpload &upload);
+
+            /**
+             * @brief Destroys the staging buffer of an upload whose copies have completed (any thread)
+             *
+             * @param setup A setup containing at least a logical device (and it's requirements)
+             * @param upload The completed upload
+             */
+            static void destroy_mesh_staging(const InstanceSetup &setup, const MeshUpload &upload);
+
+            /**
+             * @brief Removes a mesh, it's ranges being reused by next additions
+             *
+             * The caller makes sure no pending command buffer draws it anymore (see DeletionQueue).
+             *
+             * @param handle Handle of the mesh
+             */
+            void remove_mesh(MeshHandle handle);
+
+            /**
+             * @brief Gets the location of a mesh
+             *
+             * @param handle Handle of the mesh
+             * @return const MeshRange& The block and ranges of the mesh
+             */
+            const MeshRange &get_mesh(MeshHandle handle) const;
+
+            /**
+             * @brief Makes the draw item of a mesh
+             *
+             * @param handle Handle of the mesh
+             * @param instanceCount Number of instances to draw
+             * @param firstInstance First instance to draw
+             * @return DrawItem A draw of the whole mesh, from it's block's buffers
+             */
+            DrawItem make_draw_item(MeshHandle handle, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+
+            /**
+             * @brief Gets the amount of blocks
+             *
+             * @return uint32_t The amount of blocks
+             */
+            uint32_t block_count() const;
+
+            /**
+             * @brief Gets the vertex buffer of a block
+             *
+             * @param block Index of the block
+             * @return VkBuffer The block's vertex buffer
+             */
+            VkBuffer get_vertex_buffer(uint32_t block) const;
+
+            /**
+             * @brief Gets the index buffer of a block
+             *
+             * @param block Index of the block
+             * @return VkBuffer The block's index buffer (32 bits indices)
+             */
+            VkBuffer get_index_buffer(uint32_t block) const;
+
+            /**
+             * @brief Binds a block's vertex and index buffers
+             *
+             * @param commandBuffer The command buffer to record in
+             * @param block Index of the block
+             */
+            void bind(VkCommandBuffer commandBuffer, uint32_t block) const;
+    };
+}
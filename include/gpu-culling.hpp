@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/vulkan.h>
+#include <glm/glm.hpp>
+
+namespace fhope {
+    struct InstanceSetup;
+    struct Vertex3D;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr const char *CULL_SHADER_FILENAME          = "shaders/cull.c.glsl";          ///< Compute shader culling objects into indirect draws
+    inline constexpr const char *DEPTH_RESOLVE_SHADER_FILENAME = "shaders/depth-resolve.c.glsl"; ///< Compute shader writing the depth pyramid's first level from the depth buffer
+    inline constexpr const char *DEPTH_REDUCE_SHADER_FILENAME  = "shaders/depth-reduce.c.glsl";  ///< Compute shader writing a depth pyramid level from the previous one
+
+    inline constexpr uint32_t DEFAULT_OBJECT_CAPACITY = 1024; ///< Objects the culling buffers can hold before they grow
+    inline constexpr uint32_t CULL_WORKGROUP_SIZE = 64;       ///< Objects culled per workgroup (local_size_x of the cull shader)
+    inline constexpr uint32_t PYRAMID_WORKGROUP_SIZE = 8;     ///< Width and height of the depth pyramid shaders' workgroups
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Entry of the object table read by the cull shader : an instance of a mesh range (std430 layout)
+     */
+    struct GpuObject {
+        glm::vec4 boundingSphere; ///< Model-space center (xyz) and radius (w) of the mesh range
+        uint32_t  indexCount;     ///< Number of indices of the mesh range
+        uint32_t  firstIndex;     ///< First index of the mesh range in the index buffer
+        int32_t   vertexOffset;   ///< Value added to every index of the mesh range
+        uint32_t  instance;       ///< Index of the object's transform in the instance buffer
+    };
+
+
+    /**
+     * @brief GPU-driven culling : a compute pass turns the object table into indirect draws, drawn with a constant amount of commands
+     *
+     * Every frame, the cull shader tests each object against the view frustum and against the depth pyramid (hierarchical
+     * max-depth mips) built from the previous frame's depth buffer, and writes a VkDrawIndexedIndirectCommand per visible
+     * object. With drawIndirectCount, visible draws are compacted and their count is read by vkCmdDrawIndexedIndirectCount.
+     * Otherwise, every object keeps it's own command and culled ones draw zero instance through a single multi-draw.
+     *
+     * The object table and the draw buffers are owned per frame slot, like instance buffers. The depth pyramid is shared :
+     * every frame reads it before rebuilding it, in submission order.
+     */
+    class GpuCulling {
+        private:
+            /**
+             * @brief Buffers of a frame slot
+             */
+            struct FrameBuffers {
+                VkBuffer       objects       = VK_NULL_HANDLE; ///< Object table, host visible
+                VkDeviceMemory objectsMemory = VK_NULL_HANDLE; ///< Memory of the object table
+                void          *mapping       = nullptr;        ///< Persistent mapping of the object table
+
+                VkBuffer       draws        = VK_NULL_HANDLE; ///< Indirect draw commands written by the cull shader
+                VkDeviceMemory drawsMemory  = VK_NULL_HANDLE; ///< Memory of the draw commands
+                VkBuffer       count        = VK_NULL_HANDLE; ///< Amount of compacted draw commands
+                VkDeviceMemory countMemory  = VK_NULL_HANDLE; ///< Memory of the draw count
+
+                uint32_t capacity    = 0; ///< Amount of objects the buffers can hold
+                uint32_t objectCount = 0; ///< Amount of objects last uploaded to the buffers
+                uint64_t version     = 0; ///< Version of the object table last uploaded to the buffers
+
+                VkDescriptorSet descriptorSet = VK_NULL_HANDLE; ///< Descriptor set of the cull shader
+            };
+
+            /**
+             * @brief Depth pyramid, rebuilt after every frame's render pass
+             */
+            struct DepthPyramid {
+                VkImage                  image  = VK_NULL_HANDLE; ///< R32 image, every mip holding the farthest depth of the 2x2 texels below it
+                VkDeviceMemory           memory = VK_NULL_HANDLE; ///< Memory of the image
+                VkImageView              view   = VK_NULL_HANDLE; ///< View to every mip, sampled by the cull shader
+                std::vector<VkImageView> levelViews;              ///< View to each single mip, written (and read by the next level)
+                VkExtent2D               extent = {0, 0};         ///< Extent of the first mip (largest power of 2 fitting in the depth buffer)
+
+                VkDescriptorPool             descriptorPool = VK_NULL_HANDLE; ///< Pool of the pyramid shaders' descriptor sets
+                VkDescriptorSet              resolveSet     = VK_NULL_HANDLE; ///< Descriptor set writing the first mip from the depth buffer
+                std::vector<VkDescriptorSet> reduceSets;                      ///< Descriptor sets writing each next mip
+            };
+
+            VkDevice device;            ///< Logical device the resources have been created with
+            bool     synchronization2;  ///< Wether or not barriers may use vkCmdPipelineBarrier2KHR
+            bool     drawIndirectCount; ///< Wether or not draws are compacted and drawn with vkCmdDrawIndexedIndirectCount
+            bool     multiDrawIndirect; ///< Wether or not a single indirect draw call may draw several commands
+
+            VkBuffer vertexBuffer; ///< Vertex buffer every object is drawn from
+            VkBuffer indexBuffer;  ///< Index buffer every object is drawn from
+
+            std::vector<GpuObject>    objects; ///< Object table
+            uint64_t                  version; ///< Incremented on every change of the object table
+            std::vector<FrameBuffers> frames;  ///< Buffers of every frame slot
+
+            VkDescriptorSetLayout cullSetLayout;    ///< Layout of the cull shader's descriptor sets
+            VkDescriptorSetLayout pyramidSetLayout; ///< Layout of the pyramid shaders' descriptor sets (sampled source, storage destination)
+            VkDescriptorPool      descriptorPool;   ///< Pool of the cull shader's descriptor sets
+            VkSampler             pyramidSampler;   ///< Nearest sampler the pyramid is read with
+
+            VkPipelineLayout cullLayout;      ///< Layout of the cull pipeline
+            VkPipeline       cullPipeline;    ///< Cull pipeline
+            VkPipelineLayout pyramidLayout;   ///< Layout of both pyramid pipelines
+            VkPipeline       resolvePipeline; ///< Pipeline writing the first mip from the depth buffer
+            VkPipeline       reducePipeline;  ///< Pipeline writing the next mips
+
+            DepthPyramid            pyramid;          ///< Depth pyramid
+            VkImage                 depthImage;       ///< Depth buffer the pyramid is built from
+            VkImageSubresourceRange depthRange;       ///< Every aspect of the depth buffer
+            VkExtent2D              depthExtent;      ///< Extent of the depth buffer
+            uint32_t                depthSampleCount; ///< Amount of samples per texel of the depth buffer
+
+            /**
+             * @brief Creates a frame slot's buffers
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param capacity Amount of objects the buffers must hold
+             * @return FrameBuffers The created and mapped buffers, without descriptor set
+             */
+            FrameBuffers create_frame_buffers(const InstanceSetup &setup, uint32_t capacity) const;
+
+            /**
+             * @brief Destroys a frame slot's buffers (the descriptor set is kept)
+             *
+             * @param buffers The buffers to destroy
+             */
+            void destroy_frame_buffers(FrameBuffers *buffers) const;
+
+            /**
+             * @brief Writes the object table, draw and count bindings of a frame slot's descriptor set
+             *
+             * @param buffers The frame slot's buffers
+             */
+            void write_buffer_descriptors(const FrameBuffers &buffers) const;
+
+            /**
+             * @brief Creates the depth pyramid matching the setup's depth buffer, cleared to the far plane
+             *
+             * @param setup A setup containing at least a logical device, a depth buffer, a swap chain config, command pools and a graphics queue
+             */
+            void create_pyramid(const InstanceSetup &setup);
+
+            /**
+             * @brief Destroys the depth pyramid and it's descriptor sets
+             */
+            void destroy_pyramid();
+
+        public:
+            /**
+             * @brief Creates the culling pipelines, the depth pyramid and the buffers of every frame slot, without any object
+             *
+             * @param setup A setup containing at least a logical device, a depth buffer, uniform buffers, an instance buffer, command pools and a graphics queue
+             * @param frameCount Amount of frame slots (frames in flight)
+             * @param vertexBuffer Vertex buffer every object is drawn from
+             * @param indexBuffer Index buffer every object is drawn from
+             * @param initialCapacity Amount of objects each slot's buffers can hold before growing
+             */
+            GpuCulling(const InstanceSetup &setup, uint32_t frameCount, VkBuffer vertexBuffer, VkBuffer indexBuffer, uint32_t initialCapacity = DEFAULT_OBJECT_CAPACITY);
+
+            GpuCulling(const GpuCulling &) = delete;
+            GpuCulling &operator=(const GpuCulling &) = delete;
+
+            /**
+             * @brief Explicitely destroys every vulkan object
+             */
+            void destroy();
+
+            /**
+             * @brief Replaces the object table, used from the next upload on
+             *
+             * @param newObjects The new object table
+             */
+            void set_objects(std::vector<GpuObject> newObjects);
+
+            /**
+             * @brief Gets the amount of objects
+             *
+             * @return uint32_t The amount of objects in the table
+             */
+            uint32_t size() const;
+
+            /**
+             * @brief Checks wether or not visible draws are compacted and drawn with vkCmdDrawIndexedIndirectCount
+             *
+             * @return true If the device supports drawIndirectCount
+             * @return false If culled objects are drawn with zero instance instead
+             */
+            bool uses_draw_indirect_count() const;
+
+            /**
+             * @brief Uploads the object table to a frame slot's buffers if it changed since it was last uploaded, growing them if needed
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param frameIndex The frame slot whose fence has just been waited on
+             * @return true If the table has been uploaded : the object count and draw buffers are baked in recorded command buffers, which must be recorded again
+             * @return false If the slot was already up to date
+             */
+            bool upload(const InstanceSetup &setup, uint32_t frameIndex);
+
+            /**
+             * @brief Rebinds a frame slot's instance buffer, after it has been recreated
+             *
+             * @param frameIndex The frame slot
+             * @param instances The new instance buffer of the slot
+             */
+            void rebind_instances(uint32_t frameIndex, const VkDescriptorBufferInfo &instances);
+
+            /**
+             * @brief Recreates the depth pyramid along the depth buffer (after the swap chain has been recreated)
+             *
+             * @param setup A setup containing at least a logical device, a depth buffer, a swap chain config, command pools and a graphics queue
+             */
+            void resize(const InstanceSetup &setup);
+
+            /**
+             * @brief Records the cull pass, outside of any render pass
+             *
+             * @param commandBuffer The command buffer to record in
+             * @param frameIndex The frame slot whose buffers are written
+             */
+            void record_cull(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+            /**
+             * @brief Records the indirect draws written by the cull pass, inside the render pass (pipeline and descriptors must be bound)
+             *
+             * @param commandBuffer The command buffer to record in
+             * @param frameIndex The frame slot whose draw buffers are read
+             */
+            void record_draws(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+            /**
+             * @brief Records the depth pyramid's rebuild from the depth buffer, after the render pass
+             *
+             * @param commandBuffer The command buffer to record in
+             */
+            void record_depth_pyramid(VkCommandBuffer commandBuffer) const;
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Computes a sphere bounding every vertex of a mesh (centered on their axis-aligned bounding box)
+     *
+     * @param vertices The vertices of the mesh
+     * @return glm::vec4 The center (xyz) and radius (w) of the sphere
+     */
+    glm::vec4 compute_bounding_sphere(const std::vector<Vertex3D> &vertices);
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <glad/vulkan.h>
+
+namespace fhope {
+    struct InstanceSetup;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t GPU_PROFILER_HISTORY = 120; ///< Amount of frames GPU zone statistics are averaged over
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Timing statistics of a GPU zone, over the last GPU_PROFILER_HISTORY frames it has been measured in
+     */
+    struct GpuZoneStats {
+        std::string path;  ///< Names of the zone and it's parents, separated by '/'
+        uint32_t    depth; ///< Nesting depth of the zone (0 for root zones)
+
+        double   lastMilliseconds;    ///< Duration of the zone in the last measured frame
+        double   averageMilliseconds; ///< Average duration of the zone
+        double   minMilliseconds;     ///< Shortest duration of the zone
+        double   maxMilliseconds;     ///< Longest duration of the zone
+        uint64_t sampleCount;         ///< Amount of frames the zone has been measured in since the profiler was created
+    };
+
+
+    /**
+     * @brief Scoped GPU profiler based on timestamp queries
+     *
+     * Every frame slot owns it's own query pool. Zones recorded in a slot are read back the next time the slot's fence
+     * has been waited on, without ever waiting on query results, and converted to milliseconds with the device's
+     * timestamp period. Zones nest : a zone begun while another one is open becomes it's child.
+     */
+    class GpuProfiler {
+        private:
+            /**
+             * @brief Zone recorded in a frame slot's command buffer
+             */
+            struct RecordedZone {
+                std::string path;       ///< Names of the zone and it's parents
+                uint32_t    depth;      ///< Nesting depth of the zone
+                uint32_t    beginQuery; ///< Query written when the zone begins
+                uint32_t    endQuery;   ///< Query written when the zone ends
+            };
+
+            /**
+             * @brief Queries and zones of a frame slot
+             */
+            struct FrameQueries {
+                VkQueryPool               pool = VK_NULL_HANDLE; ///< Timestamp query pool of the slot
+                uint32_t                  usedQueries = 0;       ///< Amount of queries written by the last recording
+                std::vector<RecordedZone> zones;                 ///< Zones of the last recording
+                bool                      submitted = false;     ///< Wether the last recording has been submitted since it's last read back
+            };
+
+            /**
+             * @brief History of a zone's durations
+             */
+            struct ZoneHistory {
+                uint32_t            depth = 0;       ///< Nesting depth of the zone
+                std::vector<double> samples;         ///< Ring buffer of durations, in milliseconds
+                size_t              nextSample = 0;  ///< Index the next duration is written at
+                double              last = 0.0;      ///< Last measured duration
+                uint64_t            sampleCount = 0; ///< Amount of measured durations
+            };
+
+            VkDevice device;           ///< Logical device the query pools have been created with
+            bool     enabled;          ///< Wether or not the graphics queue supports timestamps
+            double   timestampPeriod;  ///< Nanoseconds per timestamp tick
+            uint64_t timestampMask;    ///< Mask of the timestamp's valid bits
+            uint32_t maxQueries;       ///< Capacity of each query pool
+
+            std::vector<FrameQueries>          frames;         ///< Queries of every frame slot
+            uint32_t                           recordingFrame; ///< Frame slot currently being recorded
+            std::vector<size_t>                openZones;      ///< Indices (in the recording slot's zones) of the zones not ended yet
+            std::map<std::string, ZoneHistory> history;        ///< Durations of every zone, by path
+
+            /**
+             * @brief Ends the innermost open zone, if any
+             *
+             * @param commandBuffer The command buffer to write the timestamp in
+             * @param stage Stage the ending timestamp is written at
+             * @return true If a zone has been ended
+             * @return false If no zone was open
+             */
+            bool end_open_zone(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage) noexcept;
+
+            friend class GpuZone;
+
+        public:
+            /**
+             * @brief Creates a query pool per frame slot
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param frameCount Amount of frame slots (frames in flight)
+             * @param maxZonesPerFrame Maximum amount of zones recorded per frame, deeper zones are ignored
+             */
+            GpuProfiler(const InstanceSetup &setup, uint32_t frameCount, uint32_t maxZonesPerFrame = 128);
+
+            GpuProfiler(const GpuProfiler &) = delete;
+            GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+            /**
+             * @brief Explicitely destroys the query pools
+             */
+            void destroy();
+
+            /**
+             * @brief Reads back the zones last submitted in a frame slot, without waiting
+             *
+             * @param frameIndex The frame slot whose fence has just been waited on
+             */
+            void collect(uint32_t frameIndex);
+
+            /**
+             * @brief Marks the last recording of a frame slot as submitted, so that it is read back next time
+             *
+             * @param frameIndex The submitted frame slot
+             */
+            void mark_submitted(uint32_t frameIndex);
+
+            /**
+             * @brief Starts recording a frame slot's zones, resetting it's queries (must be recorded outside of any render pass)
+             *
+             * @param commandBuffer The frame's primary command buffer
+             * @param frameIndex The recorded frame slot
+             */
+            void begin_frame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+            /**
+             * @brief Begins a zone, nested in the currently open one if any
+             *
+             * @param commandBuffer The command buffer to write the timestamp in
+             * @param name Name of the zone
+             * @param stage Stage the beginning timestamp is written at
+             */
+            void begin_zone(VkCommandBuffer commandBuffer, const std::string &name, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+            /**
+             * @brief Ends the innermost open zone
+             *
+             * @param commandBuffer The command buffer to write the timestamp in
+             * @param stage Stage the ending timestamp is written at
+             */
+            void end_zone(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+            /**
+             * @brief Gets the statistics of every zone measured so far, sorted by path (parents before children)
+             *
+             * @return std::vector<GpuZoneStats> The statistics of every zone
+             */
+            std::vector<GpuZoneStats> get_stats() const;
+
+            /**
+             * @brief Exports the statistics of every zone as a JSON document
+             *
+             * @return std::string The JSON document
+             */
+            std::string export_json() const;
+
+            /**
+             * @brief Exports the statistics of every zone as CSV, with a header line
+             *
+             * @return std::string The CSV document
+             */
+            std::string export_csv() const;
+
+            /**
+             * @brief Writes the statistics of every zone to a file, as CSV if it's name ends with ".csv", as JSON otherwise
+             *
+             * @param filename Name of the file to write
+             */
+            void save(const std::string &filename) const;
+    };
+
+
+    /**
+     * @brief Zone ended when it goes out of scope (does nothing without profiler)
+     */
+    class GpuZone {
+        private:
+            GpuProfiler    *profiler;      ///< Profiler the zone belongs to, if any
+            VkCommandBuffer commandBuffer; ///< Command buffer the zone is recorded in
+
+        public:
+            /**
+             * @brief Begins a zone
+             *
+             * @param profiler The profiler to record the zone with, or nullptr
+             * @param commandBuffer The command buffer to record the zone in
+             * @param name Name of the zone
+             */
+            GpuZone(GpuProfiler *profiler, VkCommandBuffer commandBuffer, const std::string &name);
+
+            /**
+             * @brief Ends the zone (nothing is thrown if the zone has already been ended, e.g. by an unbalanced end_zone)
+             */
+            ~GpuZone();
+
+            GpuZone(const GpuZone &) = delete;
+            GpuZone &operator=(const GpuZone &) = delete;
+    };
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/vulkan.h>
+#include <glm/glm.hpp>
+
+namespace fhope {
+    struct InstanceSetup;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t DEFAULT_INSTANCE_CAPACITY = 1024; ///< Instances the storage buffers can hold before they grow
+    inline constexpr uint32_t INSTANCE_BUFFER_BINDING = 2;      ///< Binding of the instance storage buffer in frame descriptor sets
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    using InstanceHandle = uint32_t; ///< Stable identifier of an instance, valid until it is removed
+
+    /**
+     * @brief Per-instance data read by the vertex shader at gl_InstanceIndex (std430 layout)
+     */
+    struct InstanceData {
+        glm::mat4 model;        ///< Model matrix of the instance
+        uint32_t  textureIndex; ///< Index of the instance's texture in the bindless texture array
+        uint32_t  padding[3];   ///< Pads the structure to it's std430 array stride
+    };
+
+
+    /**
+     * @brief Per-instance transforms of a model, drawn with a single instanced draw call
+     *
+     * Instances are kept densely packed on the CPU (removal moves the last instance in the hole), and every frame slot
+     * owns a persistently mapped storage buffer. A slot's buffer is only rewritten when instances changed since it was
+     * last uploaded, right after the slot's fence has been waited on, so the GPU never reads a buffer being written.
+     */
+    class InstanceBuffer {
+        private:
+            /**
+             * @brief Storage buffer of a frame slot
+             */
+            struct FrameStorage {
+                VkBuffer       buffer  = VK_NULL_HANDLE; ///< Storage buffer
+                VkDeviceMemory memory  = VK_NULL_HANDLE; ///< Memory of the buffer
+                void          *mapping = nullptr;        ///< Persistent mapping of the memory
+                uint32_t       capacity = 0;             ///< Amount of instances the buffer can hold
+                uint64_t       version  = 0;             ///< Version of the instances last uploaded to the buffer
+            };
+
+            VkDevice device; ///< Logical device the buffers have been created with
+
+            std::vector<InstanceData>   instances;     ///< Densely packed instances, in drawing order
+            std::vector<InstanceHandle> denseToHandle; ///< Handle of each packed instance
+            std::vector<uint32_t>       handleToDense; ///< Position of each handle's instance (UINT32_MAX if removed)
+            std::vector<InstanceHandle> freeHandles;   ///< Handles of removed instances, reused by next additions
+
+            uint64_t                  version; ///< Incremented on every change of the instances
+            std::vector<FrameStorage> frames;  ///< Storage buffer of every frame slot
+
+            /**
+             * @brief Creates a frame slot's storage buffer
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param capacity Amount of instances the buffer must hold
+             * @return FrameStorage The created and mapped storage buffer
+             */
+            FrameStorage create_storage(const InstanceSetup &setup, uint32_t capacity) const;
+
+            /**
+             * @brief Destroys a frame slot's storage buffer
+             *
+             * @param storage The storage buffer to destroy
+             */
+            void destroy_storage(FrameStorage *storage) const;
+
+        public:
+            /**
+             * @brief Creates a storage buffer per frame slot, without any instance
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param frameCount Amount of frame slots (frames in flight)
+             * @param initialCapacity Amount of instances each buffer can hold before growing
+             */
+            InstanceBuffer(const InstanceSetup &setup, uint32_t frameCount, uint32_t initialCapacity = DEFAULT_INSTANCE_CAPACITY);
+
+            InstanceBuffer(const InstanceBuffer &) = delete;
+            InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+            /**
+             * @brief Explicitely destroys the storage buffers
+             */
+            void destroy();
+
+            /**
+             * @brief Adds an instance, drawn from the next upload on
+             *
+             * @param model Model matrix of the instance
+             * @param textureIndex Index of the instance's texture in the bindless texture array
+             * @return InstanceHandle Handle of the new instance
+             */
+            InstanceHandle add(const glm::mat4 &model, uint32_t textureIndex = 0);
+
+            /**
+             * @brief Changes the transform of an instance
+             *
+             * @param handle Handle of the instance
+             * @param model New model matrix of the instance
+             */
+            void update(InstanceHandle handle, const glm::mat4 &model);
+
+            /**
+             * @brief Changes the texture of an instance, without breaking it's draw batch
+             *
+             * @param handle Handle of the instance
+             * @param textureIndex New index of the instance's texture in the bindless texture array
+             */
+            void set_texture(InstanceHandle handle, uint32_t textureIndex);
+
+            /**
+             * @brief Removes an instance (the last instance takes it's place in drawing order)
+             *
+             * @param handle Handle of the instance, invalid afterwards
+             */
+            void remove(InstanceHandle handle);
+
+            /**
+             * @brief Checks wether or not a handle designates an instance
+             *
+             * @param handle The handle to check
+             * @return true If the instance exists
+             * @return false If the handle has never been given or the instance has been removed
+             */
+            bool contains(InstanceHandle handle) const;
+
+            /**
+             * @brief Gets the amount of instances
+             *
+             * @return uint32_t The amount of instances, which is the instance count to draw
+             */
+            uint32_t size() const;
+
+            /**
+             * @brief Uploads instances to a frame slot's buffer if they changed since it was last uploaded, growing it if needed
+             *
+             * @param setup A setup containing at least a logical device, a physical device and queues (and their requirements)
+             * @param frameIndex The frame slot whose fence has just been waited on
+             * @param descriptorSet The frame slot's descriptor set, whose instance binding is rewritten if the buffer grows
+             * @return true If the buffer has been recreated : command buffers binding the descriptor set must be recorded again
+             * @return false If the buffer has been kept
+             */
+            bool upload(const InstanceSetup &setup, uint32_t frameIndex, VkDescriptorSet descriptorSet);
+
+            /**
+             * @brief Gets the descriptor of a frame slot's buffer
+             *
+             * @param frameIndex The frame slot
+             * @return VkDescriptorBufferInfo The whole storage buffer of the slot
+             */
+            VkDescriptorBufferInfo get_descriptor_info(uint32_t frameIndex) const;
+    };
+}
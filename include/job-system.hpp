@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fhope {
+    struct RenderConfig;
+    struct Job;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr int64_t DEFAULT_JOB_DEQUE_CAPACITY = 1024; ///< Jobs a worker's deque holds before growing (power of 2)
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Amount of unfinished jobs of a group, which other jobs can depend on and threads can wait for
+     *
+     * A counter must outlive every job counted by it or depending on it : waiting on it with JobSystem::wait before
+     * destroying it is enough.
+     */
+    class JobCounter {
+        friend class JobSystem;
+
+        private:
+            std::atomic<uint32_t> pending; ///< Jobs submitted with the counter and not finished yet
+
+            std::mutex         mutex;   ///< Protects every member below, and orders job completions with waits
+            std::vector<Job *> waiting; ///< Jobs submitted once the counter reaches zero
+            std::exception_ptr error;   ///< First exception thrown by a counted job since the last wait
+
+        public:
+            JobCounter();
+
+            JobCounter(const JobCounter &) = delete;
+            JobCounter &operator=(const JobCounter &) = delete;
+
+            /**
+             * @brief Checks wether or not every counted job has finished
+             *
+             * @return true If no counted job is pending
+             * @return false If counted jobs are still pending
+             */
+            bool is_done() const;
+    };
+
+
+    /**
+     * @brief Chase-Lev work-stealing deque : it's owner pushes and pops at the bottom, any thread steals at the top
+     *
+     * Owner operations are wait-free unless the deque grows, steals are lock-free. Rings replaced by a growth are
+     * kept until the deque is destroyed, as a thief may still be reading them.
+     */
+    class WorkStealingDeque {
+        private:
+            /**
+             * @brief Circular array of jobs, indexed modulo it's capacity
+             */
+            struct Ring {
+                int64_t                             capacity; ///< Amount of slots (power of 2)
+                std::unique_ptr<std::atomic<Job *>[]> slots;  ///< Jobs, read by thieves while the owner writes others
+
+                explicit Ring(int64_t capacity);
+            };
+
+            std::atomic<int64_t> top;    ///< Next index thieves steal from
+            std::atomic<int64_t> bottom; ///< Next index the owner pushes to
+            std::atomic<Ring *>  ring;   ///< Current ring
+
+            std::vector<std::unique_ptr<Ring>> rings; ///< Every ring used since the creation of the deque (owner only)
+
+            /**
+             * @brief Doubles the capacity of the ring, copying the queued jobs (owner only)
+             *
+             * @param currentTop Top index the jobs are copied from
+             * @param currentBottom Bottom index the jobs are copied to
+             * @return Ring* The new ring
+             */
+            Ring *grow(int64_t currentTop, int64_t currentBottom);
+
+        public:
+            /**
+             * @brief Creates an empty deque
+             *
+             * @param capacity Initial amount of slots (rounded up to a power of 2)
+             */
+            explicit WorkStealingDeque(int64_t capacity = DEFAULT_JOB_DEQUE_CAPACITY);
+
+            WorkStealingDeque(const WorkStealingDeque &) = delete;
+            WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+            /**
+             * @brief Pushes a job at the bottom (owner only)
+             *
+             * @param job The job
+             */
+            void push(Job *job);
+
+            /**
+             * @brief Pops the last pushed job (owner only)
+             *
+             * @return Job* The job, or nullptr if the deque is empty
+             */
+            Job *pop();
+
+            /**
+             * @brief Steals the oldest job (any thread)
+             *
+             * @return Job* The job, or nullptr if the deque is empty or another thread took it first
+             */
+            Job *steal();
+    };
+
+
+    /**
+     * @brief Fixed-size pool of worker threads, each running jobs from it's own deque and stealing from the others when idle
+     *
+     * Jobs submitted from a worker go to it's own deque, jobs submitted from other threads to a shared injection
+     * queue. Waiting on a counter runs other jobs until the counter reaches zero, so a thread waiting (and a job
+     * waiting for nested jobs) never blocks a worker.
+     */
+    class JobSystem {
+        private:
+            std::vector<std::thread>                        workers; ///< Worker threads
+            std::vector<std::unique_ptr<WorkStealingDeque>> deques;  ///< Deque of each worker
+
+            std::mutex        injectionMutex; ///< Protects injected
+            std::deque<Job *> injected;       ///< Jobs submitted from threads that are not workers
+
+            std::atomic<int64_t>    queued;        ///< Jobs submitted and not taken yet (drives workers' sleep)
+            std::atomic<uint32_t>   sleeping;      ///< Workers waiting for jobs
+            std::mutex              sleepMutex;    ///< Orders sleeps with wake ups
+            std::condition_variable wakeCondition; ///< Wakes workers up when a job is queued (or when stopping)
+            std::atomic<bool>       stopping;      ///< Wether or not workers must exit
+
+            void worker_loop(uint32_t workerIndex);
+
+            /**
+             * @brief Queues a job, in the calling worker's deque or in the injection queue
+             *
+             * @param job The job, whose counter has already been incremented
+             */
+            void submit(Job *job);
+
+            /**
+             * @brief Takes a job from the calling worker's deque, then from the injection queue, then from other workers
+             *
+             * @return Job* The taken job, or nullptr if none has been found
+             */
+            Job *find_job();
+
+            /**
+             * @brief Runs a job, decrements it's counter (submitting it's dependents once it reaches zero) and frees it
+             *
+             * @param job The job
+             */
+            void execute(Job *job);
+
+        public:
+            /**
+             * @brief Starts the worker threads
+             *
+             * @param workerCount Amount of worker threads (at least 1)
+             */
+            explicit JobSystem(uint32_t workerCount);
+
+            /**
+             * @brief Stops and joins the worker threads, dropping jobs never started
+             */
+            ~JobSystem();
+
+            JobSystem(const JobSystem &) = delete;
+            JobSystem &operator=(const JobSystem &) = delete;
+
+            /**
+             * @brief Gets the amount of worker threads
+             *
+             * @return uint32_t The amount of worker threads
+             */
+            uint32_t get_worker_count() const;
+
+            /**
+             * @brief Submits a job
+             *
+             * @param function The job's work
+             * @param counter Counter incremented now and decremented once the job finishes, or nullptr
+             */
+            void run(std::function<void()> function, JobCounter *counter = nullptr);
+
+            /**
+             * @brief Submits a job once every job counted by a dependency has finished (failed ones included)
+             *
+             * @param dependency Counter to wait for
+             * @param function The job's work
+             * @param counter Counter incremented now and decremented once the job finishes, or nullptr
+             */
+            void run_after(JobCounter *dependency, std::function<void()> function, JobCounter *counter = nullptr);
+
+            /**
+             * @brief Runs jobs until every job counted by a counter has finished
+             *
+             * @param counter The counter
+             * @throws The first exception thrown by a counted job since the last wait on the counter
+             */
+            void wait(JobCounter *counter);
+
+            /**
+             * @brief Splits a range in chunks run as jobs, and waits for them
+             *
+             * @param count Size of the range [0, count)
+             * @param grain Size of each chunk (0 to split the range in a few chunks per thread)
+             * @param function Called with the [begin, end) bounds of each chunk
+             */
+            void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &function);
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Gets the amount of job worker threads a render config asks for
+     *
+     * @param config The render config
+     * @return uint32_t The configured amount of workers, or the amount of hardware threads minus the calling one if it is 0
+     */
+    uint32_t get_job_worker_count(const RenderConfig &config);
+}
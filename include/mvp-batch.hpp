@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace fhope {
+    struct MVP;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr size_t MATRIX_SOA_ALIGNMENT = 32; ///< Alignment of every element array of a matrix SoA (an AVX register)
+
+    /// Matrices computed per iteration by compute_mvps (8 with AVX2 and FMA, 4 with SSE, 1 otherwise)
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+    inline constexpr uint32_t MVP_BATCH_LANES = 8;
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    inline constexpr uint32_t MVP_BATCH_LANES = 4;
+#else
+    inline constexpr uint32_t MVP_BATCH_LANES = 1;
+#endif
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Allocator returning storage aligned for aligned SIMD loads and stores
+     *
+     * @tparam T Type of the allocated values
+     */
+    template <typename T>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        AlignedAllocator() = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U> &) {}
+
+        T *allocate(size_t count) {
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(MATRIX_SOA_ALIGNMENT)));
+        }
+
+        void deallocate(T *values, size_t) {
+            ::operator delete(values, std::align_val_t(MATRIX_SOA_ALIGNMENT));
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U> &) const { return true; }
+    };
+
+
+    /**
+     * @brief 4x4 matrices stored as structure of arrays : one aligned array per element, so that several matrices are multiplied at once
+     *
+     * Elements are in glm's column-major order : elements[column * 4 + row][i] is the element of the i-th matrix.
+     */
+    struct MatrixSoA {
+        std::array<std::vector<float, AlignedAllocator<float>>, 16> elements; ///< Every element of every matrix
+
+        /**
+         * @brief Changes the amount of matrices, new ones being left zeroed
+         *
+         * @param count New amount of matrices
+         */
+        void resize(size_t count);
+
+        /**
+         * @brief Appends a matrix
+         *
+         * @param matrix The matrix
+         */
+        void push_back(const glm::mat4 &matrix);
+
+        /**
+         * @brief Overwrites a matrix
+         *
+         * @param index Index of the matrix
+         * @param matrix The new matrix
+         */
+        void set(size_t index, const glm::mat4 &matrix);
+
+        /**
+         * @brief Gathers a matrix
+         *
+         * @param index Index of the matrix
+         * @return glm::mat4 The matrix
+         */
+        glm::mat4 get(size_t index) const;
+
+        /**
+         * @brief Gets the amount of matrices
+         *
+         * @return size_t The amount of matrices
+         */
+        size_t size() const;
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Computes viewProjection * models[i] for every model, MVP_BATCH_LANES matrices at a time
+     *
+     * @param viewProjection Projection * view, shared by every model
+     * @param models Model matrices
+     * @param mvps Receives the model-view-projection matrices (resized to the amount of models)
+     */
+    void compute_mvps(const glm::mat4 &viewProjection, const MatrixSoA &models, MatrixSoA *mvps);
+
+    /**
+     * @brief Computes the model-view-projection of every model from a camera's cached view-projection
+     *
+     * @param mvp MVP whose view and projection are used (it's model is ignored)
+     * @param models Model matrices
+     * @param mvps Receives the model-view-projection matrices (resized to the amount of models)
+     */
+    void compute_mvps(MVP *mvp, const MatrixSoA &models, MatrixSoA *mvps);
+
+    /**
+     * @brief Same as compute_mvps, 4 matrices at a time with SSE (one at a time where SSE is unavailable)
+     *
+     * @param viewProjection Projection * view, shared by every model
+     * @param models Model matrices
+     * @param mvps Receives the model-view-projection matrices (resized to the amount of models)
+     */
+    void compute_mvps_sse(const glm::mat4 &viewProjection, const MatrixSoA &models, MatrixSoA *mvps);
+
+    /**
+     * @brief Same as compute_mvps, one matrix at a time (reference for the SIMD kernels)
+     *
+     * @param viewProjection Projection * view, shared by every model
+     * @param models Model matrices
+     * @param mvps Receives the model-view-projection matrices (resized to the amount of models)
+     */
+    void compute_mvps_scalar(const glm::mat4 &viewProjection, const MatrixSoA &models, MatrixSoA *mvps);
+
+    /**
+     * @brief Computes lefts[i] * rights[i] for every pair of matrices, MVP_BATCH_LANES pairs at a time (each pair has it's own left matrix)
+     *
+     * @param lefts Left matrices
+     * @param rights Right matrices (as many as left ones)
+     * @param products Receives the products (resized to the amount of pairs)
+     */
+    void multiply_matrices(const MatrixSoA &lefts, const MatrixSoA &rights, MatrixSoA *products);
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
 namespace fhope {
@@ -9,24 +11,34 @@ namespace fhope {
             glm::mat4 view;
             glm::mat4 projection;
 
+            glm::mat4 outViewProjection;
             glm::mat4 outMVP;
             bool dirty;
+            bool viewProjectionDirty;
+
+            uint64_t version; ///< Incremented on every change of a matrix
         
         public:
             MVP();
             MVP(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection);
             MVP(const MVP &o);
+            MVP &operator=(const MVP &o);
 
             glm::mat4 get_model() const;
             glm::mat4 get_view() const;
             glm::mat4 get_projection() const;
 
+            // Setting a matrix to it's current value keeps the MVP clean
             void set_model(const glm::mat4 &newModel);
             void set_view(const glm::mat4 &newView);
             void set_projection(const glm::mat4 &newProjection);
 
             bool is_dirty() const;
 
+            uint64_t get_version() const;
+
+            glm::mat4 get_view_projection();
+
             glm::mat4 get_mvp();
 
             glm::mat4 recompute_mvp();
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <glad/vulkan.h>
+
+#include "task.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+#ifdef FHOPE_SHADER_CACHE_DIR
+    inline constexpr const char *PIPELINE_CACHE_FILENAME = FHOPE_SHADER_CACHE_DIR "/pipeline-cache.bin"; ///< File the pipeline cache is persisted to (next to the binaries)
+#else
+    inline constexpr const char *PIPELINE_CACHE_FILENAME = "shader-cache/pipeline-cache.bin"; ///< File the pipeline cache is persisted to (relative to the working directory)
+#endif
+
+    inline constexpr std::chrono::seconds PIPELINE_CACHE_SAVE_INTERVAL{60}; ///< Interval between two periodic saves of the pipeline cache, if it grew
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Driver pipeline cache shared by every pipeline creation, loaded from disk at startup and saved back
+     *
+     * The file is only given to the driver if it's header matches the physical device (vendor, device and cache UUID),
+     * so that a driver update or another GPU starts from an empty cache instead of trusting foreign data. The cache is
+     * saved on destruction and periodically, on a job worker, whenever it grew.
+     */
+    class PipelineCache {
+        private:
+            VkDevice        device; ///< Logical device the cache has been created with
+            VkPipelineCache cache;  ///< The driver's cache
+
+            std::filesystem::path filename; ///< File the cache is loaded from and saved to
+
+            size_t                                savedSize; ///< Size of the data last saved (or loaded)
+            std::chrono::steady_clock::time_point lastSave;  ///< When the cache has last been saved, or checked for growth
+            bool                                  saving;    ///< Wether or not a periodic save is in progress
+
+            /**
+             * @brief Tells wether or not pipeline cache data has been written by the same driver for the same device
+             *
+             * @param data The data, starting with it's header
+             * @param properties Properties of the physical device
+             * @return true If the data may be given to the driver
+             * @return false Otherwise
+             */
+            static bool is_compatible(const std::vector<char> &data, const VkPhysicalDeviceProperties &properties);
+
+            /**
+             * @brief Saves the cache on a job worker
+             *
+             * @param setup A setup containing at least an async scheduler
+             * @return Task<void> The save, spawned on the async scheduler
+             */
+            Task<void> save_async(InstanceSetup *setup);
+
+        public:
+            /**
+             * @brief Creates the cache, filled with the file's data if it is compatible with the physical device
+             *
+             * @param setup A setup containing at least a physical device and a logical device
+             * @param filename File the cache is loaded from and saved to
+             */
+            PipelineCache(const InstanceSetup &setup, std::filesystem::path filename);
+
+            PipelineCache(const PipelineCache &) = delete;
+            PipelineCache &operator=(const PipelineCache &) = delete;
+
+            /**
+             * @brief Explicitely saves then destroys the cache (no pipeline may be being created)
+             */
+            void destroy();
+
+            /**
+             * @brief Writes the cache's data to it's file, atomically replacing the previous one (failures are ignored :
+             * the cache is only an optimization)
+             *
+             * @return size_t Size of the saved data (0 if it could not be saved)
+             */
+            size_t save() const;
+
+            /**
+             * @brief Saves the cache in the background if it grew since the last save, at most every
+             * PIPELINE_CACHE_SAVE_INTERVAL (render thread, once per frame)
+             *
+             * @param setup A setup containing at least an async scheduler
+             */
+            void update(InstanceSetup *setup);
+
+            /**
+             * @brief Gets the driver's cache, to pass to pipeline creations (internally synchronized : usable from any thread)
+             *
+             * @return VkPipelineCache The cache
+             */
+            VkPipelineCache get() const;
+    };
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <functional>
+
+#include <glad/vulkan.h>
+
+#include "barrier.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+    class RenderGraph;
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    using GraphResource = uint32_t; ///< Index of an image resource inside a render graph
+    using GraphPassId   = uint32_t; ///< Index of a pass inside a render graph
+
+
+    /**
+     * @brief Ways a pass can access an image resource
+     */
+    enum class GraphAccess {
+        ColorAttachment,        ///< Written as a color attachment
+        DepthStencilAttachment, ///< Written (and tested) as a depth/stencil attachment
+        DepthStencilRead,       ///< Tested as a read-only depth/stencil attachment
+        ResolveAttachment,      ///< Written by a multisample resolve
+        FragmentSampled,        ///< Sampled in a fragment shader
+        ComputeSampled,         ///< Sampled in a compute shader
+        ComputeStorageRead,     ///< Read as a storage image in a compute shader
+        ComputeStorageWrite,    ///< Written as a storage image in a compute shader
+        TransferSource,         ///< Read by a transfer command
+        TransferDestination     ///< Written by a transfer command
+    };
+
+
+    /**
+     * @brief Description of an image resource of a render graph
+     */
+    struct GraphImageDesc {
+        VkFormat              format;                          ///< Format of the image
+        VkExtent2D            extent;                          ///< Dimensions of the image
+        VkSampleCountFlagBits samples   = VK_SAMPLE_COUNT_1_BIT; ///< Sample count of the image
+        uint32_t              mipLevels = 1;                   ///< Amount of mip levels of the image
+    };
+
+
+    /**
+     * @brief Declared access of a pass to a resource
+     */
+    struct GraphResourceUse {
+        GraphResource               resource; ///< Accessed resource
+        GraphAccess                 access;   ///< Kind of access
+        std::optional<VkClearValue> clear;    ///< Clear value, for attachments that must be cleared when the pass begins
+    };
+
+
+    /**
+     * @brief Image resource of a render graph, either transient (owned by the graph) or imported
+     */
+    struct GraphImage {
+        std::string    name;     ///< Debug name of the resource
+        GraphImageDesc desc;     ///< Description of the image
+        bool           imported; ///< Wether the image is provided from outside the graph (swap chain, persistent texture...)
+
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; ///< Layout of an imported image when the graph begins
+        VkImageLayout finalLayout   = VK_IMAGE_LAYOUT_UNDEFINED; ///< Layout an imported image must be left in when the graph ends
+        StageAccess   finalAccess{};                            ///< Accesses waiting for an imported image once the graph ends
+
+        VkImage     image = VK_NULL_HANDLE; ///< Vulkan image (created at compile time for transient images, selected among the imported ones otherwise)
+        VkImageView view  = VK_NULL_HANDLE; ///< View to the whole image
+
+        std::vector<VkImage>     importedImages;    ///< Images an imported resource alternates between (one per swap chain image...)
+        std::vector<VkImageView> importedViews;     ///< Views to the imported images
+        uint32_t                 importedIndex = 0; ///< Index of the imported image currently used
+
+        VkImageUsageFlags usage = 0;                 ///< Usage accumulated from every declared access
+        uint32_t          firstLevel = UINT32_MAX;   ///< First dependency level using the image
+        uint32_t          lastLevel  = 0;            ///< Last dependency level using the image
+        std::optional<uint32_t> memoryBlock;         ///< Memory block the transient image is bound to
+    };
+
+
+    /**
+     * @brief Node of a render graph
+     */
+    struct GraphPass {
+        std::string name;       ///< Debug name of the pass
+        bool        raster;     ///< Wether the pass records inside a render pass built from it's attachments
+        bool        sideEffect; ///< Wether the pass must never be culled, even if nothing reads what it writes
+
+        std::vector<GraphResourceUse> uses; ///< Every resource access of the pass, attachments in declaration order
+
+        std::function<void(VkCommandBuffer, const RenderGraph &)> record; ///< Records the pass' commands
+
+        VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE; ///< How the render pass' content is provided
+
+        bool     culled = false; ///< Wether compilation removed the pass
+        uint32_t level  = 0;     ///< Dependency level the pass executes at
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;                    ///< Render pass of a raster pass
+        VkExtent2D   extent{};                                       ///< Extent shared by every attachment of a raster pass
+        std::vector<VkClearValue> clearValues;                       ///< Clear values, one per attachment
+        std::map<std::vector<uint32_t>, VkFramebuffer> framebuffers; ///< Framebuffers, keyed by the imported index of each attachment (views are never compared : handles get reused once destroyed)
+    };
+
+
+    /**
+     * @brief Layout transition the graph records before a dependency level
+     */
+    struct GraphBarrier {
+        GraphResource resource;    ///< Transitioned resource
+        VkImageLayout oldLayout;   ///< Layout of the resource before the barrier
+        VkImageLayout newLayout;   ///< Layout of the resource after the barrier
+        StageAccess   source;      ///< Accesses that must complete before the barrier
+        StageAccess   destination; ///< Accesses that must wait for the barrier
+    };
+
+
+    /**
+     * @brief Memory shared by transient images whose lifetimes do not overlap
+     */
+    struct GraphMemoryBlock {
+        VkDeviceMemory             memory = VK_NULL_HANDLE; ///< Allocated memory
+        VkDeviceSize               size = 0;                ///< Size of the allocation, in bytes
+        uint32_t                   memoryTypeBits = ~0u;    ///< Memory types every occupant accepts
+        std::vector<GraphResource> occupants;               ///< Images bound to the block, ordered by first use
+    };
+
+
+    /**
+     * @brief Helper to declare a pass' accesses
+     */
+    class GraphPassBuilder {
+        private:
+            RenderGraph *graph; ///< Graph the pass belongs to
+            GraphPassId  pass;  ///< Built pass
+
+        public:
+            GraphPassBuilder(RenderGraph *graph, GraphPassId pass);
+
+            /**
+             * @brief Declares a read of a resource
+             *
+             * @param resource The read resource
+             * @param access How the resource is read
+             * @return GraphPassBuilder& The builder, for chaining
+             */
+            GraphPassBuilder &read(GraphResource resource, GraphAccess access);
+
+            /**
+             * @brief Declares a write to a resource
+             *
+             * @param resource The written resource
+             * @param access How the resource is written
+             * @param clear The value attachments are cleared to when the pass begins, if they must be cleared
+             * @return GraphPassBuilder& The builder, for chaining
+             */
+            GraphPassBuilder &write(GraphResource resource, GraphAccess access, std::optional<VkClearValue> clear = std::nullopt);
+
+            /**
+             * @brief Prevents the pass from being culled
+             *
+             * @return GraphPassBuilder& The builder, for chaining
+             */
+            GraphPassBuilder &side_effect();
+
+            /**
+             * @brief Makes the render pass' content come from secondary command buffers
+             *
+             * @return GraphPassBuilder& The builder, for chaining
+             */
+            GraphPassBuilder &secondary_contents();
+
+            /**
+             * @brief Gets the built pass' identifier
+             *
+             * @return GraphPassId The pass' identifier
+             */
+            GraphPassId id() const;
+    };
+
+
+    /**
+     * @brief Frame graph : passes declare their reads and writes, the graph derives execution order, culling, barriers,
+     * layout transitions and transient memory aliasing from them
+     */
+    class RenderGraph {
+        friend class GraphPassBuilder;
+
+        private:
+            std::vector<GraphImage> images; ///< Every image resource
+            std::vector<GraphPass>  passes; ///< Every pass, in declaration order
+
+            std::vector<std::vector<GraphPassId>>  levels;        ///< Non-culled passes grouped by dependency level
+            std::vector<std::vector<GraphBarrier>> levelBarriers; ///< Barriers recorded before each level
+            std::vector<GraphBarrier>              finalBarriers; ///< Barriers leaving imported images in their final layouts
+
+            std::vector<GraphMemoryBlock> memoryBlocks; ///< Memory shared by transient images
+
+            VkDevice device           = VK_NULL_HANDLE; ///< Logical device the graph has been compiled with
+            bool     synchronization2 = false;          ///< Wether the graph records barriers through VK_KHR_synchronization2
+
+            bool compiled = false; ///< Wether compile has been called since the last declaration
+
+            void cull_passes();
+            void compute_levels();
+            void allocate_transient_images(const InstanceSetup &setup);
+            void compute_barriers();
+            void create_render_passes(const InstanceSetup &setup);
+            void destroy_framebuffers(GraphResource resource);
+            VkFramebuffer get_framebuffer(GraphPass &pass);
+
+        public:
+            /**
+             * @brief Declares a transient image, owned by the graph and only valid during it's execution
+             *
+             * @param name Debug name of the image
+             * @param desc Description of the image
+             * @return GraphResource The declared resource
+             */
+            GraphResource create_image(const std::string &name, const GraphImageDesc &desc);
+
+            /**
+             * @brief Declares an image provided from outside the graph
+             *
+             * @param name Debug name of the image
+             * @param desc Description of the image
+             * @param initialLayout Layout of the image when the graph begins
+             * @param finalLayout Layout the image must be left in when the graph ends
+             * @param finalAccess Accesses waiting for the image once the graph ends (derived from the final layout if omitted)
+             * @return GraphResource The declared resource
+             */
+            GraphResource import_image(const std::string &name, const GraphImageDesc &desc, VkImageLayout initialLayout, VkImageLayout finalLayout, std::optional<StageAccess> finalAccess = std::nullopt);
+
+            /**
+             * @brief Binds the vulkan objects of an imported image
+             *
+             * @param resource The imported resource
+             * @param image The image to use
+             * @param view A view to the whole image
+             */
+            void set_imported_image(GraphResource resource, VkImage image, VkImageView view);
+
+            /**
+             * @brief Binds the images an imported resource alternates between (for example the swap chain's), and selects the first one.
+             * Framebuffers built from the previously bound images are destroyed : none of them may still be in use.
+             *
+             * @param resource The imported resource
+             * @param images The images to use
+             * @param views A view to each whole image
+             */
+            void set_imported_images(GraphResource resource, const std::vector<VkImage> &images, const std::vector<VkImageView> &views);
+
+            /**
+             * @brief Selects which of it's bound images an imported resource uses when the graph is next executed
+             *
+             * @param resource The imported resource
+             * @param index Index of the image among the bound ones
+             */
+            void select_imported_image(GraphResource resource, uint32_t index);
+
+            /**
+             * @brief Declares a pass recorded outside of any render pass (compute, transfer...)
+             *
+             * @param name Debug name of the pass
+             * @param record Records the pass' commands
+             * @return GraphPassBuilder A builder to declare the pass' accesses
+             */
+            GraphPassBuilder add_pass(const std::string &name, std::function<void(VkCommandBuffer, const RenderGraph &)> record);
+
+            /**
+             * @brief Declares a pass recorded inside a render pass built from it's attachment accesses
+             *
+             * @param name Debug name of the pass
+             * @param record Records the pass' commands (the render pass is already begun)
+             * @return GraphPassBuilder A builder to declare the pass' accesses
+             */
+            GraphPassBuilder add_raster_pass(const std::string &name, std::function<void(VkCommandBuffer, const RenderGraph &)> record);
+
+            /**
+             * @brief Replaces the function recording a pass' commands (does not require compiling again)
+             *
+             * @param pass The pass
+             * @param record Records the pass' commands
+             */
+            void set_record(GraphPassId pass, std::function<void(VkCommandBuffer, const RenderGraph &)> record);
+
+            /**
+             * @brief Culls, orders, and allocates the graph, and computes it's barriers and render passes
+             *
+             * @param setup A setup containing at least a logical device and a physical device (and their requirements)
+             */
+            void compile(const InstanceSetup &setup);
+
+            /**
+             * @brief Records every non-culled pass with it's barriers
+             *
+             * Transient memory is shared by every execution : the first use of each memory block waits for the last
+             * use of the previous execution, so that frames in flight never overwrite each other's attachments.
+             *
+             * @param commandBuffer A begun command buffer to record in
+             */
+            void execute(VkCommandBuffer commandBuffer);
+
+            /**
+             * @brief Explicitely destroys every vulkan object the graph created
+             *
+             * @param setup The setup the graph has been compiled with
+             */
+            void destroy(const InstanceSetup &setup);
+
+            /**
+             * @brief Gets the vulkan image of a resource (transient images only exist once compiled)
+             *
+             * @param resource The resource
+             * @return VkImage The resource's image
+             */
+            VkImage get_image(GraphResource resource) const;
+
+            /**
+             * @brief Gets the view to a resource's whole image
+             *
+             * @param resource The resource
+             * @return VkImageView The resource's view
+             */
+            VkImageView get_view(GraphResource resource) const;
+
+            /**
+             * @brief Gets the render pass built for a raster pass, to create compatible pipelines
+             *
+             * @param pass The raster pass
+             * @return VkRenderPass The render pass
+             */
+            VkRenderPass get_render_pass(GraphPassId pass) const;
+
+            /**
+             * @brief Checks wether or not compilation culled a pass
+             *
+             * @param pass The pass
+             * @return true If the pass will not be executed
+             * @return false If the pass will be executed
+             */
+            bool is_culled(GraphPassId pass) const;
+
+            /**
+             * @brief Gets the amount of memory bound to transient images, after aliasing
+             *
+             * @return VkDeviceSize The amount of transient memory, in bytes
+             */
+            VkDeviceSize get_transient_memory_size() const;
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Declares the engine's multisampled forward pass in a graph : transient color (and depth) attachments, resolved into a target
+     *
+     * @param graph The graph to declare the pass in
+     * @param setup A setup containing at least a swap chain config, a physical device and a max samples flag (and their requirements)
+     * @param target The (single-sampled) image the pass resolves into
+     * @param depth A multisampled depth image to test against, or std::nullopt to use a transient one
+     * @param record Records the pass' draws
+     * @return GraphPassBuilder A builder to declare more of the pass' accesses
+     */
+    GraphPassBuilder add_forward_pass(RenderGraph *graph, const InstanceSetup &setup, GraphResource target, std::optional<GraphResource> depth, std::function<void(VkCommandBuffer, const RenderGraph &)> record);
+}
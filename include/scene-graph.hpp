@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mvp-batch.hpp"
+
+namespace fhope {
+    class InstanceBuffer;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr uint32_t INVALID_NODE = UINT32_MAX;     ///< Handle of no node (parent of root nodes)
+    inline constexpr uint32_t INVALID_INSTANCE = UINT32_MAX; ///< Handle of no instance (node not drawn)
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    using NodeHandle = uint32_t; ///< Stable identifier of a scene graph node, valid until it is removed
+
+    /**
+     * @brief Transform hierarchy whose nodes are stored as structure of arrays, parents always preceding their children
+     *
+     * Local and world matrices, parents and attached instances are each kept in their own contiguous array,
+     * sorted by depth. An update walks the arrays once, one depth level at a time : a node is recomputed if it or one of
+     * it's ancestors changed, which only touches changed subtrees. A level's recomputed nodes are multiplied by their
+     * parents' world matrices as a single SIMD batch, parents' being final since their level has been batched before.
+     * Changed world matrices are then pushed to the instances attached to their nodes, which is what culling reads :
+     * the GPU culling transforms each mesh's bounds by it's instance's model matrix.
+     */
+    class SceneGraph {
+        private:
+            std::vector<glm::mat4> localMatrices; ///< Transform of each node relative to it's parent
+            std::vector<glm::mat4> worldMatrices; ///< Transform of each node relative to the world
+            std::vector<uint32_t>  parents;       ///< Position of each node's parent (INVALID_NODE for roots)
+            std::vector<uint32_t>  depths;        ///< Amount of ancestors of each node
+            std::vector<uint8_t>   dirty;         ///< Wether each node's local matrix or parent changed since the last update
+            std::vector<uint32_t>  instances;     ///< Instance each node's world matrix is pushed to (INVALID_INSTANCE if none)
+
+            std::vector<NodeHandle> denseToHandle; ///< Handle of each stored node
+            std::vector<uint32_t>   handleToDense; ///< Position of each handle's node (INVALID_NODE if removed)
+            std::vector<NodeHandle> freeHandles;   ///< Handles of removed nodes, reused by next additions
+
+            std::vector<NodeHandle> changed;   ///< Nodes whose world matrix changed during the last update
+            bool                    needsSort; ///< Wether or not a reparenting may have put a child before it's parent
+
+            std::vector<uint32_t> batchNodes;   ///< Positions of the nodes of the depth level being batched (kept between updates to reuse it's capacity)
+            MatrixSoA             batchParents; ///< World matrices of the batched nodes' parents
+            MatrixSoA             batchLocals;  ///< Local matrices of the batched nodes
+            MatrixSoA             batchWorlds;  ///< Computed world matrices of the batched nodes
+
+            /**
+             * @brief Sorts every array by depth, keeping the relative order of nodes of a same depth
+             */
+            void sort_by_depth();
+
+            /**
+             * @brief Keeps the nodes flagged to be kept, in order, and remaps parents and handles
+             *
+             * @param keep Wether or not to keep each stored node
+             */
+            void compact(const std::vector<uint8_t> &keep);
+
+            /**
+             * @brief Gets the position of a node, checking it exists
+             *
+             * @param handle Handle of the node
+             * @return uint32_t Position of the node in the arrays
+             */
+            uint32_t get_dense(NodeHandle handle) const;
+
+        public:
+            SceneGraph();
+
+            /**
+             * @brief Adds a node, computed by the next update
+             *
+             * @param local Transform of the node relative to it's parent
+             * @param parent Handle of the parent node (INVALID_NODE for a root)
+             * @return NodeHandle Handle of the new node
+             */
+            NodeHandle add_node(const glm::mat4 &local, NodeHandle parent = INVALID_NODE);
+
+            /**
+             * @brief Removes a node and every node below it (their attached instances are left to the caller)
+             *
+             * @param handle Handle of the node, invalid afterwards (as are it's descendants')
+             */
+            void remove_node(NodeHandle handle);
+
+            /**
+             * @brief Moves a node (and it's subtree) under another parent
+             *
+             * @param handle Handle of the node
+             * @param parent Handle of the new parent (INVALID_NODE to make it a root), which must not be below the node
+             */
+            void set_parent(NodeHandle handle, NodeHandle parent);
+
+            /**
+             * @brief Changes the transform of a node relative to it's parent
+             *
+             * @param handle Handle of the node
+             * @param local New local transform of the node
+             */
+            void set_local(NodeHandle handle, const glm::mat4 &local);
+
+            /**
+             * @brief Attaches an instance to a node : the instance's model matrix follows the node's world matrix
+             *
+             * @param handle Handle of the node
+             * @param instance Handle of the instance (INVALID_INSTANCE to detach)
+             */
+            void attach_instance(NodeHandle handle, uint32_t instance);
+
+            /**
+             * @brief Gets the transform of a node relative to it's parent
+             *
+             * @param handle Handle of the node
+             * @return const glm::mat4& The local transform
+             */
+            const glm::mat4 &get_local(NodeHandle handle) const;
+
+            /**
+             * @brief Gets the transform of a node relative to the world, as of the last update
+             *
+             * @param handle Handle of the node
+             * @return const glm::mat4& The world transform
+             */
+            const glm::mat4 &get_world(NodeHandle handle) const;
+
+            /**
+             * @brief Checks wether or not a handle designates a node
+             *
+             * @param handle The handle to check
+             * @return true If the node exists
+             * @return false If the handle has never been given or the node has been removed
+             */
+            bool contains(NodeHandle handle) const;
+
+            /**
+             * @brief Gets the amount of nodes
+             *
+             * @return uint32_t The amount of nodes
+             */
+            uint32_t size() const;
+
+            /**
+             * @brief Recomputes the world matrices of changed nodes and of every node below them
+             *
+             * @return uint32_t The amount of recomputed world matrices
+             */
+            uint32_t update();
+
+            /**
+             * @brief Gets the nodes whose world matrix changed during the last update
+             *
+             * @return const std::vector<NodeHandle>& The changed nodes, parents first
+             */
+            const std::vector<NodeHandle> &get_changed() const;
+
+            /**
+             * @brief Pushes the world matrices changed during the last update to the instances attached to their nodes
+             *
+             * @param instanceBuffer The instance buffer holding the attached instances
+             * @return uint32_t The amount of updated instances
+             */
+            uint32_t sync_instances(InstanceBuffer *instanceBuffer) const;
+    };
+}
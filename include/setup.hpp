@@ -12,15 +12,42 @@
 #include <streambuf>
 #include <cmath>
 #include <unordered_map>
+#include <map>
+#include <memory>
+#include <span>
 
 #include <glad/vulkan.h>
 #include <GLFW/glfw3.h>
+#ifdef FHOPE_RUNTIME_SHADERS
 #include <shaderc/shaderc.hpp>
+#endif
 #include <glm/glm.hpp>
 #include <stb_image.h>
 #include <tiny_obj_loader.h>
 
 #include "vertex.hpp"
+#include "mvp.hpp"
+#include "frame-context.hpp"
+#include "gpu-profiler.hpp"
+#include "instance-buffer.hpp"
+#include "gpu-culling.hpp"
+#include "geometry-pool.hpp"
+#include "bindless-textures.hpp"
+#include "descriptor-allocator.hpp"
+#include "scene-graph.hpp"
+#include "job-system.hpp"
+#include "async-scheduler.hpp"
+#include "deletion-queue.hpp"
+#include "asset-manager.hpp"
+#include "pipeline-cache.hpp"
+#include "render-graph.hpp"
+
+#ifdef FHOPE_RUNTIME_SHADERS
+#include "shader-reload.hpp"
+#include "shader-cache.hpp"
+#else
+#include "embedded-shaders.hpp"
+#endif
 
 namespace fhope {
     /***********************
@@ -33,7 +60,7 @@ namespace fhope {
     inline constexpr std::array<const char *, 1> ENGINE_REQUIRED_DEVICE_EXTENSIONS = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; ///< List of extensions the engine needs to run
     inline constexpr std::array<const char *, 1> ENGINE_REQUIRED_VALIDATION_LAYERS = { "VK_LAYER_KHRONOS_validation" }; ///< List of validation layers the engine needs to run
 
-    inline constexpr int MAX_FRAMES_IN_FLIGHT = 2; ///< Maximum amount of in-flight frames (double buffering, triple buffering, etc)
+    inline constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2; ///< Default amount of in-flight frames (double buffering, triple buffering, etc)
 
     /****************
      ** STRUCTURES **
@@ -57,6 +84,13 @@ namespace fhope {
          * @return false If at least one queue has no value
          */
         bool is_complete() const;
+
+        /**
+         * @brief Gets the distinct queue family indices in use (the presentation one is skipped when absent)
+         * 
+         * @return std::set<uint32_t> The distinct queue family indices
+         */
+        std::set<uint32_t> get_unique_families() const;
     };
 
 
@@ -122,20 +156,44 @@ namespace fhope {
     };
     
     
+    /**
+     * @brief Frame graph the engine draws with, rebuilt along the swap chain
+     */
+    struct FrameGraph {
+        std::unique_ptr<RenderGraph> graph;       ///< The compiled graph
+        GraphResource                target;      ///< Resource the swap chain images (or offscreen images) are imported as
+        GraphPassId                  forwardPass; ///< Multisampled forward pass, resolved into the target
+    };
+
+
     /**
      * @brief Wrapped vulkan graphics pipeline with configuration information
      */
     struct GraphicsPipelineConfig {
         std::string vertexShaderFilename; ///< Used vertex shader's source's filename
         std::string fragmentShaderFilename; ///< Used fragment shader's source's filename
+        std::map<std::string, std::string> fragmentDefinitions; ///< Macros the fragment shader is compiled with
         
         VkPipelineLayout pipelineLayout; ///< Layout of the pipeline's mutable states
-        VkRenderPass renderPass; ///< Used render pass
+        VkRenderPass renderPass; ///< Used render pass (owned by the frame graph)
         
         VkPipeline pipeline; ///< Proper Wrapped pipeline
     };
 
 
+    /**
+     * @brief Everything but shaders a graphics pipeline is built from, copied out of the setup so that pipelines can be built off the render thread
+     */
+    struct GraphicsPipelineState {
+        VkDevice              device;         ///< Logical device the pipeline is created with
+        VkPipelineLayout      pipelineLayout; ///< Layout of the pipeline
+        VkRenderPass          renderPass;     ///< Render pass the pipeline is used in
+        VkSampleCountFlagBits samples;        ///< Rasterization samples
+        VkExtent2D            extent;         ///< Extent of the initial viewport and scissor (both are dynamic)
+        VkPipelineCache       pipelineCache;  ///< Driver cache the pipeline is created through
+    };
+
+
     /**
      * @brief Wrapped vulkan data buffer with useful informations for clean and safe utilization
      */
@@ -166,13 +224,101 @@ namespace fhope {
     };
     
     
+    /**
+     * @brief Image file decoded to memory, independently from any vulkan object
+     */
+    struct DecodedImage {
+        int width;  ///< Width of the image, in pixels
+        int height; ///< Height of the image, in pixels
+
+        std::vector<stbi_uc> pixels; ///< RGBA pixels (4 bytes each), row by row
+    };
+
+
+    /**
+     * @brief Texture whose pixels wait in a staging buffer for an upload to be recorded
+     */
+    struct TextureUpload {
+        WrappedBuffer  staging; ///< Host-visible buffer holding the base level's pixels
+        WrappedTexture texture; ///< Texture the pixels are copied to, mipmaps included
+        int            width;   ///< Width of the base level, in pixels
+        int            height;  ///< Height of the base level, in pixels
+    };
+
+
     /**
      * @brief Buffer containing values to be sent as an uniform to a shader program
      */
     struct UniformBufferObject {
-        glm::mat4 model;      ///< Model matrix (location/rotation of a model)
-        glm::mat4 view;       ///< View matrix (eye and depth)
-        glm::mat4 projection; ///< Projection matrix (perspective)
+        glm::mat4 model;          ///< Model matrix (location/rotation of a model), applied on top of every instance's
+        glm::mat4 view;           ///< View matrix (eye and depth)
+        glm::mat4 projection;     ///< Projection matrix (perspective)
+        glm::mat4 modelViewProjection; ///< Projection, view and model matrices premultiplied on the CPU, applied by the vertex shader
+    };
+
+
+    /**
+     * @brief Ways the frame's draw commands can be recorded
+     */
+    enum class RecordingMode {
+        Inline,  ///< Draws are recorded directly in the primary command buffer, on the drawing thread
+        Parallel, ///< Draws are partitioned across worker threads, each recording a secondary command buffer
+        Cached    ///< Draws are recorded once per swap chain image and frame slot, and re-recorded only when the scene version changes
+    };
+
+
+    /**
+     * @brief Presentation modes the application can ask for (FIFO is used when the requested one is not supported)
+     */
+    enum class PresentModePolicy {
+        Immediate,  ///< No vertical synchronization, may tear
+        Mailbox,    ///< Vertical synchronization, newest image replaces queued ones
+        Fifo,       ///< Vertical synchronization, images are queued (always supported)
+        FifoRelaxed ///< Vertical synchronization, late images are presented immediately and may tear
+    };
+
+
+    /**
+     * @brief Renderer options chosen by the application when generating a setup
+     */
+    struct RenderConfig {
+        RecordingMode recordingMode = RecordingMode::Inline; ///< How draw commands are recorded
+        uint32_t recordingThreads = 0; ///< Amount of slices recorded as jobs in parallel mode (0 for one per hardware thread)
+
+        uint32_t jobThreads = 0; ///< Amount of job worker threads (0 to use every hardware thread but the calling one)
+
+        uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT; ///< Amount of frames the CPU may prepare while the GPU renders previous ones (at least 1)
+        std::optional<uint32_t> swapChainImageCount; ///< Requested amount of swap chain images (clamped to the surface's limits), minimum + 1 if empty
+        PresentModePolicy presentMode = PresentModePolicy::Mailbox; ///< Requested presentation mode
+
+        bool lowLatency = false; ///< Wether or not draw_frame waits for the previous frame before sampling input (late latching) : it then polls window events itself
+
+        bool gpuProfiling = false; ///< Wether or not frames are timed on the GPU with timestamp queries
+
+        bool gpuCulling = false; ///< Wether or not instances are culled on the GPU (frustum and previous frame's depth) and drawn indirectly, recording inline
+
+        bool bindlessTextures = false; ///< Wether or not textures are read from a single bindless array, indexed per instance (ignored without descriptor indexing)
+
+        bool shaderHotReload = false; ///< Wether or not the graphics pipeline is rebuilt in the background whenever one of it's shaders is saved (requires FHOPE_RUNTIME_SHADERS)
+
+        VkDeviceSize assetBudget = DEFAULT_ASSET_BUDGET; ///< Device memory assets of the asset manager may keep resident before unreferenced ones are evicted
+
+        bool       headless = false;            ///< Wether or not frames are rendered to offscreen images, without window, surface, present queue nor swap chain
+        VkExtent2D headlessExtent = {800, 600}; ///< Extent of the offscreen images in headless mode
+    };
+
+
+    /**
+     * @brief Distribution of frame times over a run
+     */
+    struct FrameTimeStats {
+        uint32_t frameCount = 0; ///< Amount of measured frames
+
+        double minMilliseconds  = 0.0; ///< Shortest frame time
+        double meanMilliseconds = 0.0; ///< Mean frame time
+        double p50Milliseconds  = 0.0; ///< Median frame time
+        double p99Milliseconds  = 0.0; ///< 99th percentile frame time
+        double maxMilliseconds  = 0.0; ///< Longest frame time
     };
 
 
@@ -196,6 +342,11 @@ namespace fhope {
 
         std::optional<VkDevice> logicalDevice = std::nullopt; ///< Logical device derived from the physical device
 
+        bool synchronization2 = false; ///< Wether or not VK_KHR_synchronization2 is enabled on the logical device
+        bool drawIndirectCount = false; ///< Wether or not the drawIndirectCount feature is enabled on the logical device
+        bool multiDrawIndirect = false; ///< Wether or not the multiDrawIndirect feature is enabled on the logical device
+        bool descriptorIndexing = false; ///< Wether or not the descriptor indexing features of the bindless texture array are enabled on the logical device
+
         std::optional<VkQueue> graphicsQueue; ///< vulkan graphics queue if the devices
         std::optional<VkQueue> presentQueue;  ///< vulkan presentation queue if the devices
         std::optional<VkQueue> transferQueue; ///< vulkan transfer (non-graphics) queue if the devices
@@ -203,45 +354,80 @@ namespace fhope {
         std::optional<SwapChainConfig> swapChainConfig; ///< Swap chain effective configuration
 
         std::optional<VkSwapchainKHR> swapChain;           ///< Swap chain
-        std::vector<VkImage>          swapChainImages;     ///< Images of the swap chain
+        std::vector<VkImage>          swapChainImages;     ///< Images of the swap chain (the offscreen images in headless mode)
         std::vector<VkImageView>      swapChainImageViews; ///< Views to the swap chain's images
+        std::vector<WrappedTexture>   offscreenImages;     ///< Images rendered to in place of the swap chain's (only in headless mode)
+
+        std::unique_ptr<SamplerCache>          samplers;          ///< Samplers deduplicated by create info
+        std::unique_ptr<DescriptorLayoutCache> descriptorLayouts; ///< Descriptor set layouts deduplicated by create info
+        std::unique_ptr<PipelineCache>         pipelineCache;     ///< Driver pipeline cache, persisted next to the binaries
 
-        std::optional<VkDescriptorSetLayout> uniformLayout; ///< uniform layout
+        std::optional<VkDescriptorSetLayout> uniformLayout; ///< uniform layout (owned by the descriptor layout cache)
         
         std::optional<CommandPools> commandPools; ///< Command pools to use queues
         
-        std::optional<ViewableImage> colorImage; ///< Swapchain-presentable color image (must be 1-sampled)
+        std::optional<DepthBuffer> depthBuffer; ///< Depth buffer the depth pyramid is built from (only when GPU culling is enabled, the frame graph's is transient otherwise)
 
-        std::optional<DepthBuffer> depthBuffer; ///< Depth buffer
+        std::optional<FrameGraph> frameGraph; ///< Frame graph owning the render pass, the framebuffers and the transient attachments
 
         std::optional<GraphicsPipelineConfig> graphicsPipelineConfig; ///< Drawing graphics pipeline
 
-        std::vector<VkFramebuffer> swapChainFramebuffers; ///< List of framebuffers (1 per in-flight frame)
-
         //TODO: should be modular and multiple (per-model)
-        std::optional<WrappedTexture> texture; ///< Texture
-        std::optional<VkImageView> textureView; ///< View to the texture
+        std::optional<WrappedTexture> texture; ///< Texture (owned by the asset manager)
+        std::optional<VkImageView> textureView; ///< View to the texture (owned by the asset manager)
 
         //TODO: should be modular and multiple (per-model)
-        std::optional<VkSampler> textureSampler; ///< Texture sampler
+        std::optional<VkSampler> textureSampler; ///< Texture sampler (owned by the sampler cache)
 
-        //TODO: should be modular and multiple (per-model)
-        std::optional<WrappedBuffer> vertexBuffer; ///< Vertex buffer
+        std::unique_ptr<BindlessTextures> textures;         ///< Bindless texture array (only when bindless textures are enabled and supported)
+        TextureIndex                      modelTexture = 0; ///< Index of the texture in the bindless array, read by the model's instances
 
-        //TODO: should be modular and multiple (per-model)
-        std::optional<WrappedBuffer> indexBuffer; ///< Index buffer for memory-size optimization of vertices
-        std::optional<size_t> indexCount; ///< Number of indices in the buffer
+        std::unique_ptr<GeometryPool> geometry;  ///< Vertex and index buffers every mesh is sub-allocated in
+        std::optional<MeshHandle>     modelMesh; ///< Mesh of the loaded model in the geometry pool
+
+        std::unique_ptr<AssetManager>  assets;    ///< Shared textures and models, evicted past the asset budget once unreferenced
+        std::unique_ptr<DeletionQueue> deletions; ///< Destructions waiting for the frames that may use what they destroy
+
+        TextureHandle modelTextureAsset; ///< The model's texture in the asset manager, referenced as long as the setup lives
+        ModelHandle   modelAsset;        ///< The model in the asset manager, referenced as long as the setup lives
 
         std::vector<WrappedBuffer> uniformBuffers; ///< Uniform Buffer Objects (1 per in-flight frame)
 
-        std::optional<VkDescriptorPool> descriptorPool; ///< Descriptor pools to integrate descriptor sets
-        std::vector<VkDescriptorSet>    descriptorSets; ///< Descriptor sets to bind non-vertice-related data
+        std::unique_ptr<InstanceBuffer> instances; ///< Per-instance transforms of the model, drawn by the first draw item in a single instanced draw
+        std::unique_ptr<SceneGraph>     scene;     ///< Transform hierarchy, pushing changed world matrices to the instances attached to it's nodes
+        NodeHandle                      modelNode; ///< Root node the model's first instance follows
+
+        std::unique_ptr<DescriptorAllocator>              descriptorAllocator;       ///< Allocator of descriptor sets living as long as the setup
+        std::vector<std::unique_ptr<DescriptorAllocator>> transientDescriptorAllocators; ///< Allocators of descriptor sets living for a single frame, reset once the frame slot's fence has been waited on (1 per in-flight frame)
+        std::vector<VkDescriptorSet>                      descriptorSets;            ///< Descriptor sets to bind non-vertice-related data
 
         std::vector<VkCommandBuffer> commandBuffers; ///< Draw-purposed command buffers (1 per in-flight frame)
 
         std::optional<BaseSyncObjects> syncObjects; ///< Synchronization objects
 
         uint32_t currentFrame = 0; ///< Current frame counter
+
+        RenderConfig config; ///< Renderer options the setup has been generated with
+
+        std::unique_ptr<JobSystem>      jobs;  ///< Worker threads running loading, compilation and parallel recording jobs
+        std::unique_ptr<AsyncScheduler> async; ///< Resumes asset loading coroutines, pumped once per frame
+
+        std::vector<DrawItem> drawItems; ///< Draw list recorded every frame
+
+        LatencyStats latency; ///< Input-to-GPU-completion latency of drawn frames
+
+        uint64_t sceneVersion = 0; ///< Must be incremented whenever the draw list, the pipelines or the swap chain change (invalidates cached command buffers)
+
+        MVP mvp; ///< Model (shared by every instance), camera and projection matrices, written to the uniform buffers only when they change
+
+        std::optional<DeviceContext>      deviceContext; ///< Validated handles used by the drawing hot path
+        std::vector<FrameContext>         frameContexts; ///< Validated per in-flight frame resources (1 per in-flight frame)
+        std::unique_ptr<ParallelRecorder> recorder;      ///< Recording threads (only in parallel recording mode)
+        std::unique_ptr<GpuProfiler>      profiler;      ///< GPU timestamp profiler (only when GPU profiling is enabled)
+        std::unique_ptr<GpuCulling>       culling;       ///< GPU-driven culling of the model's instances (only when GPU culling is enabled)
+#ifdef FHOPE_RUNTIME_SHADERS
+        std::unique_ptr<ShaderHotReload>  shaderReload;  ///< Rebuilds the graphics pipeline when it's shaders are saved (only when shader hot reload is enabled)
+#endif
     };
 
     /***************
@@ -275,17 +461,30 @@ namespace fhope {
          *- FUNCTIONS: Setup generation -*
          *-------------------------------*/
 
-    InstanceSetup generate_vulkan_setup(GLFWwindow *window, std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion, const std::string &vertexShaderFilename, const std::string &fragmentShaderFilename, const std::string &textureFilename, const std::string &modelFilename);
+    /**
+     * @brief Generates a complete setup, ready to draw a textured model to a window (or to offscreen images in headless mode)
+     * 
+     * @param window The window to draw to (ignored, and may be nullptr, in headless mode)
+     * @param appName Name of the application
+     * @param appVersion Version of the application
+     * @param vertexShaderFilename Filename of the vertex shader's source
+     * @param fragmentShaderFilename Filename of the fragment shader's source
+     * @param textureFilename Filename of the model's texture
+     * @param modelFilename Filename of the model
+     * @param config Renderer options
+     * @return InstanceSetup The generated setup
+     */
+    InstanceSetup generate_vulkan_setup(GLFWwindow *window, std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion, const std::string &vertexShaderFilename, const std::string &fragmentShaderFilename, const std::string &textureFilename, const std::string &modelFilename, const RenderConfig &config = RenderConfig{});
 
     /**
      * @brief Prepares and returns an instance and it's setup
      * 
      * @param appName Name of the application to run on the instance
      * @param appVersion Version of the application to run on the instance
-     * @param debug Wether ot not debug mode is on
+     * @param headless Wether or not the instance will render without any window (no surface extension is enabled then)
      * @return VulkanInstanceSetup The vulkan instances and required companion values
      */
-    InstanceSetup create_instance(std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion);
+    InstanceSetup create_instance(std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion, bool headless = false);
 
     /**
      * @brief Gets a vulkan surface from a GLFW window handle
@@ -333,6 +532,16 @@ namespace fhope {
      */
     bool check_physical_device_extension_support(const InstanceSetup &setup, const VkPhysicalDevice &physicalDevice);
 
+    /**
+     * @brief Checks wether or not a physical device supports a given (optional) extension
+     * 
+     * @param physicalDevice The physical device for which to check the extension's availability
+     * @param extensionName The name of the extension
+     * @return true If the extension is supported
+     * @return false If the extension is unsupported
+     */
+    bool is_device_extension_supported(const VkPhysicalDevice &physicalDevice, const char *extensionName);
+
     /**
      * @brief Checks and returns information about the swapchain support of a given physical device with a setup
      * 
@@ -378,6 +587,14 @@ namespace fhope {
      */
     SwapChainConfig prepare_swap_chain_config(const InstanceSetup &setup, GLFWwindow *window);
 
+    /**
+     * @brief Gets the vulkan presentation mode corresponding to a policy
+     * 
+     * @param policy The presentation mode policy
+     * @return VkPresentModeKHR The corresponding vulkan presentation mode
+     */
+    VkPresentModeKHR get_present_mode(PresentModePolicy policy);
+
     /**
      * @brief Create a swap chain considering a setup and a GLFW window handle
      * 
@@ -403,6 +620,22 @@ namespace fhope {
      */
     std::vector<VkImageView> create_swap_chain_image_views(const InstanceSetup &setup);
 
+    /**
+     * @brief Prepares the configuration of the offscreen images standing in for a swap chain in headless mode
+     * 
+     * @param setup A setup containing at least a physical device (and it's requirements)
+     * @return SwapChainConfig A configuration with the headless extent and one image per in-flight frame
+     */
+    SwapChainConfig prepare_offscreen_config(const InstanceSetup &setup);
+
+    /**
+     * @brief Creates the offscreen images standing in for a swap chain's images in headless mode
+     * 
+     * @param setup A setup containing at least a swap chain config, a logical device and queues (and their requirements)
+     * @return std::vector<WrappedTexture> The created images, usable as color attachments and transfer sources
+     */
+    std::vector<WrappedTexture> create_offscreen_images(const InstanceSetup &setup);
+
     /**
      * @brief Create a vulkan descriptor set layout to bind an UniformBufferObject and a sampler
      * 
@@ -419,14 +652,6 @@ namespace fhope {
      */
     CommandPools create_command_pool(const InstanceSetup &setup);
 
-    /**
-     * @brief Creates an image intended for being the swap chain's presented image (multisampling result)
-     * 
-     * @param setup A setup containing at least a swap chain configuration and a max sample flag (and their requirements)
-     * @return ViewableImage The created image
-     */
-    ViewableImage create_color_image(const InstanceSetup &setup);
-
     /**
      * @brief Creates a texture
      * 
@@ -472,7 +697,7 @@ namespace fhope {
     std::vector<VkFormat> find_supported_formats(const InstanceSetup &setup, const std::vector<VkFormat> &candidates, const VkImageTiling &tiling, const VkFormatFeatureFlags &features);
     
     /**
-     * @brief Create a graphics pipeline for a setup, compiling a shading program on the fly
+     * @brief Create a graphics pipeline for a setup, compiling a shading program on the fly (both stages at once if the setup has a job system)
      * 
      * @param setup A setup containing at least a swap chain congiguration, a max samples flag, a descriptor set layout, and a logical device (and their requirements)
      * @param vertexShaderFilename The vertex stage's source's filename for the pipeline's shader
@@ -480,31 +705,51 @@ namespace fhope {
      * @return GraphicsPipelineConfig The created graphics pipeline
      */
     GraphicsPipelineConfig create_graphics_pipeline(const InstanceSetup &setup, const std::string &vertexShaderFilename, const std::string &fragmentShaderFilename);
+
+    /**
+     * @brief Copies the state a graphics pipeline is built from out of a setup (render thread)
+     * 
+     * @param setup A setup containing at least a logical device, a swap chain configuration, a max samples flag and a pipeline cache
+     * @param pipelineConfig The graphics pipeline whose layout and render pass are used
+     * @return GraphicsPipelineState The copied state
+     */
+    GraphicsPipelineState get_graphics_pipeline_state(const InstanceSetup &setup, const GraphicsPipelineConfig &pipelineConfig);
+
+    /**
+     * @brief Builds a graphics pipeline from compiled shaders, without reading the setup (callable from any thread)
+     * 
+     * @param state The state the pipeline is built from
+     * @param vertexShader The vertex stage, compiled to SPIR-V
+     * @param fragmentShader The fragment stage, compiled to SPIR-V
+     * @return VkPipeline The built pipeline
+     */
+    VkPipeline build_graphics_pipeline(const GraphicsPipelineState &state, std::span<const uint32_t> vertexShader, std::span<const uint32_t> fragmentShader);
     
     /**
      * @brief Creates a shader module given a compiled shader
      * 
      * @param setup A setup containing at least a logical device (and it's requirements)
-     * @param compiledShader A shader compiled to SPIR-V and linked
+     * @param compiledShader The SPIR-V words of a compiled (or embedded) shader
      * @return VkShaderModule The created shader module
      */
-    VkShaderModule create_shader_module(const InstanceSetup &setup, const shaderc::SpvCompilationResult &compiledShader);
-    
+    VkShaderModule create_shader_module(const InstanceSetup &setup, std::span<const uint32_t> compiledShader);
+
     /**
-     * @brief Creates a render pass for a setup, binding vertex data for the pipeline
+     * @brief Creates a shader module given a compiled shader
      * 
-     * @param setup A setup containing at least a swap chain configuration, a logical deive, a depth buffer, and a max samples flag (and their requirements)
-     * @return VkRenderPass The created render pass
+     * @param device The logical device to create the module with
+     * @param compiledShader The SPIR-V words of a compiled (or embedded) shader
+     * @return VkShaderModule The created shader module
      */
-    VkRenderPass create_render_pass(const InstanceSetup &setup);
+    VkShaderModule create_shader_module(VkDevice device, std::span<const uint32_t> compiledShader);
     
     /**
-     * @brief Creates framebuffers for a setup
+     * @brief Declares and compiles the frame graph of a setup : the forward pass, resolved into the swap chain's images
      * 
-     * @param setup A setup containing at least a graphics pipeline, a swap chain configuration, a logical device and a depth buffer (and their requirements)
-     * @return std::vector<VkFramebuffer> A list of created framebuffers
+     * @param setup A setup containing at least a swap chain configuration, swap chain images (and their views), a logical device, a physical device and a max samples flag, plus a depth buffer with GPU culling (and their requirements)
+     * @return FrameGraph The compiled frame graph (the forward pass' record function is set when recording frames)
      */
-    std::vector<VkFramebuffer> create_framebuffers(const InstanceSetup &setup);
+    FrameGraph create_frame_graph(const InstanceSetup &setup);
     
     /**
      * @brief Creates a texture from an (RGBA)image file, considering a setup
@@ -515,14 +760,50 @@ namespace fhope {
      */
     WrappedTexture create_texture_from_image(const InstanceSetup &setup, const std::string &textureFilename);
     
+    /**
+     * @brief Creates a texture from an already decoded image, considering a setup
+     * 
+     * @param setup A setup containing at least a logical device, command pools and a graphics queue (and their requirements)
+     * @param image The decoded image
+     * @return WrappedTexture The created texture
+     */
+    WrappedTexture create_texture_from_image(const InstanceSetup &setup, const DecodedImage &image);
+    
+    /**
+     * @brief Creates a texture and a staging buffer filled with an image's pixels, without recording anything (callable from any thread)
+     * 
+     * @param setup A setup containing at least a logical device (and it's requirements)
+     * @param image The decoded image
+     * @return TextureUpload The staged upload
+     */
+    TextureUpload prepare_texture_upload(const InstanceSetup &setup, const DecodedImage &image);
+    
+    /**
+     * @brief Records the copy of a staged upload to it's texture and the generation of it's mipmaps, leaving it shader-readable
+     * 
+     * @param setup A setup containing at least a physical device (and it's requirements)
+     * @param commandBuffer The command buffer to record in, submitted to a graphics queue
+     * @param upload The staged upload
+     */
+    void record_texture_upload(const InstanceSetup &setup, VkCommandBuffer commandBuffer, const TextureUpload &upload);
+    
+    /**
+     * @brief Destroys the staging buffer of an upload whose commands have completed
+     * 
+     * @param setup A setup containing at least a logical device (and it's requirements)
+     * @param upload The completed upload
+     */
+    void destroy_texture_upload(const InstanceSetup &setup, const TextureUpload &upload);
+    
     /**
      * @brief Memory-safely copies a source wrapped vulkan buffer's content to another's, considering a setup, using memory mapping
      * 
      * @param setup A setup containing at least a logical device, a transfer command pool, and a transfer queue (and their requirements)
      * @param source The source wrapped vulkan buffer
      * @param dest The destination wrapped vulkan buffer
+     * @param destOffset Byte offset the content is copied at in the destination buffer
      */
-    void copy_buffer(const InstanceSetup &setup, const WrappedBuffer &source, WrappedBuffer *dest);
+    void copy_buffer(const InstanceSetup &setup, const WrappedBuffer &source, WrappedBuffer *dest, VkDeviceSize destOffset = 0);
     
     /**
      * @brief Creates a wrapped vulkan data buffer for a setup, considering size, usage and required memory properties
@@ -586,6 +867,17 @@ namespace fhope {
      */
     void copy_buffer_to_image(const InstanceSetup &setup, const WrappedBuffer &dataSource, VkImage *image, uint32_t width, uint32_t height);
     
+    /**
+     * @brief Records the copy of a general purpose vulkan data buffer's content to an image's base mip level, in an already begun command buffer
+     * 
+     * @param commandBuffer The command buffer to record the copy in
+     * @param dataSource The general purpose vulkan data buffer to use as a source
+     * @param image The image to use as a destination (must be in the TRANSFER_DST_OPTIMAL layout)
+     * @param width The image's width
+     * @param height The image's height
+     */
+    void record_copy_buffer_to_image(const VkCommandBuffer &commandBuffer, const WrappedBuffer &dataSource, const VkImage &image, uint32_t width, uint32_t height);
+    
     /**
      * @brief Generates mipmaps (in-place) for a specified texture, considering a setup and parameters
      * 
@@ -598,6 +890,19 @@ namespace fhope {
      */
     void generate_mipmaps(const InstanceSetup &setup, const VkImage &image, const VkFormat &format, int width, int height, uint32_t mipLevels);
     
+    /**
+     * @brief Records the generation of mipmaps for a specified texture in an already begun command buffer, batching the final layout transitions
+     * 
+     * @param setup A setup containing at least a physical device (and it's requirements)
+     * @param commandBuffer The command buffer to record the generation in
+     * @param image The image for which to generate mipmaps (every level must be in the TRANSFER_DST_OPTIMAL layout)
+     * @param format The image's and mipmap's format
+     * @param width The image's base width
+     * @param height The image's base height
+     * @param mipLevels The amount of mipmap to generate
+     */
+    void record_mipmaps(const InstanceSetup &setup, const VkCommandBuffer &commandBuffer, const VkImage &image, const VkFormat &format, int width, int height, uint32_t mipLevels);
+    
     /**
      * @brief Creates and fills a wrapped vulkan buffer intended to be used as a vertex buffer for a specified setup, using a staging buffer
      * 
@@ -624,18 +929,10 @@ namespace fhope {
      */
     std::vector<WrappedBuffer> create_uniform_buffers(const InstanceSetup &setup);
     
-    /**
-     * @brief Creates a descriptor pool considering a setup, binding uniform buffers, samplers.
-     * 
-     * @param setup A setup containing at least a logical device (and it's requrements)
-     * @return VkDescriptorPool The created descriptor pool
-     */
-    VkDescriptorPool create_descriptor_pool(const InstanceSetup &setup);
-    
     /**
      * @brief Creates a list of descriptor sets for a descriptor pool
      * 
-     * @param setup A setup containing at least a descriptor pool, a logical device, uniform buffers, texture views and texture samplers (and their requirements)
+     * @param setup A setup containing at least a descriptor allocator, a logical device, uniform buffers, texture views and texture samplers (and their requirements)
      * @return std::vector<VkDescriptorSet> A list containing all created descriptor sets
      */
     std::vector<VkDescriptorSet> create_descriptor_sets(const InstanceSetup &setup);
@@ -668,7 +965,7 @@ namespace fhope {
     void clean_setup(const InstanceSetup &setup);
     
     /**
-     * @brief Explicitely destroys a setup's swap chain
+     * @brief Explicitely destroys a setup's swap chain (or it's offscreen images in headless mode)
      * 
      * @param setup A setup with a complete swap chain
      */
@@ -681,11 +978,36 @@ namespace fhope {
     /**
      * @brief Draws a frame considering a setup, the destination window handle, and a current frame ID
      * 
-     * @param setup A pointer to a complete setup
+     * @param setup A pointer to a complete setup, whose device and frame contexts have been created (nothing else is checked)
      * @param window A pointer to the destination window
      * @param currentFrame A pointer to the current frame's ID (which will be incremented+modulo'd just before the draw ends)
      */
     void draw_frame(InstanceSetup *setup, GLFWwindow *window, size_t *currentFrame);
+
+    /**
+     * @brief Draws a frame to the offscreen image of the current frame slot, without acquiring nor presenting anything
+     * 
+     * @param setup A pointer to a complete headless setup, whose device and frame contexts have been created (nothing else is checked)
+     * @param currentFrame A pointer to the current frame's ID (which will be incremented+modulo'd just before the draw ends)
+     */
+    void draw_offscreen_frame(InstanceSetup *setup, size_t *currentFrame);
+
+    /**
+     * @brief Draws a fixed amount of offscreen frames and measures the time between consecutive frames
+     * 
+     * @param setup A pointer to a complete headless setup
+     * @param frameCount Amount of frames to draw
+     * @return FrameTimeStats The distribution of the measured frame times
+     */
+    FrameTimeStats run_headless_benchmark(InstanceSetup *setup, uint32_t frameCount);
+
+    /**
+     * @brief Computes the distribution of a set of frame times
+     * 
+     * @param frameTimes Frame times, in milliseconds
+     * @return FrameTimeStats The distribution of the frame times (percentiles use the nearest rank)
+     */
+    FrameTimeStats compute_frame_time_stats(std::vector<double> frameTimes);
     
     /**
      * @brief Explicitely destroys, then recreates a setup's swap chain
@@ -701,17 +1023,47 @@ namespace fhope {
      * @param setup A setup containing at least uniform buffers
      * @param frame A frame ID
      */
-    void update_uniform_buffer(const InstanceSetup &setup, size_t frame);
+    void update_uniform_buffer(InstanceSetup *setup, size_t frame);
     
     /**
-     * @brief Records a command buffer for rendering
+     * @brief Computes the engine's perspective projection, flipped for vulkan's clip space
      * 
-     * @param setup A complete setup
-     * @param commandBuffer A command buffer to record
-     * @param imageIndex An image index
-     * @param currentFrame A frame ID
+     * @param extent Extent of the drawn images, for the projection's aspect ratio
+     * @return glm::mat4 The projection matrix
+     */
+    glm::mat4 compute_projection(const VkExtent2D &extent);
+    
+    /**
+     * @brief Computes the current model matrix of the demo's animation (rotation over time)
+     * 
+     * @return glm::mat4 The model matrix
+     */
+    glm::mat4 compute_model_animation();
+    
+    /**
+     * @brief Creates the engine's camera : identity model, fixed view and perspective projection
+     * 
+     * @param extent Extent of the drawn images, for the projection's aspect ratio
+     * @return MVP The camera's matrices
+     */
+    MVP create_camera(const VkExtent2D &extent);
+    
+    /**
+     * @brief Gathers an MVP's matrices in a uniform buffer object, only multiplying them again if they changed
+     * 
+     * @param mvp The MVP whose matrices are gathered (it's view and projection give the frustum to cull against)
+     * @return UniformBufferObject The matrices of the frame
+     */
+    UniformBufferObject compute_uniform_buffer_object(MVP *mvp);
+    
+    /**
+     * @brief Writes an MVP's uniform buffer object to a mapped uniform buffer, without any check
+     * 
+     * @param mvp The MVP whose matrices are written
+     * @param mapping Mapping of the uniform buffer
+     * @param sizeInBytes Size of the uniform buffer, in bytes
      */
-    void record_command_buffer(const InstanceSetup &setup, const VkCommandBuffer &commandBuffer, uint32_t imageIndex, size_t currentFrame);
+    void write_uniform_buffer(MVP *mvp, void *mapping, VkDeviceSize sizeInBytes);
   
         /*---------------------*
          *- FUNCTIONS: helper -*
@@ -724,6 +1076,32 @@ namespace fhope {
      * @return LoadedModel The loaded as loaded in the memory
      */
     LoadedModel load_model(const std::string &filename);
+
+    /**
+     * @brief Parses a model from the contents of it's file, without reading anything
+     * 
+     * @param contents Contents of the model's file (wavefront OBJ)
+     * @param name Name of the model, for error messages
+     * @return LoadedModel The parsed model
+     */
+    LoadedModel parse_model(const std::vector<char> &contents, const std::string &name);
+
+    /**
+     * @brief Decodes an image file to RGBA pixels, without any vulkan call
+     * 
+     * @param filename Name of the image file to decode
+     * @return DecodedImage The decoded image
+     */
+    DecodedImage decode_image(const std::string &filename);
+
+    /**
+     * @brief Decodes an image to RGBA pixels from the contents of it's file, without reading anything nor any vulkan call
+     * 
+     * @param contents Contents of the image's file
+     * @param name Name of the image, for error messages
+     * @return DecodedImage The decoded image
+     */
+    DecodedImage decode_image(const std::vector<char> &contents, const std::string &name);
     
     /**
      * @brief Finds suitable memory type considering type filters and required properties, for a specified physical device
@@ -734,13 +1112,27 @@ namespace fhope {
      * @return uint32_t The found suitable memory type
      */
     uint32_t find_memory_type(const VkPhysicalDevice &device, uint32_t typeFilter, const VkMemoryPropertyFlags &properties);
-    
+
+#ifdef FHOPE_RUNTIME_SHADERS
     /**
-     * @brief Compiles a shader in-memory from it's source's filename to SPIR-V bytecode
+     * @brief Compiles a shader from it's source's filename to SPIR-V bytecode, or loads it from the shader cache if the
+     * same source has already been compiled with the same options
      * 
      * @param filename The source's filename
      * @param shaderKind The shader stage (vertex, fragment, compute...)
-     * @return shaderc::SpvCompilationResult The resultat SPIR-V bytecode's wrapper
+     * @param definitions Preprocessor macros defined before compiling the source (name, value)
+     * @return std::vector<uint32_t> The resulting SPIR-V words
+     */
+    std::vector<uint32_t> compile_shader(const std::string &filename, const shaderc_shader_kind &shaderKind, const std::map<std::string, std::string> &definitions = {});
+
+    /**
+     * @brief Compiles a GLSL source in-memory to SPIR-V bytecode with shaderc, bypassing the shader cache
+     * 
+     * @param source The GLSL source
+     * @param name Name of the source, for error messages
+     * @param options The options to compile with
+     * @return std::vector<uint32_t> The resulting SPIR-V words
      */
-    shaderc::SpvCompilationResult compile_shader(const std::string &filename, const shaderc_shader_kind &shaderKind);
+    std::vector<uint32_t> compile_glsl(const std::string &source, const std::string &name, const ShaderCompileOptions &options);
+#endif
 }
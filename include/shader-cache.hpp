@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <shaderc/shaderc.hpp>
+
+namespace fhope {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+#ifdef FHOPE_SHADER_CACHE_DIR
+    inline constexpr const char *SHADER_CACHE_DIRECTORY = FHOPE_SHADER_CACHE_DIR; ///< Directory compiled shaders are cached in (next to the binaries)
+#else
+    inline constexpr const char *SHADER_CACHE_DIRECTORY = "shader-cache"; ///< Directory compiled shaders are cached in (relative to the working directory)
+#endif
+
+    inline constexpr uint32_t SHADER_CACHE_FORMAT = 1; ///< Version of the cache's key and file layout, incremented to invalidate every cached shader
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Everything but it's source the SPIR-V of a shader depends on
+     */
+    struct ShaderCompileOptions {
+        shaderc_shader_kind                kind;                     ///< Shader stage (vertex, fragment, compute...)
+        shaderc_target_env                 targetEnvironment;        ///< Environment the SPIR-V targets
+        uint32_t                           targetEnvironmentVersion; ///< Version of the target environment
+        shaderc_source_language            sourceLanguage;           ///< Language of the source
+        std::map<std::string, std::string> definitions;              ///< Preprocessor macros defined before compiling the source (name, value)
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Computes the cache key of a shader : a hash of it's source, it's options, the cache format, the
+     * compiler's SPIR-V version and the revisions of shaderc and glslang the binaries are built with
+     *
+     * No include callback is given to shaderc : the source and the definitions fully determine the preprocessed
+     * source, which therefore does not need preprocessing (nor shaderc) to be hashed.
+     *
+     * @param source The shader's GLSL source
+     * @param options The options the shader is compiled with
+     * @return uint64_t The key
+     */
+    uint64_t get_shader_cache_key(const std::string &source, const ShaderCompileOptions &options);
+
+    /**
+     * @brief Computes the cache key of a shader compiled by given revisions of shaderc and glslang
+     *
+     * @param source The shader's GLSL source
+     * @param options The options the shader is compiled with
+     * @param compilerVersion The revisions of shaderc and glslang the shader is compiled by
+     * @return uint64_t The key
+     */
+    uint64_t get_shader_cache_key(const std::string &source, const ShaderCompileOptions &options, const std::string &compilerVersion);
+
+    /**
+     * @brief Loads a cached shader
+     *
+     * @param key The shader's cache key
+     * @return std::optional<std::vector<uint32_t>> The SPIR-V words, empty if the shader is not cached (or it's file is not valid SPIR-V)
+     */
+    std::optional<std::vector<uint32_t>> load_cached_shader(uint64_t key);
+
+    /**
+     * @brief Caches a compiled shader, atomically replacing any previous file with the same key (failures are ignored :
+     * the shader is compiled again next time)
+     *
+     * @param key The shader's cache key
+     * @param code The shader's SPIR-V words
+     */
+    void store_cached_shader(uint64_t key, const std::vector<uint32_t> &code);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "task.hpp"
+
+namespace fhope {
+    struct InstanceSetup;
+
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr std::chrono::milliseconds SHADER_SCAN_INTERVAL{250}; ///< Interval between two scans of the shader directory, where it cannot be watched
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Watcher of a shader directory, reporting the sources written since it's last poll without ever blocking
+     *
+     * Uses inotify on Linux (completed writes and files moved in, which covers editors saving through a temporary file),
+     * and compares modification times every SHADER_SCAN_INTERVAL elsewhere.
+     */
+    class ShaderWatcher {
+        private:
+            std::filesystem::path directory; ///< Watched directory
+
+#ifdef __linux__
+            int inotifyFd; ///< Non-blocking inotify instance (-1 once destroyed)
+#else
+            std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes; ///< Last known modification time of each source
+            std::chrono::steady_clock::time_point                             lastScan;   ///< When the directory has last been scanned
+#endif
+
+        public:
+            /**
+             * @brief Starts watching a directory
+             *
+             * @param directory The shader directory
+             * @throws std::runtime_error If the directory cannot be watched
+             */
+            explicit ShaderWatcher(const std::filesystem::path &directory);
+
+            ShaderWatcher(const ShaderWatcher &) = delete;
+            ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+            /**
+             * @brief Explicitely stops watching
+             */
+            void destroy();
+
+            /**
+             * @brief Gets the sources written since the last poll, without blocking
+             *
+             * @return std::vector<std::string> Filenames (within the directory) of the written GLSL sources, possibly repeated
+             */
+            std::vector<std::string> poll();
+    };
+
+
+    /**
+     * @brief Rebuilds the graphics pipeline whenever one of it's shaders is saved, without stalling the render thread
+     *
+     * Sources are compiled and the pipeline built on job workers, from a copy of the fixed-function state. The new
+     * pipeline is swapped in at a frame boundary, and the old one destroyed once no in-flight frame uses it. Shaders
+     * which fail to compile are reported on std::cerr and the current pipeline kept. Render thread only.
+     */
+    class ShaderHotReload {
+        private:
+            ShaderWatcher watcher; ///< Watcher of the graphics pipeline's shader directory
+
+            bool reloading;     ///< Wether or not a reload is in progress
+            bool pendingChange; ///< Wether or not a shader has been saved again during the current reload
+
+            /**
+             * @brief Recompiles the graphics pipeline's shaders and swaps the rebuilt pipeline in
+             *
+             * @param setup A setup containing at least an async scheduler, a deletion queue and a graphics pipeline
+             * @return Task<void> The reload, spawned on the async scheduler
+             */
+            Task<void> reload(InstanceSetup *setup);
+
+        public:
+            /**
+             * @brief Starts watching a shader directory
+             *
+             * @param directory Directory of the graphics pipeline's shaders
+             */
+            explicit ShaderHotReload(const std::filesystem::path &directory);
+
+            ShaderHotReload(const ShaderHotReload &) = delete;
+            ShaderHotReload &operator=(const ShaderHotReload &) = delete;
+
+            /**
+             * @brief Explicitely stops watching (the async scheduler must have been destroyed first)
+             */
+            void destroy();
+
+            /**
+             * @brief Starts a reload if one of the graphics pipeline's shaders has been saved (render thread, once per frame)
+             *
+             * @param setup A setup containing at least an async scheduler, a deletion queue and a graphics pipeline
+             */
+            void update(InstanceSetup *setup);
+    };
+}
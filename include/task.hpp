@@ -0,0 +1,155 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace fhope {
+    template <typename T>
+    class Task;
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Promise parts shared by every task : continuation and failure
+     */
+    struct TaskPromiseBase {
+        std::coroutine_handle<> continuation; ///< Coroutine awaiting the task, resumed once it completes
+        std::exception_ptr      error;        ///< Exception the task's body threw
+
+        /**
+         * @brief Resumes the awaiting coroutine (symmetric transfer : no stack grows across chained tasks)
+         */
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) const noexcept {
+                std::coroutine_handle<> next = finished.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; } // Tasks are lazy : they start when awaited
+        FinalAwaiter        final_suspend() const noexcept { return {}; }
+
+        void unhandled_exception() noexcept { this->error = std::current_exception(); }
+    };
+
+
+    /**
+     * @brief Promise of a task producing a value
+     *
+     * @tparam T Type of the value
+     */
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase {
+        std::optional<T> value; ///< Value the task's body returned
+
+        Task<T> get_return_object() noexcept;
+
+        template <typename U>
+        void return_value(U &&returned) { this->value.emplace(std::forward<U>(returned)); }
+    };
+
+
+    /**
+     * @brief Promise of a task producing nothing
+     */
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase {
+        Task<void> get_return_object() noexcept;
+
+        void return_void() const noexcept {}
+    };
+
+
+    /**
+     * @brief Lazy coroutine producing a value once awaited, whose exceptions propagate to the awaiting coroutine
+     *
+     * A task owns it's coroutine frame, and is awaited at most once (as an rvalue). Tasks chain through symmetric
+     * transfer : awaiting a task runs it on the awaiting thread until it suspends on something else.
+     *
+     * @tparam T Type of the produced value (void for none)
+     */
+    template <typename T = void>
+    class Task {
+        public:
+            using promise_type = TaskPromise<T>;
+
+        private:
+            std::coroutine_handle<promise_type> handle; ///< Owned coroutine frame
+
+        public:
+            explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+
+            Task(Task &&o) noexcept : handle(std::exchange(o.handle, nullptr)) {}
+
+            Task &operator=(Task &&o) noexcept {
+                if (this != &o) {
+                    if (this->handle) {
+                        this->handle.destroy();
+                    }
+                    this->handle = std::exchange(o.handle, nullptr);
+                }
+
+                return *this;
+            }
+
+            Task(const Task &) = delete;
+            Task &operator=(const Task &) = delete;
+
+            ~Task() {
+                if (this->handle) {
+                    this->handle.destroy();
+                }
+            }
+
+            /**
+             * @brief Starts the task, resuming the awaiting coroutine with it's value once it completes
+             */
+            auto operator co_await() && noexcept {
+                struct Awaiter {
+                    std::coroutine_handle<promise_type> handle;
+
+                    bool await_ready() const noexcept { return !this->handle || this->handle.done(); }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                        this->handle.promise().continuation = awaiting;
+                        return this->handle;
+                    }
+
+                    T await_resume() const {
+                        if (this->handle.promise().error) {
+                            std::rethrow_exception(this->handle.promise().error);
+                        }
+
+                        if constexpr (!std::is_void_v<T>) {
+                            return std::move(*this->handle.promise().value);
+                        }
+                    }
+                };
+
+                return Awaiter{ this->handle };
+            }
+    };
+
+
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+}
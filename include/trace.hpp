@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/************
+ ** MACROS **
+ ************/
+
+#ifdef FHOPE_ENABLE_TRACING
+    #define FHOPE_TRACE_CONCAT_IMPL(a, b) a##b
+    #define FHOPE_TRACE_CONCAT(a, b) FHOPE_TRACE_CONCAT_IMPL(a, b)
+
+    /// Traces the enclosing scope under a name with static storage duration (string literal)
+    #define FHOPE_TRACE_SCOPE(name) ::fhope::trace::Scope FHOPE_TRACE_CONCAT(fhopeTraceScope, __LINE__)(name)
+    /// Traces the enclosing function under it's name
+    #define FHOPE_TRACE_FUNCTION() FHOPE_TRACE_SCOPE(__func__)
+    /// Names the calling thread in written traces
+    #define FHOPE_TRACE_THREAD_NAME(name) ::fhope::trace::set_thread_name(name)
+    /// Moves events out of every thread's ring buffer, so that they never overflow
+    #define FHOPE_TRACE_COLLECT() ::fhope::trace::collect()
+    /// Writes every traced event to a Chrome trace_event JSON file
+    #define FHOPE_TRACE_WRITE(filename) ::fhope::trace::write_chrome_trace(filename)
+#else
+    #define FHOPE_TRACE_SCOPE(name) ((void)0)
+    #define FHOPE_TRACE_FUNCTION() ((void)0)
+    #define FHOPE_TRACE_THREAD_NAME(name) ((void)0)
+    #define FHOPE_TRACE_COLLECT() ((void)0)
+    #define FHOPE_TRACE_WRITE(filename) ((void)0)
+#endif
+
+namespace fhope::trace {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    inline constexpr size_t THREAD_BUFFER_CAPACITY = 1 << 16; ///< Events each thread can hold before they are collected (power of 2)
+
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Completed traced scope
+     */
+    struct Event {
+        const char *name;             ///< Name of the scope (static storage duration)
+        uint64_t    beginNanoseconds; ///< Beginning of the scope, since the tracing epoch
+        uint64_t    endNanoseconds;   ///< End of the scope, since the tracing epoch
+    };
+
+
+    /**
+     * @brief Traces a scope from it's construction to it's destruction (use through FHOPE_TRACE_SCOPE)
+     */
+    class Scope {
+        private:
+            const char *name;             ///< Name of the scope
+            uint64_t    beginNanoseconds; ///< Beginning of the scope
+
+        public:
+            explicit Scope(const char *name);
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+    };
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    /**
+     * @brief Gets the current time of the tracing clock
+     *
+     * @return uint64_t Nanoseconds elapsed since the tracing epoch (first use of the clock)
+     */
+    uint64_t now();
+
+    /**
+     * @brief Pushes an event in the calling thread's ring buffer, without locking (the event is dropped if the buffer is full)
+     *
+     * @param event The event to record
+     */
+    void record(const Event &event);
+
+    /**
+     * @brief Names the calling thread in written traces
+     *
+     * @param name Name of the thread (static storage duration)
+     */
+    void set_thread_name(const char *name);
+
+    /**
+     * @brief Moves the events of every thread's ring buffer to the collected events
+     */
+    void collect();
+
+    /**
+     * @brief Collects pending events, then writes every collected event as a Chrome trace_event JSON file (readable by Perfetto)
+     *
+     * @param filename Name of the file to write
+     */
+    void write_chrome_trace(const std::string &filename);
+
+    /**
+     * @brief Gets the amount of events dropped because a thread's ring buffer was full
+     *
+     * @return uint64_t The amount of dropped events
+     */
+    uint64_t get_dropped_event_count();
+}
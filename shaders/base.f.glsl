@@ -1,12 +1,25 @@
 #version 450
 
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragUV;
+layout(location = 2) flat in uint fragTextureIndex;
 
+#ifdef BINDLESS
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+#else
 layout(binding = 1) uniform sampler2D texSampler;
+#endif
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
+#ifdef BINDLESS
+    outColor = texture(textures[nonuniformEXT(fragTextureIndex)], fragUV);
+#else
     outColor = texture(texSampler, fragUV);
+#endif
 }
@@ -4,17 +4,30 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 projection;
+    mat4 modelViewProjection;
 } ubo;
 
+struct Instance {
+    mat4 model;
+    uint textureIndex;
+};
+
+layout(std430, binding = 2) readonly buffer InstanceBuffer {
+    Instance data[];
+} instances;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inUV;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTextureIndex;
 
 void main() {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    // Matrix-vector products only : the model-view-projection is premultiplied on the CPU, only when it changes
+    gl_Position = ubo.modelViewProjection * (instances.data[gl_InstanceIndex].model * vec4(inPosition, 1.0));
     fragColor = inColor;
     fragUV = inUV;
+    fragTextureIndex = instances.data[gl_InstanceIndex].textureIndex;
 }
@@ -0,0 +1,134 @@
+#version 450
+
+layout(local_size_x = 64) in;
+
+struct GpuObject {
+    vec4 boundingSphere;
+    uint indexCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint instance;
+};
+
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+};
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+} ubo;
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer {
+    GpuObject objects[];
+};
+
+struct Instance {
+    mat4 model;
+    uint textureIndex;
+};
+
+layout(std430, binding = 2) readonly buffer InstanceBuffer {
+    Instance data[];
+} instances;
+
+layout(std430, binding = 3) writeonly buffer DrawBuffer {
+    DrawCommand draws[];
+};
+
+layout(std430, binding = 4) buffer CountBuffer {
+    uint drawCount;
+};
+
+layout(binding = 5) uniform sampler2D depthPyramid;
+
+layout(push_constant) uniform Constants {
+    uint objectCount;
+    uint compact;
+} constants;
+
+// View-space sphere against the clip planes of the projection (near plane at z = -w, which holds for both depth ranges)
+bool is_in_frustum(vec3 center, float radius) {
+    mat4 rows = transpose(ubo.projection);
+
+    vec4 planes[6] = vec4[6](rows[3] + rows[0], rows[3] - rows[0],
+                             rows[3] + rows[1], rows[3] - rows[1],
+                             rows[3] + rows[2], rows[3] - rows[2]);
+
+    for (int i = 0; i != 6; ++i) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Screen rectangle of the sphere against the farthest depth of the pyramid mip where it covers at most 2x2 texels
+bool is_occluded(vec3 center, float radius) {
+    vec2  uvMin = vec2(1.0);
+    vec2  uvMax = vec2(0.0);
+    float nearestDepth = 1.0;
+
+    for (int i = 0; i != 8; ++i) {
+        vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = ubo.projection * vec4(corner, 1.0);
+
+        if (clip.w <= 0.0) { // Crosses the camera plane : never occluded
+            return false;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearestDepth = min(nearestDepth, ndc.z);
+    }
+
+    uvMin = clamp(uvMin, 0.0, 1.0);
+    uvMax = clamp(uvMax, 0.0, 1.0);
+
+    vec2 size = (uvMax - uvMin) * vec2(textureSize(depthPyramid, 0));
+    int  level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, textureQueryLevels(depthPyramid) - 1);
+
+    ivec2 levelSize = textureSize(depthPyramid, level);
+    ivec2 texelMin = min(ivec2(uvMin * vec2(levelSize)), levelSize - 1);
+    ivec2 texelMax = min(ivec2(uvMax * vec2(levelSize)), levelSize - 1);
+
+    float farthestDepth = max(max(texelFetch(depthPyramid, texelMin, level).r,
+                                  texelFetch(depthPyramid, ivec2(texelMax.x, texelMin.y), level).r),
+                              max(texelFetch(depthPyramid, ivec2(texelMin.x, texelMax.y), level).r,
+                                  texelFetch(depthPyramid, texelMax, level).r));
+
+    return nearestDepth > farthestDepth;
+}
+
+void main() {
+    uint objectIndex = gl_GlobalInvocationID.x;
+
+    if (objectIndex >= constants.objectCount) {
+        return;
+    }
+
+    GpuObject object = objects[objectIndex];
+
+    mat4  modelView = ubo.view * ubo.model * instances.data[object.instance].model;
+    vec3  center = (modelView * vec4(object.boundingSphere.xyz, 1.0)).xyz;
+    float scale = max(length(modelView[0].xyz), max(length(modelView[1].xyz), length(modelView[2].xyz)));
+    float radius = object.boundingSphere.w * scale;
+
+    bool visible = is_in_frustum(center, radius) && !is_occluded(center, radius);
+
+    if (constants.compact != 0) {
+        if (visible) {
+            uint slot = atomicAdd(drawCount, 1u);
+            draws[slot] = DrawCommand(object.indexCount, 1u, object.firstIndex, object.vertexOffset, object.instance);
+        }
+    } else { // Every object keeps it's own command, culled ones draw no instance
+        draws[objectIndex] = DrawCommand(object.indexCount, visible ? 1u : 0u, object.firstIndex, object.vertexOffset, object.instance);
+    }
+}
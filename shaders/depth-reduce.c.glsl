@@ -0,0 +1,30 @@
+#version 450
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D previousLevel;
+
+layout(binding = 1, r32f) uniform writeonly image2D pyramidLevel;
+
+layout(push_constant) uniform Constants {
+    uvec2 sourceSize;
+    uvec2 levelSize;
+    int   sampleCount;
+} constants;
+
+void main() {
+    uvec2 texel = gl_GlobalInvocationID.xy;
+
+    if (any(greaterThanEqual(texel, constants.levelSize))) {
+        return;
+    }
+
+    // Once a side reaches 1 texel, the 2x2 footprint is clamped on that side
+    ivec2 first = ivec2(texel * 2);
+    ivec2 last  = min(first + 1, ivec2(constants.sourceSize) - 1);
+
+    float farthestDepth = max(max(texelFetch(previousLevel, first, 0).r, texelFetch(previousLevel, ivec2(last.x, first.y), 0).r),
+                              max(texelFetch(previousLevel, ivec2(first.x, last.y), 0).r, texelFetch(previousLevel, last, 0).r));
+
+    imageStore(pyramidLevel, ivec2(texel), vec4(farthestDepth));
+}
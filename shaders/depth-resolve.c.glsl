@@ -0,0 +1,45 @@
+#version 450
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#ifdef MULTISAMPLED
+layout(binding = 0) uniform sampler2DMS depthImage;
+#else
+layout(binding = 0) uniform sampler2D depthImage;
+#endif
+
+layout(binding = 1, r32f) uniform writeonly image2D pyramidLevel;
+
+layout(push_constant) uniform Constants {
+    uvec2 sourceSize;
+    uvec2 levelSize;
+    int   sampleCount;
+} constants;
+
+void main() {
+    uvec2 texel = gl_GlobalInvocationID.xy;
+
+    if (any(greaterThanEqual(texel, constants.levelSize))) {
+        return;
+    }
+
+    // The first mip is at most as large as the depth buffer : each of it's texels covers at least one depth texel
+    uvec2 begin = texel * constants.sourceSize / constants.levelSize;
+    uvec2 end   = max((texel + 1) * constants.sourceSize / constants.levelSize, begin + 1);
+
+    float farthestDepth = 0.0;
+
+    for (uint y = begin.y; y < end.y; ++y) {
+        for (uint x = begin.x; x < end.x; ++x) {
+#ifdef MULTISAMPLED
+            for (int s = 0; s < constants.sampleCount; ++s) {
+                farthestDepth = max(farthestDepth, texelFetch(depthImage, ivec2(x, y), s).r);
+            }
+#else
+            farthestDepth = max(farthestDepth, texelFetch(depthImage, ivec2(x, y), 0).r);
+#endif
+        }
+    }
+
+    imageStore(pyramidLevel, ivec2(texel), vec4(farthestDepth));
+}
@@ -0,0 +1,513 @@
+#include "asset-manager.hpp"
+#include "async-loading.hpp"
+#include "deletion-queue.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+namespace fhope {
+    /*************
+     ** HELPERS **
+     *************/
+
+    // Key of a file in a registry : paths naming the same file are acquired once
+    static std::string canonical_path(const std::string &filename) {
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(filename, error);
+
+        return error ? filename : canonical.generic_string();
+    }
+
+
+
+    // FNV-1a : files with the same contents share their asset
+    static uint64_t hash_contents(const std::vector<char> &contents) {
+        FHOPE_TRACE_FUNCTION();
+
+        uint64_t hash = 14695981039346656037ull;
+
+        for (char byte : contents) {
+            hash ^= static_cast<uint8_t>(byte);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    AssetManager::AssetManager(VkDeviceSize budget) : budget(budget), residentBytes(0), useClock(0) {}
+
+
+
+    AssetManager::~AssetManager() = default;
+
+
+
+    void AssetManager::destroy(const InstanceSetup &setup) {
+        for (const Entry<TextureAsset> &entry : this->textures.entries) {
+            if (entry.live && entry.target == INVALID_ASSET && entry.state == AssetState::Resident) {
+                make_destruction(setup, entry.asset)();
+            }
+        }
+
+        for (const Entry<ModelAsset> &entry : this->models.entries) {
+            if (entry.live && entry.target == INVALID_ASSET && entry.state == AssetState::Resident) {
+                make_destruction(setup, entry.asset)();
+            }
+        }
+
+        this->textures = Registry<TextureAsset>{};
+        this->models = Registry<ModelAsset>{};
+        this->residentBytes = 0;
+    }
+
+
+
+    template <typename Asset>
+    AssetHandle<Asset> AssetManager::acquire(Registry<Asset> *registry, const std::string &filename, bool *created) {
+        std::string path = canonical_path(filename);
+
+        auto found = registry->byPath.find(path);
+        if (found != registry->byPath.end()) {
+            Entry<Asset> &entry = registry->entries[found->second];
+            ++entry.references;
+            entry.lastUsed = ++this->useClock;
+
+            *created = false;
+            return AssetHandle<Asset>{ found->second, entry.generation };
+        }
+
+        uint32_t index;
+        if (!registry->freeEntries.empty()) {
+            index = registry->freeEntries.back();
+            registry->freeEntries.pop_back();
+        } else {
+            index = static_cast<uint32_t>(registry->entries.size());
+            registry->entries.emplace_back();
+        }
+
+        Entry<Asset> &entry = registry->entries[index];
+        entry.asset       = Asset{};
+        entry.state       = AssetState::Loading;
+        entry.references  = 1;
+        entry.target      = INVALID_ASSET;
+        entry.lastUsed    = ++this->useClock;
+        entry.sizeInBytes = 0;
+        entry.contentHash = 0;
+        entry.contentSize = 0;
+        entry.paths       = { path };
+        entry.live        = true;
+
+        registry->byPath.emplace(std::move(path), index);
+
+        *created = true;
+        return AssetHandle<Asset>{ index, entry.generation };
+    }
+
+
+
+    template <typename Asset>
+    AssetHandle<Asset> AssetManager::add(const InstanceSetup &setup, Registry<Asset> *registry, const std::string &filename, const Asset &asset, VkDeviceSize sizeInBytes) {
+        if (registry->byPath.contains(canonical_path(filename))) {
+            throw std::runtime_error("Tried to add an asset for a file already registered in the asset manager.");
+        }
+
+        bool created;
+        AssetHandle<Asset> handle = this->acquire(registry, filename, &created);
+
+        this->make_resident(setup, registry, handle.entry, asset, sizeInBytes);
+
+        return handle;
+    }
+
+
+
+    template <typename Asset>
+    const AssetManager::Entry<Asset> &AssetManager::resolve(const Registry<Asset> &registry, AssetHandle<Asset> handle) const {
+        if (handle.entry >= registry.entries.size() || !registry.entries[handle.entry].live || registry.entries[handle.entry].generation != handle.generation) {
+            throw std::runtime_error("Tried to use an asset handle that has been released.");
+        }
+
+        const Entry<Asset> &entry = registry.entries[handle.entry];
+
+        return entry.target == INVALID_ASSET ? entry : registry.entries[entry.target];
+    }
+
+
+
+    template <typename Asset>
+    void AssetManager::release(const InstanceSetup &setup, Registry<Asset> *registry, AssetHandle<Asset> handle) {
+        this->resolve(*registry, handle); // Rejects stale handles
+
+        Entry<Asset> &entry = registry->entries[handle.entry];
+
+        // Cached assets outlive their last handle : releasing it again must not wrap their count around
+        if (entry.references == 0) {
+            throw std::runtime_error("Tried to release an asset handle more times than it's asset has been acquired.");
+        }
+
+        --entry.references;
+        entry.lastUsed = ++this->useClock;
+
+        if (entry.target != INVALID_ASSET) {
+            Entry<Asset> &target = registry->entries[entry.target];
+            --target.references;
+            target.lastUsed = entry.lastUsed;
+
+            if (target.references == 0 && target.state == AssetState::Failed) {
+                this->free_entry(registry, entry.target);
+            }
+
+            // Aliases hold nothing : only their handles kept them
+            if (entry.references == 0) {
+                this->free_entry(registry, handle.entry);
+            }
+        } else if (entry.references == 0 && entry.state == AssetState::Failed) {
+            this->free_entry(registry, handle.entry);
+        }
+
+        this->enforce_budget(setup);
+    }
+
+
+
+    template <typename Asset>
+    bool AssetManager::share_contents(Registry<Asset> *registry, uint32_t index, uint64_t contentHash, size_t contentSize) {
+        auto found = registry->byContent.find(contentHash);
+
+        if (found == registry->byContent.end() || registry->entries[found->second].contentSize != contentSize) {
+            Entry<Asset> &entry = registry->entries[index];
+            entry.contentHash = contentHash;
+            entry.contentSize = contentSize;
+
+            registry->byContent.emplace(contentHash, index);
+            return false;
+        }
+
+        uint32_t targetIndex = found->second;
+        Entry<Asset> &entry = registry->entries[index];
+        Entry<Asset> &target = registry->entries[targetIndex];
+
+        target.references += entry.references;
+        target.lastUsed = std::max(target.lastUsed, entry.lastUsed);
+
+        // Next acquisitions of the path go to the asset directly
+        for (std::string &path : entry.paths) {
+            registry->byPath[path] = targetIndex;
+            target.paths.push_back(std::move(path));
+        }
+        entry.paths.clear();
+
+        entry.target = targetIndex;
+
+        if (entry.references == 0) {
+            this->free_entry(registry, index);
+        }
+
+        return true;
+    }
+
+
+
+    template <typename Asset>
+    void AssetManager::make_resident(const InstanceSetup &setup, Registry<Asset> *registry, uint32_t index, const Asset &asset, VkDeviceSize sizeInBytes) {
+        Entry<Asset> &entry = registry->entries[index];
+        entry.asset       = asset;
+        entry.state       = AssetState::Resident;
+        entry.sizeInBytes = sizeInBytes;
+
+        this->residentBytes += sizeInBytes;
+
+        this->enforce_budget(setup);
+    }
+
+
+
+    template <typename Asset>
+    void AssetManager::mark_failed(Registry<Asset> *registry, uint32_t index) {
+        Entry<Asset> &entry = registry->entries[index];
+        entry.state = AssetState::Failed;
+
+        // Next acquisitions of the path retry
+        for (const std::string &path : entry.paths) {
+            registry->byPath.erase(path);
+        }
+        entry.paths.clear();
+
+        auto content = registry->byContent.find(entry.contentHash);
+        if (content != registry->byContent.end() && content->second == index) {
+            registry->byContent.erase(content);
+        }
+
+        if (entry.references == 0) {
+            this->free_entry(registry, index);
+        }
+    }
+
+
+
+    template <typename Asset>
+    void AssetManager::free_entry(Registry<Asset> *registry, uint32_t index) {
+        Entry<Asset> &entry = registry->entries[index];
+
+        for (const std::string &path : entry.paths) {
+            registry->byPath.erase(path);
+        }
+
+        auto content = registry->byContent.find(entry.contentHash);
+        if (content != registry->byContent.end() && content->second == index) {
+            registry->byContent.erase(content);
+        }
+
+        entry.asset = Asset{};
+        entry.paths.clear();
+        entry.live = false;
+        ++entry.generation;
+
+        registry->freeEntries.push_back(index);
+    }
+
+
+
+    template <typename Asset>
+    void AssetManager::evict(const InstanceSetup &setup, Registry<Asset> *registry, uint32_t index) {
+        Entry<Asset> &entry = registry->entries[index];
+
+        this->residentBytes -= entry.sizeInBytes;
+
+        // In-flight frames may still use the asset
+        setup.deletions->push(make_destruction(setup, entry.asset));
+
+        this->free_entry(registry, index);
+    }
+
+
+
+    template <typename Asset>
+    uint32_t AssetManager::find_eviction_candidate(const Registry<Asset> &registry, uint64_t *lastUsed) const {
+        uint32_t candidate = INVALID_ASSET;
+
+        for (uint32_t i = 0; i != registry.entries.size(); ++i) {
+            const Entry<Asset> &entry = registry.entries[i];
+
+            if (entry.live && entry.target == INVALID_ASSET && entry.state == AssetState::Resident && entry.references == 0 && entry.lastUsed < *lastUsed) {
+                candidate = i;
+                *lastUsed = entry.lastUsed;
+            }
+        }
+
+        return candidate;
+    }
+
+
+
+    void AssetManager::enforce_budget(const InstanceSetup &setup) {
+        while (this->residentBytes > this->budget) {
+            uint64_t lastUsed = UINT64_MAX;
+
+            uint32_t texture = this->find_eviction_candidate(this->textures, &lastUsed);
+            uint32_t model = this->find_eviction_candidate(this->models, &lastUsed);
+
+            if (model != INVALID_ASSET) {
+                this->evict(setup, &this->models, model);
+            } else if (texture != INVALID_ASSET) {
+                this->evict(setup, &this->textures, texture);
+            } else {
+                return; // Everything resident is referenced
+            }
+        }
+    }
+
+
+
+    Task<void> AssetManager::load_texture(InstanceSetup *setup, uint32_t index, std::string path) {
+        AsyncScheduler &async = *setup->async;
+        std::exception_ptr loadError;
+
+        try {
+            // Worker
+            std::vector<char> contents = co_await async.read_file(path);
+            uint64_t contentHash = hash_contents(contents);
+
+            // Render thread : the registry is only touched there
+            co_await async.next_frame();
+
+            if (this->share_contents(&this->textures, index, contentHash, contents.size())) {
+                co_return;
+            }
+
+            co_await async.schedule();
+
+            TextureAsset asset = co_await create_texture_async(setup, std::move(contents), path);
+
+            // Render thread again
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(setup->logicalDevice.value(), asset.texture.texture, &requirements);
+
+            this->make_resident(*setup, &this->textures, index, asset, requirements.size);
+            co_return;
+        } catch (...) {
+            loadError = std::current_exception();
+        }
+
+        co_await async.next_frame();
+
+        this->mark_failed(&this->textures, index);
+        std::rethrow_exception(loadError);
+    }
+
+
+
+    Task<void> AssetManager::load_model(InstanceSetup *setup, uint32_t index, std::string path) {
+        AsyncScheduler &async = *setup->async;
+        std::exception_ptr loadError;
+
+        try {
+            // Worker
+            std::vector<char> contents = co_await async.read_file(path);
+            uint64_t contentHash = hash_contents(contents);
+
+            // Render thread : the registry is only touched there
+            co_await async.next_frame();
+
+            if (this->share_contents(&this->models, index, contentHash, contents.size())) {
+                co_return;
+            }
+
+            co_await async.schedule();
+
+            ModelAsset asset{};
+            asset.mesh = co_await create_model_async(setup, std::move(contents), path);
+
+            // Render thread again
+            const MeshRange &mesh = setup->geometry->get_mesh(asset.mesh);
+            VkDeviceSize sizeInBytes = static_cast<VkDeviceSize>(mesh.vertexCount) * sizeof(Vertex3D) + static_cast<VkDeviceSize>(mesh.indexCount) * sizeof(uint32_t);
+
+            this->make_resident(*setup, &this->models, index, asset, sizeInBytes);
+            co_return;
+        } catch (...) {
+            loadError = std::current_exception();
+        }
+
+        co_await async.next_frame();
+
+        this->mark_failed(&this->models, index);
+        std::rethrow_exception(loadError);
+    }
+
+
+
+    std::function<void()> AssetManager::make_destruction(const InstanceSetup &setup, const TextureAsset &asset) {
+        // Destructions are deferred past frames : the setup they have been pushed with may have moved by then
+        return [device = setup.logicalDevice.value(), textures = setup.textures.get(), asset]() { destroy_texture_asset(device, textures, asset); };
+    }
+
+
+
+    std::function<void()> AssetManager::make_destruction(const InstanceSetup &setup, const ModelAsset &asset) {
+        return [geometry = setup.geometry.get(), mesh = asset.mesh]() { geometry->remove_mesh(mesh); };
+    }
+
+
+
+    TextureHandle AssetManager::acquire_texture(InstanceSetup *setup, const std::string &filename) {
+        if (!setup->async) {
+            throw std::runtime_error("Tried to acquire a texture without providing an async scheduler in the setup.");
+        }
+
+        bool created;
+        TextureHandle handle = this->acquire(&this->textures, filename, &created);
+
+        if (created) {
+            setup->async->spawn(this->load_texture(setup, handle.entry, this->textures.entries[handle.entry].paths.front()));
+        }
+
+        return handle;
+    }
+
+
+
+    ModelHandle AssetManager::acquire_model(InstanceSetup *setup, const std::string &filename) {
+        if (!setup->async) {
+            throw std::runtime_error("Tried to acquire a model without providing an async scheduler in the setup.");
+        }
+
+        if (!setup->geometry) {
+            throw std::runtime_error("Tried to acquire a model without providing a geometry pool in the setup.");
+        }
+
+        bool created;
+        ModelHandle handle = this->acquire(&this->models, filename, &created);
+
+        if (created) {
+            setup->async->spawn(this->load_model(setup, handle.entry, this->models.entries[handle.entry].paths.front()));
+        }
+
+        return handle;
+    }
+
+
+
+    TextureHandle AssetManager::add_texture(const InstanceSetup &setup, const std::string &filename, const TextureAsset &asset, VkDeviceSize sizeInBytes) {
+        return this->add(setup, &this->textures, filename, asset, sizeInBytes);
+    }
+
+
+
+    ModelHandle AssetManager::add_model(const InstanceSetup &setup, const std::string &filename, const ModelAsset &asset, VkDeviceSize sizeInBytes) {
+        return this->add(setup, &this->models, filename, asset, sizeInBytes);
+    }
+
+
+
+    void AssetManager::release(const InstanceSetup &setup, TextureHandle handle) {
+        this->release(setup, &this->textures, handle);
+    }
+
+
+
+    void AssetManager::release(const InstanceSetup &setup, ModelHandle handle) {
+        this->release(setup, &this->models, handle);
+    }
+
+
+
+    const TextureAsset *AssetManager::get(TextureHandle handle) const {
+        const Entry<TextureAsset> &entry = this->resolve(this->textures, handle);
+
+        return entry.state == AssetState::Resident ? &entry.asset : nullptr;
+    }
+
+
+
+    const ModelAsset *AssetManager::get(ModelHandle handle) const {
+        const Entry<ModelAsset> &entry = this->resolve(this->models, handle);
+
+        return entry.state == AssetState::Resident ? &entry.asset : nullptr;
+    }
+
+
+
+    AssetState AssetManager::get_state(TextureHandle handle) const {
+        return this->resolve(this->textures, handle).state;
+    }
+
+
+
+    AssetState AssetManager::get_state(ModelHandle handle) const {
+        return this->resolve(this->models, handle).state;
+    }
+
+
+
+    VkDeviceSize AssetManager::get_resident_bytes() const {
+        return this->residentBytes;
+    }
+}
@@ -0,0 +1,146 @@
+#include "async-loading.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace fhope {
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    Task<TextureAsset> load_texture_async(InstanceSetup *setup, std::string filename) {
+        if (!setup->async) {
+            throw std::runtime_error("Tried to load a texture asynchronously without providing an async scheduler in the setup.");
+        }
+
+        std::vector<char> contents = co_await setup->async->read_file(filename);
+
+        co_return co_await create_texture_async(setup, std::move(contents), std::move(filename));
+    }
+
+
+
+    Task<TextureAsset> create_texture_async(InstanceSetup *setup, std::vector<char> contents, std::string name) {
+        if (!setup->async) {
+            throw std::runtime_error("Tried to create a texture asynchronously without providing an async scheduler in the setup.");
+        }
+
+        AsyncScheduler &async = *setup->async;
+
+        // Worker : decoding and staging
+        TextureUpload upload;
+
+        {
+            FHOPE_TRACE_SCOPE("decode texture");
+
+            DecodedImage image = decode_image(contents, name);
+            upload = prepare_texture_upload(*setup, image);
+        }
+
+        // Render thread : the graphics queue is only submitted to there
+        co_await async.next_frame();
+
+        VkCommandBuffer commandBuffer = async.begin_upload();
+        record_texture_upload(*setup, commandBuffer, upload);
+        VkFence uploaded = async.submit_upload(commandBuffer);
+
+        // Worker : nothing blocks while the GPU copies and blits
+        co_await async.gpu_complete(uploaded);
+
+        destroy_texture_upload(*setup, upload);
+
+        TextureAsset asset{};
+        asset.texture = upload.texture;
+        asset.view = create_texture_image_view(*setup, asset.texture, VK_FORMAT_R8G8B8A8_SRGB, asset.texture.mipLevels.value());
+
+        // Render thread : the upload pool, the sampler cache and the bindless array are not thread-safe
+        co_await async.next_frame();
+
+        async.release_upload(commandBuffer, uploaded);
+
+        asset.sampler = create_texture_sampler(*setup, asset.texture.mipLevels);
+
+        if (setup->textures) {
+            asset.bindlessIndex = setup->textures->add(asset.view, asset.sampler);
+        }
+
+        co_return asset;
+    }
+
+
+
+    Task<MeshHandle> load_model_async(InstanceSetup *setup, std::string filename) {
+        if (!setup->async) {
+            throw std::runtime_error("Tried to load a model asynchronously without providing an async scheduler in the setup.");
+        }
+
+        std::vector<char> contents = co_await setup->async->read_file(filename);
+
+        co_return co_await create_model_async(setup, std::move(contents), std::move(filename));
+    }
+
+
+
+    Task<MeshHandle> create_model_async(InstanceSetup *setup, std::vector<char> contents, std::string name) {
+        if (!setup->async) {
+            throw std::runtime_error("Tried to create a model asynchronously without providing an async scheduler in the setup.");
+        }
+
+        if (!setup->geometry) {
+            throw std::runtime_error("Tried to create a model asynchronously without providing a geometry pool in the setup.");
+        }
+
+        AsyncScheduler &async = *setup->async;
+
+        // Worker : parsing and staging
+        MeshUpload upload;
+
+        {
+            FHOPE_TRACE_SCOPE("parse model");
+
+            LoadedModel model = parse_model(contents, name);
+            upload = GeometryPool::stage_mesh(*setup, model.vertices, model.indices);
+        }
+
+        // Render thread : the geometry pool is not thread-safe, and the graphics queue is only submitted to there
+        co_await async.next_frame();
+
+        setup->geometry->allocate_mesh(*setup, &upload);
+
+        VkCommandBuffer commandBuffer = async.begin_upload();
+        GeometryPool::record_mesh_upload(*setup, commandBuffer, upload);
+        VkFence uploaded = async.submit_upload(commandBuffer);
+
+        // Worker : nothing blocks while the GPU copies, the handle is only given once the mesh is drawable
+        co_await async.gpu_complete(uploaded);
+
+        GeometryPool::destroy_mesh_staging(*setup, upload);
+
+        // Render thread : the upload pool is not thread-safe
+        co_await async.next_frame();
+
+        async.release_upload(commandBuffer, uploaded);
+
+        co_return upload.mesh;
+    }
+
+
+
+    void destroy_texture_asset(const InstanceSetup &setup, const TextureAsset &asset) {
+        destroy_texture_asset(setup.logicalDevice.value(), setup.textures.get(), asset);
+    }
+
+
+
+    void destroy_texture_asset(VkDevice device, BindlessTextures *textures, const TextureAsset &asset) {
+        if (asset.bindlessIndex.has_value()) {
+            textures->remove(asset.bindlessIndex.value());
+        }
+
+        vkDestroyImageView(device, asset.view, nullptr);
+
+        vkDestroyImage(device, asset.texture.texture, nullptr);
+        vkFreeMemory(device, asset.texture.memory, nullptr);
+    }
+}
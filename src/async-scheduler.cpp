@@ -0,0 +1,337 @@
+#include "async-scheduler.hpp"
+#include "job-system.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Coroutine type of spawned tasks : started immediately, freed once done, never awaited
+     */
+    struct DetachedTask {
+        struct promise_type {
+            DetachedTask get_return_object() const noexcept { return {}; }
+
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+
+            void return_void() const noexcept {}
+
+            // run_detached catches everything the task throws
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    /*************
+     ** HELPERS **
+     *************/
+
+    static std::vector<char> read_whole_file(const std::string &filename) {
+        FHOPE_TRACE_FUNCTION();
+
+        std::ifstream file(filename, std::ifstream::binary | std::ifstream::ate);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file : '" + filename + "'.");
+        }
+
+        std::vector<char> contents(static_cast<size_t>(file.tellg()));
+
+        file.seekg(0, std::ios::beg);
+        file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+
+        return contents;
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    void AsyncScheduler::ScheduleAwaiter::await_suspend(std::coroutine_handle<> coroutine) const {
+        this->jobs->run([coroutine]() { coroutine.resume(); });
+    }
+
+
+
+    void AsyncScheduler::FileReadAwaiter::await_suspend(std::coroutine_handle<> coroutine) {
+        // The awaiter lives in the suspended coroutine's frame until it is resumed
+        this->jobs->run([this, coroutine]() {
+            try {
+                this->contents = read_whole_file(this->filename);
+            } catch (...) {
+                this->error = std::current_exception();
+            }
+
+            coroutine.resume();
+        });
+    }
+
+
+
+    std::vector<char> AsyncScheduler::FileReadAwaiter::await_resume() {
+        if (this->error) {
+            std::rethrow_exception(this->error);
+        }
+
+        return std::move(this->contents);
+    }
+
+
+
+    void AsyncScheduler::GpuAwaiter::await_suspend(std::coroutine_handle<> coroutine) {
+        this->wait.coroutine = coroutine;
+
+        std::lock_guard<std::mutex> lock(this->scheduler->mutex);
+        this->scheduler->gpuWaits.push_back(this->wait);
+    }
+
+
+
+    void AsyncScheduler::FrameAwaiter::await_suspend(std::coroutine_handle<> coroutine) const {
+        std::lock_guard<std::mutex> lock(this->scheduler->mutex);
+        this->scheduler->frameWaiters.push_back(coroutine);
+    }
+
+
+
+    AsyncScheduler::AsyncScheduler(const InstanceSetup &setup, JobSystem *jobs) : jobs(jobs), pending(0) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create an async scheduler without providing a logical device in the setup.");
+        }
+
+        if (!setup.queues.has_value() || !setup.queues.value().graphicsIndex.has_value()) {
+            throw std::runtime_error("Tried to create an async scheduler without providing a graphics queue family in the setup.");
+        }
+
+        if (!setup.graphicsQueue.has_value()) {
+            throw std::runtime_error("Tried to create an async scheduler without providing a graphics queue in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+        this->queue = setup.graphicsQueue.value();
+
+        VkCommandPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolCreateInfo.queueFamilyIndex = setup.queues.value().graphicsIndex.value();
+
+        if (vkCreateCommandPool(this->device, &poolCreateInfo, nullptr, &this->uploadPool) != VK_SUCCESS) {
+            throw std::runtime_error("Could not create upload command pool.");
+        }
+    }
+
+
+
+    void AsyncScheduler::destroy() {
+        this->drain();
+
+        vkDestroyCommandPool(this->device, this->uploadPool, nullptr);
+    }
+
+
+
+    DetachedTask AsyncScheduler::run_detached(AsyncScheduler *scheduler, Task<void> task) {
+        std::exception_ptr taskError;
+
+        try {
+            co_await std::move(task);
+        } catch (...) {
+            taskError = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(scheduler->mutex);
+
+            if (taskError && !scheduler->error) {
+                scheduler->error = taskError;
+            }
+        }
+
+        scheduler->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+
+
+    void AsyncScheduler::spawn(Task<void> task) {
+        this->pending.fetch_add(1, std::memory_order_relaxed);
+
+        run_detached(this, std::move(task));
+    }
+
+
+
+    void AsyncScheduler::resume_ready() {
+        std::vector<std::coroutine_handle<>> completed;
+        std::vector<std::coroutine_handle<>> boundary;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            for (size_t i = 0; i != this->gpuWaits.size();) {
+                const GpuWait &wait = this->gpuWaits[i];
+
+                bool done;
+                if (wait.fence != VK_NULL_HANDLE) {
+                    done = vkGetFenceStatus(this->device, wait.fence) == VK_SUCCESS;
+                } else {
+                    uint64_t value(0);
+                    done = vkGetSemaphoreCounterValue(this->device, wait.semaphore, &value) == VK_SUCCESS && value >= wait.value;
+                }
+
+                if (done) {
+                    completed.push_back(wait.coroutine);
+                    this->gpuWaits[i] = this->gpuWaits.back();
+                    this->gpuWaits.pop_back();
+                } else {
+                    ++i;
+                }
+            }
+
+            // Coroutines awaiting the next boundary again while being resumed are parked for the following one
+            boundary.swap(this->frameWaiters);
+        }
+
+        for (std::coroutine_handle<> coroutine : completed) {
+            this->jobs->run([coroutine]() { coroutine.resume(); });
+        }
+
+        for (std::coroutine_handle<> coroutine : boundary) {
+            coroutine.resume();
+        }
+    }
+
+
+
+    void AsyncScheduler::pump() {
+        FHOPE_TRACE_FUNCTION();
+
+        this->resume_ready();
+
+        std::exception_ptr taskError;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            taskError = std::exchange(this->error, nullptr);
+        }
+
+        if (taskError) {
+            std::rethrow_exception(taskError);
+        }
+    }
+
+
+
+    void AsyncScheduler::drain() {
+        FHOPE_TRACE_FUNCTION();
+
+        while (this->pending.load(std::memory_order_acquire) != 0) {
+            this->resume_ready();
+            std::this_thread::yield();
+        }
+    }
+
+
+
+    uint32_t AsyncScheduler::get_pending() const {
+        return this->pending.load(std::memory_order_acquire);
+    }
+
+
+
+    AsyncScheduler::ScheduleAwaiter AsyncScheduler::schedule() const {
+        return ScheduleAwaiter{ this->jobs };
+    }
+
+
+
+    AsyncScheduler::FileReadAwaiter AsyncScheduler::read_file(std::string filename) const {
+        return FileReadAwaiter{ this->jobs, std::move(filename), {}, nullptr };
+    }
+
+
+
+    AsyncScheduler::GpuAwaiter AsyncScheduler::gpu_complete(VkFence fence) {
+        return GpuAwaiter{ this, { fence, VK_NULL_HANDLE, 0, nullptr } };
+    }
+
+
+
+    AsyncScheduler::GpuAwaiter AsyncScheduler::gpu_complete(VkSemaphore timeline, uint64_t value) {
+        return GpuAwaiter{ this, { VK_NULL_HANDLE, timeline, value, nullptr } };
+    }
+
+
+
+    AsyncScheduler::FrameAwaiter AsyncScheduler::next_frame() {
+        return FrameAwaiter{ this };
+    }
+
+
+
+    VkCommandBuffer AsyncScheduler::begin_upload() {
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = this->uploadPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(this->device, &allocateInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't allocate upload command buffer.");
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't record upload command buffer (beginning).");
+        }
+
+        return commandBuffer;
+    }
+
+
+
+    VkFence AsyncScheduler::submit_upload(VkCommandBuffer commandBuffer) {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record upload command buffer (end).");
+        }
+
+        VkFenceCreateInfo fenceCreateInfo{};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence fence;
+        if (vkCreateFence(this->device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create upload fence.");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        if (vkQueueSubmit(this->queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit upload command buffer.");
+        }
+
+        return fence;
+    }
+
+
+
+    void AsyncScheduler::release_upload(VkCommandBuffer commandBuffer, VkFence fence) {
+        vkFreeCommandBuffers(this->device, this->uploadPool, 1, &commandBuffer);
+        vkDestroyFence(this->device, fence, nullptr);
+    }
+}
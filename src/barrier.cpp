@@ -0,0 +1,210 @@
+#include "barrier.hpp"
+
+#include <stdexcept>
+
+namespace fhope {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    // Accesses which actually need to be made available by a barrier's first scope
+    static constexpr VkAccessFlags2KHR WRITE_ACCESSES = VK_ACCESS_2_SHADER_WRITE_BIT_KHR
+                                                      | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR
+                                                      | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR
+                                                      | VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR
+                                                      | VK_ACCESS_2_HOST_WRITE_BIT_KHR
+                                                      | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+
+    /*************
+     ** METHODS **
+     *************/
+
+    BarrierBatch::BarrierBatch(bool useSynchronization2) : useSynchronization2(useSynchronization2) {}
+
+
+
+    BarrierBatch &BarrierBatch::transition_image(VkImage image, const VkImageSubresourceRange &range, VkImageLayout oldLayout, VkImageLayout newLayout) {
+        return this->transition_image(image, range, oldLayout, newLayout, get_layout_stage_access(oldLayout, true), get_layout_stage_access(newLayout, false));
+    }
+
+
+
+    BarrierBatch &BarrierBatch::transition_image(VkImage image, const VkImageSubresourceRange &range, VkImageLayout oldLayout, VkImageLayout newLayout, const StageAccess &source, const StageAccess &destination) {
+        VkImageMemoryBarrier2KHR barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+        barrier.srcStageMask  = source.stages;
+        barrier.srcAccessMask = source.access & WRITE_ACCESSES;
+        barrier.dstStageMask  = destination.stages;
+        barrier.dstAccessMask = destination.access;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = range;
+
+        this->imageBarriers.push_back(barrier);
+
+        return *this;
+    }
+
+
+
+    BarrierBatch &BarrierBatch::buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const StageAccess &source, const StageAccess &destination) {
+        VkBufferMemoryBarrier2KHR barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+        barrier.srcStageMask  = source.stages;
+        barrier.srcAccessMask = source.access & WRITE_ACCESSES;
+        barrier.dstStageMask  = destination.stages;
+        barrier.dstAccessMask = destination.access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size   = size;
+
+        this->bufferBarriers.push_back(barrier);
+
+        return *this;
+    }
+
+
+
+    bool BarrierBatch::empty() const {
+        return this->imageBarriers.empty() && this->bufferBarriers.empty();
+    }
+
+
+
+    void BarrierBatch::flush(VkCommandBuffer commandBuffer) {
+        if (this->empty()) {
+            return;
+        }
+
+        if (this->useSynchronization2) {
+            VkDependencyInfoKHR dependencyInfo{};
+            dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+            dependencyInfo.imageMemoryBarrierCount  = static_cast<uint32_t>(this->imageBarriers.size());
+            dependencyInfo.pImageMemoryBarriers     = this->imageBarriers.data();
+            dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(this->bufferBarriers.size());
+            dependencyInfo.pBufferMemoryBarriers    = this->bufferBarriers.data();
+
+            vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+        } else {
+            // Legacy barriers share a single pair of stage masks : merge every barrier's scopes.
+            // Every synchronization2 bit we emit has the same value as it's legacy counterpart.
+            VkPipelineStageFlags sourceStages(0);
+            VkPipelineStageFlags destStages(0);
+
+            std::vector<VkImageMemoryBarrier> legacyImageBarriers(this->imageBarriers.size());
+            for (size_t i = 0; i != this->imageBarriers.size(); ++i) {
+                const VkImageMemoryBarrier2KHR &barrier = this->imageBarriers[i];
+
+                legacyImageBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                legacyImageBarriers[i].srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+                legacyImageBarriers[i].dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+                legacyImageBarriers[i].oldLayout = barrier.oldLayout;
+                legacyImageBarriers[i].newLayout = barrier.newLayout;
+                legacyImageBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+                legacyImageBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+                legacyImageBarriers[i].image = barrier.image;
+                legacyImageBarriers[i].subresourceRange = barrier.subresourceRange;
+
+                sourceStages |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+                destStages   |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+            }
+
+            std::vector<VkBufferMemoryBarrier> legacyBufferBarriers(this->bufferBarriers.size());
+            for (size_t i = 0; i != this->bufferBarriers.size(); ++i) {
+                const VkBufferMemoryBarrier2KHR &barrier = this->bufferBarriers[i];
+
+                legacyBufferBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                legacyBufferBarriers[i].srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+                legacyBufferBarriers[i].dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+                legacyBufferBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+                legacyBufferBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+                legacyBufferBarriers[i].buffer = barrier.buffer;
+                legacyBufferBarriers[i].offset = barrier.offset;
+                legacyBufferBarriers[i].size   = barrier.size;
+
+                sourceStages |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+                destStages   |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+            }
+
+            // STAGE_2_NONE has no legacy equivalent when used alone
+            if (sourceStages == 0) { sourceStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT; }
+            if (destStages   == 0) { destStages   = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT; }
+
+            vkCmdPipelineBarrier(commandBuffer,
+                sourceStages, destStages, 0,
+                0, nullptr,
+                static_cast<uint32_t>(legacyBufferBarriers.size()), legacyBufferBarriers.data(),
+                static_cast<uint32_t>(legacyImageBarriers.size()),  legacyImageBarriers.data()
+            );
+        }
+
+        this->imageBarriers.clear();
+        this->bufferBarriers.clear();
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    StageAccess get_layout_stage_access(VkImageLayout layout, bool asSource) {
+        switch (layout) {
+            case VK_IMAGE_LAYOUT_UNDEFINED:
+                if (!asSource) {
+                    throw std::runtime_error("Tried to transition an image to the undefined layout.");
+                }
+                return { VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR };
+
+            case VK_IMAGE_LAYOUT_PREINITIALIZED:
+                return { VK_PIPELINE_STAGE_2_HOST_BIT_KHR, VK_ACCESS_2_HOST_WRITE_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                return { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+                return { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+                return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+                return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+                return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_SHADER_READ_BIT_KHR };
+
+            case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+                // The presentation engine is synchronized through semaphores, not barriers
+                return { VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR };
+
+            default:
+                return { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR, VK_ACCESS_2_MEMORY_READ_BIT_KHR | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR };
+        }
+    }
+
+
+
+    VkImageAspectFlags get_format_aspect(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+            case VK_FORMAT_D32_SFLOAT:
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+            default:
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+}
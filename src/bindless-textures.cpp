@@ -0,0 +1,160 @@
+#include "bindless-textures.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fhope {
+    /*************
+     ** METHODS **
+     *************/
+
+    BindlessTextures::BindlessTextures(const InstanceSetup &setup, uint32_t requestedCapacity) : nextSlot(0) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create bindless textures without providing a logical device in the setup.");
+        }
+
+        if (!setup.physicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create bindless textures without providing a physical device in the setup.");
+        }
+
+        if (!setup.descriptorIndexing) {
+            throw std::runtime_error("Tried to create bindless textures on a logical device created without descriptor indexing.");
+        }
+
+        this->device = setup.logicalDevice.value();
+
+        VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+        vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &vulkan12Properties;
+        vkGetPhysicalDeviceProperties2(setup.physicalDevice.value(), &properties);
+
+        this->capacity = std::min({ std::max(requestedCapacity, 1u), vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers, vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages });
+
+        VkDescriptorSetLayoutBinding textureBinding{};
+        textureBinding.binding = BINDLESS_TEXTURE_BINDING;
+        textureBinding.descriptorCount = this->capacity;
+        textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        textureBinding.pImmutableSamplers = nullptr;
+
+        // Slots never written stay unbound, and free slots are written while frames reading other slots are pending
+        VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{};
+        bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsCreateInfo.bindingCount = 1;
+        bindingFlagsCreateInfo.pBindingFlags = &bindingFlags;
+
+        VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+        layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+        layoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layoutCreateInfo.bindingCount = 1;
+        layoutCreateInfo.pBindings = &textureBinding;
+
+        if (vkCreateDescriptorSetLayout(this->device, &layoutCreateInfo, nullptr, &this->layout) != VK_SUCCESS) {
+            throw std::runtime_error("Could not create bindless texture set layout.");
+        }
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSize.descriptorCount = this->capacity;
+
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolCreateInfo.poolSizeCount = 1;
+        poolCreateInfo.pPoolSizes = &poolSize;
+        poolCreateInfo.maxSets = 1;
+
+        if (vkCreateDescriptorPool(this->device, &poolCreateInfo, nullptr, &this->pool) != VK_SUCCESS) {
+            throw std::runtime_error("Could not create bindless texture descriptor pool.");
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = this->pool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &this->layout;
+
+        if (vkAllocateDescriptorSets(this->device, &allocateInfo, &this->descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't allocate bindless texture descriptor set.");
+        }
+    }
+
+
+
+    void BindlessTextures::destroy() {
+        vkDestroyDescriptorPool(this->device, this->pool, nullptr);
+        vkDestroyDescriptorSetLayout(this->device, this->layout, nullptr);
+    }
+
+
+
+    TextureIndex BindlessTextures::add(VkImageView view, VkSampler sampler) {
+        TextureIndex index;
+
+        if (!this->freeSlots.empty()) {
+            index = this->freeSlots.back();
+            this->freeSlots.pop_back();
+        } else if (this->nextSlot != this->capacity) {
+            index = this->nextSlot++;
+        } else {
+            throw std::runtime_error("Tried to add a texture to a full bindless texture array.");
+        }
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = view;
+        imageInfo.sampler = sampler;
+
+        VkWriteDescriptorSet writeInfo{};
+        writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeInfo.dstSet = this->descriptorSet;
+        writeInfo.dstBinding = BINDLESS_TEXTURE_BINDING;
+        writeInfo.dstArrayElement = index;
+        writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writeInfo.descriptorCount = 1;
+        writeInfo.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(this->device, 1, &writeInfo, 0, nullptr);
+
+        return index;
+    }
+
+
+
+    void BindlessTextures::remove(TextureIndex index) {
+        if (index >= this->nextSlot || std::find(this->freeSlots.begin(), this->freeSlots.end(), index) != this->freeSlots.end()) {
+            throw std::runtime_error("Tried to remove a bindless texture that does not exist.");
+        }
+
+        // The slot keeps it's stale descriptor until it is reused : partially bound slots are only invalid when read
+        this->freeSlots.push_back(index);
+    }
+
+
+
+    uint32_t BindlessTextures::get_capacity() const {
+        return this->capacity;
+    }
+
+
+
+    VkDescriptorSetLayout BindlessTextures::get_layout() const {
+        return this->layout;
+    }
+
+
+
+    VkDescriptorSet BindlessTextures::get_descriptor_set() const {
+        return this->descriptorSet;
+    }
+}
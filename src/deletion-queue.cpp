@@ -0,0 +1,60 @@
+#include "deletion-queue.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+namespace fhope {
+    /*************
+     ** METHODS **
+     *************/
+
+    DeletionQueue::DeletionQueue(uint32_t framesInFlight) : submitted(0), completed(0), slotSubmissions(std::max(framesInFlight, 1u), 0) {}
+
+
+
+    void DeletionQueue::push(std::function<void()> destroy) {
+        // The frame being prepared is the next submission
+        this->deletions.push_back(Deletion{ this->submitted + 1, std::move(destroy) });
+    }
+
+
+
+    void DeletionQueue::mark_submitted(uint32_t frameIndex) {
+        this->slotSubmissions[frameIndex] = ++this->submitted;
+    }
+
+
+
+    void DeletionQueue::collect(uint32_t frameIndex) {
+        FHOPE_TRACE_FUNCTION();
+
+        this->completed = std::max(this->completed, this->slotSubmissions[frameIndex]);
+
+        while (!this->deletions.empty() && this->deletions.front().submission <= this->completed) {
+            // Popped first : a destruction may push others
+            std::function<void()> destroy = std::move(this->deletions.front().destroy);
+            this->deletions.pop_front();
+
+            destroy();
+        }
+    }
+
+
+
+    void DeletionQueue::flush() {
+        while (!this->deletions.empty()) {
+            std::function<void()> destroy = std::move(this->deletions.front().destroy);
+            this->deletions.pop_front();
+
+            destroy();
+        }
+
+        this->completed = this->submitted;
+    }
+
+
+
+    size_t DeletionQueue::size() const {
+        return this->deletions.size();
+    }
+}
@@ -0,0 +1,367 @@
+#include "descriptor-allocator.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+
+namespace fhope {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    // Descriptors per set of the engine's usual sets (frame sets, culling and pyramid sets)
+    static const std::vector<PoolSizeRatio> DEFAULT_POOL_SIZE_RATIOS = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         1.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         2.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          1.0f }
+    };
+
+    /*************
+     ** HELPERS **
+     *************/
+
+    template<typename T>
+    static void hash_combine(size_t *seed, const T &value) {
+        *seed ^= std::hash<T>()(value) + 0x9e3779b9 + (*seed << 6) + (*seed >> 2);
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    bool SamplerKey::operator==(const SamplerKey &o) const {
+        return this->info.flags                   == o.info.flags
+            && this->info.magFilter               == o.info.magFilter
+            && this->info.minFilter               == o.info.minFilter
+            && this->info.mipmapMode              == o.info.mipmapMode
+            && this->info.addressModeU            == o.info.addressModeU
+            && this->info.addressModeV            == o.info.addressModeV
+            && this->info.addressModeW            == o.info.addressModeW
+            && this->info.mipLodBias              == o.info.mipLodBias
+            && this->info.anisotropyEnable        == o.info.anisotropyEnable
+            && this->info.maxAnisotropy           == o.info.maxAnisotropy
+            && this->info.compareEnable           == o.info.compareEnable
+            && this->info.compareOp               == o.info.compareOp
+            && this->info.minLod                  == o.info.minLod
+            && this->info.maxLod                  == o.info.maxLod
+            && this->info.borderColor             == o.info.borderColor
+            && this->info.unnormalizedCoordinates == o.info.unnormalizedCoordinates;
+    }
+
+
+
+    size_t SamplerKeyHash::operator() (const SamplerKey &toHash) const {
+        size_t seed(0);
+        hash_combine(&seed, toHash.info.flags);
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.magFilter));
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.minFilter));
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.mipmapMode));
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.addressModeU));
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.addressModeV));
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.addressModeW));
+        hash_combine(&seed, toHash.info.mipLodBias);
+        hash_combine(&seed, toHash.info.anisotropyEnable);
+        hash_combine(&seed, toHash.info.maxAnisotropy);
+        hash_combine(&seed, toHash.info.compareEnable);
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.compareOp));
+        hash_combine(&seed, toHash.info.minLod);
+        hash_combine(&seed, toHash.info.maxLod);
+        hash_combine(&seed, static_cast<uint32_t>(toHash.info.borderColor));
+        hash_combine(&seed, toHash.info.unnormalizedCoordinates);
+
+        return seed;
+    }
+
+
+
+    bool DescriptorLayoutKey::operator==(const DescriptorLayoutKey &o) const {
+        if (this->flags != o.flags || this->bindings.size() != o.bindings.size() || this->bindingFlags != o.bindingFlags || this->immutableSamplers != o.immutableSamplers) {
+            return false;
+        }
+
+        for (size_t i = 0; i != this->bindings.size(); ++i) {
+            const VkDescriptorSetLayoutBinding &a = this->bindings[i];
+            const VkDescriptorSetLayoutBinding &b = o.bindings[i];
+
+            if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    size_t DescriptorLayoutKeyHash::operator() (const DescriptorLayoutKey &toHash) const {
+        size_t seed(0);
+        hash_combine(&seed, toHash.flags);
+
+        for (const VkDescriptorSetLayoutBinding &binding : toHash.bindings) {
+            hash_combine(&seed, binding.binding);
+            hash_combine(&seed, static_cast<uint32_t>(binding.descriptorType));
+            hash_combine(&seed, binding.descriptorCount);
+            hash_combine(&seed, binding.stageFlags);
+        }
+
+        for (VkDescriptorBindingFlags flags : toHash.bindingFlags) {
+            hash_combine(&seed, flags);
+        }
+
+        // Sizes keep samplers split differently across bindings from hashing alike
+        for (const std::vector<VkSampler> &samplers : toHash.immutableSamplers) {
+            hash_combine(&seed, samplers.size());
+
+            for (VkSampler sampler : samplers) {
+                hash_combine(&seed, sampler);
+            }
+        }
+
+        return seed;
+    }
+
+
+
+    DescriptorAllocator::DescriptorAllocator(const InstanceSetup &setup, const std::vector<PoolSizeRatio> &poolRatios, uint32_t initialSets) : setsPerPool(std::clamp(initialSets, 1u, MAX_DESCRIPTOR_POOL_SETS)), currentPool(VK_NULL_HANDLE) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a descriptor allocator without providing a logical device in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+        this->ratios = poolRatios.empty() ? DEFAULT_POOL_SIZE_RATIOS : poolRatios;
+    }
+
+
+
+    VkDescriptorPool DescriptorAllocator::grab_pool() {
+        if (!this->freePools.empty()) {
+            VkDescriptorPool pool = this->freePools.back();
+            this->freePools.pop_back();
+
+            return pool;
+        }
+
+        FHOPE_TRACE_SCOPE("DescriptorAllocator::grab_pool");
+
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        poolSizes.reserve(this->ratios.size());
+        for (const PoolSizeRatio &ratio : this->ratios) {
+            poolSizes.push_back({ ratio.type, std::max(static_cast<uint32_t>(ratio.ratio * this->setsPerPool), 1u) });
+        }
+
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolCreateInfo.pPoolSizes = poolSizes.data();
+        poolCreateInfo.maxSets = this->setsPerPool;
+
+        VkDescriptorPool newPool;
+        if (vkCreateDescriptorPool(this->device, &poolCreateInfo, nullptr, &newPool) != VK_SUCCESS) {
+            throw std::runtime_error("Could not create descriptor pool.");
+        }
+
+        this->setsPerPool = std::min(this->setsPerPool * 2, MAX_DESCRIPTOR_POOL_SETS);
+
+        return newPool;
+    }
+
+
+
+    void DescriptorAllocator::destroy() {
+        this->reset();
+
+        for (VkDescriptorPool pool : this->freePools) {
+            vkDestroyDescriptorPool(this->device, pool, nullptr);
+        }
+
+        this->freePools.clear();
+    }
+
+
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+        if (this->currentPool == VK_NULL_HANDLE) {
+            this->currentPool = this->grab_pool();
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = this->currentPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet newSet;
+        VkResult result = vkAllocateDescriptorSets(this->device, &allocateInfo, &newSet);
+
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+            // The exhausted pool is kept until the next reset : it's sets are still in use
+            this->fullPools.push_back(this->currentPool);
+            this->currentPool = this->grab_pool();
+
+            allocateInfo.descriptorPool = this->currentPool;
+            result = vkAllocateDescriptorSets(this->device, &allocateInfo, &newSet);
+        }
+
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't allocate descriptor set.");
+        }
+
+        return newSet;
+    }
+
+
+
+    void DescriptorAllocator::reset() {
+        if (this->currentPool != VK_NULL_HANDLE) {
+            this->fullPools.push_back(this->currentPool);
+            this->currentPool = VK_NULL_HANDLE;
+        }
+
+        for (VkDescriptorPool pool : this->fullPools) {
+            vkResetDescriptorPool(this->device, pool, 0);
+            this->freePools.push_back(pool);
+        }
+
+        this->fullPools.clear();
+    }
+
+
+
+    SamplerCache::SamplerCache(const InstanceSetup &setup) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a sampler cache without providing a logical device in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+    }
+
+
+
+    void SamplerCache::destroy() {
+        for (const auto &[key, sampler] : this->samplers) {
+            vkDestroySampler(this->device, sampler, nullptr);
+        }
+
+        this->samplers.clear();
+    }
+
+
+
+    VkSampler SamplerCache::get(const VkSamplerCreateInfo &createInfo) {
+        if (createInfo.pNext != nullptr) {
+            throw std::runtime_error("Tried to cache a sampler whose create info has an extension chain.");
+        }
+
+        SamplerKey key{ createInfo };
+
+        auto found = this->samplers.find(key);
+        if (found != this->samplers.end()) {
+            return found->second;
+        }
+
+        VkSampler newSampler;
+        if (vkCreateSampler(this->device, &createInfo, nullptr, &newSampler) != VK_SUCCESS) {
+            throw std::runtime_error("Could not create texture sampler.");
+        }
+
+        this->samplers.emplace(key, newSampler);
+
+        return newSampler;
+    }
+
+
+
+    size_t SamplerCache::size() const {
+        return this->samplers.size();
+    }
+
+
+
+    DescriptorLayoutCache::DescriptorLayoutCache(const InstanceSetup &setup) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a descriptor layout cache without providing a logical device in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+    }
+
+
+
+    void DescriptorLayoutCache::destroy() {
+        for (const auto &[key, layout] : this->layouts) {
+            vkDestroyDescriptorSetLayout(this->device, layout, nullptr);
+        }
+
+        this->layouts.clear();
+    }
+
+
+
+    VkDescriptorSetLayout DescriptorLayoutCache::get(const VkDescriptorSetLayoutCreateInfo &createInfo) {
+        const VkDescriptorSetLayoutBindingFlagsCreateInfo *bindingFlagsInfo = nullptr;
+
+        if (createInfo.pNext != nullptr) {
+            const VkDescriptorSetLayoutBindingFlagsCreateInfo *chained = static_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo *>(createInfo.pNext);
+
+            if (chained->sType != VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO || chained->pNext != nullptr) {
+                throw std::runtime_error("Tried to cache a descriptor set layout whose create info chains more than binding flags.");
+            }
+
+            bindingFlagsInfo = chained;
+        }
+
+        // Bindings are compared in binding order, whatever order they were given in
+        std::vector<uint32_t> order(createInfo.bindingCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&createInfo](uint32_t a, uint32_t b) {
+            return createInfo.pBindings[a].binding < createInfo.pBindings[b].binding;
+        });
+
+        DescriptorLayoutKey key{};
+        key.flags = createInfo.flags;
+        key.bindings.reserve(createInfo.bindingCount);
+        key.immutableSamplers.reserve(createInfo.bindingCount);
+
+        for (uint32_t i : order) {
+            VkDescriptorSetLayoutBinding binding = createInfo.pBindings[i];
+
+            // Samplers stay with their binding : layouts only differing by which binding owns them are different layouts
+            std::vector<VkSampler> &samplers = key.immutableSamplers.emplace_back();
+            if (binding.pImmutableSamplers != nullptr) {
+                samplers.assign(binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+                binding.pImmutableSamplers = nullptr;
+            }
+
+            key.bindings.push_back(binding);
+
+            if (bindingFlagsInfo != nullptr && bindingFlagsInfo->bindingCount != 0) {
+                key.bindingFlags.push_back(bindingFlagsInfo->pBindingFlags[i]);
+            }
+        }
+
+        auto found = this->layouts.find(key);
+        if (found != this->layouts.end()) {
+            return found->second;
+        }
+
+        VkDescriptorSetLayout newLayout;
+        if (vkCreateDescriptorSetLayout(this->device, &createInfo, nullptr, &newLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Could not create descriptor set layout.");
+        }
+
+        this->layouts.emplace(std::move(key), newLayout);
+
+        return newLayout;
+    }
+
+
+
+    size_t DescriptorLayoutCache::size() const {
+        return this->layouts.size();
+    }
+}
@@ -0,0 +1,29 @@
+#include "embedded-shaders.hpp"
+#include "embedded-spirv.hpp" // Generated at build time
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace fhope {
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    std::span<const uint32_t> get_embedded_shader(const std::string &filename, const std::map<std::string, std::string> &definitions) {
+        std::string name = std::filesystem::path(filename).filename().string();
+
+        // Same layout as the build step's : maps are sorted by name
+        std::string variant;
+        for (const auto &[definitionName, value] : definitions) {
+            variant += (variant.empty() ? "" : ",") + definitionName + "=" + value;
+        }
+
+        for (const EmbeddedShader &shader : embedded::SHADERS) {
+            if (name == shader.filename && variant == shader.definitions) {
+                return shader.code;
+            }
+        }
+
+        throw std::runtime_error("Shader '" + name + "' has not been embedded with definitions [" + variant + "] at build time.");
+    }
+}
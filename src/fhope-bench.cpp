@@ -0,0 +1,600 @@
+#include "fhope-bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define GLAD_VULKAN_IMPLEMENTATION
+#include <glad/vulkan.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "setup.hpp"
+#include "vertex.hpp"
+#include "mvp.hpp"
+#include "mvp-batch.hpp"
+#include "frustum-culling.hpp"
+#include "scene-graph.hpp"
+#include "job-system.hpp"
+
+namespace fhope::bench {
+    /*************
+     ** HELPERS **
+     *************/
+
+    // Results are accumulated here so that measured code is never optimized away
+    static volatile uint64_t sink = 0;
+
+
+
+    static std::vector<Vertex3D> make_random_vertices(size_t count) {
+        std::mt19937 generator(1234); // Fixed seed : every run hashes the same vertices
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+        std::vector<Vertex3D> vertices(count);
+        for (Vertex3D &vertex : vertices) {
+            vertex.position = { distribution(generator), distribution(generator), distribution(generator) };
+            vertex.color    = { 1.0f, 1.0f, 1.0f };
+            vertex.uv       = { distribution(generator), distribution(generator) };
+        }
+
+        return vertices;
+    }
+
+
+
+    static SphereSoA make_random_spheres(size_t count) {
+        std::mt19937 generator(1234); // Fixed seed : every run culls the same spheres
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> radius(0.1f, 2.0f);
+
+        SphereSoA spheres;
+        for (size_t i = 0; i != count; ++i) {
+            spheres.push_back({ position(generator), position(generator), position(generator), radius(generator) });
+        }
+
+        return spheres;
+    }
+
+
+
+    static AabbSoA make_random_boxes(size_t count) {
+        std::mt19937 generator(1234); // Fixed seed : every run culls the same boxes
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        AabbSoA boxes;
+        for (size_t i = 0; i != count; ++i) {
+            glm::vec3 center(position(generator), position(generator), position(generator));
+            glm::vec3 halfExtent(extent(generator), extent(generator), extent(generator));
+            boxes.push_back(center - halfExtent, center + halfExtent);
+        }
+
+        return boxes;
+    }
+
+
+
+    static MatrixSoA make_random_models(size_t count) {
+        std::mt19937 generator(1234); // Fixed seed : every run multiplies the same models
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+
+        MatrixSoA models;
+        for (size_t i = 0; i != count; ++i) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(generator), position(generator), position(generator)));
+            models.push_back(glm::rotate(model, angle(generator), glm::vec3(0.0f, 0.0f, 1.0f)));
+        }
+
+        return models;
+    }
+
+
+
+    // Throws if a batched kernel strays from glm's product by more than float rounding
+    static void check_mvp_kernel(const char *name, void (*kernel)(const glm::mat4 &, const MatrixSoA &, MatrixSoA *), const glm::mat4 &viewProjection, const MatrixSoA &models) {
+        MatrixSoA mvps;
+        kernel(viewProjection, models, &mvps);
+
+        for (size_t i = 0; i != models.size(); ++i) {
+            glm::mat4 expected = viewProjection * models.get(i);
+            glm::mat4 computed = mvps.get(i);
+
+            for (int column = 0; column != 4; ++column) {
+                for (int row = 0; row != 4; ++row) {
+                    if (std::abs(computed[column][row] - expected[column][row]) > 1e-4f * std::max(1.0f, std::abs(expected[column][row]))) {
+                        throw std::runtime_error(std::string("MVP kernel ") + name + " does not match glm.");
+                    }
+                }
+            }
+        }
+    }
+
+
+
+    // Every node is parented to a random earlier one, the first being the only root
+    static std::shared_ptr<SceneGraph> make_random_scene(size_t count) {
+        std::mt19937 generator(1234); // Fixed seed : every run updates the same hierarchy
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+        auto scene = std::make_shared<SceneGraph>();
+        std::vector<NodeHandle> nodes;
+        for (size_t i = 0; i != count; ++i) {
+            NodeHandle parent = nodes.empty() ? INVALID_NODE : nodes[std::uniform_int_distribution<size_t>(0, nodes.size() - 1)(generator)];
+            glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(offset(generator), offset(generator), offset(generator)));
+            nodes.push_back(scene->add_node(local, parent));
+        }
+        scene->update();
+
+        return scene;
+    }
+
+
+
+#ifdef FHOPE_RUNTIME_SHADERS
+    // Always runs shaderc : compile_shader would be served by the shader cache after the warmup
+    static std::vector<uint32_t> compile_uncached(const std::string &filename, shaderc_shader_kind kind) {
+        std::ifstream file(filename, std::ifstream::binary);
+        std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        ShaderCompileOptions options{};
+        options.kind = kind;
+        options.targetEnvironment = shaderc_target_env_vulkan;
+        options.targetEnvironmentVersion = shaderc_env_version_vulkan_1_2;
+        options.sourceLanguage = shaderc_source_language_glsl;
+
+        return compile_glsl(source, filename, options);
+    }
+#endif
+
+
+
+    static std::string find_json_string(const std::string &line, const std::string &key) {
+        size_t keyPosition = line.find("\"" + key + "\"");
+        if (keyPosition == std::string::npos) {
+            return "";
+        }
+
+        size_t begin = line.find('"', line.find(':', keyPosition) + 1);
+        size_t end = line.find('"', begin + 1);
+
+        return line.substr(begin + 1, end - begin - 1);
+    }
+
+
+
+    static double find_json_number(const std::string &line, const std::string &key) {
+        size_t keyPosition = line.find("\"" + key + "\"");
+        if (keyPosition == std::string::npos) {
+            return -1.0;
+        }
+
+        return std::stod(line.substr(line.find(':', keyPosition) + 1));
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    BenchmarkResult run_benchmark(const Benchmark &benchmark, uint32_t samples, double sampleMilliseconds) {
+        benchmark.body(); // Warmup : caches, allocators, lazily initialized statics
+
+        std::vector<double> timings;
+        timings.reserve(samples);
+
+        BenchmarkResult result{};
+        result.name = benchmark.name;
+        result.operations = 0;
+
+        for (uint32_t i = 0; i != samples; ++i) {
+            uint64_t operations(0);
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            std::chrono::duration<double, std::milli> elapsed(0.0);
+
+            do {
+                operations += benchmark.body();
+                elapsed = std::chrono::steady_clock::now() - begin;
+            } while (elapsed.count() < sampleMilliseconds);
+
+            timings.push_back(elapsed.count() * 1000000.0 / static_cast<double>(std::max<uint64_t>(operations, 1)));
+            result.operations += operations;
+        }
+
+        std::sort(timings.begin(), timings.end());
+
+        double total(0.0);
+        for (double timing : timings) {
+            total += timing;
+        }
+
+        result.medianNanoseconds = timings[timings.size() / 2];
+        result.meanNanoseconds = total / static_cast<double>(timings.size());
+        result.minNanoseconds = timings.front();
+        result.maxNanoseconds = timings.back();
+
+        return result;
+    }
+
+
+
+    std::string results_to_json(const std::vector<BenchmarkResult> &results) {
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+        json << "{\n  \"benchmarks\": [";
+
+        for (size_t i = 0; i != results.size(); ++i) {
+            const BenchmarkResult &result = results[i];
+
+            json << (i == 0 ? "\n" : ",\n")
+                 << "    { \"name\": \"" << result.name << "\""
+                 << ", \"operations\": " << result.operations
+                 << ", \"medianNs\": " << result.medianNanoseconds
+                 << ", \"meanNs\": " << result.meanNanoseconds
+                 << ", \"minNs\": " << result.minNanoseconds
+                 << ", \"maxNs\": " << result.maxNanoseconds << " }";
+        }
+
+        json << "\n  ]\n}\n";
+
+        return json.str();
+    }
+
+
+
+    std::map<std::string, double> load_baseline(const std::string &filename) {
+        std::ifstream file(filename);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open baseline file `" + filename + "`.");
+        }
+
+        std::map<std::string, double> baseline;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            std::string name = find_json_string(line, "name");
+
+            if (!name.empty()) {
+                baseline[name] = find_json_number(line, "medianNs");
+            }
+        }
+
+        return baseline;
+    }
+
+
+
+    bool compare_to_baseline(const std::vector<BenchmarkResult> &results, const std::map<std::string, double> &baseline, double thresholdPercent) {
+        bool regressed(false);
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::endl << std::left << std::setw(32) << "benchmark" << std::right << std::setw(14) << "baseline ns" << std::setw(14) << "current ns" << std::setw(10) << "delta" << std::endl;
+
+        for (const BenchmarkResult &result : results) {
+            auto baselineResult = baseline.find(result.name);
+
+            if (baselineResult == baseline.end() || baselineResult->second <= 0.0) {
+                std::cout << std::left << std::setw(32) << result.name << std::right << std::setw(14) << "-" << std::setw(14) << result.medianNanoseconds << std::setw(10) << "new" << std::endl;
+                continue;
+            }
+
+            double delta = (result.medianNanoseconds - baselineResult->second) / baselineResult->second * 100.0;
+
+            std::ostringstream deltaText;
+            deltaText << std::fixed << std::setprecision(1) << std::showpos << delta << '%';
+
+            const char *verdict = delta > thresholdPercent ? "  REGRESSED" : (delta < -thresholdPercent ? "  improved" : "");
+            regressed = regressed || delta > thresholdPercent;
+
+            std::cout << std::left << std::setw(32) << result.name << std::right << std::setw(14) << baselineResult->second << std::setw(14) << result.medianNanoseconds << std::setw(10) << deltaText.str() << verdict << std::endl;
+        }
+
+        return !regressed;
+    }
+}
+
+
+
+static std::vector<fhope::bench::Benchmark> make_benchmarks() {
+    using fhope::bench::sink;
+
+    std::vector<fhope::bench::Benchmark> benchmarks;
+
+    benchmarks.push_back({ "load_model/viking_room", []() -> uint64_t {
+        fhope::LoadedModel model = fhope::load_model("models/viking_room.obj");
+        sink = sink + model.indices.size();
+        return 1;
+    }});
+
+    // Vertices are shared between hashing and equality benchmarks, and built once
+    auto vertices = std::make_shared<std::vector<fhope::Vertex3D>>(fhope::bench::make_random_vertices(1 << 16));
+
+    benchmarks.push_back({ "vertex3d/hash", [vertices]() -> uint64_t {
+        std::hash<fhope::Vertex3D> hasher;
+        size_t accumulated(0);
+        for (const fhope::Vertex3D &vertex : *vertices) {
+            accumulated ^= hasher(vertex);
+        }
+        sink = sink + accumulated;
+        return vertices->size();
+    }});
+
+    benchmarks.push_back({ "vertex3d/equality", [vertices]() -> uint64_t {
+        size_t equal(0);
+        for (size_t i = 1; i < vertices->size(); ++i) {
+            equal += (*vertices)[i] == (*vertices)[i - 1];
+            equal += (*vertices)[i] == (*vertices)[i];
+        }
+        sink = sink + equal;
+        return 2 * (vertices->size() - 1);
+    }});
+
+    benchmarks.push_back({ "mvp/get_mvp_dirty", []() -> uint64_t {
+        static fhope::MVP mvp(glm::mat4(1.0f), glm::lookAt(glm::vec3(2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)), glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 10.0f));
+        float accumulated(0.0f);
+        for (int i = 0; i != 1024; ++i) {
+            mvp.set_model(glm::rotate(glm::mat4(1.0f), static_cast<float>(i) * 0.001f, glm::vec3(0.0f, 0.0f, 1.0f)));
+            accumulated += mvp.get_mvp()[3][3];
+        }
+        sink = sink + static_cast<uint64_t>(accumulated);
+        return 1024;
+    }});
+
+    benchmarks.push_back({ "mvp/get_mvp_clean", []() -> uint64_t {
+        static fhope::MVP mvp(glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f));
+        float accumulated(0.0f);
+        for (int i = 0; i != 1024; ++i) {
+            accumulated += mvp.get_mvp()[3][3];
+        }
+        sink = sink + static_cast<uint64_t>(accumulated);
+        return 1024;
+    }});
+
+    benchmarks.push_back({ "mvp/recompute_mvp", []() -> uint64_t {
+        static fhope::MVP mvp(glm::mat4(1.0f), glm::lookAt(glm::vec3(2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)), glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 10.0f));
+        float accumulated(0.0f);
+        for (int i = 0; i != 1024; ++i) {
+            accumulated += mvp.recompute_mvp()[3][3];
+        }
+        sink = sink + static_cast<uint64_t>(accumulated);
+        return 1024;
+    }});
+
+#ifdef FHOPE_RUNTIME_SHADERS
+    benchmarks.push_back({ "compile_shader/base_vertex", []() -> uint64_t {
+        std::vector<uint32_t> compiled = fhope::bench::compile_uncached("shaders/base.v.glsl", shaderc_shader_kind::shaderc_vertex_shader);
+        sink = sink + static_cast<uint64_t>(compiled.size());
+        return 1;
+    }});
+
+    benchmarks.push_back({ "compile_shader/base_fragment", []() -> uint64_t {
+        std::vector<uint32_t> compiled = fhope::bench::compile_uncached("shaders/base.f.glsl", shaderc_shader_kind::shaderc_fragment_shader);
+        sink = sink + static_cast<uint64_t>(compiled.size());
+        return 1;
+    }});
+
+    benchmarks.push_back({ "compile_shader/base_fragment_cached", []() -> uint64_t {
+        std::vector<uint32_t> compiled = fhope::compile_shader("shaders/base.f.glsl", shaderc_shader_kind::shaderc_fragment_shader);
+        sink = sink + static_cast<uint64_t>(compiled.size());
+        return 1;
+    }});
+#endif
+
+    benchmarks.push_back({ "decode_image/viking_room", []() -> uint64_t {
+        fhope::DecodedImage image = fhope::decode_image("textures/viking_room.png");
+        sink = sink + image.pixels.size();
+        return 1;
+    }});
+
+    // Bounds are shared between the SIMD and scalar culling benchmarks, and built once
+    constexpr size_t CULLED_OBJECTS = 100000;
+
+    auto spheres = std::make_shared<fhope::SphereSoA>(fhope::bench::make_random_spheres(CULLED_OBJECTS));
+    auto boxes   = std::make_shared<fhope::AabbSoA>(fhope::bench::make_random_boxes(CULLED_OBJECTS));
+    auto visible = std::make_shared<std::vector<uint32_t>>();
+
+    glm::mat4 cullingProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 cullingView       = glm::lookAt(glm::vec3(0.0f, -60.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    fhope::Frustum frustum      = fhope::extract_frustum(cullingProjection * cullingView);
+
+    benchmarks.push_back({ "frustum_culling/spheres_100k", [spheres, visible, frustum]() -> uint64_t {
+        sink = sink + fhope::cull_spheres(frustum, *spheres, visible.get());
+        return spheres->size();
+    }});
+
+    benchmarks.push_back({ "frustum_culling/spheres_100k_scalar", [spheres, visible, frustum]() -> uint64_t {
+        sink = sink + fhope::cull_spheres_scalar(frustum, *spheres, visible.get());
+        return spheres->size();
+    }});
+
+    benchmarks.push_back({ "frustum_culling/aabbs_100k", [boxes, visible, frustum]() -> uint64_t {
+        sink = sink + fhope::cull_aabbs(frustum, *boxes, visible.get());
+        return boxes->size();
+    }});
+
+    benchmarks.push_back({ "frustum_culling/aabbs_100k_scalar", [boxes, visible, frustum]() -> uint64_t {
+        sink = sink + fhope::cull_aabbs_scalar(frustum, *boxes, visible.get());
+        return boxes->size();
+    }});
+
+    // Models are shared between the batched and looping MVP benchmarks, kernels being checked once against glm
+    constexpr size_t MVP_MODELS = 10000;
+
+    auto models = std::make_shared<fhope::MatrixSoA>(fhope::bench::make_random_models(MVP_MODELS + 3)); // Odd count : tails are checked too
+    auto mvps   = std::make_shared<fhope::MatrixSoA>();
+
+    glm::mat4 batchViewProjection = cullingProjection * cullingView;
+
+    fhope::bench::check_mvp_kernel("compute_mvps", fhope::compute_mvps, batchViewProjection, *models);
+    fhope::bench::check_mvp_kernel("compute_mvps_sse", fhope::compute_mvps_sse, batchViewProjection, *models);
+    fhope::bench::check_mvp_kernel("compute_mvps_scalar", fhope::compute_mvps_scalar, batchViewProjection, *models);
+
+    auto loopedModels = std::make_shared<std::vector<glm::mat4>>();
+    for (size_t i = 0; i != models->size(); ++i) {
+        loopedModels->push_back(models->get(i));
+    }
+
+    benchmarks.push_back({ "mvp/batch_10k", [models, mvps, batchViewProjection]() -> uint64_t {
+        fhope::compute_mvps(batchViewProjection, *models, mvps.get());
+        sink = sink + static_cast<uint64_t>(mvps->elements[15][0]);
+        return models->size();
+    }});
+
+    benchmarks.push_back({ "mvp/batch_10k_sse", [models, mvps, batchViewProjection]() -> uint64_t {
+        fhope::compute_mvps_sse(batchViewProjection, *models, mvps.get());
+        sink = sink + static_cast<uint64_t>(mvps->elements[15][0]);
+        return models->size();
+    }});
+
+    benchmarks.push_back({ "mvp/batch_10k_scalar", [models, mvps, batchViewProjection]() -> uint64_t {
+        fhope::compute_mvps_scalar(batchViewProjection, *models, mvps.get());
+        sink = sink + static_cast<uint64_t>(mvps->elements[15][0]);
+        return models->size();
+    }});
+
+    benchmarks.push_back({ "mvp/get_mvp_loop_10k", [loopedModels, cullingView, cullingProjection]() -> uint64_t {
+        static fhope::MVP mvp(glm::mat4(1.0f), cullingView, cullingProjection);
+        float accumulated(0.0f);
+        for (const glm::mat4 &model : *loopedModels) {
+            mvp.set_model(model);
+            accumulated += mvp.get_mvp()[3][3];
+        }
+        sink = sink + static_cast<uint64_t>(accumulated);
+        return loopedModels->size();
+    }});
+
+    constexpr size_t SCENE_NODES = 10000;
+
+    auto scene = fhope::bench::make_random_scene(SCENE_NODES);
+
+    benchmarks.push_back({ "scene_graph/update_root_10k", [scene]() -> uint64_t {
+        static float angle = 0.0f;
+        angle += 0.001f;
+        scene->set_local(0, glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f)));
+        sink = sink + scene->update();
+        return SCENE_NODES;
+    }});
+
+    benchmarks.push_back({ "scene_graph/update_leaf_10k", [scene]() -> uint64_t {
+        // The last node is always a leaf : only it is recomputed
+        static float angle = 0.0f;
+        angle += 0.001f;
+        scene->set_local(static_cast<fhope::NodeHandle>(SCENE_NODES - 1), glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f)));
+        sink = sink + scene->update();
+        return 1;
+    }});
+
+    // Workers are shared by every job benchmark, the benchmarking thread helping whenever it waits
+    auto jobs = std::make_shared<fhope::JobSystem>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    benchmarks.push_back({ "jobs/empty_10k", [jobs]() -> uint64_t {
+        fhope::JobCounter counter;
+        for (int i = 0; i != 10000; ++i) {
+            jobs->run([]() {}, &counter);
+        }
+        jobs->wait(&counter);
+        return 10000;
+    }});
+
+    benchmarks.push_back({ "jobs/parallel_for_mvp_100k", [jobs, batchViewProjection]() -> uint64_t {
+        static std::vector<glm::mat4> models(100000, glm::mat4(1.0f));
+        static std::vector<glm::mat4> mvps(100000);
+        jobs->parallel_for(models.size(), 0, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i != end; ++i) {
+                mvps[i] = batchViewProjection * models[i];
+            }
+        });
+        sink = sink + static_cast<uint64_t>(mvps.back()[3][3]);
+        return models.size();
+    }});
+
+    benchmarks.push_back({ "jobs/serial_for_mvp_100k", [batchViewProjection]() -> uint64_t {
+        static std::vector<glm::mat4> models(100000, glm::mat4(1.0f));
+        static std::vector<glm::mat4> mvps(100000);
+        for (size_t i = 0; i != models.size(); ++i) {
+            mvps[i] = batchViewProjection * models[i];
+        }
+        sink = sink + static_cast<uint64_t>(mvps.back()[3][3]);
+        return models.size();
+    }});
+
+    return benchmarks;
+}
+
+
+
+int main(int argc, char const *argv[]) {
+    std::string outputFilename = "fhope-bench.json";
+    std::string baselineFilename;
+    std::string filter;
+    double thresholdPercent = fhope::bench::DEFAULT_THRESHOLD_PERCENT;
+    uint32_t samples = fhope::bench::DEFAULT_SAMPLES;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument(argv[i]);
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--out" && hasValue) {
+            outputFilename = argv[++i];
+        } else if (argument == "--baseline" && hasValue) {
+            baselineFilename = argv[++i];
+        } else if (argument == "--threshold" && hasValue) {
+            thresholdPercent = std::stod(argv[++i]);
+        } else if (argument == "--samples" && hasValue) {
+            // Parsed signed : stoul silently wraps negative counts around
+            long requestedSamples = std::stol(argv[++i]);
+
+            if (requestedSamples < 1) {
+                std::cerr << "--samples must be at least 1." << std::endl;
+                return 2;
+            }
+
+            samples = static_cast<uint32_t>(requestedSamples);
+        } else if (argument == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "Usage: fhope-bench [--out results.json] [--baseline baseline.json] [--threshold percent] [--samples count] [--filter substring]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<fhope::bench::BenchmarkResult> results;
+
+    try {
+        for (const fhope::bench::Benchmark &benchmark : make_benchmarks()) {
+            if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+                continue;
+            }
+
+            fhope::bench::BenchmarkResult result = fhope::bench::run_benchmark(benchmark, samples);
+            std::cout << std::left << std::setw(32) << result.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(14) << result.medianNanoseconds << " ns/op (min " << result.minNanoseconds << ", max " << result.maxNanoseconds << ")" << std::endl;
+
+            results.push_back(result);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::ofstream outputFile(outputFilename, std::ios::trunc);
+    outputFile << fhope::bench::results_to_json(results);
+
+    if (baselineFilename.empty()) {
+        return 0;
+    }
+
+    return fhope::bench::compare_to_baseline(results, fhope::bench::load_baseline(baselineFilename), thresholdPercent) ? 0 : 1;
+}
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <vector>
 #include <iostream>
+#include <string>
 
 #define GLAD_VULKAN_IMPLEMENTATION
 #include <glad/vulkan.h>
@@ -14,6 +15,7 @@
 #include <glm/glm.hpp>
 
 #include "setup.hpp"
+#include "trace.hpp"
 
 static VKAPI_ATTR VkBool32 debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void *pUserData) {
     std::cerr << "Validation Layer : " << pCallbackData->pMessage << std::endl;
@@ -21,29 +23,87 @@ static VKAPI_ATTR VkBool32 debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT
     return VK_FALSE;
 }
 
+static int run_headless(uint32_t frameCount, bool gpuCulling, bool bindlessTextures) {
+    fhope::RenderConfig config{};
+    config.headless = true;
+    config.gpuCulling = gpuCulling;
+    config.bindlessTextures = bindlessTextures;
+
+    fhope::InstanceSetup setup;
+    try {
+        setup = fhope::generate_vulkan_setup(nullptr, "Test", {0, 0, 1}, "shaders/base.v.glsl", "shaders/base.f.glsl", "textures/viking_room.png", "models/viking_room.obj", config);
+    } catch(const std::exception& e) {
+        std::cout << e.what() << std::endl;
+
+        fhope::terminate_dependencies();
+        return 1;
+    }
+
+    fhope::FrameTimeStats stats = fhope::run_headless_benchmark(&setup, frameCount);
+
+    std::cout << "frames: " << stats.frameCount
+              << " | min: " << stats.minMilliseconds << " ms"
+              << " | mean: " << stats.meanMilliseconds << " ms"
+              << " | p50: " << stats.p50Milliseconds << " ms"
+              << " | p99: " << stats.p99Milliseconds << " ms"
+              << " | max: " << stats.maxMilliseconds << " ms" << std::endl;
+
+    fhope::clean_setup(setup);
+
+    FHOPE_TRACE_WRITE("fhope-trace.json");
+
+    fhope::terminate_dependencies();
+    return 0;
+}
+
 int main(int argc, char const *argv[]) {
+    FHOPE_TRACE_THREAD_NAME("main");
     fhope::initialize_dependencies();
 
+    // --headless <frames> [--gpu-culling] [--bindless] : renders offscreen, without any window, and prints frame time statistics
+    if (argc >= 3 && std::string(argv[1]) == "--headless") {
+        bool gpuCulling(false), bindlessTextures(false);
+        for (int i = 3; i < argc; ++i) {
+            gpuCulling       |= std::string(argv[i]) == "--gpu-culling";
+            bindlessTextures |= std::string(argv[i]) == "--bindless";
+        }
+
+        return run_headless(static_cast<uint32_t>(std::stoul(argv[2])), gpuCulling, bindlessTextures);
+    }
+
     GLFWwindow *window = glfwCreateWindow(800, 600, "hope", nullptr, nullptr);
     glfwMakeContextCurrent(window);
 
+    fhope::RenderConfig config{};
+
+#ifdef FHOPE_RUNTIME_SHADERS
+    // Saving a shader while the window is open rebuilds the pipeline
+    config.shaderHotReload = true;
+#endif
+
     fhope::InstanceSetup setup;
     try {
-        setup = fhope::generate_vulkan_setup(window, "Test", {0, 0, 1}, "shaders/base.v.glsl", "shaders/base.f.glsl", "textures/viking_room.png", "models/viking_room.obj");
+        setup = fhope::generate_vulkan_setup(window, "Test", {0, 0, 1}, "shaders/base.v.glsl", "shaders/base.f.glsl", "textures/viking_room.png", "models/viking_room.obj", config);
     } catch(const std::exception& e) {
         std::cout << e.what() << std::endl;
     }
 
     size_t currentFrame(0);
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        if (!setup.config.lowLatency) {
+            glfwPollEvents();
+        }
         fhope::draw_frame(&setup, window, &currentFrame);
+
+        FHOPE_TRACE_COLLECT();
     }
 
     vkDeviceWaitIdle(setup.logicalDevice.value());
 
     fhope::clean_setup(setup);
 
+    FHOPE_TRACE_WRITE("fhope-trace.json");
+
     glfwDestroyWindow(window);
 
     
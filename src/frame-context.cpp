@@ -0,0 +1,411 @@
+#include "frame-context.hpp"
+#include "setup.hpp"
+#include "gpu-profiler.hpp"
+#include "gpu-culling.hpp"
+#include "job-system.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace fhope {
+    /*************
+     ** METHODS **
+     *************/
+
+    ParallelRecorder::ParallelRecorder(JobSystem *jobs, uint32_t sliceCount) : jobs(jobs), sliceCount(std::max(sliceCount, 1u)) {}
+
+
+
+    uint32_t ParallelRecorder::get_thread_count() const {
+        return this->sliceCount;
+    }
+
+
+
+    std::vector<VkCommandBuffer> ParallelRecorder::record(const DeviceContext &device, FrameContext *frame, const std::vector<DrawItem> &drawItems) {
+        FHOPE_TRACE_FUNCTION();
+
+        const size_t threadCount = this->sliceCount;
+        const size_t chunkSize = (drawItems.size() + threadCount - 1) / threadCount;
+
+        std::vector<VkCommandBuffer> recorded(threadCount, VK_NULL_HANDLE);
+
+        auto recordSlice = [&](uint32_t threadIndex) {
+            const size_t first = std::min(drawItems.size(), threadIndex * chunkSize);
+            const size_t last  = std::min(drawItems.size(), first + chunkSize);
+
+            if (first == last) {
+                return;
+            }
+
+            const ThreadContext &thread = frame->threads[threadIndex];
+
+            // The frame's fence has been waited on : nothing recorded from this pool is still in use
+            vkResetCommandPool(device.device, thread.pool, 0);
+
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.renderPass = device.renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = VK_NULL_HANDLE; // Picked by the graph when executing : left unknown
+
+            VkCommandBufferBeginInfo commandBufferBeginInfo{};
+            commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+            if (vkBeginCommandBuffer(thread.secondary, &commandBufferBeginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("Couldn't record secondary command buffer (beginning).");
+            }
+
+            record_draw_items(device, *frame, thread.secondary, drawItems.data() + first, drawItems.data() + last);
+
+            if (vkEndCommandBuffer(thread.secondary) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to record secondary command buffer (end)");
+            }
+
+            recorded[threadIndex] = thread.secondary;
+        };
+
+        // Each slice owns it's thread context's pool : slices may run on any thread, never two at once on the same pool
+        JobCounter recordedSlices;
+
+        for (uint32_t i = 0; i != threadCount; ++i) {
+            this->jobs->run([&recordSlice, i]() {
+                FHOPE_TRACE_SCOPE("record secondary");
+                recordSlice(i);
+            }, &recordedSlices);
+        }
+
+        this->jobs->wait(&recordedSlices);
+
+        recorded.erase(std::remove(recorded.begin(), recorded.end(), VK_NULL_HANDLE), recorded.end());
+
+        return recorded;
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    uint32_t get_recording_thread_count(const RenderConfig &config) {
+        if (config.recordingThreads != 0) {
+            return config.recordingThreads;
+        }
+
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+
+
+    DeviceContext create_device_context(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a device context without providing a logical device in the setup.");
+        }
+
+        if (!setup.graphicsQueue.has_value()) {
+            throw std::runtime_error("Tried to create a device context without providing a graphics queue in the setup.");
+        }
+
+        if (!setup.config.headless && !setup.swapChain.has_value()) {
+            throw std::runtime_error("Tried to create a device context without providing a swap chain in the setup.");
+        }
+
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to create a device context without providing a swap chain config in the setup.");
+        }
+
+        if (!setup.graphicsPipelineConfig.has_value()) {
+            throw std::runtime_error("Tried to create a device context without providing a graphics pipeline in the setup.");
+        }
+
+        if (!setup.frameGraph.has_value()) {
+            throw std::runtime_error("Tried to create a device context without providing a frame graph in the setup.");
+        }
+
+        DeviceContext newDeviceContext{};
+        newDeviceContext.device = setup.logicalDevice.value();
+        newDeviceContext.graphicsQueue = setup.graphicsQueue.value();
+        newDeviceContext.swapChain = setup.swapChain.value_or(VK_NULL_HANDLE);
+        newDeviceContext.extent = setup.swapChainConfig.value().extent;
+        newDeviceContext.pipeline = setup.graphicsPipelineConfig.value().pipeline;
+        newDeviceContext.pipelineLayout = setup.graphicsPipelineConfig.value().pipelineLayout;
+        newDeviceContext.textureSet = setup.textures ? setup.textures->get_descriptor_set() : VK_NULL_HANDLE;
+        newDeviceContext.graph = setup.frameGraph.value().graph.get();
+        newDeviceContext.target = setup.frameGraph.value().target;
+        newDeviceContext.forwardPass = setup.frameGraph.value().forwardPass;
+        newDeviceContext.renderPass = newDeviceContext.graph->get_render_pass(newDeviceContext.forwardPass);
+
+        return newDeviceContext;
+    }
+
+
+
+    std::vector<FrameContext> create_frame_contexts(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create frame contexts without providing a logical device in the setup.");
+        }
+
+        if (!setup.queues.has_value() || !setup.queues.value().graphicsIndex.has_value()) {
+            throw std::runtime_error("Tried to create frame contexts without providing a graphics queue family index in the setup.");
+        }
+
+        if (!setup.syncObjects.has_value()) {
+            throw std::runtime_error("Tried to create frame contexts without providing sync objects in the setup.");
+        }
+
+        const size_t framesInFlight = setup.config.framesInFlight;
+
+        if (setup.commandBuffers.size() != framesInFlight || setup.descriptorSets.size() != framesInFlight || setup.uniformBuffers.size() != framesInFlight) {
+            throw std::runtime_error("Tried to create frame contexts without providing a command buffer, a descriptor set and an uniform buffer per in-flight frame in the setup.");
+        }
+
+        const uint32_t threadCount = setup.config.recordingMode == RecordingMode::Parallel ? get_recording_thread_count(setup.config) : 0;
+
+        std::vector<FrameContext> newFrameContexts(framesInFlight);
+
+        for (size_t i = 0; i != framesInFlight; ++i) {
+            if (!setup.uniformBuffers[i].mapping.has_value()) {
+                throw std::runtime_error("Tried to create frame contexts without providing uniform buffer memory mappings in the setup.");
+            }
+
+            FrameContext &frame = newFrameContexts[i];
+            frame.index = static_cast<uint32_t>(i);
+            frame.primary = setup.commandBuffers[i];
+            frame.imageAvailable = setup.syncObjects.value().imageAvailableSemaphores[i];
+            frame.renderFinished = setup.syncObjects.value().renderFinishedSemaphores[i];
+            frame.inFlight = setup.syncObjects.value().inFlightFences[i];
+            frame.descriptorSet = setup.descriptorSets[i];
+            frame.uniformMapping = setup.uniformBuffers[i].mapping.value();
+            frame.uniformSize = setup.uniformBuffers[i].sizeInBytes;
+
+            frame.threads.resize(threadCount);
+
+            for (ThreadContext &thread : frame.threads) {
+                VkCommandPoolCreateInfo commandPoolCreateInfo{};
+                commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                commandPoolCreateInfo.queueFamilyIndex = setup.queues.value().graphicsIndex.value();
+
+                if (vkCreateCommandPool(setup.logicalDevice.value(), &commandPoolCreateInfo, nullptr, &thread.pool) != VK_SUCCESS) {
+                    throw std::runtime_error("Couldn't create recording thread command pool.");
+                }
+
+                VkCommandBufferAllocateInfo commandBufferAllocationInfo{};
+                commandBufferAllocationInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                commandBufferAllocationInfo.commandPool = thread.pool;
+                commandBufferAllocationInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                commandBufferAllocationInfo.commandBufferCount = 1;
+
+                if (vkAllocateCommandBuffers(setup.logicalDevice.value(), &commandBufferAllocationInfo, &thread.secondary) != VK_SUCCESS) {
+                    throw std::runtime_error("Couldn't allocate recording thread secondary command buffer.");
+                }
+            }
+        }
+
+        if (setup.config.recordingMode == RecordingMode::Cached) {
+            allocate_cached_command_buffers(setup, &newFrameContexts);
+        }
+
+        return newFrameContexts;
+    }
+
+
+
+    void allocate_cached_command_buffers(const InstanceSetup &setup, std::vector<FrameContext> *frames) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to allocate cached command buffers without providing a logical device in the setup.");
+        }
+
+        if (!setup.commandPools.has_value()) {
+            throw std::runtime_error("Tried to allocate cached command buffers without providing command pools in the setup.");
+        }
+
+        for (FrameContext &frame : *frames) {
+            if (!frame.cachedPrimaries.empty()) {
+                vkFreeCommandBuffers(setup.logicalDevice.value(), setup.commandPools.value().graphics, static_cast<uint32_t>(frame.cachedPrimaries.size()), frame.cachedPrimaries.data());
+            }
+
+            frame.cachedPrimaries.resize(setup.swapChainImages.size());
+            frame.cachedVersions.assign(setup.swapChainImages.size(), UINT64_MAX);
+
+            VkCommandBufferAllocateInfo commandBufferAllocationInfo{};
+            commandBufferAllocationInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            commandBufferAllocationInfo.commandPool = setup.commandPools.value().graphics;
+            commandBufferAllocationInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            commandBufferAllocationInfo.commandBufferCount = static_cast<uint32_t>(frame.cachedPrimaries.size());
+
+            if (vkAllocateCommandBuffers(setup.logicalDevice.value(), &commandBufferAllocationInfo, frame.cachedPrimaries.data()) != VK_SUCCESS) {
+                throw std::runtime_error("Couldn't allocate cached command buffers.");
+            }
+        }
+    }
+
+
+
+    void destroy_frame_contexts(const VkDevice &device, const std::vector<FrameContext> &frames) {
+        for (const FrameContext &frame : frames) {
+            for (const ThreadContext &thread : frame.threads) {
+                vkDestroyCommandPool(device, thread.pool, nullptr);
+            }
+        }
+    }
+
+
+
+    void measure_frame_latency(LatencyStats *stats, FrameContext *frame) {
+        if (!frame->inputSampleTime.has_value()) {
+            return;
+        }
+
+        double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame->inputSampleTime.value()).count();
+        frame->inputSampleTime.reset();
+
+        stats->lastMilliseconds = latency;
+        stats->maxMilliseconds = std::max(stats->maxMilliseconds, latency);
+        stats->averageMilliseconds = stats->sampleCount == 0 ? latency : stats->averageMilliseconds + 0.05 * (latency - stats->averageMilliseconds);
+        ++stats->sampleCount;
+    }
+
+
+
+    /**
+     * @brief Binds the pipeline, dynamic states and descriptors every draw of the frame uses
+     */
+    static void record_draw_state(const DeviceContext &device, const FrameContext &frame, VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipeline);
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(device.extent.width);
+        viewport.height = static_cast<float>(device.extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = device.extent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+
+        if (device.textureSet != VK_NULL_HANDLE) {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelineLayout, BINDLESS_TEXTURE_SET, 1, &device.textureSet, 0, nullptr);
+        }
+    }
+
+
+
+    /**
+     * @brief Records the draws of the frame's forward pass (already begun by the graph), either inline, from secondary command buffers or from the GPU culling's indirect buffers
+     */
+    static void record_forward_pass(const DeviceContext &device, const FrameContext &frame, VkCommandBuffer commandBuffer, const std::vector<DrawItem> &drawItems, const std::vector<VkCommandBuffer> *secondaries, GpuProfiler *profiler, const GpuCulling *culling) {
+        if (secondaries != nullptr) {
+            // Only vkCmdExecuteCommands is allowed in such a subpass : secondary draws are timed by the render pass' zone
+            if (!secondaries->empty()) {
+                vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries->size()), secondaries->data());
+            }
+        } else if (culling != nullptr) {
+            GpuZone drawZone(profiler, commandBuffer, "indirect draws");
+            record_draw_state(device, frame, commandBuffer);
+            culling->record_draws(commandBuffer, frame.index);
+        } else {
+            GpuZone drawZone(profiler, commandBuffer, "draws");
+            record_draw_items(device, frame, commandBuffer, drawItems.data(), drawItems.data() + drawItems.size());
+        }
+    }
+
+
+
+    void record_frame(const DeviceContext &device, FrameContext *frame, VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<DrawItem> &drawItems, ParallelRecorder *recorder, GpuProfiler *profiler, GpuCulling *culling) {
+        FHOPE_TRACE_FUNCTION();
+
+        // Indirect draws are a handful of commands : there is nothing left to record in parallel
+        if (culling != nullptr) {
+            recorder = nullptr;
+        }
+
+        // Secondary buffers are recorded before the primary one begins : workers only need the frame's read-only handles
+        std::vector<VkCommandBuffer> secondaries;
+        if (recorder != nullptr) {
+            secondaries = recorder->record(device, frame, drawItems);
+        }
+
+        VkCommandBufferBeginInfo commandBufferBeginInfo{};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't record command buffer (beginning).");
+        }
+
+        if (profiler != nullptr) {
+            profiler->begin_frame(commandBuffer, frame->index);
+        }
+
+        {
+            GpuZone frameZone(profiler, commandBuffer, "frame");
+
+            if (culling != nullptr) {
+                GpuZone cullZone(profiler, commandBuffer, "culling");
+                culling->record_cull(commandBuffer, frame->index);
+            }
+
+            {
+                GpuZone renderPassZone(profiler, commandBuffer, "render pass");
+
+                const std::vector<VkCommandBuffer> *forwardSecondaries = recorder != nullptr ? &secondaries : nullptr;
+
+                device.graph->select_imported_image(device.target, imageIndex);
+                device.graph->set_record(device.forwardPass, [&](VkCommandBuffer passCommandBuffer, const RenderGraph &) {
+                    record_forward_pass(device, *frame, passCommandBuffer, drawItems, forwardSecondaries, profiler, culling);
+                });
+
+                device.graph->execute(commandBuffer);
+            }
+
+            if (culling != nullptr) {
+                GpuZone pyramidZone(profiler, commandBuffer, "depth pyramid");
+                culling->record_depth_pyramid(commandBuffer);
+            }
+        }
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer (end)");
+        }
+    }
+
+
+
+    void record_draw_items(const DeviceContext &device, const FrameContext &frame, VkCommandBuffer commandBuffer, const DrawItem *first, const DrawItem *last) {
+        // Secondary command buffers inherit nothing but the render pass : every state is bound again
+        record_draw_state(device, frame, commandBuffer);
+
+        VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+        VkBuffer boundIndexBuffer  = VK_NULL_HANDLE;
+
+        for (const DrawItem *item = first; item != last; ++item) {
+            if (item->vertexBuffer != boundVertexBuffer) {
+                VkDeviceSize offset(0);
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &item->vertexBuffer, &offset);
+                boundVertexBuffer = item->vertexBuffer;
+            }
+
+            if (item->indexBuffer != boundIndexBuffer) {
+                vkCmdBindIndexBuffer(commandBuffer, item->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                boundIndexBuffer = item->indexBuffer;
+            }
+
+            vkCmdDrawIndexed(commandBuffer, item->indexCount, item->instanceCount, item->firstIndex, item->vertexOffset, item->firstInstance);
+        }
+    }
+}
@@ -0,0 +1,299 @@
+#include "frustum-culling.hpp"
+#include "mvp.hpp"
+
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+#endif
+
+namespace fhope {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static bool is_sphere_visible(const Frustum &frustum, float x, float y, float z, float radius) {
+        for (const glm::vec4 &plane : frustum.planes) {
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    static bool is_aabb_visible(const Frustum &frustum, float x, float y, float z, float extentX, float extentY, float extentZ) {
+        for (const glm::vec4 &plane : frustum.planes) {
+            // Distance of the box's corner the farthest along the plane's normal
+            float reach = std::abs(plane.x) * extentX + std::abs(plane.y) * extentY + std::abs(plane.z) * extentZ;
+
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w + reach < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    // Writes base + the index of every set bit of a lane mask, in increasing order
+    static uint32_t *append_lanes(uint32_t mask, uint32_t base, uint32_t *out) {
+        while (mask != 0) {
+            *out++ = base + static_cast<uint32_t>(std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+
+        return out;
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    void SphereSoA::push_back(const glm::vec4 &sphere) {
+        this->centerX.push_back(sphere.x);
+        this->centerY.push_back(sphere.y);
+        this->centerZ.push_back(sphere.z);
+        this->radius.push_back(sphere.w);
+    }
+
+
+
+    size_t SphereSoA::size() const {
+        return this->radius.size();
+    }
+
+
+
+    void AabbSoA::push_back(const glm::vec3 &minimum, const glm::vec3 &maximum) {
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+        glm::vec3 extent = (maximum - minimum) * 0.5f;
+
+        this->centerX.push_back(center.x);
+        this->centerY.push_back(center.y);
+        this->centerZ.push_back(center.z);
+        this->extentX.push_back(extent.x);
+        this->extentY.push_back(extent.y);
+        this->extentZ.push_back(extent.z);
+    }
+
+
+
+    size_t AabbSoA::size() const {
+        return this->centerX.size();
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    Frustum extract_frustum(const glm::mat4 &viewProjection) {
+        // glm is column-major : row i of the matrix gathers the i-th component of every column
+        glm::mat4 rows = glm::transpose(viewProjection);
+
+        Frustum frustum{};
+        frustum.planes = {
+            rows[3] + rows[0], rows[3] - rows[0], // Left, right
+            rows[3] + rows[1], rows[3] - rows[1], // Bottom, top
+            rows[3] + rows[2], rows[3] - rows[2]  // Near, far
+        };
+
+        for (glm::vec4 &plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return frustum;
+    }
+
+
+
+    Frustum extract_frustum(const MVP &mvp) {
+        return extract_frustum(mvp.get_projection() * mvp.get_view());
+    }
+
+
+
+    size_t cull_spheres(const Frustum &frustum, const SphereSoA &spheres, std::vector<uint32_t> *visible) {
+        size_t count = spheres.size();
+        visible->resize(count);
+
+        uint32_t *out = visible->data();
+        size_t i(0);
+
+#if defined(__AVX2__)
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (size_t p = 0; p != 6; ++p) {
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+        }
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_loadu_ps(spheres.centerX.data() + i);
+            __m256 y = _mm256_loadu_ps(spheres.centerY.data() + i);
+            __m256 z = _mm256_loadu_ps(spheres.centerZ.data() + i);
+            __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius.data() + i));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (size_t p = 0; p != 6; ++p) {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+
+            out = append_lanes(static_cast<uint32_t>(_mm256_movemask_ps(inside)), static_cast<uint32_t>(i), out);
+        }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (size_t p = 0; p != 6; ++p) {
+            planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+        }
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(spheres.centerX.data() + i);
+            __m128 y = _mm_loadu_ps(spheres.centerY.data() + i);
+            __m128 z = _mm_loadu_ps(spheres.centerZ.data() + i);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius.data() + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (size_t p = 0; p != 6; ++p) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+
+            out = append_lanes(static_cast<uint32_t>(_mm_movemask_ps(inside)), static_cast<uint32_t>(i), out);
+        }
+#endif
+
+        // Remaining spheres (all of them without SIMD)
+        for (; i != count; ++i) {
+            if (is_sphere_visible(frustum, spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i], spheres.radius[i])) {
+                *out++ = static_cast<uint32_t>(i);
+            }
+        }
+
+        visible->resize(static_cast<size_t>(out - visible->data()));
+        return visible->size();
+    }
+
+
+
+    size_t cull_aabbs(const Frustum &frustum, const AabbSoA &boxes, std::vector<uint32_t> *visible) {
+        size_t count = boxes.size();
+        visible->resize(count);
+
+        uint32_t *out = visible->data();
+        size_t i(0);
+
+#if defined(__AVX2__)
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absoluteX[6], absoluteY[6], absoluteZ[6];
+        for (size_t p = 0; p != 6; ++p) {
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+            absoluteX[p] = _mm256_andnot_ps(signMask, planeX[p]);
+            absoluteY[p] = _mm256_andnot_ps(signMask, planeY[p]);
+            absoluteZ[p] = _mm256_andnot_ps(signMask, planeZ[p]);
+        }
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_loadu_ps(boxes.centerX.data() + i);
+            __m256 y = _mm256_loadu_ps(boxes.centerY.data() + i);
+            __m256 z = _mm256_loadu_ps(boxes.centerZ.data() + i);
+            __m256 extentX = _mm256_loadu_ps(boxes.extentX.data() + i);
+            __m256 extentY = _mm256_loadu_ps(boxes.extentY.data() + i);
+            __m256 extentZ = _mm256_loadu_ps(boxes.extentZ.data() + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (size_t p = 0; p != 6; ++p) {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+                __m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absoluteX[p], extentX), _mm256_mul_ps(absoluteY[p], extentY)), _mm256_mul_ps(absoluteZ[p], extentZ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            out = append_lanes(static_cast<uint32_t>(_mm256_movemask_ps(inside)), static_cast<uint32_t>(i), out);
+        }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absoluteX[6], absoluteY[6], absoluteZ[6];
+        for (size_t p = 0; p != 6; ++p) {
+            planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+            absoluteX[p] = _mm_andnot_ps(signMask, planeX[p]);
+            absoluteY[p] = _mm_andnot_ps(signMask, planeY[p]);
+            absoluteZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+        }
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(boxes.centerX.data() + i);
+            __m128 y = _mm_loadu_ps(boxes.centerY.data() + i);
+            __m128 z = _mm_loadu_ps(boxes.centerZ.data() + i);
+            __m128 extentX = _mm_loadu_ps(boxes.extentX.data() + i);
+            __m128 extentY = _mm_loadu_ps(boxes.extentY.data() + i);
+            __m128 extentZ = _mm_loadu_ps(boxes.extentZ.data() + i);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (size_t p = 0; p != 6; ++p) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absoluteX[p], extentX), _mm_mul_ps(absoluteY[p], extentY)), _mm_mul_ps(absoluteZ[p], extentZ));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+            }
+
+            out = append_lanes(static_cast<uint32_t>(_mm_movemask_ps(inside)), static_cast<uint32_t>(i), out);
+        }
+#endif
+
+        // Remaining boxes (all of them without SIMD)
+        for (; i != count; ++i) {
+            if (is_aabb_visible(frustum, boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i], boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i])) {
+                *out++ = static_cast<uint32_t>(i);
+            }
+        }
+
+        visible->resize(static_cast<size_t>(out - visible->data()));
+        return visible->size();
+    }
+
+
+
+    size_t cull_spheres_scalar(const Frustum &frustum, const SphereSoA &spheres, std::vector<uint32_t> *visible) {
+        visible->clear();
+
+        for (size_t i = 0; i != spheres.size(); ++i) {
+            if (is_sphere_visible(frustum, spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i], spheres.radius[i])) {
+                visible->push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        return visible->size();
+    }
+
+
+
+    size_t cull_aabbs_scalar(const Frustum &frustum, const AabbSoA &boxes, std::vector<uint32_t> *visible) {
+        visible->clear();
+
+        for (size_t i = 0; i != boxes.size(); ++i) {
+            if (is_aabb_visible(frustum, boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i], boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i])) {
+                visible->push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        return visible->size();
+    }
+}
@@ -0,0 +1,316 @@
+#include "geometry-pool.hpp"
+#include "barrier.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace fhope {
+    /*************
+     ** METHODS **
+     *************/
+
+    GeometryPool::GeometryPool(const InstanceSetup &setup, uint32_t vertexCapacity, uint32_t indexCapacity) : vertexCapacity(std::max(vertexCapacity, 1u)), indexCapacity(std::max(indexCapacity, 1u)) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a geometry pool without providing a logical device in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+
+        this->blocks.push_back(this->create_block(setup, this->vertexCapacity, this->indexCapacity));
+    }
+
+
+
+    GeometryPool::Block GeometryPool::create_block(const InstanceSetup &setup, uint32_t vertices, uint32_t indices) const {
+        WrappedBuffer vertexBuffer = create_buffer(setup, static_cast<VkDeviceSize>(vertices) * sizeof(Vertex3D), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        WrappedBuffer indexBuffer  = create_buffer(setup, static_cast<VkDeviceSize>(indices) * sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        Block block{};
+        block.vertexBuffer   = vertexBuffer.buffer;
+        block.vertexMemory   = vertexBuffer.memory;
+        block.indexBuffer    = indexBuffer.buffer;
+        block.indexMemory    = indexBuffer.memory;
+        block.vertexCapacity = vertices;
+        block.indexCapacity  = indices;
+
+        return block;
+    }
+
+
+
+    void GeometryPool::destroy() {
+        for (Block &block : this->blocks) {
+            vkDestroyBuffer(this->device, block.indexBuffer, nullptr);
+            vkFreeMemory(this->device, block.indexMemory, nullptr);
+
+            vkDestroyBuffer(this->device, block.vertexBuffer, nullptr);
+            vkFreeMemory(this->device, block.vertexMemory, nullptr);
+        }
+
+        this->blocks.clear();
+        this->meshes.clear();
+        this->freeHandles.clear();
+    }
+
+
+
+    bool GeometryPool::fits(const std::vector<FreeRange> &freeRanges, uint32_t end, uint32_t capacity, uint32_t count) {
+        if (capacity - end >= count) {
+            return true;
+        }
+
+        return std::any_of(freeRanges.begin(), freeRanges.end(), [count](const FreeRange &range) { return range.count >= count; });
+    }
+
+
+
+    uint32_t GeometryPool::allocate_range(std::vector<FreeRange> *freeRanges, uint32_t *end, uint32_t count) {
+        auto found = std::find_if(freeRanges->begin(), freeRanges->end(), [count](const FreeRange &range) { return range.count >= count; });
+
+        if (found == freeRanges->end()) {
+            uint32_t offset = *end;
+            *end += count;
+
+            return offset;
+        }
+
+        uint32_t offset = found->offset;
+        found->offset += count;
+        found->count  -= count;
+
+        if (found->count == 0) {
+            freeRanges->erase(found);
+        }
+
+        return offset;
+    }
+
+
+
+    void GeometryPool::release_range(std::vector<FreeRange> *freeRanges, uint32_t *end, uint32_t offset, uint32_t count) {
+        auto next = std::lower_bound(freeRanges->begin(), freeRanges->end(), offset, [](const FreeRange &range, uint32_t value) { return range.offset < value; });
+        auto inserted = freeRanges->insert(next, FreeRange{ offset, count });
+
+        // Merging with the following range first keeps the iterator valid for the preceding one
+        auto following = inserted + 1;
+        if (following != freeRanges->end() && inserted->offset + inserted->count == following->offset) {
+            inserted->count += following->count;
+            freeRanges->erase(following);
+        }
+
+        if (inserted != freeRanges->begin()) {
+            auto preceding = inserted - 1;
+
+            if (preceding->offset + preceding->count == inserted->offset) {
+                preceding->count += inserted->count;
+                inserted = freeRanges->erase(inserted) - 1;
+            }
+        }
+
+        // A free range ending the allocated elements gives them back to the end of the block
+        if (inserted->offset + inserted->count == *end) {
+            *end = inserted->offset;
+            freeRanges->erase(inserted);
+        }
+    }
+
+
+
+    MeshHandle GeometryPool::add_mesh(const InstanceSetup &setup, const std::vector<Vertex3D> &vertices, const std::vector<uint32_t> &indices) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.commandPools.has_value()) {
+            throw std::runtime_error("Tried to add a mesh to a geometry pool without providing command pools in the setup.");
+        }
+
+        if (!setup.transferQueue.has_value()) {
+            throw std::runtime_error("Tried to add a mesh to a geometry pool without providing a transfer queue in the setup.");
+        }
+
+        MeshUpload upload = stage_mesh(setup, vertices, indices);
+        this->allocate_mesh(setup, &upload);
+
+        VkCommandBuffer commandBuffer = begin_one_shot_command(setup, setup.commandPools.value().transfer);
+        record_mesh_upload(setup, commandBuffer, upload);
+        end_one_shot_command(setup, setup.commandPools.value().transfer, setup.transferQueue.value(), &commandBuffer);
+
+        destroy_mesh_staging(setup, upload);
+
+        return upload.mesh;
+    }
+
+
+
+    MeshUpload GeometryPool::stage_mesh(const InstanceSetup &setup, const std::vector<Vertex3D> &vertices, const std::vector<uint32_t> &indices) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (vertices.empty() || indices.empty()) {
+            throw std::runtime_error("Tried to add a mesh without any vertex or index to a geometry pool.");
+        }
+
+        VkDeviceSize vertexBytes = vertices.size() * sizeof(Vertex3D);
+        VkDeviceSize indexBytes  = indices.size() * sizeof(uint32_t);
+
+        WrappedBuffer stagingBuffer = create_buffer(setup, vertexBytes + indexBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+
+        void *mapping;
+        vkMapMemory(setup.logicalDevice.value(), stagingBuffer.memory, 0, stagingBuffer.sizeInBytes, 0, &mapping);
+            std::memcpy(mapping, vertices.data(), vertexBytes);
+            std::memcpy(static_cast<char *>(mapping) + vertexBytes, indices.data(), indexBytes);
+        vkUnmapMemory(setup.logicalDevice.value(), stagingBuffer.memory);
+
+        MeshUpload upload{};
+        upload.staging        = stagingBuffer.buffer;
+        upload.stagingMemory  = stagingBuffer.memory;
+        upload.vertexCount    = static_cast<uint32_t>(vertices.size());
+        upload.indexCount     = static_cast<uint32_t>(indices.size());
+        upload.boundingSphere = compute_bounding_sphere(vertices);
+
+        return upload;
+    }
+
+
+
+    void GeometryPool::allocate_mesh(const InstanceSetup &setup, MeshUpload *upload) {
+        uint32_t vertexCount = upload->vertexCount;
+        uint32_t indexCount  = upload->indexCount;
+
+        auto hasRoom = [vertexCount, indexCount](const Block &block) {
+            return fits(block.freeVertices, block.vertexCount, block.vertexCapacity, vertexCount) && fits(block.freeIndices, block.indexCount, block.indexCapacity, indexCount);
+        };
+
+        auto found = std::find_if(this->blocks.begin(), this->blocks.end(), hasRoom);
+        uint32_t blockIndex = static_cast<uint32_t>(found - this->blocks.begin());
+
+        if (found == this->blocks.end()) {
+            // Meshes larger than a default block get a block of their own
+            this->blocks.push_back(this->create_block(setup, std::max(vertexCount, this->vertexCapacity), std::max(indexCount, this->indexCapacity)));
+        }
+
+        Block &block = this->blocks[blockIndex];
+
+        uint32_t firstVertex = allocate_range(&block.freeVertices, &block.vertexCount, vertexCount);
+        uint32_t firstIndex  = allocate_range(&block.freeIndices, &block.indexCount, indexCount);
+
+        VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexCount) * sizeof(Vertex3D);
+
+        upload->vertexBuffer = block.vertexBuffer;
+        upload->indexBuffer  = block.indexBuffer;
+        upload->vertexCopy   = VkBufferCopy{ 0, static_cast<VkDeviceSize>(firstVertex) * sizeof(Vertex3D), vertexBytes };
+        upload->indexCopy    = VkBufferCopy{ vertexBytes, static_cast<VkDeviceSize>(firstIndex) * sizeof(uint32_t), static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t) };
+
+        MeshRange mesh{};
+        mesh.block          = blockIndex;
+        mesh.firstIndex     = firstIndex;
+        mesh.indexCount     = indexCount;
+        mesh.vertexOffset   = static_cast<int32_t>(firstVertex);
+        mesh.vertexCount    = vertexCount;
+        mesh.boundingSphere = upload->boundingSphere;
+
+        if (!this->freeHandles.empty()) {
+            upload->mesh = this->freeHandles.back();
+            this->freeHandles.pop_back();
+
+            this->meshes[upload->mesh] = mesh;
+            return;
+        }
+
+        this->meshes.push_back(mesh);
+
+        upload->mesh = static_cast<MeshHandle>(this->meshes.size() - 1);
+    }
+
+
+
+    void GeometryPool::record_mesh_upload(const InstanceSetup &setup, VkCommandBuffer commandBuffer, const MeshUpload &upload) {
+        FHOPE_TRACE_FUNCTION();
+
+        vkCmdCopyBuffer(commandBuffer, upload.staging, upload.vertexBuffer, 1, &upload.vertexCopy);
+        vkCmdCopyBuffer(commandBuffer, upload.staging, upload.indexBuffer, 1, &upload.indexCopy);
+
+        // Vertices and indices are read by draws, and by culling shaders, of later submissions
+        StageAccess copied{ VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR };
+        StageAccess read{ VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR, VK_ACCESS_2_MEMORY_READ_BIT_KHR };
+
+        BarrierBatch barriers(setup.synchronization2);
+        barriers.buffer(upload.vertexBuffer, upload.vertexCopy.dstOffset, upload.vertexCopy.size, copied, read);
+        barriers.buffer(upload.indexBuffer, upload.indexCopy.dstOffset, upload.indexCopy.size, copied, read);
+        barriers.flush(commandBuffer);
+    }
+
+
+
+    void GeometryPool::destroy_mesh_staging(const InstanceSetup &setup, const MeshUpload &upload) {
+        vkDestroyBuffer(setup.logicalDevice.value(), upload.staging, nullptr);
+        vkFreeMemory(setup.logicalDevice.value(), upload.stagingMemory, nullptr);
+    }
+
+
+
+    void GeometryPool::remove_mesh(MeshHandle handle) {
+        const MeshRange &mesh = this->get_mesh(handle);
+        Block &block = this->blocks[mesh.block];
+
+        release_range(&block.freeVertices, &block.vertexCount, static_cast<uint32_t>(mesh.vertexOffset), mesh.vertexCount);
+        release_range(&block.freeIndices, &block.indexCount, mesh.firstIndex, mesh.indexCount);
+
+        this->meshes[handle] = MeshRange{};
+        this->freeHandles.push_back(handle);
+    }
+
+
+
+    const MeshRange &GeometryPool::get_mesh(MeshHandle handle) const {
+        if (handle >= this->meshes.size() || this->meshes[handle].indexCount == 0) {
+            throw std::runtime_error("Tried to get a mesh that does not exist.");
+        }
+
+        return this->meshes[handle];
+    }
+
+
+
+    DrawItem GeometryPool::make_draw_item(MeshHandle handle, uint32_t instanceCount, uint32_t firstInstance) const {
+        const MeshRange &mesh = this->get_mesh(handle);
+
+        DrawItem item{};
+        item.vertexBuffer  = this->blocks[mesh.block].vertexBuffer;
+        item.indexBuffer   = this->blocks[mesh.block].indexBuffer;
+        item.indexCount    = mesh.indexCount;
+        item.firstIndex    = mesh.firstIndex;
+        item.vertexOffset  = mesh.vertexOffset;
+        item.instanceCount = instanceCount;
+        item.firstInstance = firstInstance;
+
+        return item;
+    }
+
+
+
+    uint32_t GeometryPool::block_count() const {
+        return static_cast<uint32_t>(this->blocks.size());
+    }
+
+
+
+    VkBuffer GeometryPool::get_vertex_buffer(uint32_t block) const {
+        return this->blocks[block].vertexBuffer;
+    }
+
+
+
+    VkBuffer GeometryPool::get_index_buffer(uint32_t block) const {
+        return this->blocks[block].indexBuffer;
+    }
+
+
+
+    void GeometryPool::bind(VkCommandBuffer commandBuffer, uint32_t block) const {
+        VkDeviceSize offset(0);
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &this->blocks[block].vertexBuffer, &offset);
+        vkCmdBindIndexBuffer(commandBuffer, this->blocks[block].indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+}
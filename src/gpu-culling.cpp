@@ -0,0 +1,738 @@
+#include "gpu-culling.hpp"
+#include "setup.hpp"
+#include "barrier.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Push constants of the cull shader
+     */
+    struct CullConstants {
+        uint32_t objectCount; ///< Amount of objects in the table
+        uint32_t compact;     ///< Wether visible draws are compacted (1) or culled draws get zero instance (0)
+    };
+
+
+    /**
+     * @brief Push constants of the depth pyramid shaders
+     */
+    struct PyramidConstants {
+        uint32_t sourceWidth;  ///< Width of the read image (depth buffer or previous mip)
+        uint32_t sourceHeight; ///< Height of the read image
+        uint32_t levelWidth;   ///< Width of the written mip
+        uint32_t levelHeight;  ///< Height of the written mip
+        uint32_t sampleCount;  ///< Amount of samples per texel of the read image
+    };
+
+    /*************
+     ** HELPERS **
+     *************/
+
+    static uint32_t previous_power_of_two(uint32_t value) {
+        uint32_t power(1);
+        while (power * 2 <= value) {
+            power *= 2;
+        }
+
+        return power;
+    }
+
+
+
+    static uint32_t group_count(uint32_t invocations, uint32_t groupSize) {
+        return (invocations + groupSize - 1) / groupSize;
+    }
+
+
+
+    static VkPipeline create_compute_pipeline(const InstanceSetup &setup, const std::string &shaderFilename, const std::map<std::string, std::string> &definitions, VkPipelineLayout layout) {
+#ifdef FHOPE_RUNTIME_SHADERS
+        VkShaderModule shaderModule = create_shader_module(setup, compile_shader(shaderFilename, shaderc_compute_shader, definitions));
+#else
+        VkShaderModule shaderModule = create_shader_module(setup, get_embedded_shader(shaderFilename, definitions));
+#endif
+
+        VkComputePipelineCreateInfo pipelineCreateInfo{};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreateInfo.stage.module = shaderModule;
+        pipelineCreateInfo.stage.pName = "main";
+        pipelineCreateInfo.layout = layout;
+
+        VkPipeline pipeline;
+        VkResult status = vkCreateComputePipelines(setup.logicalDevice.value(), setup.pipelineCache->get(), 1, &pipelineCreateInfo, nullptr, &pipeline);
+
+        vkDestroyShaderModule(setup.logicalDevice.value(), shaderModule, nullptr);
+
+        if (status != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create compute pipeline from '" + shaderFilename + "'.");
+        }
+
+        return pipeline;
+    }
+
+
+
+    static VkDescriptorSetLayoutBinding compute_binding(uint32_t binding, VkDescriptorType type) {
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding = binding;
+        layoutBinding.descriptorType = type;
+        layoutBinding.descriptorCount = 1;
+        layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        return layoutBinding;
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    GpuCulling::GpuCulling(const InstanceSetup &setup, uint32_t frameCount, VkBuffer vertexBuffer, VkBuffer indexBuffer, uint32_t initialCapacity) : vertexBuffer(vertexBuffer), indexBuffer(indexBuffer), version(0) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create GPU culling without providing a logical device in the setup.");
+        }
+
+        if (!setup.maxSamplesFlag.has_value()) {
+            throw std::runtime_error("Tried to create GPU culling without providing a max sample flag in the setup.");
+        }
+
+        if (!setup.instances || setup.uniformBuffers.size() < frameCount) {
+            throw std::runtime_error("Tried to create GPU culling without providing an instance buffer and uniform buffers in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+        this->synchronization2 = setup.synchronization2;
+        this->drawIndirectCount = setup.drawIndirectCount;
+        this->multiDrawIndirect = setup.multiDrawIndirect;
+        this->depthSampleCount = static_cast<uint32_t>(setup.maxSamplesFlag.value());
+
+        // DESCRIPTOR SET LAYOUTS
+        std::array<VkDescriptorSetLayoutBinding, 6> cullBindings = {
+            compute_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER),        // Camera
+            compute_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),        // Object table
+            compute_binding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),        // Instances
+            compute_binding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),        // Draw commands
+            compute_binding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),        // Draw count
+            compute_binding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) // Depth pyramid
+        };
+
+        VkDescriptorSetLayoutCreateInfo cullSetLayoutCreateInfo{};
+        cullSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        cullSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+        cullSetLayoutCreateInfo.pBindings = cullBindings.data();
+
+        if (vkCreateDescriptorSetLayout(this->device, &cullSetLayoutCreateInfo, nullptr, &this->cullSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create cull descriptor set layout.");
+        }
+
+        std::array<VkDescriptorSetLayoutBinding, 2> pyramidBindings = {
+            compute_binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER), // Read image
+            compute_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)           // Written mip
+        };
+
+        VkDescriptorSetLayoutCreateInfo pyramidSetLayoutCreateInfo{};
+        pyramidSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        pyramidSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(pyramidBindings.size());
+        pyramidSetLayoutCreateInfo.pBindings = pyramidBindings.data();
+
+        if (vkCreateDescriptorSetLayout(this->device, &pyramidSetLayoutCreateInfo, nullptr, &this->pyramidSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create depth pyramid descriptor set layout.");
+        }
+
+        // PIPELINES
+        VkPushConstantRange cullConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants) };
+
+        VkPipelineLayoutCreateInfo cullLayoutCreateInfo{};
+        cullLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        cullLayoutCreateInfo.setLayoutCount = 1;
+        cullLayoutCreateInfo.pSetLayouts = &this->cullSetLayout;
+        cullLayoutCreateInfo.pushConstantRangeCount = 1;
+        cullLayoutCreateInfo.pPushConstantRanges = &cullConstantRange;
+
+        if (vkCreatePipelineLayout(this->device, &cullLayoutCreateInfo, nullptr, &this->cullLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create cull pipeline layout.");
+        }
+
+        VkPushConstantRange pyramidConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidConstants) };
+
+        VkPipelineLayoutCreateInfo pyramidLayoutCreateInfo{};
+        pyramidLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pyramidLayoutCreateInfo.setLayoutCount = 1;
+        pyramidLayoutCreateInfo.pSetLayouts = &this->pyramidSetLayout;
+        pyramidLayoutCreateInfo.pushConstantRangeCount = 1;
+        pyramidLayoutCreateInfo.pPushConstantRanges = &pyramidConstantRange;
+
+        if (vkCreatePipelineLayout(this->device, &pyramidLayoutCreateInfo, nullptr, &this->pyramidLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create depth pyramid pipeline layout.");
+        }
+
+        this->cullPipeline = create_compute_pipeline(setup, CULL_SHADER_FILENAME, {}, this->cullLayout);
+        this->reducePipeline = create_compute_pipeline(setup, DEPTH_REDUCE_SHADER_FILENAME, {}, this->pyramidLayout);
+
+        // A multisampled depth buffer can only be read through a sampler2DMS
+        std::map<std::string, std::string> resolveDefinitions;
+        if (this->depthSampleCount > 1) {
+            resolveDefinitions["MULTISAMPLED"] = "1";
+        }
+        this->resolvePipeline = create_compute_pipeline(setup, DEPTH_RESOLVE_SHADER_FILENAME, resolveDefinitions, this->pyramidLayout);
+
+        // SAMPLER
+        VkSamplerCreateInfo samplerCreateInfo{};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.minLod = 0.0f;
+        samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+        if (vkCreateSampler(this->device, &samplerCreateInfo, nullptr, &this->pyramidSampler) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create depth pyramid sampler.");
+        }
+
+        this->create_pyramid(setup);
+
+        // FRAME SLOTS
+        std::array<VkDescriptorPoolSize, 3> poolSizes{};
+        poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount };
+        poolSizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * frameCount };
+        poolSizes[2] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount };
+
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolCreateInfo.pPoolSizes = poolSizes.data();
+        poolCreateInfo.maxSets = frameCount;
+
+        if (vkCreateDescriptorPool(this->device, &poolCreateInfo, nullptr, &this->descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create cull descriptor pool.");
+        }
+
+        std::vector<VkDescriptorSetLayout> setLayouts(frameCount, this->cullSetLayout);
+        std::vector<VkDescriptorSet>       descriptorSets(frameCount);
+
+        VkDescriptorSetAllocateInfo setAllocateInfo{};
+        setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setAllocateInfo.descriptorPool = this->descriptorPool;
+        setAllocateInfo.descriptorSetCount = frameCount;
+        setAllocateInfo.pSetLayouts = setLayouts.data();
+
+        if (vkAllocateDescriptorSets(this->device, &setAllocateInfo, descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't allocate cull descriptor sets.");
+        }
+
+        this->frames.reserve(frameCount);
+        for (uint32_t i = 0; i != frameCount; ++i) {
+            FrameBuffers buffers = this->create_frame_buffers(setup, std::max(initialCapacity, 1u));
+            buffers.descriptorSet = descriptorSets[i];
+
+            VkDescriptorBufferInfo uniformInfo{ setup.uniformBuffers[i].buffer, 0, VK_WHOLE_SIZE };
+            VkDescriptorImageInfo  pyramidInfo{ this->pyramidSampler, this->pyramid.view, VK_IMAGE_LAYOUT_GENERAL };
+
+            std::array<VkWriteDescriptorSet, 2> writes{};
+            writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[0].dstSet = buffers.descriptorSet;
+            writes[0].dstBinding = 0;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].descriptorCount = 1;
+            writes[0].pBufferInfo = &uniformInfo;
+
+            writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[1].dstSet = buffers.descriptorSet;
+            writes[1].dstBinding = 5;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[1].descriptorCount = 1;
+            writes[1].pImageInfo = &pyramidInfo;
+
+            vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+            this->write_buffer_descriptors(buffers);
+            this->frames.push_back(buffers);
+
+            this->rebind_instances(i, setup.instances->get_descriptor_info(i));
+        }
+    }
+
+
+
+    GpuCulling::FrameBuffers GpuCulling::create_frame_buffers(const InstanceSetup &setup, uint32_t capacity) const {
+        FrameBuffers buffers{};
+        buffers.capacity = capacity;
+
+        WrappedBuffer objectBuffer = create_buffer(setup, static_cast<VkDeviceSize>(capacity) * sizeof(GpuObject), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        buffers.objects = objectBuffer.buffer;
+        buffers.objectsMemory = objectBuffer.memory;
+
+        vkMapMemory(this->device, buffers.objectsMemory, 0, objectBuffer.sizeInBytes, 0, &buffers.mapping);
+
+        WrappedBuffer drawBuffer = create_buffer(setup, static_cast<VkDeviceSize>(capacity) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        buffers.draws = drawBuffer.buffer;
+        buffers.drawsMemory = drawBuffer.memory;
+
+        WrappedBuffer countBuffer = create_buffer(setup, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        buffers.count = countBuffer.buffer;
+        buffers.countMemory = countBuffer.memory;
+
+        return buffers;
+    }
+
+
+
+    void GpuCulling::destroy_frame_buffers(FrameBuffers *buffers) const {
+        if (buffers->objects == VK_NULL_HANDLE) {
+            return;
+        }
+
+        vkUnmapMemory(this->device, buffers->objectsMemory);
+        vkDestroyBuffer(this->device, buffers->objects, nullptr);
+        vkFreeMemory(this->device, buffers->objectsMemory, nullptr);
+
+        vkDestroyBuffer(this->device, buffers->draws, nullptr);
+        vkFreeMemory(this->device, buffers->drawsMemory, nullptr);
+
+        vkDestroyBuffer(this->device, buffers->count, nullptr);
+        vkFreeMemory(this->device, buffers->countMemory, nullptr);
+
+        VkDescriptorSet descriptorSet = buffers->descriptorSet;
+        *buffers = FrameBuffers{};
+        buffers->descriptorSet = descriptorSet;
+    }
+
+
+
+    void GpuCulling::write_buffer_descriptors(const FrameBuffers &buffers) const {
+        std::array<VkDescriptorBufferInfo, 3> bufferInfos = {{
+            { buffers.objects, 0, VK_WHOLE_SIZE },
+            { buffers.draws,   0, VK_WHOLE_SIZE },
+            { buffers.count,   0, VK_WHOLE_SIZE }
+        }};
+
+        std::array<uint32_t, 3> bindings = { 1, 3, 4 };
+
+        std::array<VkWriteDescriptorSet, 3> writes{};
+        for (size_t i = 0; i != writes.size(); ++i) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = buffers.descriptorSet;
+            writes[i].dstBinding = bindings[i];
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].descriptorCount = 1;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+
+
+    void GpuCulling::create_pyramid(const InstanceSetup &setup) {
+        if (!setup.depthBuffer.has_value()) {
+            throw std::runtime_error("Tried to create a depth pyramid without providing a depth buffer in the setup.");
+        }
+
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to create a depth pyramid without providing a swap chain config in the setup.");
+        }
+
+        if (!setup.commandPools.has_value() || !setup.graphicsQueue.has_value()) {
+            throw std::runtime_error("Tried to create a depth pyramid without providing command pools and a graphics queue in the setup.");
+        }
+
+        const DepthBuffer &depthBuffer = setup.depthBuffer.value();
+
+        this->depthImage = depthBuffer.image.texture;
+        this->depthRange = { get_format_aspect(depthBuffer.format), 0, 1, 0, 1 };
+        this->depthExtent = setup.swapChainConfig.value().extent;
+
+        // Power of 2 mips : each texel of a mip covers exactly 2x2 texels of the previous one
+        this->pyramid.extent = { previous_power_of_two(this->depthExtent.width), previous_power_of_two(this->depthExtent.height) };
+
+        uint32_t levelCount = static_cast<uint32_t>(std::floor(std::log2(std::max(this->pyramid.extent.width, this->pyramid.extent.height)))) + 1;
+
+        WrappedTexture pyramidImage = create_texture(setup, this->pyramid.extent.width, this->pyramid.extent.height, VK_SAMPLE_COUNT_1_BIT, levelCount, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        this->pyramid.image = pyramidImage.texture;
+        this->pyramid.memory = pyramidImage.memory;
+
+        VkImageViewCreateInfo viewCreateInfo{};
+        viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewCreateInfo.image = this->pyramid.image;
+        viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+
+        if (vkCreateImageView(this->device, &viewCreateInfo, nullptr, &this->pyramid.view) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create depth pyramid image view.");
+        }
+
+        this->pyramid.levelViews.resize(levelCount);
+        for (uint32_t level = 0; level != levelCount; ++level) {
+            viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+
+            if (vkCreateImageView(this->device, &viewCreateInfo, nullptr, &this->pyramid.levelViews[level]) != VK_SUCCESS) {
+                throw std::runtime_error("Couldn't create depth pyramid level image view.");
+            }
+        }
+
+        // Cleared to the far plane : nothing is occluded until a first pyramid has been built
+        VkCommandBuffer commandBuffer = begin_one_shot_command(setup, setup.commandPools.value().graphics);
+
+        VkImageSubresourceRange pyramidRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+
+        BarrierBatch(this->synchronization2)
+            .transition_image(this->pyramid.image, pyramidRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                              { VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT_KHR, 0 }, { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR })
+            .flush(commandBuffer);
+
+        VkClearColorValue farPlane{};
+        farPlane.float32[0] = 1.0f;
+        vkCmdClearColorImage(commandBuffer, this->pyramid.image, VK_IMAGE_LAYOUT_GENERAL, &farPlane, 1, &pyramidRange);
+
+        BarrierBatch(this->synchronization2)
+            .transition_image(this->pyramid.image, pyramidRange, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                              { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR }, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR })
+            .flush(commandBuffer);
+
+        end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &commandBuffer);
+
+        // DESCRIPTOR SETS : one to resolve the depth buffer, one per next mip
+        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        poolSizes[0] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levelCount };
+        poolSizes[1] = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levelCount };
+
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolCreateInfo.pPoolSizes = poolSizes.data();
+        poolCreateInfo.maxSets = levelCount;
+
+        if (vkCreateDescriptorPool(this->device, &poolCreateInfo, nullptr, &this->pyramid.descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create depth pyramid descriptor pool.");
+        }
+
+        std::vector<VkDescriptorSetLayout> setLayouts(levelCount, this->pyramidSetLayout);
+        std::vector<VkDescriptorSet>       descriptorSets(levelCount);
+
+        VkDescriptorSetAllocateInfo setAllocateInfo{};
+        setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setAllocateInfo.descriptorPool = this->pyramid.descriptorPool;
+        setAllocateInfo.descriptorSetCount = levelCount;
+        setAllocateInfo.pSetLayouts = setLayouts.data();
+
+        if (vkAllocateDescriptorSets(this->device, &setAllocateInfo, descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't allocate depth pyramid descriptor sets.");
+        }
+
+        this->pyramid.resolveSet = descriptorSets[0];
+        this->pyramid.reduceSets.assign(descriptorSets.begin() + 1, descriptorSets.end());
+
+        std::vector<VkDescriptorImageInfo> sourceInfos(levelCount);
+        std::vector<VkDescriptorImageInfo> levelInfos(levelCount);
+        std::vector<VkWriteDescriptorSet>  writes(2 * levelCount);
+
+        for (uint32_t level = 0; level != levelCount; ++level) {
+            // The depth buffer is left read-only by the render pass
+            sourceInfos[level] = level == 0 ? VkDescriptorImageInfo{ this->pyramidSampler, depthBuffer.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL }
+                                            : VkDescriptorImageInfo{ this->pyramidSampler, this->pyramid.levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+            levelInfos[level] = { VK_NULL_HANDLE, this->pyramid.levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+
+            writes[2 * level].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[2 * level].dstSet = descriptorSets[level];
+            writes[2 * level].dstBinding = 0;
+            writes[2 * level].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[2 * level].descriptorCount = 1;
+            writes[2 * level].pImageInfo = &sourceInfos[level];
+
+            writes[2 * level + 1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[2 * level + 1].dstSet = descriptorSets[level];
+            writes[2 * level + 1].dstBinding = 1;
+            writes[2 * level + 1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[2 * level + 1].descriptorCount = 1;
+            writes[2 * level + 1].pImageInfo = &levelInfos[level];
+        }
+
+        vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+
+
+    void GpuCulling::destroy_pyramid() {
+        if (this->pyramid.image == VK_NULL_HANDLE) {
+            return;
+        }
+
+        vkDestroyDescriptorPool(this->device, this->pyramid.descriptorPool, nullptr);
+
+        for (VkImageView levelView : this->pyramid.levelViews) {
+            vkDestroyImageView(this->device, levelView, nullptr);
+        }
+
+        vkDestroyImageView(this->device, this->pyramid.view, nullptr);
+        vkDestroyImage(this->device, this->pyramid.image, nullptr);
+        vkFreeMemory(this->device, this->pyramid.memory, nullptr);
+
+        this->pyramid = DepthPyramid{};
+    }
+
+
+
+    void GpuCulling::destroy() {
+        for (FrameBuffers &buffers : this->frames) {
+            this->destroy_frame_buffers(&buffers);
+        }
+
+        this->destroy_pyramid();
+
+        vkDestroyDescriptorPool(this->device, this->descriptorPool, nullptr);
+
+        vkDestroyPipeline(this->device, this->cullPipeline, nullptr);
+        vkDestroyPipeline(this->device, this->resolvePipeline, nullptr);
+        vkDestroyPipeline(this->device, this->reducePipeline, nullptr);
+
+        vkDestroyPipelineLayout(this->device, this->cullLayout, nullptr);
+        vkDestroyPipelineLayout(this->device, this->pyramidLayout, nullptr);
+
+        vkDestroyDescriptorSetLayout(this->device, this->cullSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(this->device, this->pyramidSetLayout, nullptr);
+
+        vkDestroySampler(this->device, this->pyramidSampler, nullptr);
+    }
+
+
+
+    void GpuCulling::set_objects(std::vector<GpuObject> newObjects) {
+        this->objects = std::move(newObjects);
+
+        ++this->version;
+    }
+
+
+
+    uint32_t GpuCulling::size() const {
+        return static_cast<uint32_t>(this->objects.size());
+    }
+
+
+
+    bool GpuCulling::uses_draw_indirect_count() const {
+        return this->drawIndirectCount;
+    }
+
+
+
+    bool GpuCulling::upload(const InstanceSetup &setup, uint32_t frameIndex) {
+        FrameBuffers &buffers = this->frames[frameIndex];
+
+        if (buffers.version == this->version) {
+            return false;
+        }
+
+        FHOPE_TRACE_SCOPE("GpuCulling::upload");
+
+        if (this->objects.size() > buffers.capacity) {
+            // The slot's fence has been waited on : nothing reads the old buffers anymore
+            uint32_t newCapacity = buffers.capacity;
+            while (newCapacity < this->objects.size()) {
+                newCapacity *= 2;
+            }
+
+            VkDescriptorSet descriptorSet = buffers.descriptorSet;
+
+            this->destroy_frame_buffers(&buffers);
+            buffers = this->create_frame_buffers(setup, newCapacity);
+            buffers.descriptorSet = descriptorSet;
+
+            this->write_buffer_descriptors(buffers);
+        }
+
+        std::memcpy(buffers.mapping, this->objects.data(), this->objects.size() * sizeof(GpuObject));
+        buffers.objectCount = static_cast<uint32_t>(this->objects.size());
+        buffers.version = this->version;
+
+        return true;
+    }
+
+
+
+    void GpuCulling::rebind_instances(uint32_t frameIndex, const VkDescriptorBufferInfo &instances) {
+        VkWriteDescriptorSet writeInfo{};
+        writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeInfo.dstSet = this->frames[frameIndex].descriptorSet;
+        writeInfo.dstBinding = 2;
+        writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writeInfo.descriptorCount = 1;
+        writeInfo.pBufferInfo = &instances;
+
+        vkUpdateDescriptorSets(this->device, 1, &writeInfo, 0, nullptr);
+    }
+
+
+
+    void GpuCulling::resize(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        this->destroy_pyramid();
+        this->create_pyramid(setup);
+
+        VkDescriptorImageInfo pyramidInfo{ this->pyramidSampler, this->pyramid.view, VK_IMAGE_LAYOUT_GENERAL };
+
+        for (const FrameBuffers &buffers : this->frames) {
+            VkWriteDescriptorSet writeInfo{};
+            writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeInfo.dstSet = buffers.descriptorSet;
+            writeInfo.dstBinding = 5;
+            writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writeInfo.descriptorCount = 1;
+            writeInfo.pImageInfo = &pyramidInfo;
+
+            vkUpdateDescriptorSets(this->device, 1, &writeInfo, 0, nullptr);
+        }
+    }
+
+
+
+    void GpuCulling::record_cull(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+        const FrameBuffers &buffers = this->frames[frameIndex];
+
+        // The slot's previous draws have completed (it's fence has been waited on) : the count can be reset right away
+        vkCmdFillBuffer(commandBuffer, buffers.count, 0, sizeof(uint32_t), 0);
+
+        BarrierBatch(this->synchronization2)
+            .buffer(buffers.count, 0, VK_WHOLE_SIZE, { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR }, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR })
+            .flush(commandBuffer);
+
+        CullConstants constants{ buffers.objectCount, this->drawIndirectCount ? 1u : 0u };
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->cullPipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->cullLayout, 0, 1, &buffers.descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, this->cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &constants);
+
+        if (buffers.objectCount != 0) {
+            vkCmdDispatch(commandBuffer, group_count(buffers.objectCount, CULL_WORKGROUP_SIZE), 1, 1);
+        }
+
+        BarrierBatch(this->synchronization2)
+            .buffer(buffers.draws, 0, VK_WHOLE_SIZE, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR }, { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR })
+            .buffer(buffers.count, 0, VK_WHOLE_SIZE, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR }, { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR })
+            .flush(commandBuffer);
+    }
+
+
+
+    void GpuCulling::record_draws(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+        const FrameBuffers &buffers = this->frames[frameIndex];
+
+        if (buffers.objectCount == 0) {
+            return;
+        }
+
+        VkDeviceSize offset(0);
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &this->vertexBuffer, &offset);
+        vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        if (this->drawIndirectCount) {
+            vkCmdDrawIndexedIndirectCount(commandBuffer, buffers.draws, 0, buffers.count, 0, buffers.objectCount, stride);
+        } else if (this->multiDrawIndirect) {
+            vkCmdDrawIndexedIndirect(commandBuffer, buffers.draws, 0, buffers.objectCount, stride);
+        } else {
+            // Without multi-draw, each command needs it's own call : CPU cost grows with the object count again
+            for (uint32_t i = 0; i != buffers.objectCount; ++i) {
+                vkCmdDrawIndexedIndirect(commandBuffer, buffers.draws, static_cast<VkDeviceSize>(i) * stride, 1, stride);
+            }
+        }
+    }
+
+
+
+    void GpuCulling::record_depth_pyramid(VkCommandBuffer commandBuffer) const {
+        uint32_t levelCount = static_cast<uint32_t>(this->pyramid.levelViews.size());
+        VkImageSubresourceRange pyramidRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+
+        // The cull pass of this frame must have read the previous pyramid before it is overwritten
+        BarrierBatch(this->synchronization2)
+            .transition_image(this->pyramid.image, pyramidRange, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                              { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR }, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR })
+            .flush(commandBuffer);
+
+        // First mip : farthest depth of every covered texel (and sample) of the depth buffer
+        PyramidConstants constants{ this->depthExtent.width, this->depthExtent.height, this->pyramid.extent.width, this->pyramid.extent.height, this->depthSampleCount };
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->resolvePipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pyramidLayout, 0, 1, &this->pyramid.resolveSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, this->pyramidLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidConstants), &constants);
+        vkCmdDispatch(commandBuffer, group_count(constants.levelWidth, PYRAMID_WORKGROUP_SIZE), group_count(constants.levelHeight, PYRAMID_WORKGROUP_SIZE), 1);
+
+        // Next mips : farthest depth of the 2x2 texels below
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->reducePipeline);
+
+        for (uint32_t level = 1; level != levelCount; ++level) {
+            BarrierBatch(this->synchronization2)
+                .transition_image(this->pyramid.image, { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1 }, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                                  { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR }, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR })
+                .flush(commandBuffer);
+
+            constants.sourceWidth  = constants.levelWidth;
+            constants.sourceHeight = constants.levelHeight;
+            constants.levelWidth   = std::max(constants.levelWidth / 2, 1u);
+            constants.levelHeight  = std::max(constants.levelHeight / 2, 1u);
+            constants.sampleCount  = 1;
+
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pyramidLayout, 0, 1, &this->pyramid.reduceSets[level - 1], 0, nullptr);
+            vkCmdPushConstants(commandBuffer, this->pyramidLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidConstants), &constants);
+            vkCmdDispatch(commandBuffer, group_count(constants.levelWidth, PYRAMID_WORKGROUP_SIZE), group_count(constants.levelHeight, PYRAMID_WORKGROUP_SIZE), 1);
+        }
+
+        // Next frame's cull pass reads the pyramid, and it's render pass must not clear the depth buffer while it is still read
+        BarrierBatch(this->synchronization2)
+            .transition_image(this->pyramid.image, pyramidRange, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                              { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR }, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR })
+            .transition_image(this->depthImage, this->depthRange, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                              { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, 0 }, { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR, 0 })
+            .flush(commandBuffer);
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    glm::vec4 compute_bounding_sphere(const std::vector<Vertex3D> &vertices) {
+        if (vertices.empty()) {
+            return glm::vec4(0.0f);
+        }
+
+        glm::vec3 minimum(std::numeric_limits<float>::max());
+        glm::vec3 maximum(std::numeric_limits<float>::lowest());
+
+        for (const Vertex3D &vertex : vertices) {
+            minimum = glm::min(minimum, vertex.position);
+            maximum = glm::max(maximum, vertex.position);
+        }
+
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+
+        float radiusSquared(0.0f);
+        for (const Vertex3D &vertex : vertices) {
+            glm::vec3 offset = vertex.position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+
+        return glm::vec4(center, std::sqrt(radiusSquared));
+    }
+}
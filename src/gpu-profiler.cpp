@@ -0,0 +1,309 @@
+#include "gpu-profiler.hpp"
+#include "setup.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fhope {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static std::string escape_json(const std::string &text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(c);
+        }
+
+        return escaped;
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+        /*-----------------------*
+         *- METHODS: GpuProfiler -*
+         *-----------------------*/
+
+    GpuProfiler::GpuProfiler(const InstanceSetup &setup, uint32_t frameCount, uint32_t maxZonesPerFrame) : recordingFrame(0) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a GPU profiler without providing a logical device in the setup.");
+        }
+
+        if (!setup.physicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a GPU profiler without providing a physical device in the setup.");
+        }
+
+        if (!setup.queues.has_value() || !setup.queues.value().graphicsIndex.has_value()) {
+            throw std::runtime_error("Tried to create a GPU profiler without providing a graphics queue family index in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+        this->maxQueries = maxZonesPerFrame * 2;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(setup.physicalDevice.value(), &properties);
+        this->timestampPeriod = static_cast<double>(properties.limits.timestampPeriod);
+
+        uint32_t familyCount(0);
+        vkGetPhysicalDeviceQueueFamilyProperties(setup.physicalDevice.value(), &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(setup.physicalDevice.value(), &familyCount, families.data());
+
+        uint32_t validBits = families[setup.queues.value().graphicsIndex.value()].timestampValidBits;
+        this->timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+        // Without valid bits, timestamps are unsupported on the queue : every zone silently does nothing
+        this->enabled = validBits != 0;
+
+        this->frames.resize(frameCount);
+
+        if (!this->enabled) {
+            return;
+        }
+
+        for (FrameQueries &frame : this->frames) {
+            VkQueryPoolCreateInfo queryPoolCreateInfo{};
+            queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolCreateInfo.queryCount = this->maxQueries;
+
+            if (vkCreateQueryPool(this->device, &queryPoolCreateInfo, nullptr, &frame.pool) != VK_SUCCESS) {
+                throw std::runtime_error("Couldn't create GPU profiler query pool.");
+            }
+        }
+    }
+
+
+
+    void GpuProfiler::destroy() {
+        for (FrameQueries &frame : this->frames) {
+            if (frame.pool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(this->device, frame.pool, nullptr);
+                frame.pool = VK_NULL_HANDLE;
+            }
+        }
+
+        this->enabled = false;
+    }
+
+
+
+    void GpuProfiler::collect(uint32_t frameIndex) {
+        FrameQueries &frame = this->frames[frameIndex];
+
+        if (!this->enabled || !frame.submitted || frame.usedQueries == 0) {
+            return;
+        }
+
+        std::vector<uint64_t> timestamps(frame.usedQueries);
+
+        // No WAIT flag : the slot's fence has been waited on, so results are available (or the frame is skipped)
+        if (vkGetQueryPoolResults(this->device, frame.pool, 0, frame.usedQueries, timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            return;
+        }
+
+        frame.submitted = false;
+
+        for (const RecordedZone &zone : frame.zones) {
+            uint64_t ticks = (timestamps[zone.endQuery] - timestamps[zone.beginQuery]) & this->timestampMask;
+            double milliseconds = static_cast<double>(ticks) * this->timestampPeriod / 1000000.0;
+
+            ZoneHistory &zoneHistory = this->history[zone.path];
+            zoneHistory.depth = zone.depth;
+
+            if (zoneHistory.samples.size() < GPU_PROFILER_HISTORY) {
+                zoneHistory.samples.push_back(milliseconds);
+            } else {
+                zoneHistory.samples[zoneHistory.nextSample] = milliseconds;
+            }
+
+            zoneHistory.nextSample = (zoneHistory.nextSample + 1) % GPU_PROFILER_HISTORY;
+            zoneHistory.last = milliseconds;
+            ++zoneHistory.sampleCount;
+        }
+    }
+
+
+
+    void GpuProfiler::mark_submitted(uint32_t frameIndex) {
+        this->frames[frameIndex].submitted = true;
+    }
+
+
+
+    void GpuProfiler::begin_frame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+        this->recordingFrame = frameIndex;
+        this->openZones.clear();
+
+        FrameQueries &frame = this->frames[frameIndex];
+        frame.zones.clear();
+        frame.usedQueries = 0;
+
+        if (this->enabled) {
+            vkCmdResetQueryPool(commandBuffer, frame.pool, 0, this->maxQueries);
+        }
+    }
+
+
+
+    void GpuProfiler::begin_zone(VkCommandBuffer commandBuffer, const std::string &name, VkPipelineStageFlagBits stage) {
+        FrameQueries &frame = this->frames[this->recordingFrame];
+
+        // Out of queries : the zone (and it's children) are still tracked so that end_zone calls stay balanced
+        if (!this->enabled || frame.usedQueries + 2 > this->maxQueries) {
+            this->openZones.push_back(SIZE_MAX);
+            return;
+        }
+
+        RecordedZone zone{};
+        zone.path = this->openZones.empty() || this->openZones.back() == SIZE_MAX ? name : frame.zones[this->openZones.back()].path + "/" + name;
+        zone.depth = static_cast<uint32_t>(this->openZones.size());
+        zone.beginQuery = frame.usedQueries++;
+        zone.endQuery = frame.usedQueries++; // Reserved now, so that a parent's queries always surround it's children's
+
+        vkCmdWriteTimestamp(commandBuffer, stage, frame.pool, zone.beginQuery);
+
+        this->openZones.push_back(frame.zones.size());
+        frame.zones.push_back(zone);
+    }
+
+
+
+    void GpuProfiler::end_zone(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage) {
+        if (!this->end_open_zone(commandBuffer, stage)) {
+            throw std::runtime_error("Tried to end a GPU zone while none is open.");
+        }
+    }
+
+
+
+    bool GpuProfiler::end_open_zone(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage) noexcept {
+        if (this->openZones.empty()) {
+            return false;
+        }
+
+        size_t zoneIndex = this->openZones.back();
+        this->openZones.pop_back();
+
+        if (zoneIndex == SIZE_MAX) {
+            return true;
+        }
+
+        FrameQueries &frame = this->frames[this->recordingFrame];
+        vkCmdWriteTimestamp(commandBuffer, stage, frame.pool, frame.zones[zoneIndex].endQuery);
+
+        return true;
+    }
+
+
+
+    std::vector<GpuZoneStats> GpuProfiler::get_stats() const {
+        std::vector<GpuZoneStats> stats;
+        stats.reserve(this->history.size());
+
+        for (const auto &[path, zoneHistory] : this->history) {
+            GpuZoneStats zoneStats{};
+            zoneStats.path = path;
+            zoneStats.depth = zoneHistory.depth;
+            zoneStats.lastMilliseconds = zoneHistory.last;
+            zoneStats.sampleCount = zoneHistory.sampleCount;
+
+            double total(0.0);
+            zoneStats.minMilliseconds = zoneHistory.samples.empty() ? 0.0 : zoneHistory.samples.front();
+            zoneStats.maxMilliseconds = zoneStats.minMilliseconds;
+
+            for (double sample : zoneHistory.samples) {
+                total += sample;
+                zoneStats.minMilliseconds = std::min(zoneStats.minMilliseconds, sample);
+                zoneStats.maxMilliseconds = std::max(zoneStats.maxMilliseconds, sample);
+            }
+
+            zoneStats.averageMilliseconds = zoneHistory.samples.empty() ? 0.0 : total / static_cast<double>(zoneHistory.samples.size());
+
+            stats.push_back(zoneStats);
+        }
+
+        return stats;
+    }
+
+
+
+    std::string GpuProfiler::export_json() const {
+        std::ostringstream json;
+        json << "{\n  \"zones\": [";
+
+        std::vector<GpuZoneStats> stats = this->get_stats();
+        for (size_t i = 0; i != stats.size(); ++i) {
+            const GpuZoneStats &zone = stats[i];
+
+            json << (i == 0 ? "\n" : ",\n")
+                 << "    { \"path\": \"" << escape_json(zone.path) << "\""
+                 << ", \"depth\": " << zone.depth
+                 << ", \"lastMs\": " << zone.lastMilliseconds
+                 << ", \"averageMs\": " << zone.averageMilliseconds
+                 << ", \"minMs\": " << zone.minMilliseconds
+                 << ", \"maxMs\": " << zone.maxMilliseconds
+                 << ", \"samples\": " << zone.sampleCount << " }";
+        }
+
+        json << "\n  ]\n}\n";
+
+        return json.str();
+    }
+
+
+
+    std::string GpuProfiler::export_csv() const {
+        std::ostringstream csv;
+        csv << "path,depth,last_ms,average_ms,min_ms,max_ms,samples\n";
+
+        for (const GpuZoneStats &zone : this->get_stats()) {
+            csv << '"' << zone.path << "\"," << zone.depth << ',' << zone.lastMilliseconds << ',' << zone.averageMilliseconds << ','
+                << zone.minMilliseconds << ',' << zone.maxMilliseconds << ',' << zone.sampleCount << '\n';
+        }
+
+        return csv.str();
+    }
+
+
+
+    void GpuProfiler::save(const std::string &filename) const {
+        std::ofstream file(filename, std::ios::trunc);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open GPU profile file `" + filename + "`.");
+        }
+
+        bool csv = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0;
+        file << (csv ? this->export_csv() : this->export_json());
+    }
+
+        /*-------------------*
+         *- METHODS: GpuZone -*
+         *-------------------*/
+
+    GpuZone::GpuZone(GpuProfiler *profiler, VkCommandBuffer commandBuffer, const std::string &name) : profiler(profiler), commandBuffer(commandBuffer) {
+        if (this->profiler != nullptr) {
+            this->profiler->begin_zone(this->commandBuffer, name);
+        }
+    }
+
+
+
+    GpuZone::~GpuZone() {
+        // Destructors must not throw : an unbalanced zone is simply not ended twice
+        if (this->profiler != nullptr) {
+            this->profiler->end_open_zone(this->commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        }
+    }
+}
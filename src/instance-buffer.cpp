@@ -0,0 +1,203 @@
+#include "instance-buffer.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace fhope {
+    /*************
+     ** METHODS **
+     *************/
+
+    InstanceBuffer::InstanceBuffer(const InstanceSetup &setup, uint32_t frameCount, uint32_t initialCapacity) : version(0) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create an instance buffer without providing a logical device in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+
+        this->frames.reserve(frameCount);
+        for (uint32_t i = 0; i != frameCount; ++i) {
+            this->frames.push_back(this->create_storage(setup, std::max(initialCapacity, 1u)));
+        }
+    }
+
+
+
+    InstanceBuffer::FrameStorage InstanceBuffer::create_storage(const InstanceSetup &setup, uint32_t capacity) const {
+        WrappedBuffer buffer = create_buffer(setup, static_cast<VkDeviceSize>(capacity) * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        FrameStorage storage{};
+        storage.buffer = buffer.buffer;
+        storage.memory = buffer.memory;
+        storage.capacity = capacity;
+
+        vkMapMemory(this->device, storage.memory, 0, buffer.sizeInBytes, 0, &storage.mapping);
+
+        return storage;
+    }
+
+
+
+    void InstanceBuffer::destroy_storage(FrameStorage *storage) const {
+        if (storage->buffer == VK_NULL_HANDLE) {
+            return;
+        }
+
+        vkUnmapMemory(this->device, storage->memory);
+        vkDestroyBuffer(this->device, storage->buffer, nullptr);
+        vkFreeMemory(this->device, storage->memory, nullptr);
+
+        *storage = FrameStorage{};
+    }
+
+
+
+    void InstanceBuffer::destroy() {
+        for (FrameStorage &storage : this->frames) {
+            this->destroy_storage(&storage);
+        }
+    }
+
+
+
+    InstanceHandle InstanceBuffer::add(const glm::mat4 &model, uint32_t textureIndex) {
+        InstanceHandle handle;
+
+        if (!this->freeHandles.empty()) {
+            handle = this->freeHandles.back();
+            this->freeHandles.pop_back();
+        } else {
+            handle = static_cast<InstanceHandle>(this->handleToDense.size());
+            this->handleToDense.push_back(UINT32_MAX);
+        }
+
+        this->handleToDense[handle] = static_cast<uint32_t>(this->instances.size());
+        this->instances.push_back({ model, textureIndex, {} });
+        this->denseToHandle.push_back(handle);
+
+        ++this->version;
+
+        return handle;
+    }
+
+
+
+    void InstanceBuffer::update(InstanceHandle handle, const glm::mat4 &model) {
+        if (!this->contains(handle)) {
+            throw std::runtime_error("Tried to update an instance that does not exist.");
+        }
+
+        this->instances[this->handleToDense[handle]].model = model;
+
+        ++this->version;
+    }
+
+
+
+    void InstanceBuffer::set_texture(InstanceHandle handle, uint32_t textureIndex) {
+        if (!this->contains(handle)) {
+            throw std::runtime_error("Tried to change the texture of an instance that does not exist.");
+        }
+
+        this->instances[this->handleToDense[handle]].textureIndex = textureIndex;
+
+        ++this->version;
+    }
+
+
+
+    void InstanceBuffer::remove(InstanceHandle handle) {
+        if (!this->contains(handle)) {
+            throw std::runtime_error("Tried to remove an instance that does not exist.");
+        }
+
+        // Swap with the last instance : instances stay packed, only one instance moves
+        uint32_t dense = this->handleToDense[handle];
+        uint32_t last  = static_cast<uint32_t>(this->instances.size() - 1);
+
+        if (dense != last) {
+            this->instances[dense] = this->instances[last];
+            this->denseToHandle[dense] = this->denseToHandle[last];
+            this->handleToDense[this->denseToHandle[dense]] = dense;
+        }
+
+        this->instances.pop_back();
+        this->denseToHandle.pop_back();
+
+        this->handleToDense[handle] = UINT32_MAX;
+        this->freeHandles.push_back(handle);
+
+        ++this->version;
+    }
+
+
+
+    bool InstanceBuffer::contains(InstanceHandle handle) const {
+        return handle < this->handleToDense.size() && this->handleToDense[handle] != UINT32_MAX;
+    }
+
+
+
+    uint32_t InstanceBuffer::size() const {
+        return static_cast<uint32_t>(this->instances.size());
+    }
+
+
+
+    bool InstanceBuffer::upload(const InstanceSetup &setup, uint32_t frameIndex, VkDescriptorSet descriptorSet) {
+        FrameStorage &storage = this->frames[frameIndex];
+
+        if (storage.version == this->version) {
+            return false;
+        }
+
+        FHOPE_TRACE_SCOPE("InstanceBuffer::upload");
+
+        bool grown(false);
+
+        if (this->instances.size() > storage.capacity) {
+            // The slot's fence has been waited on : nothing reads the old buffer anymore
+            uint32_t newCapacity = storage.capacity;
+            while (newCapacity < this->instances.size()) {
+                newCapacity *= 2;
+            }
+
+            this->destroy_storage(&storage);
+            storage = this->create_storage(setup, newCapacity);
+
+            VkDescriptorBufferInfo descriptorBufferInfo = this->get_descriptor_info(frameIndex);
+
+            VkWriteDescriptorSet writeInfo{};
+            writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeInfo.dstSet = descriptorSet;
+            writeInfo.dstBinding = INSTANCE_BUFFER_BINDING;
+            writeInfo.dstArrayElement = 0;
+            writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writeInfo.descriptorCount = 1;
+            writeInfo.pBufferInfo = &descriptorBufferInfo;
+
+            vkUpdateDescriptorSets(this->device, 1, &writeInfo, 0, nullptr);
+
+            grown = true;
+        }
+
+        std::memcpy(storage.mapping, this->instances.data(), this->instances.size() * sizeof(InstanceData));
+        storage.version = this->version;
+
+        return grown;
+    }
+
+
+
+    VkDescriptorBufferInfo InstanceBuffer::get_descriptor_info(uint32_t frameIndex) const {
+        VkDescriptorBufferInfo descriptorBufferInfo{};
+        descriptorBufferInfo.buffer = this->frames[frameIndex].buffer;
+        descriptorBufferInfo.offset = 0;
+        descriptorBufferInfo.range  = VK_WHOLE_SIZE;
+
+        return descriptorBufferInfo;
+    }
+}
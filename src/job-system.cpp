@@ -0,0 +1,401 @@
+#include "job-system.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace fhope {
+    /****************
+     ** STRUCTURES **
+     ****************/
+
+    /**
+     * @brief Unit of work queued in a job system
+     */
+    struct Job {
+        std::function<void()> function; ///< Work of the job
+        JobCounter           *counter;  ///< Counter decremented once the job finishes (nullptr if none)
+    };
+
+    /*************
+     ** HELPERS **
+     *************/
+
+    // Job system and worker index of the calling thread (nullptr for threads that are not workers)
+    static thread_local JobSystem *currentSystem = nullptr;
+    static thread_local uint32_t   currentWorker = 0;
+
+    /*************
+     ** METHODS **
+     *************/
+
+    JobCounter::JobCounter() : pending(0) {}
+
+
+
+    bool JobCounter::is_done() const {
+        return this->pending.load(std::memory_order_acquire) == 0;
+    }
+
+
+
+    WorkStealingDeque::Ring::Ring(int64_t capacity) : capacity(capacity), slots(new std::atomic<Job *>[static_cast<size_t>(capacity)]) {}
+
+
+
+    WorkStealingDeque::WorkStealingDeque(int64_t capacity) : top(0), bottom(0) {
+        this->rings.push_back(std::make_unique<Ring>(static_cast<int64_t>(std::bit_ceil(static_cast<uint64_t>(std::max<int64_t>(capacity, 2))))));
+        this->ring.store(this->rings.back().get(), std::memory_order_relaxed);
+    }
+
+
+
+    WorkStealingDeque::Ring *WorkStealingDeque::grow(int64_t currentTop, int64_t currentBottom) {
+        Ring *oldRing = this->ring.load(std::memory_order_relaxed);
+
+        this->rings.push_back(std::make_unique<Ring>(oldRing->capacity * 2));
+        Ring *newRing = this->rings.back().get();
+
+        for (int64_t i = currentTop; i != currentBottom; ++i) {
+            newRing->slots[i & (newRing->capacity - 1)].store(oldRing->slots[i & (oldRing->capacity - 1)].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        this->ring.store(newRing, std::memory_order_release);
+
+        return newRing;
+    }
+
+
+
+    void WorkStealingDeque::push(Job *job) {
+        int64_t currentBottom = this->bottom.load(std::memory_order_relaxed);
+        int64_t currentTop = this->top.load(std::memory_order_acquire);
+        Ring *currentRing = this->ring.load(std::memory_order_relaxed);
+
+        if (currentBottom - currentTop > currentRing->capacity - 1) {
+            currentRing = this->grow(currentTop, currentBottom);
+        }
+
+        currentRing->slots[currentBottom & (currentRing->capacity - 1)].store(job, std::memory_order_relaxed);
+
+        // Thieves seeing the new bottom must see the job
+        std::atomic_thread_fence(std::memory_order_release);
+        this->bottom.store(currentBottom + 1, std::memory_order_relaxed);
+    }
+
+
+
+    Job *WorkStealingDeque::pop() {
+        int64_t currentBottom = this->bottom.load(std::memory_order_relaxed) - 1;
+        Ring *currentRing = this->ring.load(std::memory_order_relaxed);
+
+        // Reserves the last job before looking at thieves' progress
+        this->bottom.store(currentBottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t currentTop = this->top.load(std::memory_order_relaxed);
+
+        if (currentTop > currentBottom) { // Empty
+            this->bottom.store(currentBottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job *job = currentRing->slots[currentBottom & (currentRing->capacity - 1)].load(std::memory_order_relaxed);
+
+        if (currentTop == currentBottom) { // Last job : thieves may be racing for it
+            if (!this->top.compare_exchange_strong(currentTop, currentTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+
+            this->bottom.store(currentBottom + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+
+
+    Job *WorkStealingDeque::steal() {
+        int64_t currentTop = this->top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t currentBottom = this->bottom.load(std::memory_order_acquire);
+
+        if (currentTop >= currentBottom) {
+            return nullptr;
+        }
+
+        Ring *currentRing = this->ring.load(std::memory_order_acquire);
+        Job *job = currentRing->slots[currentTop & (currentRing->capacity - 1)].load(std::memory_order_relaxed);
+
+        if (!this->top.compare_exchange_strong(currentTop, currentTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+
+        return job;
+    }
+
+
+
+    JobSystem::JobSystem(uint32_t workerCount) : queued(0), sleeping(0), stopping(false) {
+        workerCount = std::max(workerCount, 1u);
+
+        // Every deque exists before any worker may steal from it
+        for (uint32_t i = 0; i != workerCount; ++i) {
+            this->deques.push_back(std::make_unique<WorkStealingDeque>());
+        }
+
+        for (uint32_t i = 0; i != workerCount; ++i) {
+            this->workers.emplace_back(&JobSystem::worker_loop, this, i);
+        }
+    }
+
+
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(this->sleepMutex);
+            this->stopping.store(true);
+        }
+        this->wakeCondition.notify_all();
+
+        for (std::thread &worker : this->workers) {
+            worker.join();
+        }
+
+        for (const std::unique_ptr<WorkStealingDeque> &deque : this->deques) {
+            while (Job *job = deque->steal()) {
+                delete job;
+            }
+        }
+
+        for (Job *job : this->injected) {
+            delete job;
+        }
+    }
+
+
+
+    void JobSystem::worker_loop(uint32_t workerIndex) {
+        FHOPE_TRACE_THREAD_NAME("job worker");
+
+        currentSystem = this;
+        currentWorker = workerIndex;
+
+        while (true) {
+            if (Job *job = this->find_job()) {
+                this->execute(job);
+                continue;
+            }
+
+            // Announcing the sleep before checking the queue count pairs with submit reading it after queuing : no wake up is lost
+            this->sleeping.fetch_add(1);
+
+            {
+                std::unique_lock<std::mutex> lock(this->sleepMutex);
+                this->wakeCondition.wait(lock, [this]() { return this->stopping.load() || this->queued.load() > 0; });
+            }
+
+            this->sleeping.fetch_sub(1);
+
+            if (this->stopping.load()) {
+                return;
+            }
+        }
+    }
+
+
+
+    void JobSystem::submit(Job *job) {
+        if (currentSystem == this) {
+            this->deques[currentWorker]->push(job);
+        } else {
+            std::lock_guard<std::mutex> lock(this->injectionMutex);
+            this->injected.push_back(job);
+        }
+
+        this->queued.fetch_add(1);
+
+        if (this->sleeping.load() != 0) {
+            // Taking the mutex makes sure a worker between it's check and it's wait is waiting before being notified
+            { std::lock_guard<std::mutex> lock(this->sleepMutex); }
+            this->wakeCondition.notify_one();
+        }
+    }
+
+
+
+    Job *JobSystem::find_job() {
+        Job *job = nullptr;
+
+        if (currentSystem == this) {
+            job = this->deques[currentWorker]->pop();
+        }
+
+        if (job == nullptr) {
+            std::lock_guard<std::mutex> lock(this->injectionMutex);
+
+            if (!this->injected.empty()) {
+                job = this->injected.front();
+                this->injected.pop_front();
+            }
+        }
+
+        if (job == nullptr) {
+            // Victims are visited from the next worker on, so that thieves spread over the deques
+            const uint32_t workerCount = static_cast<uint32_t>(this->deques.size());
+            const uint32_t first = (currentSystem == this) ? currentWorker + 1 : 0;
+
+            for (uint32_t i = 0; i != workerCount && job == nullptr; ++i) {
+                job = this->deques[(first + i) % workerCount]->steal();
+            }
+        }
+
+        if (job != nullptr) {
+            this->queued.fetch_sub(1);
+        }
+
+        return job;
+    }
+
+
+
+    void JobSystem::execute(Job *job) {
+        std::exception_ptr jobError;
+
+        try {
+            FHOPE_TRACE_SCOPE("job");
+            job->function();
+        } catch (...) {
+            jobError = std::current_exception();
+        }
+
+        JobCounter *counter = job->counter;
+
+        // The job's captures are released last : they may own the counter
+        std::unique_ptr<Job> finished(job);
+
+        if (counter == nullptr) {
+            return;
+        }
+
+        std::vector<Job *> released;
+
+        {
+            // Decrementing under the lock keeps the counter alive until it is released, a waiter taking the lock before returning
+            std::lock_guard<std::mutex> lock(counter->mutex);
+
+            if (jobError && !counter->error) {
+                counter->error = jobError;
+            }
+
+            if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                released.swap(counter->waiting);
+            }
+        }
+
+        for (Job *dependent : released) {
+            this->submit(dependent);
+        }
+    }
+
+
+
+    uint32_t JobSystem::get_worker_count() const {
+        return static_cast<uint32_t>(this->workers.size());
+    }
+
+
+
+    void JobSystem::run(std::function<void()> function, JobCounter *counter) {
+        if (counter != nullptr) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        this->submit(new Job{ std::move(function), counter });
+    }
+
+
+
+    void JobSystem::run_after(JobCounter *dependency, std::function<void()> function, JobCounter *counter) {
+        if (counter != nullptr) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Job *job = new Job{ std::move(function), counter };
+
+        {
+            std::lock_guard<std::mutex> lock(dependency->mutex);
+
+            if (dependency->pending.load(std::memory_order_acquire) != 0) {
+                dependency->waiting.push_back(job);
+                return;
+            }
+        }
+
+        this->submit(job);
+    }
+
+
+
+    void JobSystem::wait(JobCounter *counter) {
+        FHOPE_TRACE_FUNCTION();
+
+        while (counter->pending.load(std::memory_order_acquire) != 0) {
+            if (Job *job = this->find_job()) {
+                this->execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        std::exception_ptr error;
+
+        {
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            error = counter->error;
+            counter->error = nullptr;
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+
+
+    void JobSystem::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &function) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (count == 0) {
+            return;
+        }
+
+        if (grain == 0) {
+            // A few chunks per thread (workers and the waiting one) balance uneven chunks without much overhead
+            const size_t chunkCount = 4 * (this->workers.size() + 1);
+            grain = std::max<size_t>((count + chunkCount - 1) / chunkCount, 1);
+        }
+
+        JobCounter counter;
+
+        for (size_t begin = 0; begin < count; begin += grain) {
+            const size_t end = std::min(count, begin + grain);
+            this->run([&function, begin, end]() { function(begin, end); }, &counter);
+        }
+
+        this->wait(&counter);
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    uint32_t get_job_worker_count(const RenderConfig &config) {
+        if (config.jobThreads != 0) {
+            return config.jobThreads;
+        }
+
+        // The thread creating the system helps whenever it waits
+        return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+}
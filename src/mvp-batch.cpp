@@ -0,0 +1,297 @@
+#include "mvp-batch.hpp"
+#include "mvp.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+    #include <immintrin.h>
+    #define FHOPE_MVP_BATCH_AVX2
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define FHOPE_MVP_BATCH_SSE
+#endif
+
+namespace fhope {
+    /*************
+     ** HELPERS **
+     *************/
+
+    // Element pointers of every array of a SoA, models being read and mvps written
+    struct MatrixStreams {
+        const float *in[16];
+        float       *out[16];
+    };
+
+
+
+    static MatrixStreams prepare_streams(const MatrixSoA &models, MatrixSoA *mvps) {
+        mvps->resize(models.size());
+
+        MatrixStreams streams;
+        for (size_t e = 0; e != 16; ++e) {
+            streams.in[e] = models.elements[e].data();
+            streams.out[e] = mvps->elements[e].data();
+        }
+
+        return streams;
+    }
+
+
+
+    // Element pointers of every array of three SoAs, lefts and rights being read and products written
+    struct PairStreams {
+        const float *left[16];
+        const float *right[16];
+        float       *out[16];
+    };
+
+
+
+    // out[column][row] = sum over k of left[k][row] * in[column][k], for matrices [first, count)
+    static void multiply_scalar(const float *left, const MatrixStreams &streams, size_t first, size_t count) {
+        for (size_t i = first; i != count; ++i) {
+            for (size_t column = 0; column != 4; ++column) {
+                float m0 = streams.in[column * 4][i];
+                float m1 = streams.in[column * 4 + 1][i];
+                float m2 = streams.in[column * 4 + 2][i];
+                float m3 = streams.in[column * 4 + 3][i];
+
+                for (size_t row = 0; row != 4; ++row) {
+                    streams.out[column * 4 + row][i] = left[row] * m0 + left[4 + row] * m1 + left[8 + row] * m2 + left[12 + row] * m3;
+                }
+            }
+        }
+    }
+
+
+
+    // Returns the first matrix left to compute
+    static size_t multiply_sse(const float *left, const MatrixStreams &streams, size_t count) {
+        size_t i(0);
+
+#if defined(FHOPE_MVP_BATCH_SSE)
+        __m128 broadcast[16];
+        for (size_t e = 0; e != 16; ++e) {
+            broadcast[e] = _mm_set1_ps(left[e]);
+        }
+
+        // Arrays are aligned, and i stays a multiple of 4 : every access is aligned
+        for (; i + 4 <= count; i += 4) {
+            for (size_t column = 0; column != 4; ++column) {
+                __m128 m0 = _mm_load_ps(streams.in[column * 4] + i);
+                __m128 m1 = _mm_load_ps(streams.in[column * 4 + 1] + i);
+                __m128 m2 = _mm_load_ps(streams.in[column * 4 + 2] + i);
+                __m128 m3 = _mm_load_ps(streams.in[column * 4 + 3] + i);
+
+                for (size_t row = 0; row != 4; ++row) {
+                    __m128 sum = _mm_add_ps(_mm_mul_ps(broadcast[row], m0), _mm_mul_ps(broadcast[4 + row], m1));
+                    sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(broadcast[8 + row], m2), _mm_mul_ps(broadcast[12 + row], m3)));
+                    _mm_store_ps(streams.out[column * 4 + row] + i, sum);
+                }
+            }
+        }
+#endif
+
+        return i;
+    }
+
+    // Same as multiply_scalar, with a left matrix per pair
+    static void multiply_pairs_scalar(const PairStreams &streams, size_t first, size_t count) {
+        for (size_t i = first; i != count; ++i) {
+            for (size_t column = 0; column != 4; ++column) {
+                float m0 = streams.right[column * 4][i];
+                float m1 = streams.right[column * 4 + 1][i];
+                float m2 = streams.right[column * 4 + 2][i];
+                float m3 = streams.right[column * 4 + 3][i];
+
+                for (size_t row = 0; row != 4; ++row) {
+                    streams.out[column * 4 + row][i] = streams.left[row][i] * m0 + streams.left[4 + row][i] * m1 + streams.left[8 + row][i] * m2 + streams.left[12 + row][i] * m3;
+                }
+            }
+        }
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    void MatrixSoA::resize(size_t count) {
+        for (auto &element : this->elements) {
+            element.resize(count);
+        }
+    }
+
+
+
+    void MatrixSoA::push_back(const glm::mat4 &matrix) {
+        for (size_t e = 0; e != 16; ++e) {
+            this->elements[e].push_back(matrix[static_cast<int>(e / 4)][static_cast<int>(e % 4)]);
+        }
+    }
+
+
+
+    void MatrixSoA::set(size_t index, const glm::mat4 &matrix) {
+        for (size_t e = 0; e != 16; ++e) {
+            this->elements[e][index] = matrix[static_cast<int>(e / 4)][static_cast<int>(e % 4)];
+        }
+    }
+
+
+
+    glm::mat4 MatrixSoA::get(size_t index) const {
+        glm::mat4 matrix;
+        for (size_t e = 0; e != 16; ++e) {
+            matrix[static_cast<int>(e / 4)][static_cast<int>(e % 4)] = this->elements[e][index];
+        }
+
+        return matrix;
+    }
+
+
+
+    size_t MatrixSoA::size() const {
+        return this->elements[0].size();
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    void compute_mvps(const glm::mat4 &viewProjection, const MatrixSoA &models, MatrixSoA *mvps) {
+        FHOPE_TRACE_FUNCTION();
+
+        MatrixStreams streams = prepare_streams(models, mvps);
+        const float *left = &viewProjection[0][0];
+        size_t count = models.size();
+        size_t i(0);
+
+#if defined(FHOPE_MVP_BATCH_AVX2)
+        __m256 broadcast[16];
+        for (size_t e = 0; e != 16; ++e) {
+            broadcast[e] = _mm256_set1_ps(left[e]);
+        }
+
+        // Arrays are aligned, and i stays a multiple of 8 : every access is aligned
+        for (; i + 8 <= count; i += 8) {
+            for (size_t column = 0; column != 4; ++column) {
+                __m256 m0 = _mm256_load_ps(streams.in[column * 4] + i);
+                __m256 m1 = _mm256_load_ps(streams.in[column * 4 + 1] + i);
+                __m256 m2 = _mm256_load_ps(streams.in[column * 4 + 2] + i);
+                __m256 m3 = _mm256_load_ps(streams.in[column * 4 + 3] + i);
+
+                for (size_t row = 0; row != 4; ++row) {
+                    __m256 sum = _mm256_mul_ps(broadcast[row], m0);
+                    sum = _mm256_fmadd_ps(broadcast[4 + row], m1, sum);
+                    sum = _mm256_fmadd_ps(broadcast[8 + row], m2, sum);
+                    sum = _mm256_fmadd_ps(broadcast[12 + row], m3, sum);
+                    _mm256_store_ps(streams.out[column * 4 + row] + i, sum);
+                }
+            }
+        }
+#else
+        i = multiply_sse(left, streams, count);
+#endif
+
+        multiply_scalar(left, streams, i, count);
+    }
+
+
+
+    void compute_mvps(MVP *mvp, const MatrixSoA &models, MatrixSoA *mvps) {
+        compute_mvps(mvp->get_view_projection(), models, mvps);
+    }
+
+
+
+    void compute_mvps_sse(const glm::mat4 &viewProjection, const MatrixSoA &models, MatrixSoA *mvps) {
+        FHOPE_TRACE_FUNCTION();
+
+        MatrixStreams streams = prepare_streams(models, mvps);
+        const float *left = &viewProjection[0][0];
+        size_t count = models.size();
+
+        multiply_scalar(left, streams, multiply_sse(left, streams, count), count);
+    }
+
+
+
+    void compute_mvps_scalar(const glm::mat4 &viewProjection, const MatrixSoA &models, MatrixSoA *mvps) {
+        FHOPE_TRACE_FUNCTION();
+
+        MatrixStreams streams = prepare_streams(models, mvps);
+
+        multiply_scalar(&viewProjection[0][0], streams, 0, models.size());
+    }
+
+
+
+    void multiply_matrices(const MatrixSoA &lefts, const MatrixSoA &rights, MatrixSoA *products) {
+        if (lefts.size() != rights.size()) {
+            throw std::runtime_error("Tried to multiply batches of matrices of different sizes.");
+        }
+
+        size_t count = lefts.size();
+        products->resize(count);
+
+        PairStreams streams;
+        for (size_t e = 0; e != 16; ++e) {
+            streams.left[e] = lefts.elements[e].data();
+            streams.right[e] = rights.elements[e].data();
+            streams.out[e] = products->elements[e].data();
+        }
+
+        size_t i(0);
+
+#if defined(FHOPE_MVP_BATCH_AVX2)
+        // Arrays are aligned, and i stays a multiple of 8 : every access is aligned
+        for (; i + 8 <= count; i += 8) {
+            __m256 left[16];
+            for (size_t e = 0; e != 16; ++e) {
+                left[e] = _mm256_load_ps(streams.left[e] + i);
+            }
+
+            for (size_t column = 0; column != 4; ++column) {
+                __m256 m0 = _mm256_load_ps(streams.right[column * 4] + i);
+                __m256 m1 = _mm256_load_ps(streams.right[column * 4 + 1] + i);
+                __m256 m2 = _mm256_load_ps(streams.right[column * 4 + 2] + i);
+                __m256 m3 = _mm256_load_ps(streams.right[column * 4 + 3] + i);
+
+                for (size_t row = 0; row != 4; ++row) {
+                    __m256 sum = _mm256_mul_ps(left[row], m0);
+                    sum = _mm256_fmadd_ps(left[4 + row], m1, sum);
+                    sum = _mm256_fmadd_ps(left[8 + row], m2, sum);
+                    sum = _mm256_fmadd_ps(left[12 + row], m3, sum);
+                    _mm256_store_ps(streams.out[column * 4 + row] + i, sum);
+                }
+            }
+        }
+#elif defined(FHOPE_MVP_BATCH_SSE)
+        // Arrays are aligned, and i stays a multiple of 4 : every access is aligned
+        for (; i + 4 <= count; i += 4) {
+            __m128 left[16];
+            for (size_t e = 0; e != 16; ++e) {
+                left[e] = _mm_load_ps(streams.left[e] + i);
+            }
+
+            for (size_t column = 0; column != 4; ++column) {
+                __m128 m0 = _mm_load_ps(streams.right[column * 4] + i);
+                __m128 m1 = _mm_load_ps(streams.right[column * 4 + 1] + i);
+                __m128 m2 = _mm_load_ps(streams.right[column * 4 + 2] + i);
+                __m128 m3 = _mm_load_ps(streams.right[column * 4 + 3] + i);
+
+                for (size_t row = 0; row != 4; ++row) {
+                    __m128 sum = _mm_add_ps(_mm_mul_ps(left[row], m0), _mm_mul_ps(left[4 + row], m1));
+                    sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(left[8 + row], m2), _mm_mul_ps(left[12 + row], m3)));
+                    _mm_store_ps(streams.out[column * 4 + row] + i, sum);
+                }
+            }
+        }
+#endif
+
+        multiply_pairs_scalar(streams, i, count);
+    }
+}
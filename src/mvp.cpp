@@ -1,20 +1,37 @@
 #include "mvp.hpp"
 
 namespace fhope {
-    MVP::MVP() : model(1.0f), view(1.0f), projection(1.0f), dirty(false) {
-        this->outMVP = projection * view * model;
+    MVP::MVP() : model(1.0f), view(1.0f), projection(1.0f), dirty(false), viewProjectionDirty(false), version(0) {
+        this->outViewProjection = projection * view;
+        this->outMVP = this->outViewProjection * model;
     }
 
 
 
     MVP::MVP(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection) :
-            model(model), view(view), projection(projection), dirty(false) {
-        this->outMVP = projection * view * model;
+            model(model), view(view), projection(projection), dirty(false), viewProjectionDirty(false), version(0) {
+        this->outViewProjection = projection * view;
+        this->outMVP = this->outViewProjection * model;
     }
 
 
     
-    MVP::MVP(const MVP &o) : model(o.model), view(o.view), projection(o.projection), dirty(o.dirty), outMVP(o.outMVP) {}
+    MVP::MVP(const MVP &o) : model(o.model), view(o.view), projection(o.projection), outViewProjection(o.outViewProjection), outMVP(o.outMVP), dirty(o.dirty), viewProjectionDirty(o.viewProjectionDirty), version(o.version) {}
+
+
+
+    MVP &MVP::operator=(const MVP &o) {
+        this->model = o.model;
+        this->view = o.view;
+        this->projection = o.projection;
+        this->outViewProjection = o.outViewProjection;
+        this->outMVP = o.outMVP;
+        this->dirty = o.dirty;
+        this->viewProjectionDirty = o.viewProjectionDirty;
+        this->version = o.version;
+
+        return *this;
+    }
 
 
 
@@ -37,22 +54,39 @@ namespace fhope {
 
 
     void MVP::set_model(const glm::mat4 &newModel) {
+        if (newModel == this->model) {
+            return;
+        }
+
         this->model = newModel;
         this->dirty = true;
+        ++this->version;
     }
 
 
 
     void MVP::set_view(const glm::mat4 &newView) {
+        if (newView == this->view) {
+            return;
+        }
+
         this->view = newView;
         this->dirty = true;
+        this->viewProjectionDirty = true;
+        ++this->version;
     }
 
 
 
     void MVP::set_projection(const glm::mat4 &newProjection) {
+        if (newProjection == this->projection) {
+            return;
+        }
+
         this->projection = newProjection;
         this->dirty = true;
+        this->viewProjectionDirty = true;
+        ++this->version;
     }
 
 
@@ -63,9 +97,27 @@ namespace fhope {
 
 
 
+    uint64_t MVP::get_version() const {
+        return this->version;
+    }
+
+
+
+    glm::mat4 MVP::get_view_projection() {
+        if (this->viewProjectionDirty) {
+            this->outViewProjection = this->projection * this->view;
+            this->viewProjectionDirty = false;
+        }
+
+        return this->outViewProjection;
+    }
+
+
+
     glm::mat4 MVP::get_mvp() {
         if (this->dirty) {
-            this->outMVP = this->projection * this->view * this->model;
+            // A moving model over a still camera only costs a single product
+            this->outMVP = this->get_view_projection() * this->model;
             this->dirty = false;
         }
 
@@ -75,8 +127,10 @@ namespace fhope {
 
 
     glm::mat4 MVP::recompute_mvp() {
-        this->outMVP = this->projection * this->view * this->model;
+        this->outViewProjection = this->projection * this->view;
+        this->outMVP = this->outViewProjection * this->model;
         this->dirty = false;
+        this->viewProjectionDirty = false;
 
         return this->outMVP;
     }
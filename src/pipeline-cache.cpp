@@ -0,0 +1,218 @@
+#include "pipeline-cache.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace fhope {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    static constexpr size_t PIPELINE_CACHE_HEADER_SIZE = 16 + VK_UUID_SIZE; ///< Size of a version one header : size, version, vendor ID, device ID and cache UUID
+
+    /*************
+     ** HELPERS **
+     *************/
+
+    static uint32_t read_header_word(const std::vector<char> &data, size_t offset) {
+        uint32_t word;
+        std::memcpy(&word, data.data() + offset, sizeof(word));
+
+        return word;
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    PipelineCache::PipelineCache(const InstanceSetup &setup, std::filesystem::path filename) : cache(VK_NULL_HANDLE), filename(std::move(filename)), savedSize(0), lastSave(std::chrono::steady_clock::now()), saving(false) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.physicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a pipeline cache without providing a physical device in the setup.");
+        }
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to create a pipeline cache without providing a logical device in the setup.");
+        }
+
+        this->device = setup.logicalDevice.value();
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(setup.physicalDevice.value(), &properties);
+
+        std::vector<char> data;
+        std::ifstream cacheFile(this->filename, std::ifstream::binary);
+
+        if (cacheFile.is_open()) {
+            data.assign((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+        }
+
+        // Foreign or corrupted data starts an empty cache, overwritten on next save
+        if (!is_compatible(data, properties)) {
+            data.clear();
+        }
+
+        VkPipelineCacheCreateInfo cacheCreateInfo{};
+        cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheCreateInfo.initialDataSize = data.size();
+        cacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache(this->device, &cacheCreateInfo, nullptr, &this->cache) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create pipeline cache.");
+        }
+
+        this->savedSize = data.size();
+    }
+
+
+
+    void PipelineCache::destroy() {
+        FHOPE_TRACE_FUNCTION();
+
+        if (this->cache == VK_NULL_HANDLE) {
+            return;
+        }
+
+        this->save();
+
+        vkDestroyPipelineCache(this->device, this->cache, nullptr);
+        this->cache = VK_NULL_HANDLE;
+    }
+
+
+
+    size_t PipelineCache::save() const {
+        FHOPE_TRACE_FUNCTION();
+
+        size_t size(0);
+
+        if (vkGetPipelineCacheData(this->device, this->cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+            return 0;
+        }
+
+        std::vector<char> data(size);
+
+        // The cache may grow between both calls : VK_INCOMPLETE still writes a valid (partial) cache
+        VkResult status = vkGetPipelineCacheData(this->device, this->cache, &size, data.data());
+
+        if (status != VK_SUCCESS && status != VK_INCOMPLETE) {
+            return 0;
+        }
+
+        data.resize(size);
+
+        std::error_code error;
+        std::filesystem::create_directories(this->filename.parent_path(), error);
+
+        // Written aside then renamed : a crash while saving never leaves a truncated cache
+        std::filesystem::path temporaryPath = this->filename;
+        temporaryPath += ".tmp";
+
+        {
+            std::ofstream temporaryFile(temporaryPath, std::ofstream::binary | std::ofstream::trunc);
+
+            if (!temporaryFile.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+                temporaryFile.close();
+                std::filesystem::remove(temporaryPath, error);
+
+                return 0;
+            }
+        }
+
+        std::filesystem::rename(temporaryPath, this->filename, error);
+
+        if (error) {
+            std::filesystem::remove(temporaryPath, error);
+
+            return 0;
+        }
+
+        return data.size();
+    }
+
+
+
+    void PipelineCache::update(InstanceSetup *setup) {
+        if (this->saving) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        if (now - this->lastSave < PIPELINE_CACHE_SAVE_INTERVAL) {
+            return;
+        }
+
+        this->lastSave = now;
+
+        size_t size(0);
+
+        // Only the size is queried here : copying and writing the data is left to a worker
+        if (vkGetPipelineCacheData(this->device, this->cache, &size, nullptr) != VK_SUCCESS || size == this->savedSize) {
+            return;
+        }
+
+        this->saving = true;
+
+        setup->async->spawn(this->save_async(setup));
+    }
+
+
+
+    VkPipelineCache PipelineCache::get() const {
+        return this->cache;
+    }
+
+
+
+    Task<void> PipelineCache::save_async(InstanceSetup *setup) {
+        AsyncScheduler &async = *setup->async;
+
+        // Worker : the driver's cache is internally synchronized, pipelines may keep being created meanwhile
+        co_await async.schedule();
+
+        size_t saved = this->save();
+
+        // Render thread : the save's bookkeeping is only touched there
+        co_await async.next_frame();
+
+        if (saved != 0) {
+            this->savedSize = saved;
+        }
+
+        this->saving = false;
+    }
+
+
+
+    bool PipelineCache::is_compatible(const std::vector<char> &data, const VkPhysicalDeviceProperties &properties) {
+        if (data.size() < PIPELINE_CACHE_HEADER_SIZE) {
+            return false;
+        }
+
+        uint32_t headerSize    = read_header_word(data, 0);
+        uint32_t headerVersion = read_header_word(data, 4);
+        uint32_t vendorID      = read_header_word(data, 8);
+        uint32_t deviceID      = read_header_word(data, 12);
+
+        if (headerSize < PIPELINE_CACHE_HEADER_SIZE || headerSize > data.size()) {
+            return false;
+        }
+
+        if (headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+            return false;
+        }
+
+        if (vendorID != properties.vendorID || deviceID != properties.deviceID) {
+            return false;
+        }
+
+        // The UUID changes with driver versions : their caches are not compatible with each other
+        return std::memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+}
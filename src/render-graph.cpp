@@ -0,0 +1,961 @@
+#include "render-graph.hpp"
+#include "setup.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fhope {
+    /*************
+     ** HELPERS **
+     *************/
+
+    /**
+     * @brief Everything an access implies for the accessed image
+     */
+    struct GraphAccessInfo {
+        VkImageLayout     layout;      ///< Layout the image must be in
+        StageAccess       stageAccess; ///< Stages and accesses touching the image
+        bool              write;       ///< Wether the access writes the image
+        bool              attachment;  ///< Wether the access binds the image as a render pass attachment
+        VkImageUsageFlags usage;       ///< Usage the image must be created with
+    };
+
+
+
+    static GraphAccessInfo get_access_info(GraphAccess access) {
+        switch (access) {
+            case GraphAccess::ColorAttachment:
+                return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR }, true, true, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+
+            case GraphAccess::DepthStencilAttachment:
+                return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR }, true, true, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+
+            case GraphAccess::DepthStencilRead:
+                return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR }, false, true, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+
+            case GraphAccess::ResolveAttachment:
+                return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR }, true, true, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+
+            case GraphAccess::FragmentSampled:
+                return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR }, false, false, VK_IMAGE_USAGE_SAMPLED_BIT };
+
+            case GraphAccess::ComputeSampled:
+                return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR }, false, false, VK_IMAGE_USAGE_SAMPLED_BIT };
+
+            case GraphAccess::ComputeStorageRead:
+                return { VK_IMAGE_LAYOUT_GENERAL, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR }, false, false, VK_IMAGE_USAGE_STORAGE_BIT };
+
+            case GraphAccess::ComputeStorageWrite:
+                return { VK_IMAGE_LAYOUT_GENERAL, { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR }, true, false, VK_IMAGE_USAGE_STORAGE_BIT };
+
+            case GraphAccess::TransferSource:
+                return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR }, false, false, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+
+            case GraphAccess::TransferDestination:
+                return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR }, true, false, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+        }
+
+        throw std::runtime_error("Unknown render graph access.");
+    }
+
+
+
+    static VkImageSubresourceRange get_whole_range(const GraphImageDesc &desc) {
+        return { get_format_aspect(desc.format), 0, desc.mipLevels, 0, 1 };
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+        /*----------------------------*
+         *- METHODS: GraphPassBuilder -*
+         *----------------------------*/
+
+    GraphPassBuilder::GraphPassBuilder(RenderGraph *graph, GraphPassId pass) : graph(graph), pass(pass) {}
+
+
+
+    GraphPassBuilder &GraphPassBuilder::read(GraphResource resource, GraphAccess access) {
+        if (get_access_info(access).write) {
+            throw std::runtime_error("Tried to declare a writing access as a render graph read.");
+        }
+
+        this->graph->passes[this->pass].uses.push_back({ resource, access, std::nullopt });
+        this->graph->compiled = false;
+
+        return *this;
+    }
+
+
+
+    GraphPassBuilder &GraphPassBuilder::write(GraphResource resource, GraphAccess access, std::optional<VkClearValue> clear) {
+        if (!get_access_info(access).write) {
+            throw std::runtime_error("Tried to declare a reading access as a render graph write.");
+        }
+
+        this->graph->passes[this->pass].uses.push_back({ resource, access, clear });
+        this->graph->compiled = false;
+
+        return *this;
+    }
+
+
+
+    GraphPassBuilder &GraphPassBuilder::side_effect() {
+        this->graph->passes[this->pass].sideEffect = true;
+        this->graph->compiled = false;
+
+        return *this;
+    }
+
+
+
+    GraphPassBuilder &GraphPassBuilder::secondary_contents() {
+        this->graph->passes[this->pass].contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+
+        return *this;
+    }
+
+
+
+    GraphPassId GraphPassBuilder::id() const {
+        return this->pass;
+    }
+
+        /*-----------------------*
+         *- METHODS: RenderGraph -*
+         *-----------------------*/
+
+    GraphResource RenderGraph::create_image(const std::string &name, const GraphImageDesc &desc) {
+        GraphImage newImage{};
+        newImage.name = name;
+        newImage.desc = desc;
+        newImage.imported = false;
+
+        this->images.push_back(newImage);
+        this->compiled = false;
+
+        return static_cast<GraphResource>(this->images.size() - 1);
+    }
+
+
+
+    GraphResource RenderGraph::import_image(const std::string &name, const GraphImageDesc &desc, VkImageLayout initialLayout, VkImageLayout finalLayout, std::optional<StageAccess> finalAccess) {
+        GraphImage newImage{};
+        newImage.name = name;
+        newImage.desc = desc;
+        newImage.imported = true;
+        newImage.initialLayout = initialLayout;
+        newImage.finalLayout = finalLayout;
+
+        if (finalAccess.has_value()) {
+            newImage.finalAccess = finalAccess.value();
+        } else if (finalLayout != VK_IMAGE_LAYOUT_UNDEFINED) {
+            newImage.finalAccess = get_layout_stage_access(finalLayout, false);
+        }
+
+        this->images.push_back(newImage);
+        this->compiled = false;
+
+        return static_cast<GraphResource>(this->images.size() - 1);
+    }
+
+
+
+    void RenderGraph::set_imported_image(GraphResource resource, VkImage image, VkImageView view) {
+        this->set_imported_images(resource, { image }, { view });
+    }
+
+
+
+    void RenderGraph::set_imported_images(GraphResource resource, const std::vector<VkImage> &images, const std::vector<VkImageView> &views) {
+        GraphImage &image = this->images[resource];
+
+        if (!image.imported) {
+            throw std::runtime_error("Tried to bind an external image to the transient render graph resource `" + image.name + "`.");
+        }
+
+        if (images.empty() || images.size() != views.size()) {
+            throw std::runtime_error("Tried to bind external images to the render graph resource `" + image.name + "` without providing exactly one view per image.");
+        }
+
+        // New views may reuse the handles of destroyed ones : framebuffers are rebuilt rather than looked up by view
+        this->destroy_framebuffers(resource);
+
+        image.importedImages = images;
+        image.importedViews  = views;
+
+        this->select_imported_image(resource, 0);
+    }
+
+
+
+    void RenderGraph::select_imported_image(GraphResource resource, uint32_t index) {
+        GraphImage &image = this->images[resource];
+
+        if (index >= image.importedImages.size()) {
+            throw std::runtime_error("Tried to select image " + std::to_string(index) + " of the render graph resource `" + image.name + "`, which only has " + std::to_string(image.importedImages.size()) + " bound.");
+        }
+
+        image.importedIndex = index;
+        image.image = image.importedImages[index];
+        image.view  = image.importedViews[index];
+    }
+
+
+
+    GraphPassBuilder RenderGraph::add_pass(const std::string &name, std::function<void(VkCommandBuffer, const RenderGraph &)> record) {
+        GraphPass newPass{};
+        newPass.name = name;
+        newPass.raster = false;
+        newPass.sideEffect = false;
+        newPass.record = std::move(record);
+
+        this->passes.push_back(std::move(newPass));
+        this->compiled = false;
+
+        return GraphPassBuilder(this, static_cast<GraphPassId>(this->passes.size() - 1));
+    }
+
+
+
+    GraphPassBuilder RenderGraph::add_raster_pass(const std::string &name, std::function<void(VkCommandBuffer, const RenderGraph &)> record) {
+        GraphPassBuilder builder = this->add_pass(name, std::move(record));
+        this->passes[builder.id()].raster = true;
+
+        return builder;
+    }
+
+
+
+    void RenderGraph::set_record(GraphPassId pass, std::function<void(VkCommandBuffer, const RenderGraph &)> record) {
+        this->passes[pass].record = std::move(record);
+    }
+
+
+
+    void RenderGraph::compile(const InstanceSetup &setup) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to compile a render graph without providing a logical device in the setup.");
+        }
+
+        if (!setup.physicalDevice.has_value()) {
+            throw std::runtime_error("Tried to compile a render graph without providing a physical device in the setup.");
+        }
+
+        this->destroy(setup);
+
+        this->device = setup.logicalDevice.value();
+        this->synchronization2 = setup.synchronization2;
+
+        this->cull_passes();
+        this->compute_levels();
+        this->allocate_transient_images(setup);
+        this->compute_barriers();
+        this->create_render_passes(setup);
+
+        this->compiled = true;
+    }
+
+
+
+    void RenderGraph::cull_passes() {
+        // Reference counting : passes count the resources they write, resources count the passes reading them.
+        // Unread transient resources release their producers, which release what they read, and so on.
+        std::vector<uint32_t> passReferences(this->passes.size(), 0);
+        std::vector<uint32_t> imageReferences(this->images.size(), 0);
+        std::vector<std::vector<GraphPassId>> producers(this->images.size());
+
+        for (GraphPassId p = 0; p != this->passes.size(); ++p) {
+            this->passes[p].culled = false;
+
+            for (const GraphResourceUse &use : this->passes[p].uses) {
+                if (get_access_info(use.access).write) {
+                    ++passReferences[p];
+                    producers[use.resource].push_back(p);
+                } else {
+                    ++imageReferences[use.resource];
+                }
+            }
+        }
+
+        std::vector<GraphResource> unreferenced;
+
+        auto cull = [&](GraphPassId p) {
+            this->passes[p].culled = true;
+
+            for (const GraphResourceUse &use : this->passes[p].uses) {
+                if (!get_access_info(use.access).write && --imageReferences[use.resource] == 0 && !this->images[use.resource].imported) {
+                    unreferenced.push_back(use.resource);
+                }
+            }
+        };
+
+        for (GraphPassId p = 0; p != this->passes.size(); ++p) {
+            if (passReferences[p] == 0 && !this->passes[p].sideEffect) {
+                cull(p);
+            }
+        }
+
+        for (GraphResource r = 0; r != this->images.size(); ++r) {
+            if (imageReferences[r] == 0 && !this->images[r].imported) {
+                unreferenced.push_back(r);
+            }
+        }
+
+        while (!unreferenced.empty()) {
+            GraphResource resource = unreferenced.back();
+            unreferenced.pop_back();
+
+            for (GraphPassId producer : producers[resource]) {
+                if (!this->passes[producer].culled && --passReferences[producer] == 0 && !this->passes[producer].sideEffect) {
+                    cull(producer);
+                }
+            }
+        }
+    }
+
+
+
+    void RenderGraph::compute_levels() {
+        // A pass depends on the last writer of what it accesses, and writers depend on readers (write after read).
+        // Reads switching to another layout also depend on previous reads. Passes are then grouped by dependency
+        // level, so that every barrier a level needs is recorded in a single batch.
+        struct ResourceTrack {
+            std::optional<GraphPassId> lastWriter;
+            std::vector<GraphPassId>   readers;
+            VkImageLayout              readLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        };
+
+        std::vector<ResourceTrack> tracks(this->images.size());
+
+        for (GraphImage &image : this->images) {
+            image.usage = 0;
+            image.firstLevel = UINT32_MAX;
+            image.lastLevel = 0;
+        }
+
+        this->levels.clear();
+
+        for (GraphPassId p = 0; p != this->passes.size(); ++p) {
+            GraphPass &pass = this->passes[p];
+
+            if (pass.culled) {
+                continue;
+            }
+
+            uint32_t level(0);
+            auto depend_on = [&](GraphPassId dependency) {
+                if (dependency != p) {
+                    level = std::max(level, this->passes[dependency].level + 1);
+                }
+            };
+
+            for (const GraphResourceUse &use : pass.uses) {
+                const ResourceTrack &track = tracks[use.resource];
+                GraphAccessInfo info = get_access_info(use.access);
+
+                if (track.lastWriter.has_value()) {
+                    depend_on(track.lastWriter.value());
+                }
+
+                if (info.write || track.readLayout != info.layout) {
+                    for (GraphPassId reader : track.readers) {
+                        depend_on(reader);
+                    }
+                }
+            }
+
+            pass.level = level;
+
+            for (const GraphResourceUse &use : pass.uses) {
+                ResourceTrack &track = tracks[use.resource];
+                GraphAccessInfo info = get_access_info(use.access);
+
+                if (info.write) {
+                    track.lastWriter = p;
+                    track.readers.clear();
+                } else {
+                    if (track.readLayout != info.layout) {
+                        track.readers.clear();
+                    }
+
+                    track.readers.push_back(p);
+                    track.readLayout = info.layout;
+                }
+
+                GraphImage &image = this->images[use.resource];
+                image.usage |= info.usage;
+                image.firstLevel = std::min(image.firstLevel, level);
+                image.lastLevel  = std::max(image.lastLevel,  level);
+            }
+
+            if (this->levels.size() <= level) {
+                this->levels.resize(level + 1);
+            }
+
+            this->levels[level].push_back(p);
+        }
+    }
+
+
+
+    void RenderGraph::allocate_transient_images(const InstanceSetup &setup) {
+        const VkDevice &device = setup.logicalDevice.value();
+
+        std::vector<std::pair<GraphResource, VkMemoryRequirements>> transients;
+
+        for (GraphResource r = 0; r != this->images.size(); ++r) {
+            GraphImage &image = this->images[r];
+            image.memoryBlock.reset();
+
+            if (image.imported || image.firstLevel == UINT32_MAX) {
+                continue;
+            }
+
+            VkImageCreateInfo imageCreateInfo{};
+            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageCreateInfo.extent = { image.desc.extent.width, image.desc.extent.height, 1 };
+            imageCreateInfo.mipLevels = image.desc.mipLevels;
+            imageCreateInfo.arrayLayers = 1;
+            imageCreateInfo.format = image.desc.format;
+            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageCreateInfo.usage = image.usage;
+            imageCreateInfo.samples = image.desc.samples;
+            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateImage(device, &imageCreateInfo, nullptr, &image.image) != VK_SUCCESS) {
+                throw std::runtime_error("Could not create transient render graph image `" + image.name + "`.");
+            }
+
+            VkMemoryRequirements memoryRequirements;
+            vkGetImageMemoryRequirements(device, image.image, &memoryRequirements);
+
+            transients.emplace_back(r, memoryRequirements);
+        }
+
+        // Greedy aliasing : biggest images first, each one joins the first block whose occupants' lifetimes don't overlap it's own
+        std::sort(transients.begin(), transients.end(), [](const auto &a, const auto &b) { return a.second.size > b.second.size; });
+
+        this->memoryBlocks.clear();
+
+        for (const auto &[resource, requirements] : transients) {
+            GraphImage &image = this->images[resource];
+
+            std::optional<uint32_t> chosenBlock;
+            for (uint32_t b = 0; b != this->memoryBlocks.size() && !chosenBlock.has_value(); ++b) {
+                const GraphMemoryBlock &block = this->memoryBlocks[b];
+
+                if ((block.memoryTypeBits & requirements.memoryTypeBits) == 0) {
+                    continue;
+                }
+
+                bool overlaps = std::any_of(block.occupants.begin(), block.occupants.end(), [&](GraphResource occupant) {
+                    const GraphImage &other = this->images[occupant];
+                    return image.firstLevel <= other.lastLevel && other.firstLevel <= image.lastLevel;
+                });
+
+                if (!overlaps) {
+                    chosenBlock = b;
+                }
+            }
+
+            if (!chosenBlock.has_value()) {
+                this->memoryBlocks.emplace_back();
+                chosenBlock = static_cast<uint32_t>(this->memoryBlocks.size() - 1);
+            }
+
+            GraphMemoryBlock &block = this->memoryBlocks[chosenBlock.value()];
+            block.size = std::max(block.size, requirements.size);
+            block.memoryTypeBits &= requirements.memoryTypeBits;
+            block.occupants.push_back(resource);
+
+            image.memoryBlock = chosenBlock;
+        }
+
+        for (GraphMemoryBlock &block : this->memoryBlocks) {
+            std::sort(block.occupants.begin(), block.occupants.end(), [&](GraphResource a, GraphResource b) { return this->images[a].firstLevel < this->images[b].firstLevel; });
+
+            VkMemoryAllocateInfo memoryAllocateInfo{};
+            memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            memoryAllocateInfo.allocationSize = block.size;
+            memoryAllocateInfo.memoryTypeIndex = find_memory_type(setup.physicalDevice.value(), block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &block.memory) != VK_SUCCESS) {
+                throw std::runtime_error("Couldn't allocate render graph transient memory.");
+            }
+
+            for (GraphResource occupant : block.occupants) {
+                GraphImage &image = this->images[occupant];
+
+                vkBindImageMemory(device, image.image, block.memory, 0);
+
+                VkImageViewCreateInfo viewCreateInfo{};
+                viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewCreateInfo.image = image.image;
+                viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewCreateInfo.format = image.desc.format;
+                viewCreateInfo.subresourceRange = get_whole_range(image.desc);
+
+                if (vkCreateImageView(device, &viewCreateInfo, nullptr, &image.view) != VK_SUCCESS) {
+                    throw std::runtime_error("Could not create view for transient render graph image `" + image.name + "`.");
+                }
+            }
+        }
+    }
+
+
+
+    void RenderGraph::compute_barriers() {
+        struct ResourceState {
+            VkImageLayout            layout;
+            bool                     used = false;
+            bool                     hasWrite = false;
+            StageAccess              lastWrite { VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR };
+            VkPipelineStageFlags2KHR readStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+            VkPipelineStageFlags2KHR visibleStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+        };
+
+        std::vector<ResourceState> states(this->images.size());
+        for (GraphResource r = 0; r != this->images.size(); ++r) {
+            states[r].layout = this->images[r].imported ? this->images[r].initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+
+        auto final_scope = [](const ResourceState &state) -> StageAccess {
+            return { state.lastWrite.stages | state.readStages, state.hasWrite ? state.lastWrite.access : VK_ACCESS_2_NONE_KHR };
+        };
+
+        this->levelBarriers.assign(this->levels.size(), {});
+
+        // Level and index of the barrier preceding each image's first use
+        std::vector<std::optional<std::pair<uint32_t, size_t>>> firstBarriers(this->images.size());
+
+        for (uint32_t level = 0; level != this->levels.size(); ++level) {
+            std::vector<GraphBarrier> &barriers = this->levelBarriers[level];
+            std::map<GraphResource, size_t> levelBarrierIndices;
+
+            for (GraphPassId p : this->levels[level]) {
+                for (const GraphResourceUse &use : this->passes[p].uses) {
+                    ResourceState &state = states[use.resource];
+                    const GraphImage &image = this->images[use.resource];
+                    GraphAccessInfo info = get_access_info(use.access);
+
+                    // Same-level accesses never conflict (see compute_levels) : they share the level's barrier
+                    auto existing = levelBarrierIndices.find(use.resource);
+                    if (existing != levelBarrierIndices.end()) {
+                        barriers[existing->second].destination.stages |= info.stageAccess.stages;
+                        barriers[existing->second].destination.access |= info.stageAccess.access;
+                        state.visibleStages |= info.stageAccess.stages;
+                        continue;
+                    }
+
+                    bool layoutChange   = state.layout != info.layout;
+                    bool needVisibility = state.hasWrite && (info.write || (state.visibleStages & info.stageAccess.stages) != info.stageAccess.stages);
+                    bool writeAfterRead = info.write && state.readStages != VK_PIPELINE_STAGE_2_NONE_KHR;
+
+                    if (layoutChange || needVisibility || writeAfterRead) {
+                        StageAccess source = final_scope(state);
+
+                        if (!state.used) {
+                            if (image.imported) {
+                                // Chain with whatever external wait (e.g. swap chain acquisition) guards the first access
+                                source.stages |= info.stageAccess.stages;
+                            } else if (image.memoryBlock.has_value()) {
+                                // Aliased memory : wait for the previous occupant to be done with it
+                                const std::vector<GraphResource> &occupants = this->memoryBlocks[image.memoryBlock.value()].occupants;
+                                auto self = std::find(occupants.begin(), occupants.end(), use.resource);
+
+                                if (self != occupants.begin()) {
+                                    StageAccess previous = final_scope(states[*(self - 1)]);
+                                    source.stages |= previous.stages;
+                                    source.access |= previous.access;
+                                }
+                            }
+                        }
+
+                        if (!state.used) {
+                            firstBarriers[use.resource] = std::make_pair(level, barriers.size());
+                        }
+
+                        levelBarrierIndices[use.resource] = barriers.size();
+                        barriers.push_back({ use.resource, state.layout, info.layout, source, info.stageAccess });
+
+                        state.visibleStages = info.stageAccess.stages;
+                    }
+
+                    state.used = true;
+                    state.layout = info.layout;
+
+                    if (info.write) {
+                        state.hasWrite = true;
+                        state.lastWrite = info.stageAccess;
+                        state.readStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+                    } else {
+                        state.readStages |= info.stageAccess.stages;
+                    }
+                }
+            }
+        }
+
+        // Executions in flight share transient memory : the block's first occupant waits for it's last occupant, as left by the previous execution
+        for (const GraphMemoryBlock &block : this->memoryBlocks) {
+            const std::optional<std::pair<uint32_t, size_t>> &first = firstBarriers[block.occupants.front()];
+
+            if (!first.has_value()) {
+                continue;
+            }
+
+            StageAccess previous = final_scope(states[block.occupants.back()]);
+            GraphBarrier &barrier = this->levelBarriers[first.value().first][first.value().second];
+
+            barrier.source.stages |= previous.stages;
+            barrier.source.access |= previous.access;
+        }
+
+        this->finalBarriers.clear();
+
+        for (GraphResource r = 0; r != this->images.size(); ++r) {
+            const GraphImage &image = this->images[r];
+
+            if (image.imported && states[r].used && image.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED && image.finalLayout != states[r].layout) {
+                this->finalBarriers.push_back({ r, states[r].layout, image.finalLayout, final_scope(states[r]), image.finalAccess });
+            }
+        }
+    }
+
+
+
+    void RenderGraph::create_render_passes(const InstanceSetup &setup) {
+        for (GraphPass &pass : this->passes) {
+            if (pass.culled || !pass.raster) {
+                continue;
+            }
+
+            std::vector<VkAttachmentDescription> attachments;
+            std::vector<VkAttachmentReference>   colorReferences;
+            std::vector<VkAttachmentReference>   resolveReferences;
+            std::optional<VkAttachmentReference> depthReference;
+
+            pass.clearValues.clear();
+            pass.extent = {};
+
+            for (const GraphResourceUse &use : pass.uses) {
+                GraphAccessInfo info = get_access_info(use.access);
+
+                if (!info.attachment) {
+                    continue;
+                }
+
+                const GraphImage &image = this->images[use.resource];
+
+                if (attachments.empty()) {
+                    pass.extent = image.desc.extent;
+                } else if (image.desc.extent.width != pass.extent.width || image.desc.extent.height != pass.extent.height) {
+                    throw std::runtime_error("Render graph pass `" + pass.name + "` has attachments of different extents.");
+                }
+
+                // Content exists if an earlier level wrote it, or if it comes from outside the graph
+                bool hasContent = image.imported && image.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+                bool usedLater  = image.imported;
+
+                for (const GraphPass &other : this->passes) {
+                    if (other.culled || &other == &pass) {
+                        continue;
+                    }
+
+                    for (const GraphResourceUse &otherUse : other.uses) {
+                        if (otherUse.resource != use.resource) {
+                            continue;
+                        }
+
+                        hasContent = hasContent || (other.level < pass.level && get_access_info(otherUse.access).write);
+                        usedLater  = usedLater  || other.level > pass.level;
+                    }
+                }
+
+                VkAttachmentLoadOp  loadOp  = use.clear.has_value() ? VK_ATTACHMENT_LOAD_OP_CLEAR : (hasContent && use.access != GraphAccess::ResolveAttachment ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+                VkAttachmentStoreOp storeOp = usedLater ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                bool hasStencil = get_format_aspect(image.desc.format) & VK_IMAGE_ASPECT_STENCIL_BIT;
+
+                VkAttachmentDescription attachment{};
+                attachment.format  = image.desc.format;
+                attachment.samples = image.desc.samples;
+                attachment.loadOp  = loadOp;
+                attachment.storeOp = storeOp;
+                attachment.stencilLoadOp  = hasStencil ? loadOp  : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachment.stencilStoreOp = hasStencil ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                // The graph transitions attachments itself : render passes never change layouts
+                attachment.initialLayout = info.layout;
+                attachment.finalLayout   = info.layout;
+
+                VkAttachmentReference reference{};
+                reference.attachment = static_cast<uint32_t>(attachments.size());
+                reference.layout = info.layout;
+
+                switch (use.access) {
+                    case GraphAccess::ColorAttachment:        colorReferences.push_back(reference);   break;
+                    case GraphAccess::ResolveAttachment:      resolveReferences.push_back(reference); break;
+                    default:                                  depthReference = reference;             break;
+                }
+
+                attachments.push_back(attachment);
+                pass.clearValues.push_back(use.clear.value_or(VkClearValue{}));
+            }
+
+            if (!resolveReferences.empty() && resolveReferences.size() != colorReferences.size()) {
+                throw std::runtime_error("Render graph pass `" + pass.name + "` must resolve every color attachment or none.");
+            }
+
+            VkSubpassDescription subpassDescription{};
+            subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpassDescription.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+            subpassDescription.pColorAttachments = colorReferences.data();
+            subpassDescription.pResolveAttachments = resolveReferences.empty() ? nullptr : resolveReferences.data();
+            subpassDescription.pDepthStencilAttachment = depthReference.has_value() ? &depthReference.value() : nullptr;
+
+            VkRenderPassCreateInfo renderPassCreateInfo{};
+            renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            renderPassCreateInfo.pAttachments = attachments.data();
+            renderPassCreateInfo.subpassCount = 1;
+            renderPassCreateInfo.pSubpasses = &subpassDescription;
+
+            if (vkCreateRenderPass(setup.logicalDevice.value(), &renderPassCreateInfo, nullptr, &pass.renderPass) != VK_SUCCESS) {
+                throw std::runtime_error("Couldn't create render pass for render graph pass `" + pass.name + "`.");
+            }
+        }
+    }
+
+
+
+    void RenderGraph::destroy_framebuffers(GraphResource resource) {
+        for (GraphPass &pass : this->passes) {
+            bool attached = std::any_of(pass.uses.begin(), pass.uses.end(), [&](const GraphResourceUse &use) {
+                return use.resource == resource && get_access_info(use.access).attachment;
+            });
+
+            if (!attached) {
+                continue;
+            }
+
+            for (const auto &[key, framebuffer] : pass.framebuffers) {
+                vkDestroyFramebuffer(this->device, framebuffer, nullptr);
+            }
+            pass.framebuffers.clear();
+        }
+    }
+
+
+
+    VkFramebuffer RenderGraph::get_framebuffer(GraphPass &pass) {
+        std::vector<uint32_t>    key;
+        std::vector<VkImageView> views;
+
+        for (const GraphResourceUse &use : pass.uses) {
+            if (get_access_info(use.access).attachment) {
+                key.push_back(this->images[use.resource].importedIndex);
+                views.push_back(this->images[use.resource].view);
+            }
+        }
+
+        auto cached = pass.framebuffers.find(key);
+        if (cached != pass.framebuffers.end()) {
+            return cached->second;
+        }
+
+        VkFramebufferCreateInfo framebufferCreateInfo{};
+        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferCreateInfo.renderPass = pass.renderPass;
+        framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferCreateInfo.pAttachments = views.data();
+        framebufferCreateInfo.width = pass.extent.width;
+        framebufferCreateInfo.height = pass.extent.height;
+        framebufferCreateInfo.layers = 1;
+
+        VkFramebuffer newFramebuffer;
+        if (vkCreateFramebuffer(this->device, &framebufferCreateInfo, nullptr, &newFramebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create framebuffer for render graph pass `" + pass.name + "`.");
+        }
+
+        pass.framebuffers.emplace(std::move(key), newFramebuffer);
+
+        return newFramebuffer;
+    }
+
+
+
+    void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+        if (!this->compiled) {
+            throw std::runtime_error("Tried to execute a render graph that has not been compiled since it's last modification.");
+        }
+
+        BarrierBatch barriers(this->synchronization2);
+
+        auto queue_barriers = [&](const std::vector<GraphBarrier> &graphBarriers) {
+            for (const GraphBarrier &barrier : graphBarriers) {
+                const GraphImage &image = this->images[barrier.resource];
+                barriers.transition_image(image.image, get_whole_range(image.desc), barrier.oldLayout, barrier.newLayout, barrier.source, barrier.destination);
+            }
+
+            barriers.flush(commandBuffer);
+        };
+
+        for (uint32_t level = 0; level != this->levels.size(); ++level) {
+            queue_barriers(this->levelBarriers[level]);
+
+            for (GraphPassId p : this->levels[level]) {
+                GraphPass &pass = this->passes[p];
+
+                if (!pass.record) {
+                    throw std::runtime_error("Tried to execute render graph pass `" + pass.name + "` without providing it's record function.");
+                }
+
+                if (!pass.raster) {
+                    pass.record(commandBuffer, *this);
+                    continue;
+                }
+
+                VkRenderPassBeginInfo renderPassBeginInfo{};
+                renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                renderPassBeginInfo.renderPass = pass.renderPass;
+                renderPassBeginInfo.framebuffer = this->get_framebuffer(pass);
+                renderPassBeginInfo.renderArea.offset = { 0, 0 };
+                renderPassBeginInfo.renderArea.extent = pass.extent;
+                renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+                renderPassBeginInfo.pClearValues = pass.clearValues.data();
+
+                vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, pass.contents);
+                pass.record(commandBuffer, *this);
+                vkCmdEndRenderPass(commandBuffer);
+            }
+        }
+
+        queue_barriers(this->finalBarriers);
+    }
+
+
+
+    void RenderGraph::destroy(const InstanceSetup &setup) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to destroy a render graph without providing a logical device in the setup.");
+        }
+
+        const VkDevice &device = setup.logicalDevice.value();
+
+        for (GraphPass &pass : this->passes) {
+            for (const auto &[views, framebuffer] : pass.framebuffers) {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            pass.framebuffers.clear();
+
+            if (pass.renderPass != VK_NULL_HANDLE) {
+                vkDestroyRenderPass(device, pass.renderPass, nullptr);
+                pass.renderPass = VK_NULL_HANDLE;
+            }
+        }
+
+        for (GraphImage &image : this->images) {
+            if (image.imported) {
+                continue;
+            }
+
+            if (image.view != VK_NULL_HANDLE) {
+                vkDestroyImageView(device, image.view, nullptr);
+                image.view = VK_NULL_HANDLE;
+            }
+
+            if (image.image != VK_NULL_HANDLE) {
+                vkDestroyImage(device, image.image, nullptr);
+                image.image = VK_NULL_HANDLE;
+            }
+        }
+
+        for (const GraphMemoryBlock &block : this->memoryBlocks) {
+            vkFreeMemory(device, block.memory, nullptr);
+        }
+        this->memoryBlocks.clear();
+
+        this->compiled = false;
+    }
+
+
+
+    VkImage RenderGraph::get_image(GraphResource resource) const {
+        return this->images[resource].image;
+    }
+
+
+
+    VkImageView RenderGraph::get_view(GraphResource resource) const {
+        return this->images[resource].view;
+    }
+
+
+
+    VkRenderPass RenderGraph::get_render_pass(GraphPassId pass) const {
+        return this->passes[pass].renderPass;
+    }
+
+
+
+    bool RenderGraph::is_culled(GraphPassId pass) const {
+        return this->passes[pass].culled;
+    }
+
+
+
+    VkDeviceSize RenderGraph::get_transient_memory_size() const {
+        VkDeviceSize total(0);
+
+        for (const GraphMemoryBlock &block : this->memoryBlocks) {
+            total += block.size;
+        }
+
+        return total;
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    GraphPassBuilder add_forward_pass(RenderGraph *graph, const InstanceSetup &setup, GraphResource target, std::optional<GraphResource> depth, std::function<void(VkCommandBuffer, const RenderGraph &)> record) {
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to declare a forward pass without providing a swap chain config in the setup.");
+        }
+
+        if (!setup.maxSamplesFlag.has_value()) {
+            throw std::runtime_error("Tried to declare a forward pass without providing a max sample flag in the setup.");
+        }
+
+        const VkExtent2D &extent = setup.swapChainConfig.value().extent;
+
+        GraphResource color = graph->create_image("forward.color", { setup.swapChainConfig.value().surfaceFormat.format, extent, setup.maxSamplesFlag.value(), 1 });
+
+        if (!depth.has_value()) {
+            std::vector<VkFormat> depthFormats = find_supported_formats(setup, { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT }, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+            if (depthFormats.empty()) {
+                throw std::runtime_error("Could not find any available depth buffer format.");
+            }
+
+            depth = graph->create_image("forward.depth", { depthFormats[0], extent, setup.maxSamplesFlag.value(), 1 });
+        }
+
+        VkClearValue colorClear{};
+        colorClear.color = {{0.8f, 0.0f, 0.8f, 1.0f}};
+
+        VkClearValue depthClear{};
+        depthClear.depthStencil = {1.0f, 0};
+
+        GraphPassBuilder builder = graph->add_raster_pass("forward", std::move(record));
+
+        builder.write(color,         GraphAccess::ColorAttachment,        colorClear)
+               .write(depth.value(), GraphAccess::DepthStencilAttachment, depthClear)
+               .write(target,        GraphAccess::ResolveAttachment);
+
+        return builder;
+    }
+}
@@ -0,0 +1,348 @@
+#include "scene-graph.hpp"
+#include "instance-buffer.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fhope {
+    /*************
+     ** METHODS **
+     *************/
+
+    SceneGraph::SceneGraph() : needsSort(false) {}
+
+
+
+    uint32_t SceneGraph::get_dense(NodeHandle handle) const {
+        if (!this->contains(handle)) {
+            throw std::runtime_error("Tried to access a scene graph node that does not exist.");
+        }
+
+        return this->handleToDense[handle];
+    }
+
+
+
+    NodeHandle SceneGraph::add_node(const glm::mat4 &local, NodeHandle parent) {
+        uint32_t parentDense = INVALID_NODE;
+        uint32_t depth = 0;
+
+        if (parent != INVALID_NODE) {
+            parentDense = this->get_dense(parent);
+            depth = this->depths[parentDense] + 1;
+        }
+
+        NodeHandle handle;
+        if (!this->freeHandles.empty()) {
+            handle = this->freeHandles.back();
+            this->freeHandles.pop_back();
+        } else {
+            handle = static_cast<NodeHandle>(this->handleToDense.size());
+            this->handleToDense.push_back(INVALID_NODE);
+        }
+
+        // Appending keeps parents first, but may put a shallow node after deeper ones
+        if (!this->depths.empty() && this->depths.back() > depth) {
+            this->needsSort = true;
+        }
+
+        this->handleToDense[handle] = static_cast<uint32_t>(this->denseToHandle.size());
+        this->denseToHandle.push_back(handle);
+
+        this->localMatrices.push_back(local);
+        this->worldMatrices.push_back(local);
+        this->parents.push_back(parentDense);
+        this->depths.push_back(depth);
+        this->dirty.push_back(1);
+        this->instances.push_back(INVALID_INSTANCE);
+
+        return handle;
+    }
+
+
+
+    void SceneGraph::remove_node(NodeHandle handle) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (this->needsSort) {
+            this->sort_by_depth();
+        }
+
+        uint32_t removedDense = this->get_dense(handle);
+
+        // Descendants come after their ancestors : one forward pass flags the whole subtree
+        std::vector<uint8_t> keep(this->denseToHandle.size(), 1);
+        keep[removedDense] = 0;
+        for (uint32_t i = removedDense + 1; i != keep.size(); ++i) {
+            if (this->parents[i] != INVALID_NODE && keep[this->parents[i]] == 0) {
+                keep[i] = 0;
+            }
+        }
+
+        for (uint32_t i = 0; i != keep.size(); ++i) {
+            if (keep[i] == 0) {
+                this->handleToDense[this->denseToHandle[i]] = INVALID_NODE;
+                this->freeHandles.push_back(this->denseToHandle[i]);
+            }
+        }
+
+        this->compact(keep);
+
+        std::erase_if(this->changed, [this](NodeHandle changedHandle) { return !this->contains(changedHandle); });
+    }
+
+
+
+    void SceneGraph::set_parent(NodeHandle handle, NodeHandle parent) {
+        uint32_t dense = this->get_dense(handle);
+        uint32_t parentDense = INVALID_NODE;
+
+        if (parent != INVALID_NODE) {
+            parentDense = this->get_dense(parent);
+
+            for (uint32_t ancestor = parentDense; ancestor != INVALID_NODE; ancestor = this->parents[ancestor]) {
+                if (ancestor == dense) {
+                    throw std::runtime_error("Tried to parent a scene graph node to itself or to one of it's descendants.");
+                }
+            }
+        }
+
+        this->parents[dense] = parentDense;
+        this->dirty[dense] = 1;
+
+        // Depths of the subtree are recomputed, and the arrays reordered, before the next update reads them
+        this->needsSort = true;
+    }
+
+
+
+    void SceneGraph::set_local(NodeHandle handle, const glm::mat4 &local) {
+        uint32_t dense = this->get_dense(handle);
+
+        this->localMatrices[dense] = local;
+        this->dirty[dense] = 1;
+    }
+
+
+
+    void SceneGraph::attach_instance(NodeHandle handle, uint32_t instance) {
+        uint32_t dense = this->get_dense(handle);
+
+        this->instances[dense] = instance;
+
+        // Pushes the current world matrix to the newly attached instance on the next sync
+        this->dirty[dense] = 1;
+    }
+
+
+
+    const glm::mat4 &SceneGraph::get_local(NodeHandle handle) const {
+        return this->localMatrices[this->get_dense(handle)];
+    }
+
+
+
+    const glm::mat4 &SceneGraph::get_world(NodeHandle handle) const {
+        return this->worldMatrices[this->get_dense(handle)];
+    }
+
+
+
+    bool SceneGraph::contains(NodeHandle handle) const {
+        return handle < this->handleToDense.size() && this->handleToDense[handle] != INVALID_NODE;
+    }
+
+
+
+    uint32_t SceneGraph::size() const {
+        return static_cast<uint32_t>(this->denseToHandle.size());
+    }
+
+
+
+    void SceneGraph::sort_by_depth() {
+        FHOPE_TRACE_FUNCTION();
+
+        uint32_t count = this->size();
+
+        // Parents may follow their children after a reparenting : depths are resolved through the parent chain
+        std::vector<uint8_t> resolved(count, 0);
+        std::vector<uint32_t> chain;
+        for (uint32_t i = 0; i != count; ++i) {
+            uint32_t node = i;
+            while (resolved[node] == 0 && this->parents[node] != INVALID_NODE) {
+                chain.push_back(node);
+                node = this->parents[node];
+            }
+
+            uint32_t depth = (resolved[node] != 0) ? this->depths[node] : 0;
+            resolved[node] = 1;
+            this->depths[node] = depth;
+
+            while (!chain.empty()) {
+                ++depth;
+                this->depths[chain.back()] = depth;
+                resolved[chain.back()] = 1;
+                chain.pop_back();
+            }
+        }
+
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i != count; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return this->depths[a] < this->depths[b]; });
+
+        std::vector<uint32_t> newPositions(count);
+        for (uint32_t i = 0; i != count; ++i) {
+            newPositions[order[i]] = i;
+        }
+
+        auto permute = [&order](auto &values) {
+            auto permuted = values;
+            for (size_t i = 0; i != order.size(); ++i) {
+                permuted[i] = values[order[i]];
+            }
+            values.swap(permuted);
+        };
+
+        permute(this->localMatrices);
+        permute(this->worldMatrices);
+        permute(this->parents);
+        permute(this->depths);
+        permute(this->dirty);
+        permute(this->instances);
+        permute(this->denseToHandle);
+
+        for (uint32_t i = 0; i != count; ++i) {
+            if (this->parents[i] != INVALID_NODE) {
+                this->parents[i] = newPositions[this->parents[i]];
+            }
+            this->handleToDense[this->denseToHandle[i]] = i;
+        }
+
+        this->needsSort = false;
+    }
+
+
+
+    void SceneGraph::compact(const std::vector<uint8_t> &keep) {
+        std::vector<uint32_t> newPositions(keep.size(), INVALID_NODE);
+        uint32_t kept = 0;
+
+        for (uint32_t i = 0; i != keep.size(); ++i) {
+            if (keep[i] == 0) {
+                continue;
+            }
+
+            newPositions[i] = kept;
+
+            this->localMatrices[kept] = this->localMatrices[i];
+            this->worldMatrices[kept] = this->worldMatrices[i];
+            this->parents[kept] = (this->parents[i] != INVALID_NODE) ? newPositions[this->parents[i]] : INVALID_NODE;
+            this->depths[kept] = this->depths[i];
+            this->dirty[kept] = this->dirty[i];
+            this->instances[kept] = this->instances[i];
+            this->denseToHandle[kept] = this->denseToHandle[i];
+            this->handleToDense[this->denseToHandle[kept]] = kept;
+
+            ++kept;
+        }
+
+        this->localMatrices.resize(kept);
+        this->worldMatrices.resize(kept);
+        this->parents.resize(kept);
+        this->depths.resize(kept);
+        this->dirty.resize(kept);
+        this->instances.resize(kept);
+        this->denseToHandle.resize(kept);
+    }
+
+
+
+    uint32_t SceneGraph::update() {
+        FHOPE_TRACE_FUNCTION();
+
+        if (this->needsSort) {
+            this->sort_by_depth();
+        }
+
+        this->changed.clear();
+
+        // Nodes are sorted by depth : each level is a contiguous range, whose parents all belong to previous levels
+        uint32_t count = this->size();
+        for (uint32_t levelStart = 0, levelEnd = 0; levelStart != count; levelStart = levelEnd) {
+            this->batchNodes.clear();
+
+            for (levelEnd = levelStart; levelEnd != count && this->depths[levelEnd] == this->depths[levelStart]; ++levelEnd) {
+                uint32_t parent = this->parents[levelEnd];
+
+                // Parents precede their children, so a parent's flag already accounts for every ancestor
+                if (parent != INVALID_NODE && this->dirty[parent] != 0) {
+                    this->dirty[levelEnd] = 1;
+                }
+
+                if (this->dirty[levelEnd] == 0) {
+                    continue;
+                }
+
+                if (parent == INVALID_NODE) {
+                    this->worldMatrices[levelEnd] = this->localMatrices[levelEnd];
+                } else {
+                    this->batchNodes.push_back(levelEnd);
+                }
+
+                this->changed.push_back(this->denseToHandle[levelEnd]);
+            }
+
+            if (this->batchNodes.empty()) {
+                continue;
+            }
+
+            this->batchParents.resize(this->batchNodes.size());
+            this->batchLocals.resize(this->batchNodes.size());
+
+            for (size_t b = 0; b != this->batchNodes.size(); ++b) {
+                uint32_t node = this->batchNodes[b];
+
+                this->batchParents.set(b, this->worldMatrices[this->parents[node]]);
+                this->batchLocals.set(b, this->localMatrices[node]);
+            }
+
+            multiply_matrices(this->batchParents, this->batchLocals, &this->batchWorlds);
+
+            for (size_t b = 0; b != this->batchNodes.size(); ++b) {
+                this->worldMatrices[this->batchNodes[b]] = this->batchWorlds.get(b);
+            }
+        }
+
+        // Flags are cleared once every child has read it's parent's
+        std::fill(this->dirty.begin(), this->dirty.end(), 0);
+
+        return static_cast<uint32_t>(this->changed.size());
+    }
+
+
+
+    const std::vector<NodeHandle> &SceneGraph::get_changed() const {
+        return this->changed;
+    }
+
+
+
+    uint32_t SceneGraph::sync_instances(InstanceBuffer *instanceBuffer) const {
+        uint32_t updated = 0;
+
+        for (NodeHandle handle : this->changed) {
+            uint32_t dense = this->handleToDense[handle];
+
+            if (this->instances[dense] != INVALID_INSTANCE) {
+                instanceBuffer->update(this->instances[dense], this->worldMatrices[dense]);
+                ++updated;
+            }
+        }
+
+        return updated;
+    }
+}
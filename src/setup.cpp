@@ -1,4 +1,7 @@
 #include "setup.hpp"
+#include "async-loading.hpp"
+#include "barrier.hpp"
+#include "trace.hpp"
 
 #include <limits>
 #include <algorithm>
@@ -15,6 +18,18 @@ namespace fhope {
         return (graphicsIndex.has_value() && presentIndex.has_value() && transferIndex.has_value());
     }
 
+
+
+    std::set<uint32_t> QueueSetup::get_unique_families() const {
+        std::set<uint32_t> families = { graphicsIndex.value(), transferIndex.value() };
+
+        if (presentIndex.has_value()) {
+            families.insert(presentIndex.value());
+        }
+
+        return families;
+    }
+
     /***************
      ** CALLBACKS **
      ***************/
@@ -35,6 +50,8 @@ namespace fhope {
          *------------------------------------*/
 
     void initialize_dependencies() {
+        FHOPE_TRACE_FUNCTION();
+
         glfwInit();
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
@@ -46,6 +63,8 @@ namespace fhope {
 
 
     void terminate_dependencies() {
+        FHOPE_TRACE_FUNCTION();
+
         glfwTerminate();
     }
 
@@ -53,7 +72,9 @@ namespace fhope {
          *- FUNCTIONS: Setup generation -*
          *-------------------------------*/
 
-    InstanceSetup create_instance(std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion) {
+    InstanceSetup create_instance(std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion, bool headless) {
+        FHOPE_TRACE_FUNCTION();
+
         std::cout << std::string(fhope::ENGINE_NAME) << std::endl;
         const char *engineNameC = fhope::ENGINE_NAME;
         
@@ -69,10 +90,14 @@ namespace fhope {
         instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         instanceCreateInfo.pApplicationInfo = &appInfo;
 
-        uint32_t glfwExtensionCount(0);
-        const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        
-        std::vector<const char*> enabledExtensions(glfwExtensions, glfwExtensions+glfwExtensionCount);
+        std::vector<const char*> enabledExtensions;
+
+        if (!headless) { // Surface extensions
+            uint32_t glfwExtensionCount(0);
+            const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+            enabledExtensions.assign(glfwExtensions, glfwExtensions+glfwExtensionCount);
+        }
 
 
         
@@ -93,22 +118,23 @@ namespace fhope {
         //#ifdef DEBUG
             enabledExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
-            bool layerFound;
+            bool layerFound(false);
             for (const char *layerName : validationLayers) {
                 for (const VkLayerProperties &layerProperties : availableLayers) {
-                    if (strcmp(layerName, layerProperties.layerName)) {
+                    if (strcmp(layerName, layerProperties.layerName) == 0) {
                         layerFound = true;
                         break;
                     }
                 }
             }
 
-            if (!layerFound) {
-                std::runtime_error("Could not find any of requested validation layer");
+            // Build and benchmark machines (software ICD only) usually lack the SDK's layers
+            if (layerFound) {
+                instanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+                instanceCreateInfo.ppEnabledLayerNames = validationLayers.data();
+            } else {
+                std::cerr << "Could not find the requested validation layers, running without them." << std::endl;
             }
-
-            instanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-            instanceCreateInfo.ppEnabledLayerNames = validationLayers.data();
         //#else
         //    instanceCreateInfo.enabledLayerCount = 0;
         //#endif
@@ -143,12 +169,27 @@ namespace fhope {
 
 
 
-    InstanceSetup generate_vulkan_setup(GLFWwindow *window, std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion, const std::string &vertexShaderFilename, const std::string &fragmentShaderFilename, const std::string &textureFilename, const std::string &modelFilename) {
-        glfwMakeContextCurrent(window);
-        
-        InstanceSetup newSetup = create_instance(appName, appVersion);
+    InstanceSetup generate_vulkan_setup(GLFWwindow *window, std::string appName, std::tuple<uint32_t, uint32_t, uint32_t> appVersion, const std::string &vertexShaderFilename, const std::string &fragmentShaderFilename, const std::string &textureFilename, const std::string &modelFilename, const RenderConfig &config) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (config.framesInFlight == 0) {
+            throw std::runtime_error("Tried to generate a setup without any frame in flight.");
+        }
+
+        if (!config.headless) {
+            glfwMakeContextCurrent(window);
+        }
+
+        std::unique_ptr<JobSystem> jobs = std::make_unique<JobSystem>(get_job_worker_count(config));
+
+        InstanceSetup newSetup = create_instance(appName, appVersion, config.headless);
+
+        newSetup.config = config;
+        newSetup.jobs = std::move(jobs);
         
-        newSetup.surface.emplace(get_surface_from_window(newSetup, window));
+        if (!config.headless) {
+            newSetup.surface.emplace(get_surface_from_window(newSetup, window));
+        }
 
         newSetup.physicalDevice = autopick_physical_device(newSetup);
 
@@ -160,17 +201,25 @@ namespace fhope {
 
         newSetup.queues.emplace(find_queue_families(newSetup, newSetup.physicalDevice.value()));
 
-        newSetup.swapChainSupport.emplace(check_swap_chain_support(newSetup, newSetup.physicalDevice.value()));
+        if (!config.headless) {
+            newSetup.swapChainSupport.emplace(check_swap_chain_support(newSetup, newSetup.physicalDevice.value()));
+        }
         
         newSetup.logicalDevice.emplace(create_logical_device(&newSetup));
+
+        newSetup.samplers = std::make_unique<SamplerCache>(newSetup);
+        newSetup.descriptorLayouts = std::make_unique<DescriptorLayoutCache>(newSetup);
+        newSetup.pipelineCache = std::make_unique<PipelineCache>(newSetup, PIPELINE_CACHE_FILENAME);
         
         VkQueue q{}; // Querying proper vulkan queues
 
         vkGetDeviceQueue(newSetup.logicalDevice.value(), newSetup.queues.value().graphicsIndex.value(), 0, &q);
         newSetup.graphicsQueue.emplace(q);
 
-        vkGetDeviceQueue(newSetup.logicalDevice.value(), newSetup.queues.value().presentIndex.value(), 0, &q);
-        newSetup.presentQueue.emplace(q);
+        if (!config.headless) {
+            vkGetDeviceQueue(newSetup.logicalDevice.value(), newSetup.queues.value().presentIndex.value(), 0, &q);
+            newSetup.presentQueue.emplace(q);
+        }
 
         vkGetDeviceQueue(newSetup.logicalDevice.value(), newSetup.queues.value().transferIndex.value(), 0, &q);
         newSetup.transferQueue.emplace(q);
@@ -179,41 +228,79 @@ namespace fhope {
         // Getting a swap chain
         //newSetup.swapChainSupport.emplace(check_swap_chain_support(newSetup, newSetup.physicalDevice.value()));
         
-        newSetup.swapChainConfig.emplace(prepare_swap_chain_config(newSetup, window));
-        
-        newSetup.swapChain.emplace(create_swap_chain(newSetup, window));
+        if (config.headless) { // Offscreen images stand in for the swap chain's
+            newSetup.swapChainConfig.emplace(prepare_offscreen_config(newSetup));
+
+            newSetup.offscreenImages = create_offscreen_images(newSetup);
+
+            for (const WrappedTexture &offscreenImage : newSetup.offscreenImages) {
+                newSetup.swapChainImages.push_back(offscreenImage.texture);
+            }
+        } else {
+            newSetup.swapChainConfig.emplace(prepare_swap_chain_config(newSetup, window));
+            
+            newSetup.swapChain.emplace(create_swap_chain(newSetup, window));
 
-        newSetup.swapChainImages = retrieve_swap_chain_images(newSetup);
+            newSetup.swapChainImages = retrieve_swap_chain_images(newSetup);
+        }
 
         newSetup.swapChainImageViews = create_swap_chain_image_views(newSetup);
 
         newSetup.uniformLayout.emplace(create_descriptor_set_layout(newSetup));
+
+        if (newSetup.descriptorIndexing) {
+            newSetup.textures = std::make_unique<BindlessTextures>(newSetup);
+        }
         
         newSetup.commandPools.emplace(create_command_pool(newSetup));
+
+        newSetup.async = std::make_unique<AsyncScheduler>(newSetup, newSetup.jobs.get());
         
-        newSetup.colorImage.emplace(create_color_image(newSetup));
+        if (config.gpuCulling) {
+            newSetup.depthBuffer.emplace(create_depth_buffer(newSetup));
+        }
 
-        newSetup.depthBuffer.emplace(create_depth_buffer(newSetup));
+        newSetup.frameGraph.emplace(create_frame_graph(newSetup));
         
         newSetup.graphicsPipelineConfig.emplace(create_graphics_pipeline(newSetup, vertexShaderFilename, fragmentShaderFilename));
 
-        newSetup.swapChainFramebuffers = create_framebuffers(newSetup);
+        newSetup.geometry = std::make_unique<GeometryPool>(newSetup);
 
-        newSetup.texture.emplace(create_texture_from_image(newSetup, textureFilename));
-        newSetup.textureView.emplace(create_texture_image_view(newSetup, newSetup.texture.value(), VK_FORMAT_R8G8B8A8_SRGB, newSetup.texture.value().mipLevels.value()));
-        
-        newSetup.textureSampler.emplace(create_texture_sampler(newSetup, newSetup.texture.value().mipLevels));
+        newSetup.deletions = std::make_unique<DeletionQueue>(config.framesInFlight);
+        newSetup.assets = std::make_unique<AssetManager>(config.assetBudget);
+
+        // The texture and the model are read, decoded and uploaded concurrently, their uploads awaited through fences. Their
+        // handles are kept for the setup's whole life : they are never evicted, and later acquisitions of their files share them
+        newSetup.modelTextureAsset = newSetup.assets->acquire_texture(&newSetup, textureFilename);
+        newSetup.modelAsset = newSetup.assets->acquire_model(&newSetup, modelFilename);
 
-        LoadedModel newModel = load_model(modelFilename);
+        newSetup.async->drain();
+        newSetup.async->pump(); // Rethrows the failure of a load, if any
 
-        newSetup.vertexBuffer.emplace(create_vertex_buffer(newSetup, newModel.vertices));
+        const TextureAsset &newTexture = *newSetup.assets->get(newSetup.modelTextureAsset);
 
-        newSetup.indexBuffer.emplace(create_index_buffer(newSetup, newModel.indices));
-        newSetup.indexCount = newModel.indices.size();
+        newSetup.texture.emplace(newTexture.texture);
+        newSetup.textureView.emplace(newTexture.view);
+        newSetup.textureSampler.emplace(newTexture.sampler);
+        newSetup.modelTexture = newTexture.bindlessIndex.value_or(0);
+
+        newSetup.modelMesh = newSetup.assets->get(newSetup.modelAsset)->mesh;
 
         newSetup.uniformBuffers = create_uniform_buffers(newSetup);
+        newSetup.mvp = create_camera(newSetup.swapChainConfig.value().extent);
+
+        newSetup.instances = std::make_unique<InstanceBuffer>(newSetup, config.framesInFlight);
+        InstanceHandle modelInstance = newSetup.instances->add(glm::mat4(1.0f), newSetup.modelTexture);
+
+        newSetup.scene = std::make_unique<SceneGraph>();
+        newSetup.modelNode = newSetup.scene->add_node(glm::mat4(1.0f));
+        newSetup.scene->attach_instance(newSetup.modelNode, modelInstance);
         
-        newSetup.descriptorPool.emplace(create_descriptor_pool(newSetup));
+        newSetup.descriptorAllocator = std::make_unique<DescriptorAllocator>(newSetup);
+
+        for (uint32_t i = 0; i != config.framesInFlight; ++i) {
+            newSetup.transientDescriptorAllocators.push_back(std::make_unique<DescriptorAllocator>(newSetup));
+        }
 
         newSetup.descriptorSets = create_descriptor_sets(newSetup);
 
@@ -221,12 +308,40 @@ namespace fhope {
 
         newSetup.syncObjects.emplace(create_base_sync_objects(newSetup));
 
+        newSetup.drawItems.push_back(newSetup.geometry->make_draw_item(newSetup.modelMesh.value()));
+
+        newSetup.deviceContext.emplace(create_device_context(newSetup));
+        newSetup.frameContexts = create_frame_contexts(newSetup);
+
+        if (config.recordingMode == RecordingMode::Parallel) {
+            newSetup.recorder = std::make_unique<ParallelRecorder>(newSetup.jobs.get(), get_recording_thread_count(config));
+        }
+
+        if (config.gpuProfiling) {
+            newSetup.profiler = std::make_unique<GpuProfiler>(newSetup, config.framesInFlight);
+        }
+
+        if (config.gpuCulling) {
+            uint32_t modelBlock = newSetup.geometry->get_mesh(newSetup.modelMesh.value()).block;
+            newSetup.culling = std::make_unique<GpuCulling>(newSetup, config.framesInFlight, newSetup.geometry->get_vertex_buffer(modelBlock), newSetup.geometry->get_index_buffer(modelBlock));
+        }
+
+        if (config.shaderHotReload) {
+#ifdef FHOPE_RUNTIME_SHADERS
+            newSetup.shaderReload = std::make_unique<ShaderHotReload>(std::filesystem::path(vertexShaderFilename).parent_path());
+#else
+            throw std::runtime_error("Tried to enable shader hot reload without runtime shader compilation (FHOPE_RUNTIME_SHADERS).");
+#endif
+        }
+
         return newSetup;
     }
 
     
 
     VkSurfaceKHR get_surface_from_window(const InstanceSetup &setup, GLFWwindow *source) {
+        FHOPE_TRACE_FUNCTION();
+
         VkSurfaceKHR newSurface;
         glfwCreateWindowSurface(setup.instance, source, nullptr, &newSurface);
 
@@ -236,6 +351,8 @@ namespace fhope {
 
 
     std::optional<VkPhysicalDevice> autopick_physical_device(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         // Enumerating physical devices
         uint32_t physicalDeviceCount;
         vkEnumeratePhysicalDevices(setup.instance, &physicalDeviceCount, nullptr);
@@ -262,8 +379,18 @@ namespace fhope {
     
 
     bool is_physical_device_suitable(const InstanceSetup &setup, const VkPhysicalDevice &physicalDevice) {
-        QueueSetup queues     = find_queue_families(setup, physicalDevice);
-        bool       extensions = check_physical_device_extension_support(setup, physicalDevice);
+        FHOPE_TRACE_FUNCTION();
+
+        QueueSetup queues = find_queue_families(setup, physicalDevice);
+
+        VkPhysicalDeviceFeatures physicalFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &physicalFeatures);
+
+        if (setup.config.headless) { // Nothing is presented : any device able to draw fits
+            return queues.graphicsIndex.has_value() && physicalFeatures.samplerAnisotropy;
+        }
+
+        bool extensions = check_physical_device_extension_support(setup, physicalDevice);
         
         bool adequateSwapChain(false);
         if (extensions) {
@@ -272,16 +399,15 @@ namespace fhope {
             adequateSwapChain = !swapChain.formats.empty() && !swapChain.presentModes.empty();
         }
 
-        VkPhysicalDeviceFeatures physicalFeatures;
-        vkGetPhysicalDeviceFeatures(physicalDevice, &physicalFeatures);
-
         return queues.is_complete() && extensions && adequateSwapChain && physicalFeatures.samplerAnisotropy;
     }
 
 
 
     QueueSetup find_queue_families(const InstanceSetup &setup, const VkPhysicalDevice &physicalDevice) {
-        if (!setup.surface.has_value()) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.config.headless && !setup.surface.has_value()) {
             throw std::runtime_error("Tried to find suitable queue families without specifying a surface in setup.");
         }
 
@@ -303,11 +429,13 @@ namespace fhope {
                 queues.transferIndex = i;
             }
 
-            VkBool32 presentSupport;
-            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, setup.surface.value(), &presentSupport);
+            if (!setup.config.headless) {
+                VkBool32 presentSupport;
+                vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, setup.surface.value(), &presentSupport);
 
-            if (presentSupport) {
-                queues.presentIndex = i;
+                if (presentSupport) {
+                    queues.presentIndex = i;
+                }
             }
 
             if (queues.is_complete()) {
@@ -325,6 +453,8 @@ namespace fhope {
 
 
     bool check_physical_device_extension_support(const InstanceSetup &setup, const VkPhysicalDevice &physicalDevice) {
+        FHOPE_TRACE_FUNCTION();
+
         uint32_t extensionCount;
         vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
         std::vector<VkExtensionProperties> availablePhysicalDeviceExtensions(extensionCount);
@@ -341,7 +471,28 @@ namespace fhope {
 
 
 
+    bool is_device_extension_supported(const VkPhysicalDevice &physicalDevice, const char *extensionName) {
+        FHOPE_TRACE_FUNCTION();
+
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availablePhysicalDeviceExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availablePhysicalDeviceExtensions.data());
+
+        for (const VkExtensionProperties &availablePhysicalDeviceExtension : availablePhysicalDeviceExtensions) {
+            if (strcmp(availablePhysicalDeviceExtension.extensionName, extensionName) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+
+
     SwapChainSupport check_swap_chain_support(const InstanceSetup &setup, const VkPhysicalDevice &physicalDevice) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.surface.has_value()) {
             throw std::runtime_error("Tried to query swap chain support without specifying a surface in the setup.");
         }
@@ -366,7 +517,9 @@ namespace fhope {
 
 
     int32_t score_physical_device(const InstanceSetup &setup, const VkPhysicalDevice &physicalDevice) {
-        int32_t score;
+        FHOPE_TRACE_FUNCTION();
+
+        int32_t score(0);
 
         VkPhysicalDeviceProperties properties;
         vkGetPhysicalDeviceProperties(physicalDevice, &properties);
@@ -381,6 +534,8 @@ namespace fhope {
 
 
     VkSampleCountFlagBits get_max_multisampling_level(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.physicalDevice.has_value()) {
             throw std::runtime_error("Tried to get max multisampling level without providing a physical device in the setup.");
         }
@@ -402,6 +557,8 @@ namespace fhope {
 
 
     VkDevice create_logical_device(InstanceSetup *setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup->physicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a logical device without specifying any physical device in the setup.");
         }
@@ -410,7 +567,7 @@ namespace fhope {
             throw std::runtime_error("tried to create a logical device without specifying any queues in the setup.");
         }
 
-        std::set<uint32_t> uniqueQueues = { setup->queues.value().graphicsIndex.value(), setup->queues.value().presentIndex.value(), setup->queues.value().transferIndex.value() };
+        std::set<uint32_t> uniqueQueues = setup->queues.value().get_unique_families();
         setup->queues.value().priorities.resize(uniqueQueues.size(), 1.0f);
 
         std::vector<VkDeviceQueueCreateInfo> queuesToCreate;
@@ -428,16 +585,84 @@ namespace fhope {
         physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
         physicalDeviceFeatures.sampleRateShading = VK_TRUE;
 
+        std::vector<const char *> enabledExtensions;
+        if (!setup->config.headless) { // Every required extension is about presentation
+            enabledExtensions.assign(ENGINE_REQUIRED_DEVICE_EXTENSIONS.begin(), ENGINE_REQUIRED_DEVICE_EXTENSIONS.end());
+        }
+
+        // Optional : synchronization2, for batched barriers with per-barrier stage masks
+        VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+        synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+        if (is_device_extension_supported(setup->physicalDevice.value(), VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+            VkPhysicalDeviceFeatures2 supportedFeatures{};
+            supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures.pNext = &synchronization2Features;
+            vkGetPhysicalDeviceFeatures2(setup->physicalDevice.value(), &supportedFeatures);
+
+            if (synchronization2Features.synchronization2) {
+                enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+            }
+        }
+
+        setup->synchronization2 = synchronization2Features.synchronization2 == VK_TRUE;
+        synchronization2Features.pNext = nullptr;
+
+        // Optional : indirect draw features, for GPU-driven culling
+        VkPhysicalDeviceFeatures supportedCoreFeatures;
+        vkGetPhysicalDeviceFeatures(setup->physicalDevice.value(), &supportedCoreFeatures);
+
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(setup->physicalDevice.value(), &deviceProperties);
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        bool vulkan12 = deviceProperties.apiVersion >= VK_API_VERSION_1_2; // The 1.2 feature structure is unknown to older devices
+        if (vulkan12) {
+            VkPhysicalDeviceFeatures2 supportedVulkan12Features{};
+            supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedVulkan12Features.pNext = &vulkan12Features;
+            vkGetPhysicalDeviceFeatures2(setup->physicalDevice.value(), &supportedVulkan12Features);
+        }
+
+        setup->multiDrawIndirect = supportedCoreFeatures.multiDrawIndirect == VK_TRUE;
+        setup->drawIndirectCount = vulkan12Features.drawIndirectCount == VK_TRUE;
+
+        // Optional : descriptor indexing, for the bindless texture array (only enabled when requested)
+        setup->descriptorIndexing = setup->config.bindlessTextures
+                                 && vulkan12Features.runtimeDescriptorArray == VK_TRUE
+                                 && vulkan12Features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+                                 && vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE
+                                 && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+                                 && vulkan12Features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE;
+
+        physicalDeviceFeatures.multiDrawIndirect = supportedCoreFeatures.multiDrawIndirect;
+
+        // Only the queried features are kept enabled
+        VkBool32 descriptorIndexing = setup->descriptorIndexing ? VK_TRUE : VK_FALSE;
+
+        vulkan12Features = VkPhysicalDeviceVulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.pNext = setup->synchronization2 ? &synchronization2Features : nullptr;
+        vulkan12Features.drawIndirectCount = setup->drawIndirectCount ? VK_TRUE : VK_FALSE;
+        vulkan12Features.runtimeDescriptorArray = descriptorIndexing;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = descriptorIndexing;
+        vulkan12Features.descriptorBindingPartiallyBound = descriptorIndexing;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = descriptorIndexing;
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending = descriptorIndexing;
+
         VkDeviceCreateInfo logicalDeviceCreateInfo{};
         logicalDeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        logicalDeviceCreateInfo.pNext = vulkan12 ? static_cast<void *>(&vulkan12Features) : (setup->synchronization2 ? static_cast<void *>(&synchronization2Features) : nullptr);
         
         logicalDeviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(uniqueQueues.size());
         logicalDeviceCreateInfo.pQueueCreateInfos    = queuesToCreate.data();
         
         logicalDeviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
 
-        logicalDeviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(ENGINE_REQUIRED_DEVICE_EXTENSIONS.size());
-        logicalDeviceCreateInfo.ppEnabledExtensionNames = ENGINE_REQUIRED_DEVICE_EXTENSIONS.data();
+        logicalDeviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(enabledExtensions.size());
+        logicalDeviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         //#ifdef DEBUG
             logicalDeviceCreateInfo.enabledLayerCount   = static_cast<uint32_t>(ENGINE_REQUIRED_VALIDATION_LAYERS.size());
@@ -459,6 +684,8 @@ namespace fhope {
 
 
     SwapChainConfig prepare_swap_chain_config(const InstanceSetup &setup, GLFWwindow *window) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.swapChainSupport.has_value()) {
             throw std::runtime_error("Tried to prepare a swap chain config without providing any swap chain support summary in the setup.");
         }
@@ -474,8 +701,9 @@ namespace fhope {
         }
 
         config.presentMode = VK_PRESENT_MODE_FIFO_KHR; // Only mode guaranteed to be available
-        if (std::find(setup.swapChainSupport.value().presentModes.begin(), setup.swapChainSupport.value().presentModes.end(), VK_PRESENT_MODE_MAILBOX_KHR) != setup.swapChainSupport.value().presentModes.end()) {
-            config.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        VkPresentModeKHR requestedPresentMode = get_present_mode(setup.config.presentMode);
+        if (std::find(setup.swapChainSupport.value().presentModes.begin(), setup.swapChainSupport.value().presentModes.end(), requestedPresentMode) != setup.swapChainSupport.value().presentModes.end()) {
+            config.presentMode = requestedPresentMode;
         }
 
         if (setup.swapChainSupport.value().capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
@@ -488,17 +716,32 @@ namespace fhope {
             config.extent.height = std::clamp(static_cast<uint32_t>(height), setup.swapChainSupport.value().capabilities.minImageExtent.height, setup.swapChainSupport.value().capabilities.maxImageExtent.height);
         }
 
-        config.imageCount = setup.swapChainSupport.value().capabilities.minImageCount + 1;
+        config.imageCount = std::max(setup.config.swapChainImageCount.value_or(setup.swapChainSupport.value().capabilities.minImageCount + 1), setup.swapChainSupport.value().capabilities.minImageCount);
         if (setup.swapChainSupport.value().capabilities.maxImageCount > 0 && config.imageCount > setup.swapChainSupport.value().capabilities.maxImageCount) {
             config.imageCount = setup.swapChainSupport.value().capabilities.maxImageCount;
         }
 
         return config;
     }
+
+
+
+    VkPresentModeKHR get_present_mode(PresentModePolicy policy) {
+        FHOPE_TRACE_FUNCTION();
+
+        switch (policy) {
+            case PresentModePolicy::Immediate:   return VK_PRESENT_MODE_IMMEDIATE_KHR;
+            case PresentModePolicy::Mailbox:     return VK_PRESENT_MODE_MAILBOX_KHR;
+            case PresentModePolicy::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            default:                             return VK_PRESENT_MODE_FIFO_KHR;
+        }
+    }
     
     
     
     VkSwapchainKHR create_swap_chain(const InstanceSetup &setup, GLFWwindow *window) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.swapChainConfig.has_value()) {
             throw std::runtime_error("Tried to create a swapchain without putting any swap chain config in the setup.");
         }
@@ -535,7 +778,7 @@ namespace fhope {
         swapChainCreateInfo.imageArrayLayers = 1;
         swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
         
-        const std::set<uint32_t> qs { setup.queues.value().graphicsIndex.value(), setup.queues.value().presentIndex.value(), setup.queues.value().transferIndex.value() };
+        const std::set<uint32_t> qs = setup.queues.value().get_unique_families();
         const std::vector<uint32_t> qsv(qs.begin(), qs.end());
         if (qs.size() > 1) {
             swapChainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
@@ -567,6 +810,8 @@ namespace fhope {
 
     
     std::vector<VkImage> retrieve_swap_chain_images(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to retrieve swap chain images without providing a logical device in the setup.");
         }
@@ -586,6 +831,8 @@ namespace fhope {
 
     
     std::vector<VkImageView> create_swap_chain_image_views(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.swapChainConfig.has_value()) {
             throw std::runtime_error("Tried to create swap chain image views without providing a Swap chain config in the setup.");
         }
@@ -627,9 +874,56 @@ namespace fhope {
 
 
 
+    SwapChainConfig prepare_offscreen_config(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.physicalDevice.has_value()) {
+            throw std::runtime_error("Tried to prepare an offscreen config without providing a physical device in the setup.");
+        }
+
+        std::vector<VkFormat> availableFormats = find_supported_formats(setup, { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB }, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+
+        if (availableFormats.size() == 0) {
+            throw std::runtime_error("Could not find any available offscreen image format.");
+        }
+
+        SwapChainConfig config{};
+        config.surfaceFormat = { availableFormats[0], VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+        config.presentMode = VK_PRESENT_MODE_FIFO_KHR; // Unused, nothing is presented
+        config.extent = setup.config.headlessExtent;
+
+        // Frame slot i always draws to image i : it's fence protects the image, no acquisition is needed
+        config.imageCount = setup.config.framesInFlight;
+
+        return config;
+    }
+
+
+
+    std::vector<WrappedTexture> create_offscreen_images(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to create offscreen images without providing a swap chain config in the setup.");
+        }
+
+        std::vector<WrappedTexture> images;
+        images.reserve(setup.swapChainConfig.value().imageCount);
+
+        for (uint32_t i = 0; i != setup.swapChainConfig.value().imageCount; ++i) {
+            images.push_back(create_texture(setup, setup.swapChainConfig.value().extent.width, setup.swapChainConfig.value().extent.height, VK_SAMPLE_COUNT_1_BIT, 1, setup.swapChainConfig.value().surfaceFormat.format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+        }
+
+        return images;
+    }
+
+
+
     VkDescriptorSetLayout create_descriptor_set_layout(const InstanceSetup &setup) {
-        if (!setup.logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to create a descriptor set layout without providingg a logical device in the setup.");
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.descriptorLayouts) {
+            throw std::runtime_error("Tried to create a descriptor set layout without providing a descriptor layout cache in the setup.");
         }
         
         VkDescriptorSetLayoutBinding uboBinding{};
@@ -646,25 +940,28 @@ namespace fhope {
         samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         samplerBinding.pImmutableSamplers = nullptr;
 
-        std::array<VkDescriptorSetLayoutBinding, 2> descriptorBindings = { uboBinding, samplerBinding };
+        VkDescriptorSetLayoutBinding instanceBinding{};
+        instanceBinding.binding = INSTANCE_BUFFER_BINDING;
+        instanceBinding.descriptorCount = 1;
+        instanceBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        instanceBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        instanceBinding.pImmutableSamplers = nullptr;
+
+        std::array<VkDescriptorSetLayoutBinding, 3> descriptorBindings = { uboBinding, samplerBinding, instanceBinding };
 
         VkDescriptorSetLayoutCreateInfo descriptorCreateInfo{};
         descriptorCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
         descriptorCreateInfo.bindingCount = static_cast<uint32_t>(descriptorBindings.size());
         descriptorCreateInfo.pBindings = descriptorBindings.data();
 
-        VkDescriptorSetLayout newDescriptorSetLayout;
-
-        if (vkCreateDescriptorSetLayout(setup.logicalDevice.value(), &descriptorCreateInfo, nullptr, &newDescriptorSetLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Could not create descriptor set layout.");
-        }
-
-        return newDescriptorSetLayout;
+        return setup.descriptorLayouts->get(descriptorCreateInfo);
     }
 
 
 
     CommandPools create_command_pool(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.queues.has_value()) {
             throw std::runtime_error("Tried to create a command pool without providing queues in the setup.");
         }
@@ -706,29 +1003,9 @@ namespace fhope {
 
 
 
-    ViewableImage create_color_image(const InstanceSetup &setup) {
-        if (!setup.swapChainConfig.has_value()) {
-            throw std::runtime_error("Tried to create color image without providing a swap chain config in the setup.");
-        }
-
-        if (!setup.maxSamplesFlag.has_value()) {
-            throw std::runtime_error("Tried to create color image without providing a max sample flag in the setup.");
-        }
-        
-        ViewableImage colorImage;
-
-        VkFormat format = setup.swapChainConfig.value().surfaceFormat.format;
-
-        colorImage.image = create_texture(setup, setup.swapChainConfig.value().extent.width, setup.swapChainConfig.value().extent.height, setup.maxSamplesFlag.value(), 1, format, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
-
-        colorImage.imageView = create_texture_image_view(setup, colorImage.image, format, 1);
-
-        return colorImage;
-    }
-
-
-
     WrappedTexture create_texture(const InstanceSetup &setup, int width, int height, VkSampleCountFlagBits flags, uint32_t mipLevels, VkFormat depthFormat, VkImageUsageFlags usage) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a texture without providing a logical device in the setup.");
         }
@@ -755,7 +1032,7 @@ namespace fhope {
         imageCreateInfo.usage = usage;
         imageCreateInfo.samples = flags;
         
-        const std::set<uint32_t> qs { setup.queues.value().graphicsIndex.value(), setup.queues.value().presentIndex.value(), setup.queues.value().transferIndex.value() };
+        const std::set<uint32_t> qs = setup.queues.value().get_unique_families();
         const std::vector<uint32_t> qsv(qs.begin(), qs.end());
         if (qs.size() > 1) {
             imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
@@ -792,6 +1069,8 @@ namespace fhope {
 
 
     VkImageView create_texture_image_view(const InstanceSetup &setup, const WrappedTexture &texture, const VkFormat &format, uint32_t mipLevels) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a texture image view without providing a logical device in the setup.");
         }
@@ -818,6 +1097,8 @@ namespace fhope {
 
 
     DepthBuffer create_depth_buffer(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.swapChainConfig.has_value()) {
             throw std::runtime_error("Tried to create a depth buffer without providing a swap chain config in the setup.");
         }
@@ -842,7 +1123,13 @@ namespace fhope {
 
         newDepthBuffer.hasStencil = newDepthBuffer.format==VK_FORMAT_D32_SFLOAT_S8_UINT || newDepthBuffer.format==VK_FORMAT_D24_UNORM_S8_UINT;
 
-        newDepthBuffer.image = create_texture(setup, setup.swapChainConfig.value().extent.width, setup.swapChainConfig.value().extent.height, setup.maxSamplesFlag.value(), 1, newDepthBuffer.format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        // GPU culling builds it's depth pyramid from the depth buffer
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        if (setup.config.gpuCulling) {
+            usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        }
+
+        newDepthBuffer.image = create_texture(setup, setup.swapChainConfig.value().extent.width, setup.swapChainConfig.value().extent.height, setup.maxSamplesFlag.value(), 1, newDepthBuffer.format, usage);
 
         VkImageViewCreateInfo newImageViewCreateInfo{};
         newImageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -873,6 +1160,8 @@ namespace fhope {
 
 
     std::vector<VkFormat> find_supported_formats(const InstanceSetup &setup, const std::vector<VkFormat> &candidates, const VkImageTiling &tiling, const VkFormatFeatureFlags &features) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.physicalDevice.has_value()) {
             throw std::runtime_error("Tried to find supported formats without providing a physical device to the setup.");
         }
@@ -896,11 +1185,114 @@ namespace fhope {
 
 
     GraphicsPipelineConfig create_graphics_pipeline(const InstanceSetup &setup, const std::string &vertexShaderFilename, const std::string &fragmentShaderFilename) {
-        shaderc::SpvCompilationResult vertexCompiled   = compile_shader(vertexShaderFilename,   shaderc_shader_kind::shaderc_vertex_shader);
-        shaderc::SpvCompilationResult fragmentCompiled = compile_shader(fragmentShaderFilename, shaderc_shader_kind::shaderc_fragment_shader);
+        FHOPE_TRACE_FUNCTION();
+
+        std::map<std::string, std::string> fragmentDefinitions;
+        if (setup.textures) {
+            fragmentDefinitions["BINDLESS"] = "1";
+        }
+
+#ifdef FHOPE_RUNTIME_SHADERS
+        std::optional<std::vector<uint32_t>> vertexCompiled;
+        std::optional<std::vector<uint32_t>> fragmentCompiled;
+
+        auto compileVertex   = [&]() { vertexCompiled.emplace(compile_shader(vertexShaderFilename, shaderc_shader_kind::shaderc_vertex_shader)); };
+        auto compileFragment = [&]() { fragmentCompiled.emplace(compile_shader(fragmentShaderFilename, shaderc_shader_kind::shaderc_fragment_shader, fragmentDefinitions)); };
+
+        if (setup.jobs) { // Both stages compile at once
+            JobCounter compiled;
+            setup.jobs->run(compileVertex, &compiled);
+            setup.jobs->run(compileFragment, &compiled);
+            setup.jobs->wait(&compiled);
+        } else {
+            compileVertex();
+            compileFragment();
+        }
+
+        std::span<const uint32_t> vertexCode   = vertexCompiled.value();
+        std::span<const uint32_t> fragmentCode = fragmentCompiled.value();
+#else
+        // Compiled at build time : nothing left to compile
+        std::span<const uint32_t> vertexCode   = get_embedded_shader(vertexShaderFilename);
+        std::span<const uint32_t> fragmentCode = get_embedded_shader(fragmentShaderFilename, fragmentDefinitions);
+#endif
+
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to create a graphics pipeline without providing a swapchain congif in the setup.");
+        }
+
+        VkPipelineLayout pipelineLayout;
+
+        if (!setup.uniformLayout.has_value()) {
+            throw std::runtime_error("Tried to create a pipeline layout without providing a descriptor set layout in the setup.");
+        }
+        
+        std::vector<VkDescriptorSetLayout> setLayouts = { setup.uniformLayout.value() };
+        if (setup.textures) {
+            setLayouts.push_back(setup.textures->get_layout()); // BINDLESS_TEXTURE_SET
+        }
 
-        VkShaderModule vertexModule   = create_shader_module(setup, vertexCompiled);
-        VkShaderModule fragmentModule = create_shader_module(setup, fragmentCompiled);
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+
+        if (!setup.logicalDevice.value()) {
+            throw std::runtime_error("Tried to create a pipeline layout without providing a logical device in the setup.");
+        }
+
+        if (vkCreatePipelineLayout(setup.logicalDevice.value(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't create graphics pipeline layout.");
+        }
+
+        GraphicsPipelineConfig newPipelineConfig{};
+        newPipelineConfig.renderPass = setup.frameGraph.value().graph->get_render_pass(setup.frameGraph.value().forwardPass);
+        newPipelineConfig.vertexShaderFilename   = vertexShaderFilename;
+        newPipelineConfig.fragmentShaderFilename = fragmentShaderFilename;
+        newPipelineConfig.fragmentDefinitions    = fragmentDefinitions;
+        newPipelineConfig.pipelineLayout = pipelineLayout;
+        newPipelineConfig.pipeline = build_graphics_pipeline(get_graphics_pipeline_state(setup, newPipelineConfig), vertexCode, fragmentCode);
+
+        return newPipelineConfig;
+    }
+
+
+
+    GraphicsPipelineState get_graphics_pipeline_state(const InstanceSetup &setup, const GraphicsPipelineConfig &pipelineConfig) {
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to get a graphics pipeline state without providing a logical device in the setup.");
+        }
+
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to get a graphics pipeline state without providing a swapchain config in the setup.");
+        }
+
+        if (!setup.maxSamplesFlag.has_value()) {
+            throw std::runtime_error("Tried to get a graphics pipeline state without providing a max samples flag in the setup.");
+        }
+
+        if (!setup.pipelineCache) {
+            throw std::runtime_error("Tried to get a graphics pipeline state without providing a pipeline cache in the setup.");
+        }
+
+        GraphicsPipelineState state{};
+        state.device         = setup.logicalDevice.value();
+        state.pipelineLayout = pipelineConfig.pipelineLayout;
+        state.renderPass     = pipelineConfig.renderPass;
+        state.samples        = setup.maxSamplesFlag.value();
+        state.extent         = setup.swapChainConfig.value().extent;
+        state.pipelineCache  = setup.pipelineCache->get();
+
+        return state;
+    }
+
+
+
+    VkPipeline build_graphics_pipeline(const GraphicsPipelineState &state, std::span<const uint32_t> vertexShader, std::span<const uint32_t> fragmentShader) {
+        FHOPE_TRACE_FUNCTION();
+
+        VkShaderModule vertexModule   = create_shader_module(state.device, vertexShader);
+        VkShaderModule fragmentModule = create_shader_module(state.device, fragmentShader);
         
         VkPipelineShaderStageCreateInfo vertexStageCreateInfo{};
         vertexStageCreateInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -938,21 +1330,17 @@ namespace fhope {
         inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-        if (!setup.swapChainConfig.has_value()) {
-            throw std::runtime_error("Tried to create a graphics pipeline without providing a swapchain congif in the setup.");
-        }
-
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width  = (float)setup.swapChainConfig.value().extent.width;
-        viewport.height = (float)setup.swapChainConfig.value().extent.height;
+        viewport.width  = (float)state.extent.width;
+        viewport.height = (float)state.extent.height;
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
 
         VkRect2D scissor{};
         scissor.offset = {0, 0};
-        scissor.extent = setup.swapChainConfig.value().extent;
+        scissor.extent = state.extent;
 
         VkPipelineViewportStateCreateInfo viewportStateCreateInfo{};
         viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -974,7 +1362,7 @@ namespace fhope {
         VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo{};
         multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
         multisampleStateCreateInfo.sampleShadingEnable = VK_TRUE;
-        multisampleStateCreateInfo.rasterizationSamples = setup.maxSamplesFlag.value();
+        multisampleStateCreateInfo.rasterizationSamples = state.samples;
         multisampleStateCreateInfo.minSampleShading = .2f;
         
         VkPipelineColorBlendAttachmentState colorBlendAttachmentState{};
@@ -993,27 +1381,6 @@ namespace fhope {
         colorBlendStateCreateInfo.attachmentCount = 1;
         colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
 
-        VkPipelineLayout pipelineLayout;
-
-        if (!setup.uniformLayout.has_value()) {
-            throw std::runtime_error("Tried to create a pipeline layout without providing a descriptor set layout in the setup.");
-        }
-        
-        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutCreateInfo.setLayoutCount = 1;
-        pipelineLayoutCreateInfo.pSetLayouts = &setup.uniformLayout.value();
-
-        if (!setup.logicalDevice.value()) {
-            throw std::runtime_error("Tried to create a pipeline layout without providing a logical device in the setup.");
-        }
-
-        if (vkCreatePipelineLayout(setup.logicalDevice.value(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Couldn't create graphics pipeline layout.");
-        }
-
-        VkRenderPass renderPass = create_render_pass(setup);
-
         VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo{};
         depthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
         depthStencilStateCreateInfo.depthTestEnable = true;
@@ -1041,44 +1408,47 @@ namespace fhope {
 
         pipelineCreateInfo.pDepthStencilState = &depthStencilStateCreateInfo;
 
-        pipelineCreateInfo.layout = pipelineLayout;
+        pipelineCreateInfo.layout = state.pipelineLayout;
 
-        pipelineCreateInfo.renderPass = renderPass;
+        pipelineCreateInfo.renderPass = state.renderPass;
         pipelineCreateInfo.subpass    = 0;
 
         VkPipeline graphicsPipeline;
-        if (vkCreateGraphicsPipelines(setup.logicalDevice.value(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        VkResult created = vkCreateGraphicsPipelines(state.device, state.pipelineCache, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline);
+
+        vkDestroyShaderModule(state.device, vertexModule,   nullptr);
+        vkDestroyShaderModule(state.device, fragmentModule, nullptr);
+
+        if (created != VK_SUCCESS) {
             throw std::runtime_error("Couldn't create graphics pipeline.");
         }
 
-        GraphicsPipelineConfig newPipelineConfig{};
-        newPipelineConfig.renderPass = renderPass;
-        newPipelineConfig.vertexShaderFilename   = vertexShaderFilename;
-        newPipelineConfig.fragmentShaderFilename = fragmentShaderFilename;
-        newPipelineConfig.pipelineLayout = pipelineLayout;
-        newPipelineConfig.pipeline = graphicsPipeline;
-
-        vkDestroyShaderModule(setup.logicalDevice.value(), vertexModule,   nullptr);
-        vkDestroyShaderModule(setup.logicalDevice.value(), fragmentModule, nullptr);
-
-        return newPipelineConfig;
+        return graphicsPipeline;
     }
 
 
 
-    VkShaderModule create_shader_module(const InstanceSetup &setup, const shaderc::SpvCompilationResult &compiledShader) {
+    VkShaderModule create_shader_module(const InstanceSetup &setup, std::span<const uint32_t> compiledShader) {
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a shader module without providing a logical device in the setup.");
         }
-        
+
+        return create_shader_module(setup.logicalDevice.value(), compiledShader);
+    }
+
+
+
+    VkShaderModule create_shader_module(VkDevice device, std::span<const uint32_t> compiledShader) {
+        FHOPE_TRACE_FUNCTION();
+
         VkShaderModuleCreateInfo newShaderModuleCreateInfo{};
 
         newShaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        newShaderModuleCreateInfo.pCode = compiledShader.begin();
-        newShaderModuleCreateInfo.codeSize = (compiledShader.end() - compiledShader.begin()) * sizeof(uint32_t);
+        newShaderModuleCreateInfo.pCode = compiledShader.data();
+        newShaderModuleCreateInfo.codeSize = compiledShader.size_bytes();
 
         VkShaderModule newShaderModule;
-        if (vkCreateShaderModule(setup.logicalDevice.value(), &newShaderModuleCreateInfo, nullptr, &newShaderModule) != VK_SUCCESS) {
+        if (vkCreateShaderModule(device, &newShaderModuleCreateInfo, nullptr, &newShaderModule) != VK_SUCCESS) {
             throw std::runtime_error("Couldn't compile shader");
         }
 
@@ -1087,193 +1457,153 @@ namespace fhope {
 
 
 
-    VkRenderPass create_render_pass(const InstanceSetup &setup) {
-        if (!setup.swapChainConfig.has_value()) {
-            throw std::runtime_error("Tried to create a render pass without providing a swap chain config in the setup.");
-        }
-        
-        if (!setup.logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to create a render pass without providing a logical device in the setup.");
-        }
+    FrameGraph create_frame_graph(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
 
-        if (!setup.depthBuffer.has_value()) {
-            throw std::runtime_error("Tried to create a render pass without providing a depth buffer in the setup.");
+        if (!setup.swapChainConfig.has_value()) {
+            throw std::runtime_error("Tried to create a frame graph without providing a swap chain config in the setup.");
         }
 
         if (!setup.maxSamplesFlag.has_value()) {
-            throw std::runtime_error("Tried to create a render pass without providing a max sample in the setup.");
-        }
-        
-        // COLOR
-        VkAttachmentDescription colorAttachment{};
-        colorAttachment.format = setup.swapChainConfig.value().surfaceFormat.format;
-        colorAttachment.samples = setup.maxSamplesFlag.value();
-        colorAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentReference colorAttachmentReference{};
-        colorAttachmentReference.attachment = 0;
-        colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        // DEPTH
-        VkAttachmentDescription depthAttachment{};
-        depthAttachment.format = setup.depthBuffer.value().format;
-        depthAttachment.samples = setup.maxSamplesFlag.value();
-        depthAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentReference depthAttachmentReference{};
-        depthAttachmentReference.attachment = 1;
-        depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        // RESOLVE
-        VkAttachmentDescription resolveAttachment{};
-        resolveAttachment.format = setup.swapChainConfig.value().surfaceFormat.format;
-        resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        resolveAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        VkAttachmentReference resolveAttachmentReference{};
-        resolveAttachmentReference.attachment = 2;
-        resolveAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        // SUBPASS...
-        VkSubpassDescription subpassDescription{};
-        subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpassDescription.colorAttachmentCount = 1;
-        subpassDescription.pColorAttachments = &colorAttachmentReference;
-        subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
-        subpassDescription.pResolveAttachments = &resolveAttachmentReference;
-
-        VkSubpassDependency subpassDependency{};
-        subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        subpassDependency.srcAccessMask = 0;
-        subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-        std::array<VkAttachmentDescription, 3> attachmentDescs { colorAttachment, depthAttachment, resolveAttachment };
-        VkRenderPass renderPass{};
-        VkRenderPassCreateInfo renderPassCreateInfo{};
-        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
-        renderPassCreateInfo.pAttachments = attachmentDescs.data();
-        renderPassCreateInfo.subpassCount = 1;
-        renderPassCreateInfo.pSubpasses = &subpassDescription;
-        renderPassCreateInfo.dependencyCount = 1;
-        renderPassCreateInfo.pDependencies = &subpassDependency;
-
-        if (vkCreateRenderPass(setup.logicalDevice.value(), &renderPassCreateInfo, nullptr, &renderPass) != VK_SUCCESS) {
-            throw std::runtime_error("Couldn't create render pass.");
-        }
-
-        return renderPass;
-    }
-
-
-
-    std::vector<VkFramebuffer> create_framebuffers(const InstanceSetup &setup) {
-        if (!setup.graphicsPipelineConfig.has_value()) {
-            throw std::runtime_error("Tried to create framebuffers without proving a graphics pipeline in the setup.");
+            throw std::runtime_error("Tried to create a frame graph without providing a max sample flag in the setup.");
         }
 
-        if (!setup.swapChainConfig.has_value()) {
-            throw std::runtime_error("Tried to create framebuffers without providing a swap chain config in the setup.");
+        if (setup.swapChainImages.empty() || setup.swapChainImageViews.size() != setup.swapChainImages.size()) {
+            throw std::runtime_error("Tried to create a frame graph without providing swap chain images and their views in the setup.");
         }
 
-        if (!setup.logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to create framebuffers without providing a logical device in the setup.");
+        if (setup.config.gpuCulling && !setup.depthBuffer.has_value()) {
+            throw std::runtime_error("Tried to create a frame graph for GPU culling without providing a depth buffer in the setup.");
         }
 
-        if (!setup.depthBuffer.has_value()) {
-            throw std::runtime_error("Tried to create framebufffers without providing a depth buffer in the setup.");
-        }
+        FrameGraph newFrameGraph{};
+        newFrameGraph.graph = std::make_unique<RenderGraph>();
 
-        std::vector<VkFramebuffer> newFramebuffers(setup.swapChainImageViews.size());
+        RenderGraph *graph = newFrameGraph.graph.get();
+        const SwapChainConfig &swapChainConfig = setup.swapChainConfig.value();
 
-        for (size_t i = 0; i != setup.swapChainImageViews.size(); ++i) {
-            VkImageView attachments[] = { setup.colorImage.value().imageView, setup.depthBuffer.value().view, setup.swapChainImageViews[i] };
+        // Offscreen images may be read back
+        VkImageLayout targetLayout = setup.config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-            VkFramebufferCreateInfo framebufferCreateInfo{};
-            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferCreateInfo.renderPass = setup.graphicsPipelineConfig.value().renderPass;
-            framebufferCreateInfo.attachmentCount = 3;
-            framebufferCreateInfo.pAttachments = &attachments[0];
-            framebufferCreateInfo.width = setup.swapChainConfig.value().extent.width;
-            framebufferCreateInfo.height = setup.swapChainConfig.value().extent.height;
-            framebufferCreateInfo.layers = 1;
+        newFrameGraph.target = graph->import_image("swap chain", { swapChainConfig.surfaceFormat.format, swapChainConfig.extent }, VK_IMAGE_LAYOUT_UNDEFINED, targetLayout);
+        graph->set_imported_images(newFrameGraph.target, setup.swapChainImages, setup.swapChainImageViews);
 
-            if (vkCreateFramebuffer(setup.logicalDevice.value(), &framebufferCreateInfo, nullptr, &newFramebuffers[i]) != VK_SUCCESS) {
-                throw std::runtime_error("Couldn't create framebuffers.");
-            }
+        std::optional<GraphResource> depth;
+
+        if (setup.config.gpuCulling) {
+            // Kept after the forward pass, for the depth pyramid's compute passes
+            const DepthBuffer &depthBuffer = setup.depthBuffer.value();
+
+            depth = graph->import_image("depth buffer", { depthBuffer.format, swapChainConfig.extent, setup.maxSamplesFlag.value(), 1 }, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                                        StageAccess{ VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR });
+            graph->set_imported_image(depth.value(), depthBuffer.image.texture, depthBuffer.view);
         }
-        
-        return newFramebuffers;
+
+        // Draws depend on the frame : record_frame sets the pass' record function before executing the graph
+        GraphPassBuilder forwardPass = add_forward_pass(graph, setup, newFrameGraph.target, depth, nullptr);
+
+        if (setup.config.recordingMode == RecordingMode::Parallel && !setup.config.gpuCulling) {
+            forwardPass.secondary_contents();
+        }
+
+        newFrameGraph.forwardPass = forwardPass.id();
+
+        graph->compile(setup);
+
+        return newFrameGraph;
     }
 
 
 
     WrappedTexture create_texture_from_image(const InstanceSetup &setup, const std::string &textureFilename) {
-        if (!setup.logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to create a texture from an image without providing a logical device in the setup.");
+        return create_texture_from_image(setup, decode_image(textureFilename));
+    }
+
+
+
+    WrappedTexture create_texture_from_image(const InstanceSetup &setup, const DecodedImage &image) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.commandPools.has_value()) {
+            throw std::runtime_error("Tried to create a texture from an image without providing command pools in the setup.");
         }
-        
-        int imageWidth;
-        int imageHeight;
-        int imageChannels;
 
-        stbi_uc *imageData = stbi_load(textureFilename.c_str(), &imageWidth, &imageHeight, &imageChannels, STBI_rgb_alpha);
-        
+        if (!setup.graphicsQueue.has_value()) {
+            throw std::runtime_error("Tried to create a texture from an image without providing a graphics queue in the setup.");
+        }
 
-        if (!imageData) {
-            throw std::runtime_error("Could not load image data for texture creation.");
+        TextureUpload upload = prepare_texture_upload(setup, image);
+
+        // Transition, upload and mipmap generation share a single one-shot submission
+        VkCommandBuffer uploadCommand = begin_one_shot_command(setup, setup.commandPools.value().graphics);
+
+        record_texture_upload(setup, uploadCommand, upload);
+
+        end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &uploadCommand);
+
+        destroy_texture_upload(setup, upload);
+
+        return upload.texture;
+    }
+
+
+
+    TextureUpload prepare_texture_upload(const InstanceSetup &setup, const DecodedImage &image) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.logicalDevice.has_value()) {
+            throw std::runtime_error("Tried to prepare a texture upload without providing a logical device in the setup.");
         }
 
-        VkDeviceSize imageSizeInBytes = imageWidth*imageHeight*imageChannels*sizeof(uint8_t);
+        TextureUpload upload{};
+        upload.width  = image.width;
+        upload.height = image.height;
 
-        WrappedBuffer stagingTextureBuffer = create_buffer(setup, imageSizeInBytes, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        VkDeviceSize imageSizeInBytes = image.pixels.size()*sizeof(stbi_uc);
+
+        upload.staging = create_buffer(setup, imageSizeInBytes, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
         void *stagingTextureBufferMapping;
-        vkMapMemory(setup.logicalDevice.value(), stagingTextureBuffer.memory, 0, stagingTextureBuffer.sizeInBytes, 0, &stagingTextureBufferMapping);
-        memcpy_s(stagingTextureBufferMapping, stagingTextureBuffer.sizeInBytes,imageData, imageSizeInBytes);
-        vkUnmapMemory(setup.logicalDevice.value(), stagingTextureBuffer.memory);
+        vkMapMemory(setup.logicalDevice.value(), upload.staging.memory, 0, upload.staging.sizeInBytes, 0, &stagingTextureBufferMapping);
+        memcpy_s(stagingTextureBufferMapping, upload.staging.sizeInBytes, image.pixels.data(), imageSizeInBytes);
+        vkUnmapMemory(setup.logicalDevice.value(), upload.staging.memory);
         
-        uint32_t availableMips = static_cast<uint32_t>(std::floor(std::log2(std::max(imageHeight, imageWidth))));
+        uint32_t availableMips = static_cast<uint32_t>(std::floor(std::log2(std::max(upload.height, upload.width))));
 
-        WrappedTexture newTexture = create_texture(setup, imageWidth, imageHeight, VK_SAMPLE_COUNT_1_BIT, availableMips, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-        newTexture.mipLevels.emplace(availableMips);
+        upload.texture = create_texture(setup, upload.width, upload.height, VK_SAMPLE_COUNT_1_BIT, availableMips, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+        upload.texture.mipLevels.emplace(availableMips);
 
-        transition_image_layout(setup, &newTexture, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, availableMips);
+        return upload;
+    }
 
-        copy_buffer_to_image(setup, stagingTextureBuffer, &newTexture.texture, imageWidth, imageHeight);
 
-        generate_mipmaps(setup, newTexture.texture, VK_FORMAT_R8G8B8A8_SRGB, imageWidth, imageHeight, availableMips);
-        // TODO : See about removing ? should be done in mipmaps instead
-        //transition_image_layout(setup, &newTexture, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, availableMips);
 
-        vkDestroyBuffer(setup.logicalDevice.value(), stagingTextureBuffer.buffer, nullptr);
-        vkFreeMemory(setup.logicalDevice.value(), stagingTextureBuffer.memory, nullptr);
+    void record_texture_upload(const InstanceSetup &setup, VkCommandBuffer commandBuffer, const TextureUpload &upload) {
+        FHOPE_TRACE_FUNCTION();
 
-        stbi_image_free(imageData);
+        uint32_t mipLevels = upload.texture.mipLevels.value();
 
-        return newTexture;
+        BarrierBatch barriers(setup.synchronization2);
+        barriers.transition_image(upload.texture.texture, { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 }, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        barriers.flush(commandBuffer);
+
+        record_copy_buffer_to_image(commandBuffer, upload.staging, upload.texture.texture, upload.width, upload.height);
+
+        record_mipmaps(setup, commandBuffer, upload.texture.texture, VK_FORMAT_R8G8B8A8_SRGB, upload.width, upload.height, mipLevels);
     }
 
 
 
-    void copy_buffer(const InstanceSetup &setup, const WrappedBuffer &source, WrappedBuffer *dest) {
+    void destroy_texture_upload(const InstanceSetup &setup, const TextureUpload &upload) {
+        vkDestroyBuffer(setup.logicalDevice.value(), upload.staging.buffer, nullptr);
+        vkFreeMemory(setup.logicalDevice.value(), upload.staging.memory, nullptr);
+    }
+
+
+
+    void copy_buffer(const InstanceSetup &setup, const WrappedBuffer &source, WrappedBuffer *dest, VkDeviceSize destOffset) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to copy a buffer without providing a logical device in the setup.");
         }
@@ -1303,8 +1633,8 @@ namespace fhope {
 
         VkBufferCopy bufferCopy{};
         bufferCopy.srcOffset = 0;
-        bufferCopy.dstOffset = 0;
-        bufferCopy.size = std::min(source.sizeInBytes, dest->sizeInBytes);
+        bufferCopy.dstOffset = destOffset;
+        bufferCopy.size = std::min(source.sizeInBytes, dest->sizeInBytes - destOffset);
         vkCmdCopyBuffer(commandBuffer, source.buffer, dest->buffer, 1, &bufferCopy);
 
         vkEndCommandBuffer(commandBuffer);
@@ -1323,6 +1653,8 @@ namespace fhope {
 
 
     WrappedBuffer create_buffer(const InstanceSetup &setup, VkDeviceSize sizeInBytes, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+        FHOPE_TRACE_FUNCTION();
+
         WrappedBuffer newBuffer;
         
         VkBufferCreateInfo bufferCreateInfo{};
@@ -1330,7 +1662,7 @@ namespace fhope {
         bufferCreateInfo.size = sizeInBytes;
         bufferCreateInfo.usage = usage;
         
-        const std::set<uint32_t> qs { setup.queues.value().graphicsIndex.value(), setup.queues.value().presentIndex.value(), setup.queues.value().transferIndex.value() };
+        const std::set<uint32_t> qs = setup.queues.value().get_unique_families();
         const std::vector<uint32_t> qsv(qs.begin(), qs.end());
         
         if (qs.size() != 1) {
@@ -1367,6 +1699,8 @@ namespace fhope {
 
 
     void transition_image_layout(const InstanceSetup &setup, WrappedTexture *texture, const VkFormat &format, const VkImageLayout &oldLayout, const VkImageLayout &newLayout, uint32_t mipLevels) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.commandPools.has_value()) {
             throw std::runtime_error("Tried to transition an image layout without providing command pools in the setup.");
         }
@@ -1377,59 +1711,16 @@ namespace fhope {
         
         VkCommandBuffer transitionCommand = begin_one_shot_command(setup, setup.commandPools.value().graphics);
 
-        VkImageMemoryBarrier transitionBarrier{};
-        transitionBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        transitionBarrier.oldLayout = oldLayout;
-        transitionBarrier.newLayout = newLayout;
-        transitionBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        transitionBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        transitionBarrier.image = texture->texture;
-
-        transitionBarrier.subresourceRange.baseMipLevel = 0;
-        transitionBarrier.subresourceRange.levelCount = mipLevels;
-        transitionBarrier.subresourceRange.baseArrayLayer = 0;
-        transitionBarrier.subresourceRange.layerCount = 1;
-
-        if (format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D24_UNORM_S8_UINT) {
-            transitionBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-        } else {
-            transitionBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        }
-
-        VkPipelineStageFlags sourceStage;
-        VkPipelineStageFlags destStage;
-
-        if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-            transitionBarrier.srcAccessMask = 0;
-            transitionBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destStage   = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-            transitionBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            transitionBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destStage   = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)  {
-            transitionBarrier.srcAccessMask = 0;
-            transitionBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destStage   = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        } else {
-            throw std::runtime_error("Could not transition image layout between specified layouts.");
-        }
+        VkImageSubresourceRange range{};
+        range.aspectMask = get_format_aspect(format);
+        range.baseMipLevel = 0;
+        range.levelCount = mipLevels;
+        range.baseArrayLayer = 0;
+        range.layerCount = 1;
 
-    
-        vkCmdPipelineBarrier(
-            transitionCommand,
-            sourceStage, destStage,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &transitionBarrier
-        );
+        BarrierBatch barriers(setup.synchronization2);
+        barriers.transition_image(texture->texture, range, oldLayout, newLayout);
+        barriers.flush(transitionCommand);
 
         end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &transitionCommand);
     }
@@ -1437,6 +1728,8 @@ namespace fhope {
 
 
     VkCommandBuffer begin_one_shot_command(const InstanceSetup &setup, const VkCommandPool &selectedPool) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to begin a one-shot command without providing a logical device in the setup.");
         }
@@ -1462,6 +1755,8 @@ namespace fhope {
 
 
     void end_one_shot_command(const InstanceSetup &setup, const VkCommandPool &selectedPool, const VkQueue &selectedQueue, VkCommandBuffer *osCommandBuffer) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to end a one-shot command without providing a logical device in the setup.");
         }
@@ -1482,12 +1777,14 @@ namespace fhope {
 
 
     VkSampler create_texture_sampler(const InstanceSetup &setup, std::optional<uint32_t> mipLevel) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.physicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a texture sampler without providing a physical device in the setup.");
         }
 
-        if (!setup.logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to create a texture sampler without providing a logical device in the setup.");
+        if (!setup.samplers) {
+            throw std::runtime_error("Tried to create a texture sampler without providing a sampler cache in the setup.");
         }
 
         VkSamplerCreateInfo samplerCreateInfo{};
@@ -1520,17 +1817,14 @@ namespace fhope {
             samplerCreateInfo.maxLod = static_cast<float>(mipLevel.value());
         }
 
-        VkSampler newSampler;
-        if (vkCreateSampler(setup.logicalDevice.value(), &samplerCreateInfo, nullptr, &newSampler) != VK_SUCCESS) {
-            throw std::runtime_error("Could not create texture sampler.");
-        }
-
-        return newSampler;
+        return setup.samplers->get(samplerCreateInfo);
     }
 
 
 
     void copy_buffer_to_image(const InstanceSetup &setup, const WrappedBuffer &dataSource, VkImage *image, uint32_t imageWidth, uint32_t imageHeight) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.commandPools.has_value()) {
             throw std::runtime_error("Tried to copy a buffer to an image without providing command pools in the setup.");
         }
@@ -1541,6 +1835,16 @@ namespace fhope {
 
         VkCommandBuffer copyToImageCommand = begin_one_shot_command(setup, setup.commandPools.value().graphics);
 
+        record_copy_buffer_to_image(copyToImageCommand, dataSource, *image, imageWidth, imageHeight);
+
+        end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &copyToImageCommand);
+    }
+
+
+
+    void record_copy_buffer_to_image(const VkCommandBuffer &commandBuffer, const WrappedBuffer &dataSource, const VkImage &image, uint32_t imageWidth, uint32_t imageHeight) {
+        FHOPE_TRACE_FUNCTION();
+
         VkBufferImageCopy region{};
         region.bufferOffset = 0;
         region.bufferRowLength = 0;
@@ -1554,14 +1858,14 @@ namespace fhope {
         region.imageOffset = { 0, 0, 0 };
         region.imageExtent = { imageWidth, imageHeight, 1 };
 
-        vkCmdCopyBufferToImage(copyToImageCommand, dataSource.buffer, *image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-        end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &copyToImageCommand);
+        vkCmdCopyBufferToImage(commandBuffer, dataSource.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
     }
 
 
 
     void generate_mipmaps(const InstanceSetup &setup, const VkImage &image, const VkFormat &format, int width, int height, uint32_t mipLevels) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.commandPools.has_value()) {
             throw std::runtime_error("Tried to generate mipmaps without providing command pools in the setup.");
         }
@@ -1574,6 +1878,22 @@ namespace fhope {
             throw std::runtime_error("Tried to generate mipmaps without providing a physical device in the setup.");
         }
 
+        VkCommandBuffer command = begin_one_shot_command(setup, setup.commandPools.value().graphics);
+
+        record_mipmaps(setup, command, image, format, width, height, mipLevels);
+        
+        end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &command);
+    }
+
+
+
+    void record_mipmaps(const InstanceSetup &setup, const VkCommandBuffer &commandBuffer, const VkImage &image, const VkFormat &format, int width, int height, uint32_t mipLevels) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup.physicalDevice.has_value()) {
+            throw std::runtime_error("Tried to record mipmaps generation without providing a physical device in the setup.");
+        }
+
         VkFormatProperties props;
         vkGetPhysicalDeviceFormatProperties(setup.physicalDevice.value(), format, &props);
 
@@ -1581,34 +1901,15 @@ namespace fhope {
             throw std::runtime_error("Mipmaps can't be blitted because physical device can't handle their format with linear filtering.");
         }
         
-        VkCommandBuffer command = begin_one_shot_command(setup, setup.commandPools.value().graphics);
-        
-        VkImageMemoryBarrier mipmapBarrier{};
-        mipmapBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        mipmapBarrier.image = image;
-        mipmapBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        mipmapBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        mipmapBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        mipmapBarrier.subresourceRange.baseArrayLayer = 0;
-        mipmapBarrier.subresourceRange.layerCount = 1;
-        mipmapBarrier.subresourceRange.levelCount = 1;
+        BarrierBatch barriers(setup.synchronization2);
 
         int mipWidth = width;
         int mipHeight = height;
         
         for (uint32_t i = 1; i != mipLevels; ++i) {
-            mipmapBarrier.subresourceRange.baseMipLevel = i-1;
-            mipmapBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            mipmapBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            mipmapBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            mipmapBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            
-            vkCmdPipelineBarrier(command,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                0, nullptr,
-                0, nullptr,
-                1, &mipmapBarrier
-            );
+            // Each blit reads the level the previous one wrote : this barrier can't be batched
+            barriers.transition_image(image, { VK_IMAGE_ASPECT_COLOR_BIT, i-1, 1, 0, 1 }, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+            barriers.flush(commandBuffer);
             
             VkImageBlit blit{};
             blit.srcOffsets[0] = { 0, 0, 0 };
@@ -1625,49 +1926,30 @@ namespace fhope {
             blit.dstSubresource.baseArrayLayer = 0;
             blit.dstSubresource.layerCount = 1;
             
-            vkCmdBlitImage(command,
+            vkCmdBlitImage(commandBuffer,
                 image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                 image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 1, &blit,
                 VK_FILTER_LINEAR
             );
-
-            mipmapBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            mipmapBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            mipmapBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            mipmapBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            vkCmdPipelineBarrier(command,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                0, nullptr,
-                0, nullptr,
-                1, &mipmapBarrier
-            );
             
             if (mipWidth  > 1) { mipWidth  /= 2; }
             if (mipHeight > 1) { mipHeight /= 2; }
         }
 
-        mipmapBarrier.subresourceRange.baseMipLevel = mipLevels - 1;
-        mipmapBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        mipmapBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        mipmapBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        mipmapBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-
-        vkCmdPipelineBarrier(command,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-            0, nullptr,
-            0, nullptr,
-            1, &mipmapBarrier
-        );
-        
-        end_one_shot_command(setup, setup.commandPools.value().graphics, setup.graphicsQueue.value(), &command);
+        // Every level becomes shader-readable at once
+        if (mipLevels > 1) {
+            barriers.transition_image(image, { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels - 1, 0, 1 }, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        barriers.transition_image(image, { VK_IMAGE_ASPECT_COLOR_BIT, mipLevels - 1, 1, 0, 1 }, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        barriers.flush(commandBuffer);
     }
 
 
 
     WrappedBuffer create_vertex_buffer(const InstanceSetup &setup, const std::vector<Vertex3D> &vertices) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a vertex buffer without providing a logical device in the setup");
         }
@@ -1692,6 +1974,8 @@ namespace fhope {
 
 
     WrappedBuffer create_index_buffer(const InstanceSetup &setup, const std::vector<uint32_t> &indices) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create an index buffer without providing a logical device in the setup.");
         }
@@ -1716,7 +2000,9 @@ namespace fhope {
 
 
     std::vector<WrappedBuffer> create_uniform_buffers(const InstanceSetup &setup) {
-        std::vector<WrappedBuffer> newUniformBuffers(MAX_FRAMES_IN_FLIGHT);
+        FHOPE_TRACE_FUNCTION();
+
+        std::vector<WrappedBuffer> newUniformBuffers(setup.config.framesInFlight);
 
         VkDeviceSize bufferSizeInBytes = sizeof(UniformBufferObject);
 
@@ -1734,47 +2020,17 @@ namespace fhope {
 
 
 
-    VkDescriptorPool create_descriptor_pool(const InstanceSetup &setup) {
-        if (!setup.logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to create a descriptor pool without providing a logical device in the setup.");
-        }
-        
-        std::array<VkDescriptorPoolSize, 2> poolSizes{};
-        poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-        poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-        poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-
-        VkDescriptorPoolCreateInfo poolCreateInfo{};
-        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-        poolCreateInfo.pPoolSizes = poolSizes.data();
-        poolCreateInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    std::vector<VkDescriptorSet> create_descriptor_sets(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
 
-        VkDescriptorPool newDescriptorPool;
-        if (vkCreateDescriptorPool(setup.logicalDevice.value(), &poolCreateInfo, nullptr, &newDescriptorPool) != VK_SUCCESS) {
-            throw std::runtime_error("Could not create descriptor pool.");
+        if (!setup.descriptorAllocator) {
+            throw std::runtime_error("Tried to create descriptor sets without providing a descriptor allocator in the setup.");
         }
 
-        return newDescriptorPool;
-    }
-
+        std::vector<VkDescriptorSet> newDescriptorSets(setup.config.framesInFlight);
 
-
-    std::vector<VkDescriptorSet> create_descriptor_sets(const InstanceSetup &setup) {
-        std::vector<VkDescriptorSetLayout> newLayouts(MAX_FRAMES_IN_FLIGHT, setup.uniformLayout.value());
-        
-        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
-        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        descriptorSetAllocateInfo.descriptorPool = setup.descriptorPool.value();
-        descriptorSetAllocateInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-        descriptorSetAllocateInfo.pSetLayouts = newLayouts.data();
-        
-        std::vector<VkDescriptorSet> newDescriptorSets(MAX_FRAMES_IN_FLIGHT);
-
-        if (vkAllocateDescriptorSets(setup.logicalDevice.value(), &descriptorSetAllocateInfo, newDescriptorSets.data()) != VK_SUCCESS) {
-            throw std::runtime_error("Couldn't allocate descriptor sets.");
+        for (VkDescriptorSet &descriptorSet : newDescriptorSets) {
+            descriptorSet = setup.descriptorAllocator->allocate(setup.uniformLayout.value());
         }
 
         for (size_t i = 0; i != newDescriptorSets.size(); ++i) {
@@ -1788,7 +2044,9 @@ namespace fhope {
             descriptorImageInfo.imageView = setup.textureView.value();
             descriptorImageInfo.sampler = setup.textureSampler.value();
 
-            std::array<VkWriteDescriptorSet, 2> writeInfos{};
+            VkDescriptorBufferInfo instanceBufferInfo = setup.instances->get_descriptor_info(static_cast<uint32_t>(i));
+
+            std::array<VkWriteDescriptorSet, 3> writeInfos{};
 
             writeInfos[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             writeInfos[0].dstSet = newDescriptorSets[i];
@@ -1805,6 +2063,14 @@ namespace fhope {
             writeInfos[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
             writeInfos[1].descriptorCount = 1;
             writeInfos[1].pImageInfo = &descriptorImageInfo;
+
+            writeInfos[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeInfos[2].dstSet = newDescriptorSets[i];
+            writeInfos[2].dstBinding = INSTANCE_BUFFER_BINDING;
+            writeInfos[2].dstArrayElement = 0;
+            writeInfos[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writeInfos[2].descriptorCount = 1;
+            writeInfos[2].pBufferInfo = &instanceBufferInfo;
             
             vkUpdateDescriptorSets(setup.logicalDevice.value(), static_cast<uint32_t>(writeInfos.size()), writeInfos.data(), 0, nullptr);
         }
@@ -1815,6 +2081,8 @@ namespace fhope {
 
     
     std::vector<VkCommandBuffer> create_command_buffers(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create a command buffer without providing a logical device in the setup.");
         }
@@ -1823,7 +2091,7 @@ namespace fhope {
             throw std::runtime_error("Tried to create a command buffer without providing command pools in the buffer.");
         }
 
-        std::vector<VkCommandBuffer> newCommandBuffers(MAX_FRAMES_IN_FLIGHT);
+        std::vector<VkCommandBuffer> newCommandBuffers(setup.config.framesInFlight);
 
         VkCommandBufferAllocateInfo commandBufferAllocationInfo{};
         commandBufferAllocationInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1841,15 +2109,17 @@ namespace fhope {
 
 
     BaseSyncObjects create_base_sync_objects(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
         if (!setup.logicalDevice.has_value()) {
             throw std::runtime_error("Tried to create base sync objects without providing a logical device in the setup");
         }
 
         BaseSyncObjects newSyncObjects{};
 
-        newSyncObjects.imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        newSyncObjects.renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        newSyncObjects.inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+        newSyncObjects.imageAvailableSemaphores.resize(setup.config.framesInFlight);
+        newSyncObjects.renderFinishedSemaphores.resize(setup.config.framesInFlight);
+        newSyncObjects.inFlightFences.resize(setup.config.framesInFlight);
         
         VkSemaphoreCreateInfo semaphoreCreateInfo{};
         semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1858,7 +2128,7 @@ namespace fhope {
         fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-        for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i) {
+        for (size_t i = 0; i != setup.config.framesInFlight; ++i) {
             if (vkCreateSemaphore(setup.logicalDevice.value(), &semaphoreCreateInfo, nullptr, &newSyncObjects.imageAvailableSemaphores[i]) != VK_SUCCESS) {
                 throw std::runtime_error("Couldn't create `image available` semaphore.");
             }
@@ -1880,6 +2150,25 @@ namespace fhope {
      *----------------------------*/
 
     void clean_setup(const InstanceSetup &setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        // Pending loads may still submit uploads or add textures : they complete before anything is destroyed
+        setup.async->destroy();
+
+#ifdef FHOPE_RUNTIME_SHADERS
+        if (setup.shaderReload) {
+            setup.shaderReload->destroy();
+        }
+#endif
+
+        setup.assets->destroy(setup);
+        setup.deletions->flush();
+
+        destroy_frame_contexts(setup.logicalDevice.value(), setup.frameContexts);
+
+        if (setup.profiler) {
+            setup.profiler->destroy();
+        }
 
         for (const VkSemaphore &semaphore : setup.syncObjects.value().imageAvailableSemaphores) {
             vkDestroySemaphore(setup.logicalDevice.value(), semaphore, nullptr);
@@ -1898,35 +2187,43 @@ namespace fhope {
 
         cleanup_swap_chain(setup);
 
-        vkDestroySampler(setup.logicalDevice.value(), setup.textureSampler.value(), nullptr);
-        vkDestroyImageView(setup.logicalDevice.value(), setup.textureView.value(), nullptr);
+        setup.samplers->destroy();
 
-        vkDestroyImage(setup.logicalDevice.value(), setup.texture.value().texture, nullptr);
-        vkFreeMemory(setup.logicalDevice.value(), setup.texture.value().memory, nullptr);
-        
         for (const WrappedBuffer &uniformBuffer : setup.uniformBuffers) {
             vkDestroyBuffer(setup.logicalDevice.value(), uniformBuffer.buffer, nullptr);
             vkFreeMemory(setup.logicalDevice.value(), uniformBuffer.memory, nullptr);
         }
 
-        vkDestroyDescriptorPool(setup.logicalDevice.value(), setup.descriptorPool.value(), nullptr);
+        setup.instances->destroy();
+
+        if (setup.culling) {
+            setup.culling->destroy();
+        }
 
-        vkDestroyDescriptorSetLayout(setup.logicalDevice.value(), setup.uniformLayout.value(), nullptr);
+        if (setup.textures) {
+            setup.textures->destroy();
+        }
 
-        vkDestroyBuffer(setup.logicalDevice.value(), setup.indexBuffer.value().buffer, nullptr);
-        vkFreeMemory(setup.logicalDevice.value(), setup.indexBuffer.value().memory, nullptr);
+        setup.descriptorAllocator->destroy();
 
-        vkDestroyBuffer(setup.logicalDevice.value(), setup.vertexBuffer.value().buffer, nullptr);
-        vkFreeMemory(setup.logicalDevice.value(), setup.vertexBuffer.value().memory, nullptr);
+        for (const std::unique_ptr<DescriptorAllocator> &allocator : setup.transientDescriptorAllocators) {
+            allocator->destroy();
+        }
+
+        setup.descriptorLayouts->destroy();
+
+        setup.geometry->destroy();
 
         vkDestroyPipeline(setup.logicalDevice.value(), setup.graphicsPipelineConfig.value().pipeline, nullptr);
         vkDestroyPipelineLayout(setup.logicalDevice.value(), setup.graphicsPipelineConfig.value().pipelineLayout, nullptr);
         
-        vkDestroyRenderPass(setup.logicalDevice.value(), setup.graphicsPipelineConfig.value().renderPass, nullptr);
-        
+        setup.pipelineCache->destroy();
+
         vkDestroyDevice(setup.logicalDevice.value(), nullptr);
 
-        vkDestroySurfaceKHR(setup.instance, setup.surface.value(), nullptr);
+        if (setup.surface.has_value()) {
+            vkDestroySurfaceKHR(setup.instance, setup.surface.value(), nullptr);
+        }
 
         if (setup.debugMessenger.has_value()) {
             vkDestroyDebugUtilsMessengerEXT(setup.instance, setup.debugMessenger.value(), nullptr);
@@ -1938,51 +2235,156 @@ namespace fhope {
 
 
     void cleanup_swap_chain(const InstanceSetup &setup) {
-        for (const VkFramebuffer &framebuffer : setup.swapChainFramebuffers) {
-            vkDestroyFramebuffer(setup.logicalDevice.value(), framebuffer, nullptr);
-        }
+        FHOPE_TRACE_FUNCTION();
+
+        // Framebuffers, render pass and transient attachments
+        setup.frameGraph.value().graph->destroy(setup);
 
         for (const VkImageView &imageView : setup.swapChainImageViews) {
             vkDestroyImageView(setup.logicalDevice.value(), imageView, nullptr);
         }
 
-        vkDestroyImageView(setup.logicalDevice.value(), setup.depthBuffer.value().view, nullptr);
-        vkDestroyImage(setup.logicalDevice.value(), setup.depthBuffer.value().image.texture, nullptr);
-        vkFreeMemory(setup.logicalDevice.value(), setup.depthBuffer.value().image.memory, nullptr);
+        if (setup.depthBuffer.has_value()) {
+            vkDestroyImageView(setup.logicalDevice.value(), setup.depthBuffer.value().view, nullptr);
+            vkDestroyImage(setup.logicalDevice.value(), setup.depthBuffer.value().image.texture, nullptr);
+            vkFreeMemory(setup.logicalDevice.value(), setup.depthBuffer.value().image.memory, nullptr);
+        }
 
-        vkDestroyImageView(setup.logicalDevice.value(), setup.colorImage.value().imageView, nullptr);
-        vkDestroyImage(setup.logicalDevice.value(), setup.colorImage.value().image.texture, nullptr);
-        vkFreeMemory(setup.logicalDevice.value(), setup.colorImage.value().image.memory, nullptr);
+        for (const WrappedTexture &offscreenImage : setup.offscreenImages) {
+            vkDestroyImage(setup.logicalDevice.value(), offscreenImage.texture, nullptr);
+            vkFreeMemory(setup.logicalDevice.value(), offscreenImage.memory, nullptr);
+        }
 
-        vkDestroySwapchainKHR(setup.logicalDevice.value(), setup.swapChain.value(), nullptr);
+        if (setup.swapChain.has_value()) {
+            vkDestroySwapchainKHR(setup.logicalDevice.value(), setup.swapChain.value(), nullptr);
+        }
     }
 
     /*----------------------------*
      *- FUNCTIONS: Setup drawing -*
      *----------------------------*/
 
-    void draw_frame(InstanceSetup *setup, GLFWwindow *window, size_t *currentFrame) {
-        if (!setup->logicalDevice.has_value()) {
-            throw std::runtime_error("Tried to draw a frame without providing a logical device in the setup.");
+    static void update_frame_matrices(InstanceSetup *setup, FrameContext *frame) {
+        setup->mvp.set_model(compute_model_animation());
+
+        // The slot's uniform buffer is only rewritten when a matrix changed since it was last written there
+        if (frame->uniformVersion != setup->mvp.get_version()) {
+            write_uniform_buffer(&setup->mvp, frame->uniformMapping, frame->uniformSize);
+            frame->uniformVersion = setup->mvp.get_version();
         }
+    }
 
-        if (!setup->syncObjects.has_value()) {
-            throw std::runtime_error("Tried to draw a frame without providing sync objects in the setup.");
+
+
+    static void upload_instances(InstanceSetup *setup, FrameContext *frame) {
+        // Only the subtrees changed since the last frame are recomputed and pushed to their instances
+        setup->scene->update();
+        setup->scene->sync_instances(setup->instances.get());
+
+        // A grown buffer has been rebound in the frame's descriptor set, which invalidates command buffers binding it
+        if (setup->instances->upload(*setup, frame->index, frame->descriptorSet)) {
+            ++setup->sceneVersion;
+
+            if (setup->culling) {
+                setup->culling->rebind_instances(frame->index, setup->instances->get_descriptor_info(frame->index));
+            }
         }
 
-        if (!setup->swapChain.has_value()) {
-            throw std::runtime_error("Tried to draw a frame without providing a swap chain in the setup.");
+        if (setup->culling) {
+            // One object per instance of the model : the table only changes with the instance count
+            if (setup->culling->size() != setup->instances->size()) {
+                std::vector<GpuObject> objects(setup->instances->size());
+
+                const MeshRange &mesh = setup->geometry->get_mesh(setup->modelMesh.value());
+
+                for (uint32_t i = 0; i != objects.size(); ++i) {
+                    objects[i] = { mesh.boundingSphere, mesh.indexCount, mesh.firstIndex, mesh.vertexOffset, i };
+                }
+
+                setup->culling->set_objects(std::move(objects));
+            }
+
+            if (setup->culling->upload(*setup, frame->index)) {
+                ++setup->sceneVersion;
+            }
         }
-        
-        if (!setup->graphicsQueue.has_value()) {
-            throw std::runtime_error("Tried to draw a frame without providing a graphics queue in the setup.");
+
+        // The instance count is baked in recorded draws
+        if (setup->drawItems[0].instanceCount != setup->instances->size()) {
+            setup->drawItems[0].instanceCount = setup->instances->size();
+            ++setup->sceneVersion;
+        }
+    }
+
+
+
+    static VkCommandBuffer record_current_frame(InstanceSetup *setup, FrameContext *frame, uint32_t imageIndex) {
+        const DeviceContext &device = *setup->deviceContext;
+
+        VkCommandBuffer commandBuffer = frame->primary;
+
+        if (setup->config.recordingMode == RecordingMode::Cached) {
+            // Static content : only re-record this image's buffer if something changed since it was recorded
+            commandBuffer = frame->cachedPrimaries[imageIndex];
+
+            if (frame->cachedVersions[imageIndex] != setup->sceneVersion) {
+                vkResetCommandBuffer(commandBuffer, NULL);
+                record_frame(device, frame, commandBuffer, imageIndex, setup->drawItems, nullptr, setup->profiler.get(), setup->culling.get());
+                frame->cachedVersions[imageIndex] = setup->sceneVersion;
+            }
+        } else {
+            vkResetCommandBuffer(commandBuffer, NULL);
+            record_frame(device, frame, commandBuffer, imageIndex, setup->drawItems, setup->recorder.get(), setup->profiler.get(), setup->culling.get());
         }
 
-        vkWaitForFences(setup->logicalDevice.value(), 1, &setup->syncObjects.value().inFlightFences[*currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        return commandBuffer;
+    }
+
+
+
+    void draw_frame(InstanceSetup *setup, GLFWwindow *window, size_t *currentFrame) {
+        FHOPE_TRACE_FUNCTION();
+
+        setup->async->pump();
+
+#ifdef FHOPE_RUNTIME_SHADERS
+        if (setup->shaderReload) {
+            setup->shaderReload->update(setup);
+        }
+#endif
+
+        setup->pipelineCache->update(setup);
+
+        // Contexts have been validated when created : the hot path only reads raw handles
+        const DeviceContext &device = *setup->deviceContext;
+        FrameContext &frame = setup->frameContexts[*currentFrame];
+
+        // Input has been sampled by the caller just before drawing, unless in low latency mode
+        std::chrono::steady_clock::time_point inputSampleTime = std::chrono::steady_clock::now();
+
+        if (setup->config.lowLatency) {
+            // Drain the previous frame : the GPU will start on this one as soon as it is submitted, with fresh input
+            FrameContext &previousFrame = setup->frameContexts[(*currentFrame + setup->frameContexts.size() - 1) % setup->frameContexts.size()];
+
+            vkWaitForFences(device.device, 1, &previousFrame.inFlight, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            measure_frame_latency(&setup->latency, &previousFrame);
+        }
+
+        vkWaitForFences(device.device, 1, &frame.inFlight, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        measure_frame_latency(&setup->latency, &frame);
+
+        if (setup->profiler) {
+            setup->profiler->collect(frame.index);
+        }
+
+        setup->deletions->collect(frame.index);
+
+        // Nothing reads the slot's transient sets anymore
+        setup->transientDescriptorAllocators[frame.index]->reset();
         
         
         uint32_t imageIndex;
-        VkResult swapChainStatus = vkAcquireNextImageKHR(setup->logicalDevice.value(), setup->swapChain.value(), std::numeric_limits<uint64_t>::max(), setup->syncObjects.value().imageAvailableSemaphores[*currentFrame], VK_NULL_HANDLE, &imageIndex);
+        VkResult swapChainStatus = vkAcquireNextImageKHR(device.device, device.swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
         
         if (swapChainStatus == VK_ERROR_OUT_OF_DATE_KHR || swapChainStatus == VK_SUBOPTIMAL_KHR) {
             recreate_swap_chain(setup, window);
@@ -1991,19 +2393,24 @@ namespace fhope {
             throw std::runtime_error("Failed to acquire next swapchain image.");
         }
 
-        update_uniform_buffer(*setup, *currentFrame);
-        
-        vkResetFences(setup->logicalDevice.value(), 1, &setup->syncObjects.value().inFlightFences[*currentFrame]);
+        if (setup->config.lowLatency) {
+            // Late latching : input is sampled once the swap chain image is available, right before it is used
+            glfwPollEvents();
+            inputSampleTime = std::chrono::steady_clock::now();
+        }
 
-        vkResetCommandBuffer(setup->commandBuffers[*currentFrame], NULL);
+        update_frame_matrices(setup, &frame);
+        upload_instances(setup, &frame);
+        
+        vkResetFences(device.device, 1, &frame.inFlight);
 
-        record_command_buffer(*setup, setup->commandBuffers[*currentFrame], imageIndex, *currentFrame);
+        VkCommandBuffer commandBuffer = record_current_frame(setup, &frame, imageIndex);
         
         
-        VkSemaphore          waitSemaphores[] = { setup->syncObjects.value().imageAvailableSemaphores[*currentFrame] };
+        VkSemaphore          waitSemaphores[] = { frame.imageAvailable };
         VkPipelineStageFlags waitStages[]     = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
         
-        VkSemaphore signalSemaphore[] = { setup->syncObjects.value().renderFinishedSemaphores[*currentFrame] };
+        VkSemaphore signalSemaphore[] = { frame.renderFinished };
         
         
         VkSubmitInfo submitInfo{};
@@ -2012,23 +2419,31 @@ namespace fhope {
         submitInfo.pWaitSemaphores = &waitSemaphores[0];
         submitInfo.pWaitDstStageMask = &waitStages[0];
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &setup->commandBuffers[*currentFrame];
+        submitInfo.pCommandBuffers = &commandBuffer;
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = &signalSemaphore[0];
 
-        if (vkQueueSubmit(setup->graphicsQueue.value(), 1, &submitInfo, setup->syncObjects.value().inFlightFences[*currentFrame]) != VK_SUCCESS) {
+        if (vkQueueSubmit(device.graphicsQueue, 1, &submitInfo, frame.inFlight) != VK_SUCCESS) {
             throw std::runtime_error("Couldn't submit sync objects while drawing frame.");
         }
+
+        frame.inputSampleTime = inputSampleTime;
+
+        if (setup->profiler) {
+            setup->profiler->mark_submitted(frame.index);
+        }
+
+        setup->deletions->mark_submitted(frame.index);
         
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         presentInfo.waitSemaphoreCount = 1;
         presentInfo.pWaitSemaphores = &signalSemaphore[0];
         presentInfo.swapchainCount = 1;
-        presentInfo.pSwapchains = &setup->swapChain.value();
+        presentInfo.pSwapchains = &device.swapChain;
         presentInfo.pImageIndices = &imageIndex;
         
-        VkResult queueStatus = vkQueuePresentKHR(setup->graphicsQueue.value(), &presentInfo);
+        VkResult queueStatus = vkQueuePresentKHR(device.graphicsQueue, &presentInfo);
 
         if (queueStatus == VK_ERROR_OUT_OF_DATE_KHR ||queueStatus == VK_SUBOPTIMAL_KHR) {
             recreate_swap_chain(setup, window);
@@ -2036,12 +2451,139 @@ namespace fhope {
             throw std::runtime_error("Failed to acquire next swapchain image.");
         }
 
-        *currentFrame = (*currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        *currentFrame = (*currentFrame + 1) % setup->frameContexts.size();
+    }
+
+
+
+    void draw_offscreen_frame(InstanceSetup *setup, size_t *currentFrame) {
+        FHOPE_TRACE_FUNCTION();
+
+        setup->async->pump();
+
+#ifdef FHOPE_RUNTIME_SHADERS
+        if (setup->shaderReload) {
+            setup->shaderReload->update(setup);
+        }
+#endif
+
+        setup->pipelineCache->update(setup);
+
+        const DeviceContext &device = *setup->deviceContext;
+        FrameContext &frame = setup->frameContexts[*currentFrame];
+
+        vkWaitForFences(device.device, 1, &frame.inFlight, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        measure_frame_latency(&setup->latency, &frame);
+
+        if (setup->profiler) {
+            setup->profiler->collect(frame.index);
+        }
+
+        setup->deletions->collect(frame.index);
+
+        // Nothing reads the slot's transient sets anymore
+        setup->transientDescriptorAllocators[frame.index]->reset();
+
+        // Nothing to acquire : each frame slot owns the offscreen image of the same index
+        uint32_t imageIndex = frame.index;
+
+        std::chrono::steady_clock::time_point inputSampleTime = std::chrono::steady_clock::now();
+
+        update_frame_matrices(setup, &frame);
+        upload_instances(setup, &frame);
+
+        vkResetFences(device.device, 1, &frame.inFlight);
+
+        VkCommandBuffer commandBuffer = record_current_frame(setup, &frame, imageIndex);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        if (vkQueueSubmit(device.graphicsQueue, 1, &submitInfo, frame.inFlight) != VK_SUCCESS) {
+            throw std::runtime_error("Couldn't submit offscreen frame.");
+        }
+
+        frame.inputSampleTime = inputSampleTime;
+
+        if (setup->profiler) {
+            setup->profiler->mark_submitted(frame.index);
+        }
+
+        setup->deletions->mark_submitted(frame.index);
+
+        *currentFrame = (*currentFrame + 1) % setup->frameContexts.size();
+    }
+
+
+
+    FrameTimeStats run_headless_benchmark(InstanceSetup *setup, uint32_t frameCount) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (!setup->config.headless) {
+            throw std::runtime_error("Tried to run a headless benchmark on a setup generated with a window.");
+        }
+
+        std::vector<double> frameTimes;
+        frameTimes.reserve(frameCount);
+
+        size_t currentFrame(0);
+        std::chrono::steady_clock::time_point previous = std::chrono::steady_clock::now();
+
+        // Once frames in flight are saturated, each iteration waits for a GPU frame : iterations measure the frame rate the CPU and GPU sustain together
+        for (uint32_t i = 0; i != frameCount; ++i) {
+            draw_offscreen_frame(setup, &currentFrame);
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(now - previous).count());
+            previous = now;
+        }
+
+        vkDeviceWaitIdle(setup->logicalDevice.value());
+
+        return compute_frame_time_stats(std::move(frameTimes));
+    }
+
+
+
+    FrameTimeStats compute_frame_time_stats(std::vector<double> frameTimes) {
+        FrameTimeStats stats{};
+
+        if (frameTimes.empty()) {
+            return stats;
+        }
+
+        std::sort(frameTimes.begin(), frameTimes.end());
+
+        auto percentile = [&](double fraction) {
+            size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(frameTimes.size())));
+            return frameTimes[std::clamp<size_t>(rank, 1, frameTimes.size()) - 1];
+        };
+
+        double total(0.0);
+        for (double frameTime : frameTimes) {
+            total += frameTime;
+        }
+
+        stats.frameCount = static_cast<uint32_t>(frameTimes.size());
+        stats.minMilliseconds = frameTimes.front();
+        stats.meanMilliseconds = total / static_cast<double>(frameTimes.size());
+        stats.p50Milliseconds = percentile(0.50);
+        stats.p99Milliseconds = percentile(0.99);
+        stats.maxMilliseconds = frameTimes.back();
+
+        return stats;
     }
 
 
 
     void recreate_swap_chain(InstanceSetup *setup, GLFWwindow *window) {
+        FHOPE_TRACE_FUNCTION();
+
+        // Pipelines may be being built on workers with the render pass about to be destroyed
+        setup->async->drain();
+
         vkDeviceWaitIdle(setup->logicalDevice.value());
 
         std::cerr << "Recreating swap chain" << std::endl;
@@ -2053,135 +2595,101 @@ namespace fhope {
         setup->swapChain.emplace(create_swap_chain(*setup, window));
         setup->swapChainImages = retrieve_swap_chain_images(*setup);
         setup->swapChainImageViews = create_swap_chain_image_views(*setup);
-        setup->depthBuffer = create_depth_buffer(*setup);
-        setup->colorImage = create_color_image(*setup);
-        setup->swapChainFramebuffers = create_framebuffers(*setup);
-    }
 
+        if (setup->config.gpuCulling) {
+            setup->depthBuffer = create_depth_buffer(*setup);
+        }
 
+        // Same formats and sample counts : the graphics pipeline stays compatible with the new render pass
+        setup->frameGraph.emplace(create_frame_graph(*setup));
+        setup->graphicsPipelineConfig.value().renderPass = setup->frameGraph.value().graph->get_render_pass(setup->frameGraph.value().forwardPass);
 
-    void update_uniform_buffer(const InstanceSetup &setup, size_t frame) {
-        if (!setup.swapChainConfig.has_value()) {
-            throw std::runtime_error("Tried to update a uniform buffer without providing a swapchain config in the setup.");
+        setup->deviceContext.emplace(create_device_context(*setup));
+        setup->mvp.set_projection(compute_projection(setup->swapChainConfig.value().extent));
+
+        if (setup->culling) {
+            setup->culling->resize(*setup);
         }
 
-        if (setup.uniformBuffers.size() <= frame) {
+        if (setup->config.recordingMode == RecordingMode::Cached) {
+            allocate_cached_command_buffers(*setup, &setup->frameContexts);
+        }
+
+        ++setup->sceneVersion;
+    }
+
+
+
+    void update_uniform_buffer(InstanceSetup *setup, size_t frame) {
+        FHOPE_TRACE_FUNCTION();
+
+        if (setup->uniformBuffers.size() <= frame) {
             throw std::runtime_error("Tried to update a uniform buffer too far in the array provided in the setup");
         }
 
-        if (!setup.uniformBuffers[frame].mapping.has_value()) {
+        if (!setup->uniformBuffers[frame].mapping.has_value()) {
             throw std::runtime_error("Tried to update a uniform buffer without providing it's memory mapping in the setup.");
         }
 
-        static auto startTime = std::chrono::high_resolution_clock::now();
+        write_uniform_buffer(&setup->mvp, setup->uniformBuffers[frame].mapping.value(), setup->uniformBuffers[frame].sizeInBytes);
+    }
 
-        auto currentTime = std::chrono::high_resolution_clock::now();
 
-        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-        UniformBufferObject ubo{};
-        ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        ubo.view  = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        ubo.projection = glm::perspective(glm::radians(45.0f), setup.swapChainConfig.value().extent.width / (float)setup.swapChainConfig.value().extent.height, 0.01f, 99999.9f);
+    glm::mat4 compute_projection(const VkExtent2D &extent) {
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), extent.width / (float)extent.height, 0.01f, 99999.9f);
 
-        ubo.projection[1][1] *= -1;
+        projection[1][1] *= -1;
 
-        memcpy_s(setup.uniformBuffers[frame].mapping.value(), setup.uniformBuffers[frame].sizeInBytes, &ubo, sizeof(ubo));
+        return projection;
     }
 
 
 
-    void record_command_buffer(const InstanceSetup &setup, const VkCommandBuffer &commandBuffer, uint32_t imageIndex, size_t currentFrame) {
-        if (!setup.graphicsPipelineConfig.has_value()) {
-            throw std::runtime_error("Tried to record a command buffer without providing a graphics pipeline to the setup.");
-        }
-
-        if (!setup.swapChainConfig.has_value()) {
-            throw std::runtime_error("Tried to record a command buffer without providing a swap chain config in the setup.");
-        }
-
-        if (!setup.vertexBuffer.has_value()) {
-            throw std::runtime_error("Tried to record a command buffer without providing a vertex buffer in the setup.");
-        }
+    glm::mat4 compute_model_animation() {
+        static auto startTime = std::chrono::high_resolution_clock::now();
 
-        if (!setup.indexBuffer.has_value()) {
-            throw std::runtime_error("Tried to record a command buffer without providing an index buffer in the setup.");
-        }
+        auto currentTime = std::chrono::high_resolution_clock::now();
 
-        VkCommandBufferBeginInfo commandBufferBeginInfo{};
-        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-        if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("Couldn't record command buffer (beginning).");
-        }
+        return glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    }
 
-        std::array<VkClearValue, 2> clearColors;
-        clearColors[0].color = {{0.8f, 0.0f, 0.8f, 1.0f}};
-        clearColors[1].depthStencil = {1.0f, 0};
 
-        VkRenderPassBeginInfo renderPassBeginInfo{};
-        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassBeginInfo.renderPass = setup.graphicsPipelineConfig.value().renderPass;
-        renderPassBeginInfo.framebuffer = setup.swapChainFramebuffers[imageIndex];
-        renderPassBeginInfo.renderArea.extent = setup.swapChainConfig.value().extent;
-        renderPassBeginInfo.renderArea.offset = { 0, 0 };
-        renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearColors.size());
-        renderPassBeginInfo.pClearValues = clearColors.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    MVP create_camera(const VkExtent2D &extent) {
+        return MVP(glm::mat4(1.0f), glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)), compute_projection(extent));
+    }
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, setup.graphicsPipelineConfig.value().pipeline);
 
-        VkBuffer     vertexBuffers[] = { setup.vertexBuffer.value().buffer };
-        VkDeviceSize offsets[]       = { 0 };
 
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffers[0], &offsets[0]);
+    UniformBufferObject compute_uniform_buffer_object(MVP *mvp) {
+        UniformBufferObject ubo{};
+        ubo.model               = mvp->get_model();
+        ubo.view                = mvp->get_view();
+        ubo.projection          = mvp->get_projection();
+        ubo.modelViewProjection = mvp->get_mvp();
 
-        vkCmdBindIndexBuffer(commandBuffer, setup.indexBuffer.value().buffer, 0, VK_INDEX_TYPE_UINT32);
+        return ubo;
+    }
 
-        // TODO: avoid rpeating it again by storing them somewhere ?
-            VkViewport viewport{};
-            viewport.x = 0.0f;
-            viewport.y = 0.0f;
-            viewport.width = static_cast<float>(setup.swapChainConfig.value().extent.width);
-            viewport.height = static_cast<float>(setup.swapChainConfig.value().extent.height);
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
-            VkRect2D scissor{};
-            scissor.offset = {0, 0};
-            scissor.extent = setup.swapChainConfig.value().extent;
-        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-        // END TODO
 
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, setup.graphicsPipelineConfig.value().pipelineLayout, 0, 1, &setup.descriptorSets[currentFrame], 0, nullptr);
+    void write_uniform_buffer(MVP *mvp, void *mapping, VkDeviceSize sizeInBytes) {
+        FHOPE_TRACE_FUNCTION();
 
-        vkCmdDrawIndexed(commandBuffer, setup.indexCount.value(), 1, 0, 0, 0);
-    
-        vkCmdEndRenderPass(commandBuffer);
+        UniformBufferObject ubo = compute_uniform_buffer_object(mvp);
 
-        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to record command buffer (end)");
-        }
+        memcpy_s(mapping, sizeInBytes, &ubo, sizeof(ubo));
     }
 
     /*---------------------*
      *- FUNCTIONS: helper -*
      *---------------------*/
 
-    LoadedModel load_model(const std::string &filename) {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-
-        std::string warning;
-        std::string error;
-
-        if (tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, filename.c_str())) {
-            std::cout << "[TINYOBJ]: " + warning + error;
-        }
-
+    // Deduplicates the vertices of every shape of a parsed model
+    static LoadedModel build_model(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes) {
         LoadedModel newModel{};
 
         std::unordered_map<Vertex3D, uint32_t> uniqueVertices{};
@@ -2219,7 +2727,102 @@ namespace fhope {
 
 
 
+    LoadedModel load_model(const std::string &filename) {
+        FHOPE_TRACE_FUNCTION();
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+
+        std::string warning;
+        std::string error;
+
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, filename.c_str())) {
+            throw std::runtime_error("Could not load model `" + filename + "` : [" + warning + error + "]");
+        }
+
+        if (!warning.empty()) {
+            std::cout << "[TINYOBJ]: " + warning;
+        }
+
+        return build_model(attrib, shapes);
+    }
+
+
+
+    LoadedModel parse_model(const std::vector<char> &contents, const std::string &name) {
+        FHOPE_TRACE_FUNCTION();
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+
+        std::string warning;
+        std::string error;
+
+        std::istringstream stream(std::string(contents.begin(), contents.end()));
+
+        // Material libraries are not resolved without a file path : materials are unused anyway
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, &stream)) {
+            throw std::runtime_error("Could not parse model `" + name + "` : [" + warning + error + "]");
+        }
+
+        if (!warning.empty()) {
+            std::cout << "[TINYOBJ]: " + warning;
+        }
+
+        return build_model(attrib, shapes);
+    }
+
+
+
+    DecodedImage decode_image(const std::string &filename) {
+        FHOPE_TRACE_FUNCTION();
+
+        DecodedImage image{};
+        int channels;
+
+        stbi_uc *imageData = stbi_load(filename.c_str(), &image.width, &image.height, &channels, STBI_rgb_alpha);
+
+        if (!imageData) {
+            throw std::runtime_error("Could not load image data from `" + filename + "`.");
+        }
+
+        // Always RGBA, whatever the file's amount of channels
+        image.pixels.assign(imageData, imageData + static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * STBI_rgb_alpha);
+
+        stbi_image_free(imageData);
+
+        return image;
+    }
+
+
+
+    DecodedImage decode_image(const std::vector<char> &contents, const std::string &name) {
+        FHOPE_TRACE_FUNCTION();
+
+        DecodedImage image{};
+        int channels;
+
+        stbi_uc *imageData = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(contents.data()), static_cast<int>(contents.size()), &image.width, &image.height, &channels, STBI_rgb_alpha);
+
+        if (!imageData) {
+            throw std::runtime_error("Could not decode image data from `" + name + "`.");
+        }
+
+        // Always RGBA, whatever the file's amount of channels
+        image.pixels.assign(imageData, imageData + static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * STBI_rgb_alpha);
+
+        stbi_image_free(imageData);
+
+        return image;
+    }
+
+
+
     uint32_t find_memory_type(const VkPhysicalDevice &device, uint32_t typeFilter, const VkMemoryPropertyFlags &properties) {
+        FHOPE_TRACE_FUNCTION();
+
         VkPhysicalDeviceMemoryProperties memoryProperties;
         vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
         
@@ -2234,13 +2837,9 @@ namespace fhope {
 
 
 
-    shaderc::SpvCompilationResult compile_shader(const std::string &filename, const shaderc_shader_kind &shaderKind) {
-        shaderc::Compiler compiler;
-
-        shaderc::CompileOptions options;
-
-        options.SetTargetEnvironment(shaderc_target_env::shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
-        options.SetSourceLanguage(shaderc_source_language_glsl);
+#ifdef FHOPE_RUNTIME_SHADERS
+    std::vector<uint32_t> compile_shader(const std::string &filename, const shaderc_shader_kind &shaderKind, const std::map<std::string, std::string> &definitions) {
+        FHOPE_TRACE_FUNCTION();
 
         std::ifstream shaderFile(filename, std::ifstream::binary);
 
@@ -2256,13 +2855,49 @@ namespace fhope {
 
         fileContent.assign((std::istreambuf_iterator<char>(shaderFile)), std::istreambuf_iterator<char>());
 
-        shaderc::SpvCompilationResult compiled = compiler.CompileGlslToSpv(fileContent, shaderKind, filename.c_str(), options);
+        ShaderCompileOptions options{};
+        options.kind = shaderKind;
+        options.targetEnvironment = shaderc_target_env::shaderc_target_env_vulkan;
+        options.targetEnvironmentVersion = shaderc_env_version_vulkan_1_2;
+        options.sourceLanguage = shaderc_source_language_glsl;
+        options.definitions = definitions;
+
+        uint64_t cacheKey = get_shader_cache_key(fileContent, options);
+
+        if (std::optional<std::vector<uint32_t>> cached = load_cached_shader(cacheKey)) {
+            return std::move(cached.value());
+        }
+
+        std::vector<uint32_t> code = compile_glsl(fileContent, filename, options);
+
+        store_cached_shader(cacheKey, code);
+
+        return code;
+    }
+
+
+
+    std::vector<uint32_t> compile_glsl(const std::string &source, const std::string &name, const ShaderCompileOptions &options) {
+        FHOPE_TRACE_FUNCTION();
+
+        shaderc::Compiler compiler;
+
+        shaderc::CompileOptions compileOptions;
+
+        compileOptions.SetTargetEnvironment(options.targetEnvironment, options.targetEnvironmentVersion);
+        compileOptions.SetSourceLanguage(options.sourceLanguage);
+
+        for (const auto &[definitionName, value] : options.definitions) {
+            compileOptions.AddMacroDefinition(definitionName, value);
+        }
+
+        shaderc::SpvCompilationResult compiled = compiler.CompileGlslToSpv(source, options.kind, name.c_str(), compileOptions);
 
         if (compiled.GetCompilationStatus() != shaderc_compilation_status::shaderc_compilation_status_success) {
-            throw std::runtime_error("Couldn't compile shader `" + filename + "` : [" + compiled.GetErrorMessage() + "]");
+            throw std::runtime_error("Couldn't compile shader `" + name + "` : [" + compiled.GetErrorMessage() + "]");
         }
 
-        std::vector<uint32_t> code(compiled.begin(), compiled.end());
-        return compiled;
+        return std::vector<uint32_t>(compiled.cbegin(), compiled.cend());
     }
+#endif
 }
@@ -0,0 +1,183 @@
+#include "shader-cache.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifndef FHOPE_SHADER_COMPILER_VERSION
+    #define FHOPE_SHADER_COMPILER_VERSION "unknown"
+#endif
+
+namespace fhope {
+    /***************
+     ** CONSTANTS **
+     ***************/
+
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203; ///< First word of every SPIR-V module
+
+    static constexpr const char *SHADER_COMPILER_VERSION = FHOPE_SHADER_COMPILER_VERSION; ///< Revisions of shaderc and glslang the binaries are built with (see CMakeLists.txt)
+
+    /*************
+     ** HELPERS **
+     *************/
+
+    // FNV-1a, fed field by field
+    static void hash_bytes(uint64_t *hash, const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+        for (size_t i = 0; i < size; ++i) {
+            *hash ^= bytes[i];
+            *hash *= 1099511628211ull;
+        }
+    }
+
+
+
+    // Sizes are hashed before strings : concatenations of different strings never collide
+    static void hash_string(uint64_t *hash, const std::string &value) {
+        uint64_t size = value.size();
+
+        hash_bytes(hash, &size, sizeof(size));
+        hash_bytes(hash, value.data(), value.size());
+    }
+
+
+
+    static unsigned long get_process_id() {
+#ifdef _WIN32
+        return static_cast<unsigned long>(_getpid());
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
+    }
+
+
+
+    static std::filesystem::path get_cache_path(uint64_t key) {
+        char filename[32];
+        std::snprintf(filename, sizeof(filename), "%016llx.spv", static_cast<unsigned long long>(key));
+
+        return std::filesystem::path(SHADER_CACHE_DIRECTORY) / filename;
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    uint64_t get_shader_cache_key(const std::string &source, const ShaderCompileOptions &options) {
+        return get_shader_cache_key(source, options, SHADER_COMPILER_VERSION);
+    }
+
+
+
+    uint64_t get_shader_cache_key(const std::string &source, const ShaderCompileOptions &options, const std::string &compilerVersion) {
+        FHOPE_TRACE_FUNCTION();
+
+        uint64_t hash = 14695981039346656037ull;
+
+        unsigned int spirvVersion(0), spirvRevision(0);
+        shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+
+        uint32_t fields[] = {
+            SHADER_CACHE_FORMAT,
+            spirvVersion,
+            spirvRevision,
+            static_cast<uint32_t>(options.kind),
+            static_cast<uint32_t>(options.targetEnvironment),
+            options.targetEnvironmentVersion,
+            static_cast<uint32_t>(options.sourceLanguage)
+        };
+
+        hash_bytes(&hash, fields, sizeof(fields));
+
+        // Compilers of a same SPIR-V version may still generate different code
+        hash_string(&hash, compilerVersion);
+
+        for (const auto &[name, value] : options.definitions) {
+            hash_string(&hash, name);
+            hash_string(&hash, value);
+        }
+
+        hash_string(&hash, source);
+
+        return hash;
+    }
+
+
+
+    std::optional<std::vector<uint32_t>> load_cached_shader(uint64_t key) {
+        FHOPE_TRACE_FUNCTION();
+
+        std::ifstream cacheFile(get_cache_path(key), std::ifstream::binary | std::ifstream::ate);
+
+        if (!cacheFile.is_open()) {
+            return std::nullopt;
+        }
+
+        std::streamsize size = cacheFile.tellg();
+
+        // Truncated or foreign files are treated as misses, and overwritten once compiled again
+        if (size < static_cast<std::streamsize>(sizeof(uint32_t)) || size % sizeof(uint32_t) != 0) {
+            return std::nullopt;
+        }
+
+        std::vector<uint32_t> code(static_cast<size_t>(size) / sizeof(uint32_t));
+
+        cacheFile.seekg(0, std::ios::beg);
+
+        if (!cacheFile.read(reinterpret_cast<char *>(code.data()), size) || code[0] != SPIRV_MAGIC) {
+            return std::nullopt;
+        }
+
+        return code;
+    }
+
+
+
+    void store_cached_shader(uint64_t key, const std::vector<uint32_t> &code) {
+        FHOPE_TRACE_FUNCTION();
+
+        std::error_code error;
+        std::filesystem::create_directories(SHADER_CACHE_DIRECTORY, error);
+
+        if (error) {
+            return;
+        }
+
+        std::filesystem::path cachePath = get_cache_path(key);
+
+        // Shaders are compiled concurrently (by jobs, and by other instances) : readers never see a partial file, and
+        // writers never share a temporary file (threads of different processes may have the same id)
+        std::ostringstream temporaryName;
+        temporaryName << cachePath.filename().string() << '.' << get_process_id() << '.' << std::hash<std::thread::id>{}(std::this_thread::get_id()) << ".tmp";
+
+        std::filesystem::path temporaryPath = cachePath.parent_path() / temporaryName.str();
+
+        {
+            std::ofstream temporaryFile(temporaryPath, std::ofstream::binary | std::ofstream::trunc);
+
+            if (!temporaryFile.write(reinterpret_cast<const char *>(code.data()), static_cast<std::streamsize>(code.size() * sizeof(uint32_t)))) {
+                temporaryFile.close();
+                std::filesystem::remove(temporaryPath, error);
+
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporaryPath, cachePath, error);
+
+        if (error) {
+            std::filesystem::remove(temporaryPath, error);
+        }
+    }
+}
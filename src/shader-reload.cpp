@@ -0,0 +1,238 @@
+#include "shader-reload.hpp"
+#include "setup.hpp"
+#include "trace.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fhope {
+    /*************
+     ** HELPERS **
+     *************/
+
+    /**
+     * @brief Tells wether or not a file is a GLSL source
+     *
+     * @param filename Name of the file
+     * @return true If the file has the .glsl extension
+     * @return false Otherwise
+     */
+    static bool is_shader_source(const std::filesystem::path &filename) {
+        return filename.extension() == ".glsl";
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+#ifdef __linux__
+    ShaderWatcher::ShaderWatcher(const std::filesystem::path &directory) : directory(directory.empty() ? std::filesystem::path(".") : directory), inotifyFd(-1) {
+        this->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (this->inotifyFd < 0) {
+            throw std::runtime_error(std::string("Failed to create an inotify instance : ") + std::strerror(errno) + ".");
+        }
+
+        // Editors either write in place or move a temporary file over the source
+        if (inotify_add_watch(this->inotifyFd, this->directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            int error = errno;
+            this->destroy();
+
+            throw std::runtime_error("Failed to watch shader directory '" + this->directory.string() + "' : " + std::strerror(error) + ".");
+        }
+    }
+
+
+
+    void ShaderWatcher::destroy() {
+        if (this->inotifyFd >= 0) {
+            close(this->inotifyFd);
+            this->inotifyFd = -1;
+        }
+    }
+
+
+
+    std::vector<std::string> ShaderWatcher::poll() {
+        std::vector<std::string> written;
+
+        if (this->inotifyFd < 0) {
+            return written;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+
+        while (true) {
+            ssize_t length = read(this->inotifyFd, buffer, sizeof(buffer));
+
+            // EAGAIN : nothing left to read
+            if (length <= 0) {
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+
+                if (event->len > 0 && is_shader_source(event->name)) {
+                    written.emplace_back(event->name);
+                }
+
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        return written;
+    }
+#else
+    ShaderWatcher::ShaderWatcher(const std::filesystem::path &directory) : directory(directory.empty() ? std::filesystem::path(".") : directory), lastScan(std::chrono::steady_clock::now()) {
+        std::error_code error;
+
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(this->directory, error)) {
+            if (is_shader_source(entry.path())) {
+                this->writeTimes[entry.path().filename().string()] = entry.last_write_time(error);
+            }
+        }
+
+        if (error) {
+            throw std::runtime_error("Failed to watch shader directory '" + this->directory.string() + "' : " + error.message() + ".");
+        }
+    }
+
+
+
+    void ShaderWatcher::destroy() {
+        this->writeTimes.clear();
+    }
+
+
+
+    std::vector<std::string> ShaderWatcher::poll() {
+        std::vector<std::string> written;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        if (now - this->lastScan < SHADER_SCAN_INTERVAL) {
+            return written;
+        }
+
+        this->lastScan = now;
+
+        // A source being written may briefly be missing : errors are retried on next scan
+        std::error_code error;
+
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(this->directory, error)) {
+            if (!is_shader_source(entry.path())) {
+                continue;
+            }
+
+            std::filesystem::file_time_type writeTime = entry.last_write_time(error);
+
+            if (error) {
+                continue;
+            }
+
+            std::string filename = entry.path().filename().string();
+            auto known = this->writeTimes.find(filename);
+
+            if (known == this->writeTimes.end() || known->second != writeTime) {
+                this->writeTimes[filename] = writeTime;
+                written.push_back(filename);
+            }
+        }
+
+        return written;
+    }
+#endif
+
+    ShaderHotReload::ShaderHotReload(const std::filesystem::path &directory) : watcher(directory), reloading(false), pendingChange(false) {}
+
+
+
+    void ShaderHotReload::destroy() {
+        this->watcher.destroy();
+    }
+
+
+
+    void ShaderHotReload::update(InstanceSetup *setup) {
+        FHOPE_TRACE_FUNCTION();
+
+        const GraphicsPipelineConfig &pipelineConfig = setup->graphicsPipelineConfig.value();
+
+        std::filesystem::path vertexShader = std::filesystem::path(pipelineConfig.vertexShaderFilename).filename();
+        std::filesystem::path fragmentShader = std::filesystem::path(pipelineConfig.fragmentShaderFilename).filename();
+
+        for (const std::string &filename : this->watcher.poll()) {
+            if (filename == vertexShader || filename == fragmentShader) {
+                this->pendingChange = true;
+            }
+        }
+
+        // Saves made during a reload are picked up once it completes
+        if (this->pendingChange && !this->reloading) {
+            this->pendingChange = false;
+            this->reloading = true;
+
+            setup->async->spawn(this->reload(setup));
+        }
+    }
+
+
+
+    Task<void> ShaderHotReload::reload(InstanceSetup *setup) {
+        AsyncScheduler &async = *setup->async;
+
+        // Render thread : everything the pipeline is built from is copied before leaving it
+        const GraphicsPipelineConfig &pipelineConfig = setup->graphicsPipelineConfig.value();
+
+        std::string vertexShaderFilename = pipelineConfig.vertexShaderFilename;
+        std::string fragmentShaderFilename = pipelineConfig.fragmentShaderFilename;
+        std::map<std::string, std::string> fragmentDefinitions = pipelineConfig.fragmentDefinitions;
+
+        GraphicsPipelineState state = get_graphics_pipeline_state(*setup, pipelineConfig);
+
+        VkPipeline newPipeline = VK_NULL_HANDLE;
+
+        try {
+            // Worker : compiling and building, while frames keep using the current pipeline
+            co_await async.schedule();
+
+            FHOPE_TRACE_SCOPE("rebuild graphics pipeline");
+
+            std::vector<uint32_t> vertexCompiled = compile_shader(vertexShaderFilename, shaderc_shader_kind::shaderc_vertex_shader);
+            std::vector<uint32_t> fragmentCompiled = compile_shader(fragmentShaderFilename, shaderc_shader_kind::shaderc_fragment_shader, fragmentDefinitions);
+
+            newPipeline = build_graphics_pipeline(state, vertexCompiled, fragmentCompiled);
+        } catch (const std::exception &error) {
+            std::cerr << "Shader reload failed, keeping the current pipeline : " << error.what() << std::endl;
+        }
+
+        // Render thread : pipelines are only swapped between frames
+        co_await async.next_frame();
+
+        if (newPipeline != VK_NULL_HANDLE) {
+            VkPipeline oldPipeline = setup->graphicsPipelineConfig->pipeline;
+
+            setup->graphicsPipelineConfig->pipeline = newPipeline;
+            setup->deviceContext->pipeline = newPipeline;
+
+            ++setup->sceneVersion;
+
+            // In-flight frames may still be bound to the old pipeline
+            VkDevice device = state.device;
+            setup->deletions->push([device, oldPipeline]() { vkDestroyPipeline(device, oldPipeline, nullptr); });
+
+            std::cout << "Reloaded shaders '" << vertexShaderFilename << "' and '" << fragmentShaderFilename << "'." << std::endl;
+        }
+
+        this->reloading = false;
+    }
+}
@@ -0,0 +1,196 @@
+#include "trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace fhope::trace {
+    /*************
+     ** HELPERS **
+     *************/
+
+    /**
+     * @brief Single producer (the owning thread), single consumer (collect, under the registry's lock) ring buffer of events
+     */
+    struct ThreadBuffer {
+        std::array<Event, THREAD_BUFFER_CAPACITY> events; ///< Ring storage
+
+        alignas(64) std::atomic<uint64_t> head{0}; ///< Amount of events ever pushed (written by the producer only)
+        alignas(64) std::atomic<uint64_t> tail{0}; ///< Amount of events ever popped (written by the consumer only)
+
+        uint32_t    threadId;         ///< Identifier of the thread in written traces
+        const char *name = nullptr;   ///< Name of the thread in written traces
+    };
+
+
+    /**
+     * @brief Every thread buffer ever created, and the events collected from them
+     */
+    struct Registry {
+        std::mutex                                 mutex;     ///< Protects every member below
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;   ///< Buffers of every thread, kept alive after their thread exits
+        std::vector<std::pair<uint32_t, Event>>    collected; ///< Collected events, with the identifier of their thread
+    };
+
+
+
+    static Registry &get_registry() {
+        static Registry registry;
+        return registry;
+    }
+
+
+
+    static std::atomic<uint64_t> droppedEvents{0};
+
+
+
+    static ThreadBuffer &get_thread_buffer() {
+        // Registration locks once per thread, pushing events never does
+        thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+            Registry &registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            auto newBuffer = std::make_shared<ThreadBuffer>();
+            newBuffer->threadId = static_cast<uint32_t>(registry.buffers.size() + 1);
+            registry.buffers.push_back(newBuffer);
+
+            return newBuffer;
+        }();
+
+        return *buffer;
+    }
+
+
+
+    static void write_json_string(std::ostream &out, const char *text) {
+        out << '"';
+        for (const char *c = text; *c != '\0'; ++c) {
+            if (*c == '"' || *c == '\\') {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+
+    /*************
+     ** METHODS **
+     *************/
+
+    Scope::Scope(const char *name) : name(name), beginNanoseconds(now()) {}
+
+
+
+    Scope::~Scope() {
+        record({ this->name, this->beginNanoseconds, now() });
+    }
+
+    /***************
+     ** FUNCTIONS **
+     ***************/
+
+    uint64_t now() {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+    }
+
+
+
+    void record(const Event &event) {
+        ThreadBuffer &buffer = get_thread_buffer();
+
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.tail.load(std::memory_order_acquire) == THREAD_BUFFER_CAPACITY) {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.events[head & (THREAD_BUFFER_CAPACITY - 1)] = event;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+
+
+    void set_thread_name(const char *name) {
+        ThreadBuffer &buffer = get_thread_buffer();
+
+        std::lock_guard<std::mutex> lock(get_registry().mutex);
+        buffer.name = name;
+    }
+
+
+
+    void collect() {
+        Registry &registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (const std::shared_ptr<ThreadBuffer> &buffer : registry.buffers) {
+            uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+            for (; tail != head; ++tail) {
+                registry.collected.emplace_back(buffer->threadId, buffer->events[tail & (THREAD_BUFFER_CAPACITY - 1)]);
+            }
+
+            buffer->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+
+
+    void write_chrome_trace(const std::string &filename) {
+        collect();
+
+        std::ofstream file(filename, std::ios::trunc);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open trace file `" + filename + "`.");
+        }
+
+        Registry &registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first(true);
+        for (const std::shared_ptr<ThreadBuffer> &buffer : registry.buffers) {
+            if (buffer->name == nullptr) {
+                continue;
+            }
+
+            file << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+            write_json_string(file, buffer->name);
+            file << "}}";
+
+            first = false;
+        }
+
+        // Complete events ("X"), timestamps and durations in microseconds
+        for (const auto &[threadId, event] : registry.collected) {
+            file << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"name\":";
+            write_json_string(file, event.name);
+            file << ",\"pid\":1,\"tid\":" << threadId
+                 << ",\"ts\":" << static_cast<double>(event.beginNanoseconds) / 1000.0
+                 << ",\"dur\":" << static_cast<double>(event.endNanoseconds - event.beginNanoseconds) / 1000.0 << "}";
+
+            first = false;
+        }
+
+        file << "\n]}\n";
+    }
+
+
+
+    uint64_t get_dropped_event_count() {
+        return droppedEvents.load(std::memory_order_relaxed);
+    }
+}
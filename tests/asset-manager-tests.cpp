@@ -0,0 +1,216 @@
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glad/vulkan.h>
+
+#include "asset-manager.hpp"
+#include "async-loading.hpp"
+#include "setup.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    /**
+     * @brief What the fake device has been asked to destroy
+     */
+    struct FakeAssetDevice {
+        uintptr_t nextHandle = 0x1000; ///< Value of the next created handle
+
+        std::vector<VkImage> destroyedImages; ///< Every destroyed image, in destruction order
+    };
+
+    static FakeAssetDevice fakeAssets;
+
+
+
+    template <typename Handle>
+    static Handle make_asset_handle() {
+        return reinterpret_cast<Handle>(fakeAssets.nextHandle++);
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_command_pool(VkDevice, const VkCommandPoolCreateInfo *, const VkAllocationCallbacks *, VkCommandPool *commandPool) {
+        *commandPool = make_asset_handle<VkCommandPool>();
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_image(VkDevice, VkImage image, const VkAllocationCallbacks *) {
+        fakeAssets.destroyedImages.push_back(image);
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_command_pool(VkDevice, VkCommandPool, const VkAllocationCallbacks *) {}
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_image_view(VkDevice, VkImageView, const VkAllocationCallbacks *) {}
+    static VKAPI_ATTR void VKAPI_CALL fake_free_memory(VkDevice, VkDeviceMemory, const VkAllocationCallbacks *) {}
+
+
+
+    static TextureAsset make_texture() {
+        TextureAsset asset{};
+        asset.texture.texture = make_asset_handle<VkImage>();
+        asset.texture.memory = make_asset_handle<VkDeviceMemory>();
+        asset.texture.mipLevels = 1;
+        asset.view = make_asset_handle<VkImageView>();
+        asset.sampler = make_asset_handle<VkSampler>();
+
+        return asset;
+    }
+
+    /**************
+     ** FIXTURES **
+     **************/
+
+    /**
+     * @brief Asset manager whose textures are created by the tests, destroyed against a fake device
+     */
+    class AssetManagerTest : public ::testing::Test {
+        protected:
+            static constexpr VkDeviceSize ASSET_BUDGET = 100; ///< Fits two textures of TEXTURE_SIZE, not three
+            static constexpr VkDeviceSize TEXTURE_SIZE = 40;
+
+            InstanceSetup setup;
+            AssetManager  assets{ ASSET_BUDGET };
+
+            void SetUp() override {
+                fakeAssets = {};
+
+                glad_vkCreateCommandPool = fake_create_command_pool;
+                glad_vkDestroyCommandPool = fake_destroy_command_pool;
+                glad_vkDestroyImageView = fake_destroy_image_view;
+                glad_vkDestroyImage = fake_destroy_image;
+                glad_vkFreeMemory = fake_free_memory;
+
+                this->setup.logicalDevice = make_asset_handle<VkDevice>();
+                this->setup.queues.emplace();
+                this->setup.queues.value().graphicsIndex = 0;
+                this->setup.graphicsQueue = make_asset_handle<VkQueue>();
+
+                this->setup.jobs = std::make_unique<JobSystem>(1);
+                this->setup.async = std::make_unique<AsyncScheduler>(this->setup, this->setup.jobs.get());
+                this->setup.deletions = std::make_unique<DeletionQueue>(2);
+            }
+
+            void TearDown() override {
+                this->setup.async->destroy();
+
+                this->assets.destroy(this->setup);
+                this->setup.deletions->flush();
+            }
+    };
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST_F(AssetManagerTest, AcquiringAFileAgainSharesItsAsset) {
+        TextureHandle added = this->assets.add_texture(this->setup, "textures/stone.png", make_texture(), TEXTURE_SIZE);
+        TextureHandle acquired = this->assets.acquire_texture(&this->setup, "textures/../textures/stone.png");
+
+        // The file is registered : nothing is loaded again
+        EXPECT_EQ(this->setup.async->get_pending(), 0u);
+        EXPECT_EQ(acquired.entry, added.entry);
+        EXPECT_EQ(this->assets.get(acquired), this->assets.get(added));
+        EXPECT_EQ(this->assets.get_resident_bytes(), TEXTURE_SIZE);
+
+        // Releasing one user keeps the asset for the other, releasing both keeps it cached within the budget
+        this->assets.release(this->setup, added);
+        ASSERT_NE(this->assets.get(acquired), nullptr);
+
+        this->assets.release(this->setup, acquired);
+        EXPECT_EQ(this->assets.get_resident_bytes(), TEXTURE_SIZE);
+        EXPECT_EQ(this->setup.deletions->size(), 0u);
+    }
+
+
+
+    TEST_F(AssetManagerTest, CachedAssetsAreSharedByNextAcquisitions) {
+        TextureHandle added = this->assets.add_texture(this->setup, "textures/stone.png", make_texture(), TEXTURE_SIZE);
+        const TextureAsset *texture = this->assets.get(added);
+
+        this->assets.release(this->setup, added);
+
+        TextureHandle acquired = this->assets.acquire_texture(&this->setup, "textures/stone.png");
+
+        EXPECT_EQ(this->setup.async->get_pending(), 0u);
+        EXPECT_EQ(this->assets.get(acquired), texture);
+        EXPECT_EQ(this->assets.get_state(acquired), AssetState::Resident);
+    }
+
+
+
+    TEST_F(AssetManagerTest, EvictsLeastRecentlyReleasedAssetsPastBudget) {
+        TextureAsset first = make_texture();
+        TextureAsset second = make_texture();
+
+        TextureHandle firstHandle = this->assets.add_texture(this->setup, "textures/first.png", first, TEXTURE_SIZE);
+        TextureHandle secondHandle = this->assets.add_texture(this->setup, "textures/second.png", second, TEXTURE_SIZE);
+
+        // Both fit the budget : they stay cached once released, the second one being the least recently released
+        this->assets.release(this->setup, secondHandle);
+        this->assets.release(this->setup, firstHandle);
+        EXPECT_EQ(this->assets.get_resident_bytes(), 2 * TEXTURE_SIZE);
+
+        this->assets.add_texture(this->setup, "textures/third.png", make_texture(), TEXTURE_SIZE);
+
+        EXPECT_EQ(this->assets.get_resident_bytes(), 2 * TEXTURE_SIZE);
+        EXPECT_THROW(this->assets.get(secondHandle), std::runtime_error);
+        EXPECT_NE(this->assets.get(firstHandle), nullptr);
+
+        // The destruction waits for the frames in flight
+        ASSERT_EQ(this->setup.deletions->size(), 1u);
+        EXPECT_TRUE(fakeAssets.destroyedImages.empty());
+
+        this->setup.deletions->flush();
+        EXPECT_EQ(fakeAssets.destroyedImages, std::vector<VkImage>{ second.texture.texture });
+    }
+
+
+
+    TEST_F(AssetManagerTest, KeepsReferencedAssetsPastBudget) {
+        TextureHandle first = this->assets.add_texture(this->setup, "textures/first.png", make_texture(), TEXTURE_SIZE);
+        TextureHandle second = this->assets.add_texture(this->setup, "textures/second.png", make_texture(), TEXTURE_SIZE);
+        TextureHandle third = this->assets.add_texture(this->setup, "textures/third.png", make_texture(), TEXTURE_SIZE);
+
+        EXPECT_EQ(this->assets.get_resident_bytes(), 3 * TEXTURE_SIZE);
+        EXPECT_EQ(this->setup.deletions->size(), 0u);
+
+        // The first release brings the resident assets back under the budget
+        this->assets.release(this->setup, second);
+
+        EXPECT_EQ(this->assets.get_resident_bytes(), 2 * TEXTURE_SIZE);
+        EXPECT_NE(this->assets.get(first), nullptr);
+        EXPECT_NE(this->assets.get(third), nullptr);
+    }
+
+
+
+    TEST_F(AssetManagerTest, RejectsReleasingMoreThanAcquiring) {
+        TextureHandle added = this->assets.add_texture(this->setup, "textures/stone.png", make_texture(), TEXTURE_SIZE);
+        TextureHandle acquired = this->assets.acquire_texture(&this->setup, "textures/stone.png");
+
+        this->assets.release(this->setup, added);
+        this->assets.release(this->setup, acquired);
+
+        EXPECT_THROW(this->assets.release(this->setup, added), std::runtime_error);
+        EXPECT_EQ(this->assets.get_resident_bytes(), TEXTURE_SIZE);
+    }
+
+
+
+    TEST_F(AssetManagerTest, RejectsAddingARegisteredFile) {
+        this->assets.add_texture(this->setup, "textures/stone.png", make_texture(), TEXTURE_SIZE);
+
+        EXPECT_THROW(this->assets.add_texture(this->setup, "textures/stone.png", make_texture(), TEXTURE_SIZE), std::runtime_error);
+    }
+}
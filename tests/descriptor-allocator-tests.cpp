@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glad/vulkan.h>
+
+#include "descriptor-allocator.hpp"
+#include "setup.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static uintptr_t nextLayout = 0x1000; ///< Value of the next created layout
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_descriptor_set_layout(VkDevice, const VkDescriptorSetLayoutCreateInfo *, const VkAllocationCallbacks *, VkDescriptorSetLayout *layout) {
+        *layout = reinterpret_cast<VkDescriptorSetLayout>(nextLayout++);
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_descriptor_set_layout(VkDevice, VkDescriptorSetLayout, const VkAllocationCallbacks *) {}
+
+
+
+    static VkDescriptorSetLayoutBinding make_sampler_binding(uint32_t binding, uint32_t descriptorCount, const VkSampler *immutableSamplers) {
+        VkDescriptorSetLayoutBinding newBinding{};
+        newBinding.binding = binding;
+        newBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        newBinding.descriptorCount = descriptorCount;
+        newBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        newBinding.pImmutableSamplers = immutableSamplers;
+
+        return newBinding;
+    }
+
+
+
+    static VkDescriptorSetLayoutCreateInfo make_layout_info(const std::vector<VkDescriptorSetLayoutBinding> &bindings) {
+        VkDescriptorSetLayoutCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        createInfo.pBindings = bindings.data();
+
+        return createInfo;
+    }
+
+    /**************
+     ** FIXTURES **
+     **************/
+
+    /**
+     * @brief Layout cache over a fake device, with samplers that are never dereferenced
+     */
+    class DescriptorLayoutCacheTest : public ::testing::Test {
+        protected:
+            const VkSampler samplers[2] = { reinterpret_cast<VkSampler>(0x10), reinterpret_cast<VkSampler>(0x20) };
+
+            InstanceSetup setup;
+
+            void SetUp() override {
+                glad_vkCreateDescriptorSetLayout = fake_create_descriptor_set_layout;
+                glad_vkDestroyDescriptorSetLayout = fake_destroy_descriptor_set_layout;
+
+                this->setup.logicalDevice = reinterpret_cast<VkDevice>(0x1);
+            }
+    };
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST_F(DescriptorLayoutCacheTest, SharesLayoutsWhateverTheBindingOrder) {
+        DescriptorLayoutCache cache(this->setup);
+
+        std::vector<VkDescriptorSetLayoutBinding> ordered = { make_sampler_binding(0, 1, &this->samplers[0]), make_sampler_binding(1, 1, nullptr) };
+        std::vector<VkDescriptorSetLayoutBinding> reversed = { ordered[1], ordered[0] };
+
+        EXPECT_EQ(cache.get(make_layout_info(ordered)), cache.get(make_layout_info(reversed)));
+        EXPECT_EQ(cache.size(), 1u);
+
+        cache.destroy();
+    }
+
+
+
+    TEST_F(DescriptorLayoutCacheTest, DistinguishesWhichBindingOwnsImmutableSamplers) {
+        DescriptorLayoutCache cache(this->setup);
+
+        std::vector<VkDescriptorSetLayoutBinding> firstOwns = { make_sampler_binding(0, 1, &this->samplers[0]), make_sampler_binding(1, 1, nullptr) };
+        std::vector<VkDescriptorSetLayoutBinding> secondOwns = { make_sampler_binding(0, 1, nullptr), make_sampler_binding(1, 1, &this->samplers[0]) };
+
+        EXPECT_NE(cache.get(make_layout_info(firstOwns)), cache.get(make_layout_info(secondOwns)));
+        EXPECT_EQ(cache.size(), 2u);
+
+        cache.destroy();
+    }
+
+
+
+    TEST_F(DescriptorLayoutCacheTest, ComparesImmutableSamplersByValue) {
+        DescriptorLayoutCache cache(this->setup);
+
+        VkSampler firstCopy[2] = { this->samplers[0], this->samplers[1] };
+        VkSampler secondCopy[2] = { this->samplers[0], this->samplers[1] };
+        VkSampler swapped[2] = { this->samplers[1], this->samplers[0] };
+
+        VkDescriptorSetLayout first = cache.get(make_layout_info({ make_sampler_binding(0, 2, firstCopy) }));
+
+        EXPECT_EQ(cache.get(make_layout_info({ make_sampler_binding(0, 2, secondCopy) })), first);
+        EXPECT_NE(cache.get(make_layout_info({ make_sampler_binding(0, 2, swapped) })), first);
+        EXPECT_EQ(cache.size(), 2u);
+
+        cache.destroy();
+    }
+}
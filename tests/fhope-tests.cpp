@@ -0,0 +1,11 @@
+#define GLAD_VULKAN_IMPLEMENTATION
+#include <glad/vulkan.h>
+
+#include <gtest/gtest.h>
+
+// Tests never touch a real device : every vulkan entry point they reach is replaced by a fake (see each test file)
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
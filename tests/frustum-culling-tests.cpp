@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustum-culling.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    // Counts around every lane width, so that each SIMD kernel also goes through it's scalar tail
+    static const std::vector<size_t> CULLING_COUNTS = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100};
+
+
+
+    // Camera at the origin looking down -Z, seeing from 0.1 to 50 units away
+    static Frustum make_frustum() {
+        return extract_frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 50.0f));
+    }
+
+
+
+    // Deterministic position spread around the frustum, some objects being inside, some outside and some straddling a plane
+    static glm::vec3 make_position(uint32_t seed) {
+        return glm::vec3(float((seed * 13u) % 61u) - 30.0f, float((seed * 7u) % 41u) - 20.0f, -float((seed * 11u) % 71u) + 10.0f);
+    }
+
+
+
+    static SphereSoA make_spheres(size_t count) {
+        SphereSoA spheres;
+        for (size_t i = 0; i != count; ++i) {
+            spheres.push_back(glm::vec4(make_position(uint32_t(i)), 0.5f + float(i % 5)));
+        }
+
+        return spheres;
+    }
+
+
+
+    static AabbSoA make_boxes(size_t count) {
+        AabbSoA boxes;
+        for (size_t i = 0; i != count; ++i) {
+            glm::vec3 center = make_position(uint32_t(i));
+            glm::vec3 extent(0.5f + float(i % 3), 0.5f + float(i % 4), 0.5f + float(i % 5));
+
+            boxes.push_back(center - extent, center + extent);
+        }
+
+        return boxes;
+    }
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST(FrustumCullingTest, SimdSpheresMatchScalarSpheres) {
+        Frustum frustum = make_frustum();
+
+        for (size_t count : CULLING_COUNTS) {
+            SCOPED_TRACE(count);
+
+            SphereSoA spheres = make_spheres(count);
+
+            std::vector<uint32_t> expected;
+            size_t expectedCount = cull_spheres_scalar(frustum, spheres, &expected);
+
+            std::vector<uint32_t> visible;
+            EXPECT_EQ(cull_spheres(frustum, spheres, &visible), expectedCount);
+            EXPECT_EQ(visible, expected);
+        }
+    }
+
+
+
+    TEST(FrustumCullingTest, SimdBoxesMatchScalarBoxes) {
+        Frustum frustum = make_frustum();
+
+        for (size_t count : CULLING_COUNTS) {
+            SCOPED_TRACE(count);
+
+            AabbSoA boxes = make_boxes(count);
+
+            std::vector<uint32_t> expected;
+            size_t expectedCount = cull_aabbs_scalar(frustum, boxes, &expected);
+
+            std::vector<uint32_t> visible;
+            EXPECT_EQ(cull_aabbs(frustum, boxes, &visible), expectedCount);
+            EXPECT_EQ(visible, expected);
+        }
+    }
+
+
+
+    TEST(FrustumCullingTest, KeepsObjectsInFrontAndCullsObjectsBehind) {
+        Frustum frustum = make_frustum();
+
+        SphereSoA spheres;
+        spheres.push_back(glm::vec4(0.0f, 0.0f, -10.0f, 1.0f)); // In front of the camera
+        spheres.push_back(glm::vec4(0.0f, 0.0f, 10.0f, 1.0f));  // Behind the camera
+        spheres.push_back(glm::vec4(0.0f, 0.0f, -100.0f, 1.0f)); // Beyond the far plane
+        spheres.push_back(glm::vec4(0.0f, 0.0f, -50.5f, 1.0f));  // Straddling the far plane
+
+        std::vector<uint32_t> visible;
+        cull_spheres(frustum, spheres, &visible);
+
+        EXPECT_EQ(visible, (std::vector<uint32_t>{0, 3}));
+    }
+
+
+
+    TEST(FrustumCullingTest, ShrinksVisibleIndicesToVisibleCount) {
+        Frustum frustum = make_frustum();
+
+        std::vector<uint32_t> visible(1000, 0);
+        size_t count = cull_spheres(frustum, make_spheres(17), &visible);
+
+        EXPECT_EQ(visible.size(), count);
+    }
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "job-system.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static constexpr uint32_t STOLEN_JOBS = 200000; ///< Jobs pushed while thieves steal, enough for the deque to grow under them
+    static constexpr uint32_t THIEF_COUNT = 3;
+
+
+
+    // Deques never dereference their jobs : tests queue numbered fake pointers (0 being nullptr, numbers start at 1)
+    static Job *make_job(uint32_t number) {
+        return reinterpret_cast<Job *>(static_cast<uintptr_t>(number));
+    }
+
+
+
+    static uint32_t get_number(Job *job) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(job));
+    }
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST(WorkStealingDequeTest, OwnerPopsLastPushedFirst) {
+        WorkStealingDeque deque(8);
+
+        for (uint32_t i = 1; i != 6; ++i) {
+            deque.push(make_job(i));
+        }
+
+        for (uint32_t i = 5; i != 0; --i) {
+            EXPECT_EQ(get_number(deque.pop()), i);
+        }
+
+        EXPECT_EQ(deque.pop(), nullptr);
+        EXPECT_EQ(deque.steal(), nullptr);
+    }
+
+
+
+    TEST(WorkStealingDequeTest, ThievesStealFirstPushedFirst) {
+        WorkStealingDeque deque(8);
+
+        for (uint32_t i = 1; i != 5; ++i) {
+            deque.push(make_job(i));
+        }
+
+        // Both ends meet in the middle
+        EXPECT_EQ(get_number(deque.steal()), 1u);
+        EXPECT_EQ(get_number(deque.pop()), 4u);
+        EXPECT_EQ(get_number(deque.steal()), 2u);
+        EXPECT_EQ(get_number(deque.pop()), 3u);
+
+        EXPECT_EQ(deque.steal(), nullptr);
+        EXPECT_EQ(deque.pop(), nullptr);
+    }
+
+
+
+    TEST(WorkStealingDequeTest, GrowsKeepingQueuedJobs) {
+        WorkStealingDeque deque(2);
+
+        // Steals move the top, so that the queued jobs wrap around the ring when it grows
+        deque.push(make_job(1));
+        deque.push(make_job(2));
+        EXPECT_EQ(get_number(deque.steal()), 1u);
+
+        for (uint32_t i = 3; i != 101; ++i) {
+            deque.push(make_job(i));
+        }
+
+        EXPECT_EQ(get_number(deque.steal()), 2u);
+
+        for (uint32_t i = 100; i != 2; --i) {
+            EXPECT_EQ(get_number(deque.pop()), i);
+        }
+
+        EXPECT_EQ(deque.pop(), nullptr);
+    }
+
+
+
+    TEST(WorkStealingDequeTest, ConcurrentStealsTakeEveryJobOnce) {
+        WorkStealingDeque deque(2);
+
+        std::atomic<bool> pushing(true);
+        std::vector<std::vector<uint32_t>> stolen(THIEF_COUNT);
+
+        std::vector<std::thread> thieves;
+        for (uint32_t t = 0; t != THIEF_COUNT; ++t) {
+            thieves.emplace_back([&deque, &pushing, &taken = stolen[t]]() {
+                // Keeps stealing until the owner is done and nothing is left
+                while (true) {
+                    bool done = !pushing.load(std::memory_order_acquire);
+
+                    Job *job = deque.steal();
+                    if (job != nullptr) {
+                        taken.push_back(get_number(job));
+                    } else if (done) {
+                        break;
+                    }
+                }
+            });
+        }
+
+        // The owner pops some jobs back while pushing, racing thieves for the last ones
+        std::vector<uint32_t> popped;
+        for (uint32_t i = 1; i != STOLEN_JOBS + 1; ++i) {
+            deque.push(make_job(i));
+
+            if (i % 3 == 0) {
+                Job *job = deque.pop();
+                if (job != nullptr) {
+                    popped.push_back(get_number(job));
+                }
+            }
+        }
+
+        pushing.store(false, std::memory_order_release);
+
+        for (std::thread &thief : thieves) {
+            thief.join();
+        }
+
+        for (Job *job = deque.pop(); job != nullptr; job = deque.pop()) {
+            popped.push_back(get_number(job));
+        }
+
+        std::vector<uint32_t> taken(STOLEN_JOBS + 1, 0);
+        for (uint32_t number : popped) {
+            ++taken[number];
+        }
+        for (const std::vector<uint32_t> &thiefJobs : stolen) {
+            for (uint32_t number : thiefJobs) {
+                ++taken[number];
+            }
+        }
+
+        EXPECT_EQ(taken[0], 0u);
+        EXPECT_EQ(std::count(taken.begin() + 1, taken.end(), 1u), STOLEN_JOBS);
+    }
+
+
+
+    TEST(JobSystemTest, ParallelForCoversTheRangeOnce) {
+        JobSystem jobs(THIEF_COUNT);
+
+        std::vector<std::atomic<uint32_t>> visits(10000);
+        jobs.parallel_for(visits.size(), 7, [&visits](size_t begin, size_t end) {
+            for (size_t i = begin; i != end; ++i) {
+                visits[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        EXPECT_TRUE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<uint32_t> &visit) { return visit.load() == 1; }));
+    }
+
+
+
+    TEST(JobSystemTest, RunsDependentsAfterTheirDependencies) {
+        JobSystem jobs(THIEF_COUNT);
+
+        JobCounter first;
+        JobCounter second;
+        std::atomic<uint32_t> finished(0);
+        std::atomic<uint32_t> finishedBeforeSecond(UINT32_MAX);
+
+        for (uint32_t i = 0; i != 64; ++i) {
+            jobs.run([&finished]() { finished.fetch_add(1); }, &first);
+        }
+
+        jobs.run_after(&first, [&finished, &finishedBeforeSecond]() { finishedBeforeSecond = finished.load(); }, &second);
+        jobs.wait(&second);
+
+        EXPECT_TRUE(first.is_done());
+        EXPECT_EQ(finishedBeforeSecond.load(), 64u);
+    }
+
+
+
+    TEST(JobSystemTest, WaitRethrowsTheFirstJobError) {
+        JobSystem jobs(THIEF_COUNT);
+
+        JobCounter counter;
+        std::atomic<uint32_t> finished(0);
+
+        jobs.run([]() { throw std::runtime_error("Job failure."); }, &counter);
+        for (uint32_t i = 0; i != 16; ++i) {
+            jobs.run([&finished]() { finished.fetch_add(1); }, &counter);
+        }
+
+        EXPECT_THROW(jobs.wait(&counter), std::runtime_error);
+        EXPECT_EQ(finished.load(), 16u);
+
+        // The error is only reported once
+        EXPECT_NO_THROW(jobs.wait(&counter));
+    }
+}
@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "mvp-batch.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    // Counts around every lane width, so that each SIMD kernel also goes through it's scalar tail
+    static const std::vector<size_t> BATCH_COUNTS = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17};
+
+    static constexpr float MATRIX_TOLERANCE = 1e-4f; ///< FMA and reordered additions round differently from the scalar kernel
+
+
+
+    // Deterministic matrix whose elements differ from one seed to another
+    static glm::mat4 make_matrix(uint32_t seed) {
+        glm::mat4 matrix(1.0f);
+        for (int column = 0; column != 4; ++column) {
+            for (int row = 0; row != 4; ++row) {
+                uint32_t value = (seed * 31u + uint32_t(column) * 7u + uint32_t(row) * 3u) % 19u;
+                matrix[column][row] = float(value) / 4.0f - 2.0f;
+            }
+        }
+
+        return matrix;
+    }
+
+
+
+    static MatrixSoA make_matrices(size_t count, uint32_t seed) {
+        MatrixSoA matrices;
+        for (size_t i = 0; i != count; ++i) {
+            matrices.push_back(make_matrix(seed + uint32_t(i)));
+        }
+
+        return matrices;
+    }
+
+
+
+    static void expect_matrices_near(const MatrixSoA &actual, const MatrixSoA &expected) {
+        ASSERT_EQ(actual.size(), expected.size());
+
+        for (size_t i = 0; i != expected.size(); ++i) {
+            glm::mat4 actualMatrix = actual.get(i);
+            glm::mat4 expectedMatrix = expected.get(i);
+
+            for (int column = 0; column != 4; ++column) {
+                for (int row = 0; row != 4; ++row) {
+                    EXPECT_NEAR(actualMatrix[column][row], expectedMatrix[column][row], MATRIX_TOLERANCE) << "matrix " << i << ", column " << column << ", row " << row;
+                }
+            }
+        }
+    }
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST(MvpBatchTest, ScalarKernelMatchesGlm) {
+        glm::mat4 viewProjection = make_matrix(1000);
+        MatrixSoA models = make_matrices(9, 1);
+
+        MatrixSoA mvps;
+        compute_mvps_scalar(viewProjection, models, &mvps);
+
+        MatrixSoA expected;
+        for (size_t i = 0; i != models.size(); ++i) {
+            expected.push_back(viewProjection * models.get(i));
+        }
+
+        expect_matrices_near(mvps, expected);
+    }
+
+
+
+    TEST(MvpBatchTest, SimdKernelsMatchScalarKernel) {
+        glm::mat4 viewProjection = make_matrix(1000);
+
+        for (size_t count : BATCH_COUNTS) {
+            SCOPED_TRACE(count);
+
+            MatrixSoA models = make_matrices(count, 1);
+
+            MatrixSoA expected;
+            compute_mvps_scalar(viewProjection, models, &expected);
+
+            MatrixSoA mvps;
+            compute_mvps(viewProjection, models, &mvps);
+            expect_matrices_near(mvps, expected);
+
+            MatrixSoA sseMvps;
+            compute_mvps_sse(viewProjection, models, &sseMvps);
+            expect_matrices_near(sseMvps, expected);
+        }
+    }
+
+
+
+    TEST(MvpBatchTest, ShrinksOutputToModelCount) {
+        glm::mat4 viewProjection = make_matrix(1000);
+
+        MatrixSoA mvps;
+        compute_mvps(viewProjection, make_matrices(17, 1), &mvps);
+        compute_mvps(viewProjection, make_matrices(5, 1), &mvps);
+
+        EXPECT_EQ(mvps.size(), 5u);
+    }
+
+
+
+    TEST(MvpBatchTest, MultipliesEachPairWithItsOwnLeftMatrix) {
+        for (size_t count : BATCH_COUNTS) {
+            SCOPED_TRACE(count);
+
+            MatrixSoA lefts = make_matrices(count, 500);
+            MatrixSoA rights = make_matrices(count, 1);
+
+            MatrixSoA expected;
+            for (size_t i = 0; i != count; ++i) {
+                expected.push_back(lefts.get(i) * rights.get(i));
+            }
+
+            MatrixSoA products;
+            multiply_matrices(lefts, rights, &products);
+            expect_matrices_near(products, expected);
+        }
+    }
+
+
+
+    TEST(MvpBatchTest, RejectsPairsOfDifferentSizes) {
+        MatrixSoA products;
+
+        EXPECT_THROW(multiply_matrices(make_matrices(4, 1), make_matrices(5, 1), &products), std::runtime_error);
+    }
+}
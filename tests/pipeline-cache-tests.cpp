@@ -0,0 +1,190 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glad/vulkan.h>
+
+#include "pipeline-cache.hpp"
+#include "setup.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static constexpr uint32_t FAKE_VENDOR_ID = 0x10DE;
+    static constexpr uint32_t FAKE_DEVICE_ID = 0x2204;
+    static constexpr uint8_t  FAKE_UUID_BYTE = 0x5A; ///< Every byte of the fake device's cache UUID
+
+    static constexpr size_t FAKE_PAYLOAD_SIZE = 64; ///< Driver data following the header of written cache files
+
+    /**
+     * @brief What the fake device has been given
+     */
+    struct FakePipelineDevice {
+        bool   created = false;     ///< Wether or not a pipeline cache has been created
+        size_t initialDataSize = 0; ///< Size of the data the pipeline cache has been created with
+    };
+
+    static FakePipelineDevice fakePipelines;
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_get_physical_device_properties(VkPhysicalDevice, VkPhysicalDeviceProperties *properties) {
+        *properties = {};
+        properties->vendorID = FAKE_VENDOR_ID;
+        properties->deviceID = FAKE_DEVICE_ID;
+        std::memset(properties->pipelineCacheUUID, FAKE_UUID_BYTE, VK_UUID_SIZE);
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_pipeline_cache(VkDevice, const VkPipelineCacheCreateInfo *createInfo, const VkAllocationCallbacks *, VkPipelineCache *cache) {
+        fakePipelines.created = true;
+        fakePipelines.initialDataSize = createInfo->initialDataSize;
+
+        *cache = reinterpret_cast<VkPipelineCache>(0x1000);
+
+        return VK_SUCCESS;
+    }
+
+
+
+    // The driver has nothing to save : destroying the cache leaves the written file as is
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_get_pipeline_cache_data(VkDevice, VkPipelineCache, size_t *size, void *) {
+        *size = 0;
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_pipeline_cache(VkDevice, VkPipelineCache, const VkAllocationCallbacks *) {}
+
+    /**************
+     ** FIXTURES **
+     **************/
+
+    /**
+     * @brief Pipeline cache files written for the fake device, or altered to come from another one
+     */
+    class PipelineCacheTest : public ::testing::Test {
+        protected:
+            InstanceSetup         setup;
+            std::filesystem::path filename;
+
+            void SetUp() override {
+                fakePipelines = {};
+
+                glad_vkGetPhysicalDeviceProperties = fake_get_physical_device_properties;
+                glad_vkCreatePipelineCache = fake_create_pipeline_cache;
+                glad_vkGetPipelineCacheData = fake_get_pipeline_cache_data;
+                glad_vkDestroyPipelineCache = fake_destroy_pipeline_cache;
+
+                this->setup.physicalDevice = reinterpret_cast<VkPhysicalDevice>(0x1);
+                this->setup.logicalDevice = reinterpret_cast<VkDevice>(0x2);
+
+                this->filename = std::filesystem::temp_directory_path() / ("fhope-pipeline-cache-" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".bin");
+            }
+
+            void TearDown() override {
+                std::error_code error;
+                std::filesystem::remove(this->filename, error);
+            }
+
+            /**
+             * @brief Writes a cache file with a version one header, for the fake device unless altered
+             */
+            std::vector<char> make_cache_data() const {
+                std::vector<char> data(16 + VK_UUID_SIZE + FAKE_PAYLOAD_SIZE, 0);
+
+                uint32_t header[4] = { 16 + VK_UUID_SIZE, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, FAKE_VENDOR_ID, FAKE_DEVICE_ID };
+                std::memcpy(data.data(), header, sizeof(header));
+                std::memset(data.data() + 16, FAKE_UUID_BYTE, VK_UUID_SIZE);
+
+                return data;
+            }
+
+            void write_cache_file(const std::vector<char> &data) const {
+                std::ofstream file(this->filename, std::ofstream::binary | std::ofstream::trunc);
+                file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            }
+
+            /**
+             * @brief Creates (then destroys) a pipeline cache from the written file
+             *
+             * @return size_t Size of the data given to the driver
+             */
+            size_t load_cache() {
+                PipelineCache cache(this->setup, this->filename);
+                cache.destroy();
+
+                EXPECT_TRUE(fakePipelines.created);
+
+                return fakePipelines.initialDataSize;
+            }
+    };
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST_F(PipelineCacheTest, LoadsDataOfTheSameDevice) {
+        std::vector<char> data = this->make_cache_data();
+        this->write_cache_file(data);
+
+        EXPECT_EQ(this->load_cache(), data.size());
+    }
+
+
+
+    TEST_F(PipelineCacheTest, StartsEmptyWithoutFile) {
+        EXPECT_EQ(this->load_cache(), 0u);
+    }
+
+
+
+    TEST_F(PipelineCacheTest, RejectsDataOfAnotherVendor) {
+        std::vector<char> data = this->make_cache_data();
+        uint32_t otherVendor = FAKE_VENDOR_ID + 1;
+        std::memcpy(data.data() + 8, &otherVendor, sizeof(otherVendor));
+        this->write_cache_file(data);
+
+        EXPECT_EQ(this->load_cache(), 0u);
+    }
+
+
+
+    TEST_F(PipelineCacheTest, RejectsDataOfAnotherDevice) {
+        std::vector<char> data = this->make_cache_data();
+        uint32_t otherDevice = FAKE_DEVICE_ID + 1;
+        std::memcpy(data.data() + 12, &otherDevice, sizeof(otherDevice));
+        this->write_cache_file(data);
+
+        EXPECT_EQ(this->load_cache(), 0u);
+    }
+
+
+
+    TEST_F(PipelineCacheTest, RejectsDataOfAnotherDriver) {
+        std::vector<char> data = this->make_cache_data();
+        data[16 + VK_UUID_SIZE - 1] ^= 0x1;
+        this->write_cache_file(data);
+
+        EXPECT_EQ(this->load_cache(), 0u);
+    }
+
+
+
+    TEST_F(PipelineCacheTest, RejectsTruncatedHeaders) {
+        std::vector<char> data = this->make_cache_data();
+        data.resize(16 + VK_UUID_SIZE - 1);
+        this->write_cache_file(data);
+
+        EXPECT_EQ(this->load_cache(), 0u);
+    }
+}
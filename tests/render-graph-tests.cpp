@@ -0,0 +1,354 @@
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glad/vulkan.h>
+
+#include "render-graph.hpp"
+#include "setup.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    /**
+     * @brief What the fake device has been asked to do
+     */
+    struct FakeDevice {
+        uintptr_t nextHandle = 0x1000; ///< Value of the next created handle
+
+        std::map<VkImage, VkDeviceSize> imageSizes; ///< Memory required by each created image
+
+        std::vector<VkRenderPassBeginInfo>    beginnings; ///< Every recorded render pass beginning
+        std::vector<VkImageMemoryBarrier2KHR> barriers;   ///< Every recorded image barrier, in recording order
+
+        std::vector<std::vector<VkImageView>> framebufferAttachments; ///< Attachments of every created framebuffer
+        std::vector<VkExtent2D>               framebufferExtents;     ///< Extent of every created framebuffer
+        uint32_t                              destroyedFramebuffers = 0;
+    };
+
+    static FakeDevice fake;
+
+
+
+    template <typename Handle>
+    static Handle make_handle() {
+        return reinterpret_cast<Handle>(fake.nextHandle++);
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_image(VkDevice, const VkImageCreateInfo *createInfo, const VkAllocationCallbacks *, VkImage *image) {
+        *image = make_handle<VkImage>();
+        fake.imageSizes[*image] = VkDeviceSize(createInfo->extent.width) * createInfo->extent.height * createInfo->samples * 4;
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_get_image_memory_requirements(VkDevice, VkImage image, VkMemoryRequirements *requirements) {
+        requirements->size = fake.imageSizes[image];
+        requirements->alignment = 256;
+        requirements->memoryTypeBits = 1;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_get_physical_device_memory_properties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties *properties) {
+        *properties = {};
+        properties->memoryTypeCount = 1;
+        properties->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_allocate_memory(VkDevice, const VkMemoryAllocateInfo *, const VkAllocationCallbacks *, VkDeviceMemory *memory) {
+        *memory = make_handle<VkDeviceMemory>();
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_bind_image_memory(VkDevice, VkImage, VkDeviceMemory, VkDeviceSize) {
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_image_view(VkDevice, const VkImageViewCreateInfo *, const VkAllocationCallbacks *, VkImageView *view) {
+        *view = make_handle<VkImageView>();
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_render_pass(VkDevice, const VkRenderPassCreateInfo *, const VkAllocationCallbacks *, VkRenderPass *renderPass) {
+        *renderPass = make_handle<VkRenderPass>();
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL fake_create_framebuffer(VkDevice, const VkFramebufferCreateInfo *createInfo, const VkAllocationCallbacks *, VkFramebuffer *framebuffer) {
+        fake.framebufferAttachments.emplace_back(createInfo->pAttachments, createInfo->pAttachments + createInfo->attachmentCount);
+        fake.framebufferExtents.push_back({ createInfo->width, createInfo->height });
+
+        *framebuffer = make_handle<VkFramebuffer>();
+
+        return VK_SUCCESS;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_framebuffer(VkDevice, VkFramebuffer, const VkAllocationCallbacks *) {
+        ++fake.destroyedFramebuffers;
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_render_pass(VkDevice, VkRenderPass, const VkAllocationCallbacks *) {}
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_image_view(VkDevice, VkImageView, const VkAllocationCallbacks *) {}
+    static VKAPI_ATTR void VKAPI_CALL fake_destroy_image(VkDevice, VkImage, const VkAllocationCallbacks *) {}
+    static VKAPI_ATTR void VKAPI_CALL fake_free_memory(VkDevice, VkDeviceMemory, const VkAllocationCallbacks *) {}
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_cmd_begin_render_pass(VkCommandBuffer, const VkRenderPassBeginInfo *beginInfo, VkSubpassContents) {
+        fake.beginnings.push_back(*beginInfo);
+    }
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_cmd_end_render_pass(VkCommandBuffer) {}
+
+
+
+    static VKAPI_ATTR void VKAPI_CALL fake_cmd_pipeline_barrier2(VkCommandBuffer, const VkDependencyInfoKHR *dependencyInfo) {
+        fake.barriers.insert(fake.barriers.end(), dependencyInfo->pImageMemoryBarriers, dependencyInfo->pImageMemoryBarriers + dependencyInfo->imageMemoryBarrierCount);
+    }
+
+
+
+    static GraphImageDesc make_color_desc(uint32_t width, uint32_t height) {
+        return { VK_FORMAT_R8G8B8A8_UNORM, { width, height } };
+    }
+
+    /**************
+     ** FIXTURES **
+     **************/
+
+    /**
+     * @brief Render graph compiled and executed against a fake device
+     */
+    class RenderGraphTest : public ::testing::Test {
+        protected:
+            InstanceSetup   setup;
+            RenderGraph     graph;
+            VkCommandBuffer commandBuffer;
+
+            void SetUp() override {
+                fake = {};
+
+                glad_vkCreateImage = fake_create_image;
+                glad_vkGetImageMemoryRequirements = fake_get_image_memory_requirements;
+                glad_vkGetPhysicalDeviceMemoryProperties = fake_get_physical_device_memory_properties;
+                glad_vkAllocateMemory = fake_allocate_memory;
+                glad_vkBindImageMemory = fake_bind_image_memory;
+                glad_vkCreateImageView = fake_create_image_view;
+                glad_vkCreateRenderPass = fake_create_render_pass;
+                glad_vkCreateFramebuffer = fake_create_framebuffer;
+                glad_vkDestroyFramebuffer = fake_destroy_framebuffer;
+                glad_vkDestroyRenderPass = fake_destroy_render_pass;
+                glad_vkDestroyImageView = fake_destroy_image_view;
+                glad_vkDestroyImage = fake_destroy_image;
+                glad_vkFreeMemory = fake_free_memory;
+                glad_vkCmdBeginRenderPass = fake_cmd_begin_render_pass;
+                glad_vkCmdEndRenderPass = fake_cmd_end_render_pass;
+                glad_vkCmdPipelineBarrier2KHR = fake_cmd_pipeline_barrier2;
+
+                this->setup.logicalDevice = make_handle<VkDevice>();
+                this->setup.physicalDevice = make_handle<VkPhysicalDevice>();
+                this->setup.synchronization2 = true;
+
+                this->commandBuffer = make_handle<VkCommandBuffer>();
+            }
+
+            void TearDown() override {
+                this->graph.destroy(this->setup);
+            }
+
+            /**
+             * @brief Finds the first recorded barrier of an image
+             */
+            const VkImageMemoryBarrier2KHR *find_barrier(VkImage image) const {
+                for (const VkImageMemoryBarrier2KHR &barrier : fake.barriers) {
+                    if (barrier.image == image) {
+                        return &barrier;
+                    }
+                }
+
+                return nullptr;
+            }
+    };
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST_F(RenderGraphTest, CullsPassesWhoseWritesAreNeverRead) {
+        GraphResource target = this->graph.import_image("target", make_color_desc(64, 64), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+        GraphResource unread     = this->graph.create_image("unread",     make_color_desc(64, 64));
+        GraphResource produced   = this->graph.create_image("produced",   make_color_desc(64, 64));
+        GraphResource chainFirst = this->graph.create_image("chain.first", make_color_desc(64, 64));
+        GraphResource chainLast  = this->graph.create_image("chain.last",  make_color_desc(64, 64));
+        GraphResource sideEffect = this->graph.create_image("side effect", make_color_desc(64, 64));
+
+        GraphPassId unreadPass   = this->graph.add_pass("unread", nullptr).write(unread, GraphAccess::ComputeStorageWrite).id();
+        GraphPassId producer     = this->graph.add_pass("producer", nullptr).write(produced, GraphAccess::ComputeStorageWrite).id();
+        GraphPassId consumer     = this->graph.add_pass("consumer", nullptr).read(produced, GraphAccess::ComputeStorageRead).write(target, GraphAccess::ComputeStorageWrite).id();
+        GraphPassId chainStart   = this->graph.add_pass("chain start", nullptr).write(chainFirst, GraphAccess::ComputeStorageWrite).id();
+        GraphPassId chainEnd     = this->graph.add_pass("chain end", nullptr).read(chainFirst, GraphAccess::ComputeStorageRead).write(chainLast, GraphAccess::ComputeStorageWrite).id();
+        GraphPassId sideEffected = this->graph.add_pass("side effect", nullptr).write(sideEffect, GraphAccess::ComputeStorageWrite).side_effect().id();
+
+        this->graph.compile(this->setup);
+
+        EXPECT_TRUE(this->graph.is_culled(unreadPass));
+        EXPECT_FALSE(this->graph.is_culled(producer));
+        EXPECT_FALSE(this->graph.is_culled(consumer));
+        EXPECT_TRUE(this->graph.is_culled(chainStart));
+        EXPECT_TRUE(this->graph.is_culled(chainEnd));
+        EXPECT_FALSE(this->graph.is_culled(sideEffected));
+    }
+
+
+
+    TEST_F(RenderGraphTest, AliasesTransientsWithDisjointLifetimes) {
+        GraphResource target = this->graph.import_image("target", make_color_desc(64, 64), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+        GraphResource first  = this->graph.create_image("first",  make_color_desc(64, 64));
+        GraphResource second = this->graph.create_image("second", make_color_desc(64, 64));
+        GraphResource third  = this->graph.create_image("third",  make_color_desc(64, 64));
+
+        // Levels 0 to 3 : first and third never live at the same time, second overlaps both
+        this->graph.add_pass("first", nullptr).write(first, GraphAccess::ComputeStorageWrite);
+        this->graph.add_pass("second", nullptr).read(first, GraphAccess::ComputeStorageRead).write(second, GraphAccess::ComputeStorageWrite);
+        this->graph.add_pass("third", nullptr).read(second, GraphAccess::ComputeStorageRead).write(third, GraphAccess::ComputeStorageWrite);
+        this->graph.add_pass("resolve", nullptr).read(third, GraphAccess::ComputeStorageRead).write(target, GraphAccess::ComputeStorageWrite);
+
+        this->graph.compile(this->setup);
+
+        const VkDeviceSize imageSize = 64 * 64 * 4;
+        EXPECT_EQ(this->graph.get_transient_memory_size(), 2 * imageSize);
+    }
+
+
+
+    TEST_F(RenderGraphTest, RenderAreaComesFromAttachments) {
+        GraphResource target = this->graph.import_image("target", make_color_desc(128, 32), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        this->graph.set_imported_image(target, make_handle<VkImage>(), make_handle<VkImageView>());
+
+        GraphResource shadow = this->graph.create_image("shadow", make_color_desc(64, 64));
+
+        this->graph.add_pass("shadow", [](VkCommandBuffer, const RenderGraph &) {}).write(shadow, GraphAccess::ComputeStorageWrite);
+
+        // The sampled read comes first : it must not give the render pass it's extent
+        this->graph.add_raster_pass("compose", [](VkCommandBuffer, const RenderGraph &) {})
+            .read(shadow, GraphAccess::FragmentSampled)
+            .write(target, GraphAccess::ColorAttachment);
+
+        this->graph.compile(this->setup);
+        this->graph.execute(this->commandBuffer);
+
+        ASSERT_EQ(fake.beginnings.size(), 1u);
+        EXPECT_EQ(fake.beginnings[0].renderArea.extent.width, 128u);
+        EXPECT_EQ(fake.beginnings[0].renderArea.extent.height, 32u);
+
+        ASSERT_EQ(fake.framebufferExtents.size(), 1u);
+        EXPECT_EQ(fake.framebufferExtents[0].width, 128u);
+        EXPECT_EQ(fake.framebufferExtents[0].height, 32u);
+    }
+
+
+
+    TEST_F(RenderGraphTest, RejectsAttachmentsOfDifferentExtents) {
+        GraphResource color = this->graph.import_image("color", make_color_desc(128, 128), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        GraphResource other = this->graph.import_image("other", make_color_desc(64, 64),   VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+        this->graph.add_raster_pass("draw", nullptr)
+            .write(color, GraphAccess::ColorAttachment)
+            .write(other, GraphAccess::ColorAttachment);
+
+        EXPECT_THROW(this->graph.compile(this->setup), std::runtime_error);
+    }
+
+
+
+    TEST_F(RenderGraphTest, FramebuffersFollowImportedImages) {
+        GraphResource target = this->graph.import_image("target", make_color_desc(64, 64), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+        std::vector<VkImage>     images = { make_handle<VkImage>(), make_handle<VkImage>() };
+        std::vector<VkImageView> views  = { make_handle<VkImageView>(), make_handle<VkImageView>() };
+        this->graph.set_imported_images(target, images, views);
+
+        this->graph.add_raster_pass("draw", [](VkCommandBuffer, const RenderGraph &) {}).write(target, GraphAccess::ColorAttachment, VkClearValue{});
+
+        this->graph.compile(this->setup);
+
+        for (uint32_t index : { 0u, 1u, 0u, 1u }) {
+            this->graph.select_imported_image(target, index);
+            this->graph.execute(this->commandBuffer);
+        }
+
+        // One framebuffer per image, reused afterwards
+        ASSERT_EQ(fake.framebufferAttachments.size(), 2u);
+        EXPECT_EQ(fake.framebufferAttachments[0], std::vector<VkImageView>{ views[0] });
+        EXPECT_EQ(fake.framebufferAttachments[1], std::vector<VkImageView>{ views[1] });
+        EXPECT_EQ(fake.beginnings[0].framebuffer, fake.beginnings[2].framebuffer);
+        EXPECT_NE(fake.beginnings[0].framebuffer, fake.beginnings[1].framebuffer);
+
+        VkFramebuffer previous = fake.beginnings[0].framebuffer;
+
+        // Recreated images commonly get their predecessors' handle values back : framebuffers must still be rebuilt
+        this->graph.set_imported_images(target, images, views);
+        EXPECT_EQ(fake.destroyedFramebuffers, 2u);
+
+        this->graph.execute(this->commandBuffer);
+
+        ASSERT_EQ(fake.framebufferAttachments.size(), 3u);
+        EXPECT_NE(fake.beginnings.back().framebuffer, previous);
+    }
+
+
+
+    TEST_F(RenderGraphTest, FirstUseWaitsForPreviousExecution) {
+        GraphResource target = this->graph.import_image("target", make_color_desc(64, 64), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        this->graph.set_imported_image(target, make_handle<VkImage>(), make_handle<VkImageView>());
+
+        GraphResource lighting = this->graph.create_image("lighting", make_color_desc(64, 64));
+
+        this->graph.add_raster_pass("lighting", [](VkCommandBuffer, const RenderGraph &) {}).write(lighting, GraphAccess::ColorAttachment, VkClearValue{});
+        this->graph.add_raster_pass("compose", [](VkCommandBuffer, const RenderGraph &) {})
+            .read(lighting, GraphAccess::FragmentSampled)
+            .write(target, GraphAccess::ColorAttachment);
+
+        this->graph.compile(this->setup);
+        this->graph.execute(this->commandBuffer);
+
+        // The next frame in flight writes the same memory : it must wait for this frame's last read of it
+        const VkImageMemoryBarrier2KHR *firstUse = this->find_barrier(this->graph.get_image(lighting));
+
+        ASSERT_NE(firstUse, nullptr);
+        EXPECT_EQ(firstUse->oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+        EXPECT_EQ(firstUse->newLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        EXPECT_NE(firstUse->srcStageMask & VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, 0u);
+        EXPECT_NE(firstUse->srcStageMask & VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, 0u);
+    }
+}
@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "scene-graph.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static constexpr float WORLD_TOLERANCE = 1e-5f; ///< The SIMD batch rounds differently from glm's products
+
+
+
+    static glm::mat4 make_translation(float x, float y, float z) {
+        return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+    }
+
+
+
+    static void expect_world_near(const SceneGraph &scene, NodeHandle handle, const glm::mat4 &expected) {
+        const glm::mat4 &world = scene.get_world(handle);
+
+        for (int column = 0; column != 4; ++column) {
+            for (int row = 0; row != 4; ++row) {
+                EXPECT_NEAR(world[column][row], expected[column][row], WORLD_TOLERANCE) << "node " << handle << ", column " << column << ", row " << row;
+            }
+        }
+    }
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST(SceneGraphTest, UpdatesOnlyChangedSubtrees) {
+        SceneGraph scene;
+
+        NodeHandle root = scene.add_node(make_translation(1.0f, 0.0f, 0.0f));
+        NodeHandle child = scene.add_node(make_translation(0.0f, 2.0f, 0.0f), root);
+        NodeHandle grandChild = scene.add_node(make_translation(0.0f, 0.0f, 3.0f), child);
+        NodeHandle sibling = scene.add_node(make_translation(4.0f, 0.0f, 0.0f), root);
+
+        EXPECT_EQ(scene.update(), 4u);
+        EXPECT_EQ(scene.update(), 0u);
+
+        // A change reaches the node's descendants, parents first, but not it's siblings
+        scene.set_local(child, make_translation(0.0f, 5.0f, 0.0f));
+
+        EXPECT_EQ(scene.update(), 2u);
+        EXPECT_EQ(scene.get_changed(), (std::vector<NodeHandle>{ child, grandChild }));
+
+        expect_world_near(scene, grandChild, make_translation(1.0f, 5.0f, 3.0f));
+        expect_world_near(scene, sibling, make_translation(5.0f, 0.0f, 0.0f));
+
+        // A root change reaches the whole tree
+        scene.set_local(root, glm::mat4(1.0f));
+
+        EXPECT_EQ(scene.update(), 4u);
+        expect_world_near(scene, grandChild, make_translation(0.0f, 5.0f, 3.0f));
+        expect_world_near(scene, sibling, make_translation(4.0f, 0.0f, 0.0f));
+    }
+
+
+
+    TEST(SceneGraphTest, ReordersNodesAfterReparenting) {
+        SceneGraph scene;
+
+        // The moved subtree is stored before it's new parent
+        NodeHandle moved = scene.add_node(make_translation(1.0f, 0.0f, 0.0f));
+        NodeHandle movedChild = scene.add_node(make_translation(0.0f, 1.0f, 0.0f), moved);
+        NodeHandle parent = scene.add_node(make_translation(0.0f, 0.0f, 10.0f));
+        NodeHandle parentChild = scene.add_node(make_translation(0.0f, 0.0f, 1.0f), parent);
+
+        scene.update();
+
+        scene.set_parent(moved, parentChild);
+
+        // Only the moved subtree is recomputed, after the parent it now depends on
+        EXPECT_EQ(scene.update(), 2u);
+        EXPECT_EQ(scene.get_changed(), (std::vector<NodeHandle>{ moved, movedChild }));
+
+        expect_world_near(scene, moved, make_translation(1.0f, 0.0f, 11.0f));
+        expect_world_near(scene, movedChild, make_translation(1.0f, 1.0f, 11.0f));
+
+        // The new parent's changes now reach the moved subtree
+        scene.set_local(parent, glm::mat4(1.0f));
+
+        EXPECT_EQ(scene.update(), 4u);
+        expect_world_near(scene, movedChild, make_translation(1.0f, 1.0f, 1.0f));
+
+        // Back to a root : the subtree no longer follows it's former parent
+        scene.set_parent(moved, INVALID_NODE);
+        scene.update();
+        scene.set_local(parent, make_translation(0.0f, 0.0f, 10.0f));
+
+        EXPECT_EQ(scene.update(), 2u);
+        expect_world_near(scene, movedChild, make_translation(1.0f, 1.0f, 0.0f));
+    }
+
+
+
+    TEST(SceneGraphTest, RejectsParentingUnderADescendant) {
+        SceneGraph scene;
+
+        NodeHandle root = scene.add_node(glm::mat4(1.0f));
+        NodeHandle child = scene.add_node(glm::mat4(1.0f), root);
+
+        EXPECT_THROW(scene.set_parent(root, child), std::runtime_error);
+        EXPECT_THROW(scene.set_parent(root, root), std::runtime_error);
+    }
+
+
+
+    TEST(SceneGraphTest, RemovesWholeSubtrees) {
+        SceneGraph scene;
+
+        NodeHandle root = scene.add_node(make_translation(1.0f, 0.0f, 0.0f));
+        NodeHandle removed = scene.add_node(make_translation(0.0f, 1.0f, 0.0f), root);
+        NodeHandle removedChild = scene.add_node(make_translation(0.0f, 0.0f, 1.0f), removed);
+        NodeHandle kept = scene.add_node(make_translation(0.0f, 2.0f, 0.0f), root);
+        NodeHandle keptChild = scene.add_node(make_translation(0.0f, 0.0f, 2.0f), kept);
+
+        scene.update();
+        scene.set_local(removedChild, glm::mat4(1.0f));
+
+        scene.remove_node(removed);
+
+        EXPECT_FALSE(scene.contains(removed));
+        EXPECT_FALSE(scene.contains(removedChild));
+        EXPECT_TRUE(scene.contains(root));
+        EXPECT_TRUE(scene.contains(keptChild));
+        EXPECT_EQ(scene.size(), 3u);
+        EXPECT_THROW(scene.get_world(removedChild), std::runtime_error);
+
+        // Compacted nodes keep their parents : the remaining tree still updates as a whole
+        scene.set_local(root, glm::mat4(1.0f));
+
+        EXPECT_EQ(scene.update(), 3u);
+        expect_world_near(scene, keptChild, make_translation(0.0f, 2.0f, 2.0f));
+
+        // Removed handles are given again to new nodes
+        NodeHandle added = scene.add_node(glm::mat4(1.0f), keptChild);
+        EXPECT_TRUE(added == removed || added == removedChild);
+
+        scene.update();
+        expect_world_near(scene, added, make_translation(0.0f, 2.0f, 2.0f));
+    }
+}
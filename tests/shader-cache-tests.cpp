@@ -0,0 +1,70 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "shader-cache.hpp"
+
+namespace fhope::tests {
+    /*************
+     ** HELPERS **
+     *************/
+
+    static const std::string CACHED_SOURCE = "#version 450\n// Cached by the shader cache tests\nvoid main() {}\n";
+
+
+
+    static ShaderCompileOptions make_options() {
+        ShaderCompileOptions options{};
+        options.kind = shaderc_vertex_shader;
+        options.targetEnvironment = shaderc_target_env_vulkan;
+        options.targetEnvironmentVersion = shaderc_env_version_vulkan_1_2;
+        options.sourceLanguage = shaderc_source_language_glsl;
+
+        return options;
+    }
+
+
+
+    static void remove_cached_shader(uint64_t key) {
+        char filename[32];
+        std::snprintf(filename, sizeof(filename), "%016llx.spv", static_cast<unsigned long long>(key));
+
+        std::error_code error;
+        std::filesystem::remove(std::filesystem::path(SHADER_CACHE_DIRECTORY) / filename, error);
+    }
+
+    /***********
+     ** TESTS **
+     ***********/
+
+    TEST(ShaderCacheTest, KeysDependOnTheCompilerRevisions) {
+        ShaderCompileOptions options = make_options();
+
+        uint64_t key = get_shader_cache_key(CACHED_SOURCE, options, "shaderc-v1+glslang-v1");
+
+        EXPECT_EQ(get_shader_cache_key(CACHED_SOURCE, options, "shaderc-v1+glslang-v1"), key);
+        EXPECT_NE(get_shader_cache_key(CACHED_SOURCE, options, "shaderc-v2+glslang-v1"), key);
+        EXPECT_NE(get_shader_cache_key(CACHED_SOURCE, options, "shaderc-v1+glslang-v2"), key);
+    }
+
+
+
+    TEST(ShaderCacheTest, OtherCompilerRevisionsMissTheCache) {
+        ShaderCompileOptions options = make_options();
+
+        uint64_t oldKey = get_shader_cache_key(CACHED_SOURCE, options, "shaderc-v1+glslang-v1");
+        uint64_t newKey = get_shader_cache_key(CACHED_SOURCE, options, "shaderc-v2+glslang-v1");
+
+        std::vector<uint32_t> code = { 0x07230203, 0x00010500, 0, 1, 0 };
+        store_cached_shader(oldKey, code);
+
+        EXPECT_EQ(load_cached_shader(oldKey), code);
+        EXPECT_FALSE(load_cached_shader(newKey).has_value());
+
+        remove_cached_shader(oldKey);
+    }
+}